@@ -187,6 +187,8 @@ typedef struct /* 8 words per channel */
 void dma_memory_copy (uint32_t chnl_num, unsigned int src, unsigned int dest, unsigned int size, unsigned int num);
 void dma_data_struct_init(void);
 void dma_init(void);
+void dma_peripheral_to_memory (uint32_t chnl_num, unsigned int src, unsigned int dest, unsigned int size, unsigned int num);
+unsigned int dma_get_remaining (uint32_t chnl_num);
 
 //void dma_memory_copy_rx (unsigned int src, unsigned int dest, unsigned int size, unsigned int num);
 //void dma_init_rx(void);
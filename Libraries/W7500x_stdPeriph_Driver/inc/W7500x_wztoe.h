@@ -1190,6 +1190,21 @@ void wiz_send_data(uint8_t sn, uint8_t *wizdata, uint16_t len);
  */
 void wiz_recv_data(uint8_t sn, uint8_t *wizdata, uint16_t len);
 
+/**
+ * @ingroup Basic_IO_function
+ * @brief It copies data to your buffer from internal RX memory without consuming it
+ *
+ * @details This function works as wiz_recv_data() but does not update the Rx read pointer register,
+ * the data stays in internal RX memory and is read again by the next wiz_recv_data() or recv().
+ * Check the received size (Sn_RX_RSR) before reading.
+ *
+ * @param (uint8_t)sn Socket number. It should be <b>0 ~ 7</b>.
+ * @param wizdata Pointer buffer to read data
+ * @param len Data length
+ * @sa wiz_recv_data()
+ */
+void wiz_recv_peek(uint8_t sn, uint8_t *wizdata, uint16_t len);
+
 /**
  * @ingroup Basic_IO_function
  * @brief It discard the received data in RX memory.
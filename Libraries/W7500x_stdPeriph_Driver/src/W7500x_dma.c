@@ -143,6 +143,51 @@ void dma_memory_copy (uint32_t chnl_num, unsigned int src, unsigned int dest, un
   return;
 }
 
+/* --------------------------------------------------------------- */
+/*  DMA peripheral to memory (basic cycle, peripheral request)     */
+/* --------------------------------------------------------------- */
+void dma_peripheral_to_memory (uint32_t chnl_num, unsigned int src, unsigned int dest, unsigned int size, unsigned int num)
+{
+  unsigned long src_end_pointer =  src;                           /* peripheral data register: fixed address */
+  unsigned long dst_end_pointer = dest + ((1<<size)*(num-1));
+  unsigned long control         = (size << 30) |  /* dst_inc */
+                                  (size << 28) |  /* dst_size */
+                                  (3    << 26) |  /* src_inc - no increment */
+                                  (size << 24) |  /* src_size */
+                                  (0    << 21) |  /* dst_prot_ctrl - HPROT[3:1] */
+                                  (0    << 18) |  /* src_prot_ctrl - HPROT[3:1] */
+                                  (0    << 14) |  /* R_power - arbitrates after each transfer */
+                                  ((num-1)<< 4) | /* n_minus_1 */
+                                  (0    <<  3) |  /* next_useburst */
+                                  (1    <<  0) ;  /* cycle_ctrl - basic */
+
+  dma_data->Primary[chnl_num].SrcEndPointer  = (EXPECTED_BE) ? __REV(src_end_pointer) : (src_end_pointer);
+  dma_data->Primary[chnl_num].DestEndPointer = (EXPECTED_BE) ? __REV(dst_end_pointer) : (dst_end_pointer);
+  dma_data->Primary[chnl_num].Control        = (EXPECTED_BE) ? __REV(control        ) : (control        );
+
+  DMA->CHNL_USEBURST_CLR = (1<<chnl_num); /* respond to single and burst requests */
+  DMA->CHNL_REQ_MASK_CLR = (1<<chnl_num); /* peripheral request enabled */
+  DMA->CHNL_PRI_ALT_CLR  = (1<<chnl_num); /* use primary data structure */
+  DMA->CHNL_ENABLE_SET   = (1<<chnl_num); /* Enable channel */
+
+  return;
+}
+
+/* --------------------------------------------------------------- */
+/*  DMA remaining transfers of the channel (primary)               */
+/*  The PL230 writes back n_minus_1 after each arbitration,        */
+/*  cycle_ctrl is set to 'stop' when the DMA cycle completed.      */
+/* --------------------------------------------------------------- */
+unsigned int dma_get_remaining (uint32_t chnl_num)
+{
+  unsigned long control = dma_data->Primary[chnl_num].Control;
+
+  if(EXPECTED_BE) control = __REV(control);
+  if((control & 0x7) == 0) return 0; /* cycle_ctrl - stop */
+
+  return (((control >> 4) & 0x3FF) + 1);
+}
+
 
 #if 0
 void dma_memory_copy_tx (unsigned int src, unsigned int dest, unsigned int size, unsigned int num)
@@ -24,26 +24,109 @@ void WIZCHIP_WRITE(uint32_t Addr, uint8_t Data)
     *(volatile uint8_t *)(Addr) = Data;
     WIZCHIP_CRITICAL_EXIT();
 }
+/*
+ * Copy between the RAM buffer and the WZTOE socket buffer memory.
+ * The WZTOE side is accessed by the aligned 32-bit words; the RAM side is packed / unpacked
+ * byte by byte when its alignment differs. A socket buffer size is a multiple of 1KB,
+ * so an aligned word never straddles the socket buffer wrap.
+ */
+static void wiz_buf_read(uint8_t * dst, volatile uint8_t * src, uint32_t len)
+{
+    uint32_t word;
+
+    while((len != 0) && ((uint32_t)src & 0x3)) // leading bytes up to the word boundary
+    {
+        *dst++ = *src++;
+        len--;
+    }
+
+    if(((uint32_t)dst & 0x3) == 0)
+    {
+        for( ; len >= 16; len -= 16, dst += 16, src += 16)
+        {
+            ((uint32_t *)dst)[0] = ((volatile uint32_t *)src)[0];
+            ((uint32_t *)dst)[1] = ((volatile uint32_t *)src)[1];
+            ((uint32_t *)dst)[2] = ((volatile uint32_t *)src)[2];
+            ((uint32_t *)dst)[3] = ((volatile uint32_t *)src)[3];
+        }
+        for( ; len >= 4; len -= 4, dst += 4, src += 4)
+            *(uint32_t *)dst = *(volatile uint32_t *)src;
+    }
+    else
+    {
+        for( ; len >= 4; len -= 4, dst += 4, src += 4)
+        {
+            word = *(volatile uint32_t *)src;
+            dst[0] = (uint8_t)word;
+            dst[1] = (uint8_t)(word >> 8);
+            dst[2] = (uint8_t)(word >> 16);
+            dst[3] = (uint8_t)(word >> 24);
+        }
+    }
+
+    while(len--) *dst++ = *src++;
+}
+
+static void wiz_buf_write(volatile uint8_t * dst, const uint8_t * src, uint32_t len)
+{
+    uint32_t word;
+
+    while((len != 0) && ((uint32_t)dst & 0x3)) // leading bytes up to the word boundary
+    {
+        *dst++ = *src++;
+        len--;
+    }
+
+    if(((uint32_t)src & 0x3) == 0)
+    {
+        for( ; len >= 16; len -= 16, dst += 16, src += 16)
+        {
+            ((volatile uint32_t *)dst)[0] = ((const uint32_t *)src)[0];
+            ((volatile uint32_t *)dst)[1] = ((const uint32_t *)src)[1];
+            ((volatile uint32_t *)dst)[2] = ((const uint32_t *)src)[2];
+            ((volatile uint32_t *)dst)[3] = ((const uint32_t *)src)[3];
+        }
+        for( ; len >= 4; len -= 4, dst += 4, src += 4)
+            *(volatile uint32_t *)dst = *(const uint32_t *)src;
+    }
+    else
+    {
+        for( ; len >= 4; len -= 4, dst += 4, src += 4)
+        {
+            word = (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+            *(volatile uint32_t *)dst = word;
+        }
+    }
+
+    while(len--) *dst++ = *src++;
+}
+
+/*
+ * The buffer pointer wraps at 64KB: the transfer is split at the wrap point instead of masking each byte address.
+ * The bulk copy runs outside the critical section; only the pointer register accesses hold it.
+ */
 void WIZCHIP_READ_BUF (uint32_t BaseAddr, uint32_t ptr, uint8_t* pBuf, uint16_t len)
 {
-    uint16_t i = 0;
-    WIZCHIP_CRITICAL_ENTER();
+    uint32_t len1st;
 
-    for(i = 0; i < len; i++)
-        pBuf[i] = *(volatile uint8_t *)(BaseAddr +((ptr+i)&0xFFFF));
+    ptr &= 0xFFFF;
+    len1st = 0x10000 - ptr;
+    if(len1st > len) len1st = len;
 
-    WIZCHIP_CRITICAL_EXIT();
+    wiz_buf_read(pBuf, (volatile uint8_t *)(BaseAddr + ptr), len1st);
+    if(len > len1st) wiz_buf_read(pBuf + len1st, (volatile uint8_t *)BaseAddr, len - len1st);
 }
 
 void WIZCHIP_WRITE_BUF(uint32_t BaseAddr, uint32_t ptr, uint8_t* pBuf, uint16_t len)
 {
-    uint16_t i = 0;
-    WIZCHIP_CRITICAL_ENTER();
+    uint32_t len1st;
 
-    for( i=0; i<len; i++)
-        *(volatile uint8_t *)(BaseAddr + ((ptr+i)&0xFFFF)) = pBuf[i];
+    ptr &= 0xFFFF;
+    len1st = 0x10000 - ptr;
+    if(len1st > len) len1st = len;
 
-    WIZCHIP_CRITICAL_EXIT();
+    wiz_buf_write((volatile uint8_t *)(BaseAddr + ptr), pBuf, len1st);
+    if(len > len1st) wiz_buf_write((volatile uint8_t *)BaseAddr, pBuf + len1st, len - len1st);
 }
 
 void wiz_send_data(uint8_t sn, uint8_t *wizdata, uint16_t len)
@@ -52,11 +135,15 @@ void wiz_send_data(uint8_t sn, uint8_t *wizdata, uint16_t len)
     uint32_t sn_tx_base = 0;
 
     if(len == 0)  return;
+    WIZCHIP_CRITICAL_ENTER();
     ptr = getSn_TX_WR(sn);
+    WIZCHIP_CRITICAL_EXIT();
     sn_tx_base = (TXMEM_BASE) | ((sn&0x7)<<18);
     WIZCHIP_WRITE_BUF(sn_tx_base, ptr, wizdata, len);
     ptr += len;
+    WIZCHIP_CRITICAL_ENTER();
     setSn_TX_WR(sn,ptr);
+    WIZCHIP_CRITICAL_EXIT();
 }
 
 void wiz_recv_data(uint8_t sn, uint8_t *wizdata, uint16_t len)
@@ -65,11 +152,28 @@ void wiz_recv_data(uint8_t sn, uint8_t *wizdata, uint16_t len)
     uint32_t sn_rx_base = 0; 
 
     if(len == 0) return;
+    WIZCHIP_CRITICAL_ENTER();
     ptr = getSn_RX_RD(sn);
+    WIZCHIP_CRITICAL_EXIT();
     sn_rx_base = (RXMEM_BASE) | ((sn&0x7)<<18);
     WIZCHIP_READ_BUF(sn_rx_base, ptr, wizdata, len);
     ptr += len;
+    WIZCHIP_CRITICAL_ENTER();
     setSn_RX_RD(sn,ptr);
+    WIZCHIP_CRITICAL_EXIT();
+}
+
+void wiz_recv_peek(uint8_t sn, uint8_t *wizdata, uint16_t len)
+{
+    uint32_t ptr = 0;
+    uint32_t sn_rx_base = 0; 
+
+    if(len == 0) return;
+    WIZCHIP_CRITICAL_ENTER();
+    ptr = getSn_RX_RD(sn);
+    WIZCHIP_CRITICAL_EXIT();
+    sn_rx_base = (RXMEM_BASE) | ((sn&0x7)<<18);
+    WIZCHIP_READ_BUF(sn_rx_base, ptr, wizdata, len);
 }
 
 
@@ -78,9 +182,13 @@ void wiz_recv_ignore(uint8_t sn, uint16_t len)
     uint32_t ptr = 0;
     uint32_t sn_rx_base = 0; 
     if(len == 0) return;
+    WIZCHIP_CRITICAL_ENTER();
     ptr = getSn_RX_RD(sn);
+    WIZCHIP_CRITICAL_EXIT();
     sn_rx_base = (RXMEM_BASE) | ((sn&0x7)<<18);
     ptr = sn_rx_base + ((ptr+len)&0xFFFF);
+    WIZCHIP_CRITICAL_ENTER();
     setSn_RX_RD(sn,ptr);
+    WIZCHIP_CRITICAL_EXIT();
 }
 
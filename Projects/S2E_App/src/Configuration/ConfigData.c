@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include "common.h"
 #include "W7500x_wztoe.h"
 #include "W7500x_board.h"
@@ -14,15 +15,93 @@
 #include "uartHandler.h"
 
 static DevConfig dev_config;
+#ifdef __USE_DUAL_DATA_UART__
+static DevConfig_ch2 dev_config_ch2;
+#endif
+
+// Data channel settings: the per-channel fields of the configuration data
+static const DevConfig_channel dev_config_channel[S2E_CHANNELS] = {
+	{dev_config.network_info, dev_config.serial_info, dev_config.network_info_extend, dev_config.options.pw_connect, &dev_config.options.pw_connect_en, dev_config.telnet_en},
+#ifdef __USE_DUAL_DATA_UART__
+	{dev_config_ch2.network_info, dev_config_ch2.serial_info, dev_config_ch2.network_info_extend, dev_config_ch2.pw_connect, &dev_config_ch2.pw_connect_en, dev_config_ch2.telnet_en},
+#endif
+};
+
+// Configuration data layout version 0 (Legacy): the fields changed by the layout version 1
+struct __network_info_v0 {
+	uint8_t working_mode;
+	uint8_t state;
+	uint8_t remote_ip[4];
+	uint16_t local_port;
+	uint16_t remote_port;
+	uint16_t inactivity;
+	uint16_t reconnection;
+	uint16_t packing_time;
+	uint8_t packing_size;
+	uint8_t packing_delimiter[4];
+	uint8_t packing_delimiter_length;
+	uint8_t packing_data_appendix;
+	uint8_t keepalive_en;
+	uint16_t keepalive_wait_time;
+	uint16_t keepalive_retry_time;
+} __attribute__((packed));
+
+struct __options_v0 {
+	char pw_connect[10];
+	char pw_search[10];
+	uint8_t pw_connect_en;
+	uint8_t dhcp_use;
+	uint8_t dns_use;
+	uint8_t dns_server_ip[4];
+	char dns_domain_name[50];
+	uint8_t serial_command;
+	uint8_t serial_command_echo;
+	uint8_t serial_trigger[3];
+} __attribute__((packed));
+
+typedef struct __DevConfig_v0 {
+	uint16_t packet_size;
+	uint8_t module_type[3];
+	uint8_t module_name[15];
+	uint8_t fw_ver[3];
+	struct __network_info_common network_info_common;
+	struct __network_info_v0 network_info[1];
+	struct __serial_info serial_info[1];
+	struct __options_v0 options;
+	struct __user_io_info user_io_info;
+	struct __firmware_update firmware_update;
+	struct __firmware_update_extend firmware_update_extend;
+	// Extended Fields: serial_info_extend, network_info_extend, ... (the layout is not changed)
+} __attribute__((packed)) DevConfig_v0;
+
+static void set_DevConfig_extend_to_factory_value(void);
+static void convert_DevConfig_from_v0(void);
+#ifdef __USE_DUAL_DATA_UART__
+static void set_DevConfig_ch2_to_factory_value(void);
+static void load_DevConfig_ch2_from_storage(void);
+#endif
 
 DevConfig* get_DevConfig_pointer(void)
 {
 	return &dev_config;
 }
 
+#ifdef __USE_DUAL_DATA_UART__
+DevConfig_ch2* get_DevConfig_ch2_pointer(void)
+{
+	return &dev_config_ch2;
+}
+#endif
+
+const DevConfig_channel* get_DevConfig_channel(uint8_t ch)
+{
+	if(ch >= S2E_CHANNELS) ch = S2E_CH1;
+	return &dev_config_channel[ch];
+}
+
 void set_DevConfig_to_factory_value(void)
 {
-	dev_config.packet_size = sizeof(DevConfig);
+	dev_config.packet_size = DEVCONFIG_PACKET_SIZE;
 	
 	/* Product code */
 	// WIZ550S2E: 000
@@ -64,7 +143,7 @@ void set_DevConfig_to_factory_value(void)
 	dev_config.network_info[0].reconnection = 3000;	// msec, default: 3 sec
 	dev_config.network_info[0].packing_time = 0;
 	dev_config.network_info[0].packing_size = 0;
-	dev_config.network_info[0].packing_delimiter[0] = 0; // packing_delimiter used only one-byte (for WIZ107SR compatibility)
+	dev_config.network_info[0].packing_delimiter[0] = 0; // packing_delimiter: 1 ~ 4 bytes (packing_delimiter_length)
 	dev_config.network_info[0].packing_delimiter[1] = 0;
 	dev_config.network_info[0].packing_delimiter[2] = 0;
 	dev_config.network_info[0].packing_delimiter[3] = 0;
@@ -101,7 +180,7 @@ void set_DevConfig_to_factory_value(void)
 	dev_config.options.dns_server_ip[1] = 8;
 	dev_config.options.dns_server_ip[2] = 8;
 	dev_config.options.dns_server_ip[3] = 8;
-	memset(dev_config.options.dns_domain_name, 0x00, 50);
+	memset(dev_config.options.dns_domain_name, 0x00, sizeof(dev_config.options.dns_domain_name));
 	//memcpy(dev_config.options.dns_domain_name, "www.google.com", 14);
 
 	dev_config.options.serial_command = SEGCP_ENABLE;
@@ -128,6 +207,150 @@ void set_DevConfig_to_factory_value(void)
 	memcpy(dev_config.firmware_update_extend.fwup_server_domain, FWUP_SERVER_DOMAIN, sizeof(FWUP_SERVER_DOMAIN));
 	memset(dev_config.firmware_update_extend.fwup_server_binpath, 0x00, sizeof(dev_config.firmware_update_extend.fwup_server_binpath));
 	memcpy(dev_config.firmware_update_extend.fwup_server_binpath, FWUP_SERVER_BINPATH, sizeof(FWUP_SERVER_BINPATH));
+	
+	set_DevConfig_extend_to_factory_value();
+#ifdef __USE_DUAL_DATA_UART__
+	set_DevConfig_ch2_to_factory_value();
+#endif
+}
+
+// Extended Fields: default values for the fields added at the end of DevConfig
+static void set_DevConfig_extend_to_factory_value(void)
+{
+	dev_config.serial_info_extend[0].rs485_pre_delay = RS485_PRE_DELAY_DEFAULT;
+	dev_config.serial_info_extend[0].rs485_post_delay = RS485_POST_DELAY_DEFAULT;
+	dev_config.network_info_extend[0].sock_buf_profile = SOCK_BUF_PROFILE_DEFAULT;
+	dev_config.network_info_extend[0].tcp_server_sessions = TCP_SERVER_SESSIONS_DEFAULT;
+	dev_config.network_info_extend[0].arbitration_timeout = SERIAL_ARBITRATION_TIMEOUT_DEFAULT;
+	dev_config.network_info_extend[0].packing_time_unit = PACKING_TIME_UNIT_DEFAULT;
+	dev_config.network_info_extend[0].packing_coalesce_time = PACKING_COALESCE_TIME_DEFAULT;
+	dev_config.network_info_extend[0].udp_peer_delivery = UDP_PEER_DELIVERY_DEFAULT;
+	dev_config.network_info_extend[0].udp_peer_aging = UDP_PEER_AGING_DEFAULT;
+	memset(dev_config.network_info_extend[0].udp_multicast_ip, 0x00, sizeof(dev_config.network_info_extend[0].udp_multicast_ip));
+	dev_config.network_info_extend[0].immediate_flush = IMMEDIATE_FLUSH_DEFAULT;
+	dev_config.telnet_en[0] = DATA_PROTOCOL_DEFAULT;
+}
+
+#ifdef __USE_DUAL_DATA_UART__
+// Channel 2 defaults: disabled, TCP server (local port 5001), 115200-8-N-1; the other values are the same as the channel 1 defaults
+static void set_DevConfig_ch2_to_factory_value(void)
+{
+	memset(&dev_config_ch2, 0x00, sizeof(DevConfig_ch2));
+	
+	dev_config_ch2.packet_size = DEVCONFIG_CH2_PACKET_SIZE;
+	dev_config_ch2.channel_en = SEGCP_DISABLE;
+	
+	dev_config_ch2.network_info[0].working_mode = TCP_SERVER_MODE;
+	dev_config_ch2.network_info[0].state = ST_OPEN;
+	dev_config_ch2.network_info[0].remote_ip[0] = 192;
+	dev_config_ch2.network_info[0].remote_ip[1] = 168;
+	dev_config_ch2.network_info[0].remote_ip[2] = 11;
+	dev_config_ch2.network_info[0].remote_ip[3] = 3;
+	dev_config_ch2.network_info[0].local_port = DATA_CH2_LOCAL_PORT_DEFAULT;
+	dev_config_ch2.network_info[0].remote_port = DATA_CH2_LOCAL_PORT_DEFAULT;
+	dev_config_ch2.network_info[0].reconnection = 3000;	// msec, default: 3 sec
+	dev_config_ch2.network_info[0].keepalive_en = 1;
+	dev_config_ch2.network_info[0].keepalive_wait_time = 7000;
+	dev_config_ch2.network_info[0].keepalive_retry_time = 5000;
+	
+	dev_config_ch2.network_info_extend[0].sock_buf_profile = SOCK_BUF_PROFILE_DEFAULT;
+	dev_config_ch2.network_info_extend[0].tcp_server_sessions = TCP_SERVER_SESSIONS_DEFAULT;
+	dev_config_ch2.network_info_extend[0].arbitration_timeout = SERIAL_ARBITRATION_TIMEOUT_DEFAULT;
+	dev_config_ch2.network_info_extend[0].packing_time_unit = PACKING_TIME_UNIT_DEFAULT;
+	dev_config_ch2.network_info_extend[0].packing_coalesce_time = PACKING_COALESCE_TIME_DEFAULT;
+	dev_config_ch2.network_info_extend[0].udp_peer_delivery = UDP_PEER_DELIVERY_DEFAULT;
+	dev_config_ch2.network_info_extend[0].udp_peer_aging = UDP_PEER_AGING_DEFAULT;
+	dev_config_ch2.network_info_extend[0].immediate_flush = IMMEDIATE_FLUSH_DEFAULT;
+	
+	dev_config_ch2.serial_info[0].uart_interface = UART_IF_RS232_TTL;
+	dev_config_ch2.serial_info[0].baud_rate = baud_115200;
+	dev_config_ch2.serial_info[0].data_bits = word_len8;
+	dev_config_ch2.serial_info[0].parity = parity_none;
+	dev_config_ch2.serial_info[0].stop_bits = stop_bit1;
+	dev_config_ch2.serial_info[0].flow_control = flow_none;
+	dev_config_ch2.serial_info[0].dtr_en = SEGCP_DISABLE;
+	dev_config_ch2.serial_info[0].dsr_en = SEGCP_DISABLE;
+	dev_config_ch2.serial_info[0].serial_debug_en = SEGCP_DISABLE;
+	
+	dev_config_ch2.pw_connect_en = SEGCP_DISABLE;
+	dev_config_ch2.telnet_en[0] = DATA_PROTOCOL_DEFAULT;
+}
+
+// Not stored yet (or unknown layout): the default values are used until the settings are saved
+static void load_DevConfig_ch2_from_storage(void)
+{
+	uint16_t size;
+	
+	read_storage(STORAGE_CONFIG_CH2, 0, &dev_config_ch2, sizeof(DevConfig_ch2));
+	size = dev_config_ch2.packet_size & DEVCONFIG_SIZE_MASK;
+	
+	if((dev_config_ch2.packet_size >> DEVCONFIG_VERSION_SHIFT) != DEVCONFIG_CH2_VERSION || size == 0 || size > DEVCONFIG_CH2_STORAGE_SIZE)
+	{
+		set_DevConfig_ch2_to_factory_value();
+	}
+	else if(size < sizeof(DevConfig_ch2))
+	{
+		// Stored by the previous version: the stored fields are restored by the stored data size
+		set_DevConfig_ch2_to_factory_value();
+		read_storage(STORAGE_CONFIG_CH2, 0, &dev_config_ch2, size);
+		dev_config_ch2.packet_size = DEVCONFIG_CH2_PACKET_SIZE;
+	}
+	
+	dev_config_ch2.network_info[0].state = ST_OPEN;
+	
+	// RS-232/TTL only, no flow control
+	dev_config_ch2.serial_info[0].uart_interface = UART_IF_RS232_TTL;
+	dev_config_ch2.serial_info[0].flow_control = flow_none;
+	dev_config_ch2.serial_info[0].dtr_en = SEGCP_DISABLE;
+	dev_config_ch2.serial_info[0].dsr_en = SEGCP_DISABLE;
+}
+#endif
+
+// Stored by the layout version 0 (Legacy): the stored fields are converted to the current layout
+// packing_size is widened to 2-bytes, dns_domain_name is shortened to DNS_DOMAIN_NAME_SIZE (SEGCP accepts up to DEVCONF_DOMAIN_MAX)
+static void convert_DevConfig_from_v0(void)
+{
+	union {
+		DevConfig_v0 cfg;
+		uint8_t raw[DEVCONFIG_STORAGE_SIZE];
+	} v0;
+	uint16_t size;
+	
+	read_storage(STORAGE_CONFIG, 0, v0.raw, DEVCONFIG_STORAGE_SIZE);
+	size = v0.cfg.packet_size;
+	if(size > DEVCONFIG_STORAGE_SIZE) size = DEVCONFIG_STORAGE_SIZE;
+	
+	set_DevConfig_to_factory_value();
+	
+	memcpy(dev_config.module_type, v0.cfg.module_type, sizeof(v0.cfg.module_type));
+	memcpy(dev_config.module_name, v0.cfg.module_name, sizeof(v0.cfg.module_name));
+	memcpy(&dev_config.network_info_common, &v0.cfg.network_info_common, sizeof(struct __network_info_common));
+	
+	// network_info: packing_size
+	memcpy(&dev_config.network_info[0], &v0.cfg.network_info[0], offsetof(struct __network_info_v0, packing_size));
+	dev_config.network_info[0].packing_size = v0.cfg.network_info[0].packing_size;
+	memcpy(dev_config.network_info[0].packing_delimiter, v0.cfg.network_info[0].packing_delimiter, sizeof(struct __network_info_v0) - offsetof(struct __network_info_v0, packing_delimiter));
+	
+	memcpy(&dev_config.serial_info[0], &v0.cfg.serial_info[0], sizeof(struct __serial_info));
+	
+	// options: dns_domain_name
+	memcpy(&dev_config.options, &v0.cfg.options, offsetof(struct __options_v0, dns_domain_name));
+	strncpy(dev_config.options.dns_domain_name, v0.cfg.options.dns_domain_name, sizeof(dev_config.options.dns_domain_name) - 1);
+	dev_config.options.serial_command = v0.cfg.options.serial_command;
+	dev_config.options.serial_command_echo = v0.cfg.options.serial_command_echo;
+	memcpy(dev_config.options.serial_trigger, v0.cfg.options.serial_trigger, sizeof(v0.cfg.options.serial_trigger));
+	
+	memcpy(&dev_config.user_io_info, &v0.cfg.user_io_info, sizeof(struct __user_io_info));
+	memcpy(&dev_config.firmware_update, &v0.cfg.firmware_update, sizeof(struct __firmware_update));
+	memcpy(&dev_config.firmware_update_extend, &v0.cfg.firmware_update_extend, sizeof(struct __firmware_update_extend));
+	
+	// Extended Fields: restored by the stored data size, the fields not stored are kept as the default values
+	if(size > sizeof(DevConfig_v0))
+	{
+		size -= sizeof(DevConfig_v0);
+		if(size > (sizeof(DevConfig) - offsetof(DevConfig, serial_info_extend))) size = sizeof(DevConfig) - offsetof(DevConfig, serial_info_extend);
+		memcpy(dev_config.serial_info_extend, &v0.raw[sizeof(DevConfig_v0)], size);
+	}
 }
 
 void load_DevConfig_from_storage(void)
@@ -136,10 +359,25 @@ void load_DevConfig_from_storage(void)
 	
 	read_storage(STORAGE_CONFIG, 0, &dev_config, sizeof(DevConfig));
 
-	if(dev_config.packet_size == 0x0000 || dev_config.packet_size == 0xFFFF){
+	if(dev_config.packet_size == 0x0000 || dev_config.packet_size == 0xFFFF || (dev_config.packet_size >> DEVCONFIG_VERSION_SHIFT) > DEVCONFIG_VERSION){
 		set_DevConfig_to_factory_value();
 		write_storage(STORAGE_CONFIG, 0, &dev_config, sizeof(DevConfig));
 	}
+	else if((dev_config.packet_size >> DEVCONFIG_VERSION_SHIFT) == 0)
+	{
+		// Stored by the legacy layout (version 0): converted to the current layout
+		convert_DevConfig_from_v0();
+		write_storage(STORAGE_CONFIG, 0, &dev_config, sizeof(DevConfig));
+	}
+	else if((dev_config.packet_size & DEVCONFIG_SIZE_MASK) < sizeof(DevConfig))
+	{
+		// Stored by the previous version: the extended fields are set to the default values,
+		// then the stored fields are restored by the stored data size (packet_size)
+		set_DevConfig_extend_to_factory_value();
+		read_storage(STORAGE_CONFIG, 0, &dev_config, dev_config.packet_size & DEVCONFIG_SIZE_MASK);
+		dev_config.packet_size = DEVCONFIG_PACKET_SIZE;
+		write_storage(STORAGE_CONFIG, 0, &dev_config, sizeof(DevConfig));
+	}
 	
 	dev_config.network_info[0].state = ST_OPEN;
 	
@@ -148,11 +386,18 @@ void load_DevConfig_from_storage(void)
 	dev_config.fw_ver[2] = MAINTENANCE_VER;
 	
 	dev_config.serial_info[0].uart_interface = get_uart_if_sel_pin();
+	
+#ifdef __USE_DUAL_DATA_UART__
+	load_DevConfig_ch2_from_storage();
+#endif
 }
 
 void save_DevConfig_to_storage(void)
 {
 	write_storage(STORAGE_CONFIG, 0, &dev_config, sizeof(DevConfig));
+#ifdef __USE_DUAL_DATA_UART__
+	write_storage(STORAGE_CONFIG_CH2, 0, &dev_config_ch2, sizeof(DevConfig_ch2));
+#endif
 }
 
 void get_DevConfig_value(void *dest, const void *src, uint16_t size)
@@ -203,7 +448,7 @@ void display_Net_Info(void)
 	printf(" # SN : %d.%d.%d.%d\r\n", gWIZNETINFO.sn[0], gWIZNETINFO.sn[1], gWIZNETINFO.sn[2], gWIZNETINFO.sn[3]);
 	printf(" # DNS: %d.%d.%d.%d\r\n", gWIZNETINFO.dns[0], gWIZNETINFO.dns[1], gWIZNETINFO.dns[2], gWIZNETINFO.dns[3]);
 	
-	if(value->network_info[0].working_mode != TCP_SERVER_MODE)
+	if((value->network_info[0].working_mode != TCP_SERVER_MODE) && (value->network_info[0].working_mode != MODBUS_TCP_MODE))
 	{
 		if(value->options.dns_use == SEGCP_ENABLE)
 		{
@@ -18,6 +18,19 @@
 #define FWUP_SERVER_DOMAIN			"device.wizwiki.net"
 #define FWUP_SERVER_BINPATH			"/wiz750sr/fw/W7500x_S2E_App.bin"
 
+/* Configuration data layout version */
+// packet_size: [15:12] layout version, [11:0] size of the stored data
+// [0] Legacy layout (WIZ107SR compatible): packing_size in 1-byte, dns_domain_name[50]
+// [1] packing_size in 2-bytes, dns_domain_name[33]
+#define DEVCONFIG_VERSION			1
+#define DEVCONFIG_VERSION_SHIFT		12
+#define DEVCONFIG_SIZE_MASK			0x0FFF
+#define DEVCONFIG_PACKET_SIZE		((DEVCONFIG_VERSION << DEVCONFIG_VERSION_SHIFT) | sizeof(DevConfig))
+
+#define DEVCONFIG_STORAGE_SIZE		256	// Configuration data storage: data flash DAT1 (1 sector) / EEPROM (1 block)
+
+#define DNS_DOMAIN_NAME_SIZE		33	// DEVCONF_DOMAIN_MAX (32) + NULL
+
 struct __network_info_common {
 	uint8_t mac[6];
 	uint8_t local_ip[4];
@@ -26,7 +39,7 @@ struct __network_info_common {
 } __attribute__((packed));
 
 struct __network_info {
-	uint8_t working_mode;			// TCP_CLIENT_MODE (0), TCP_SERVER_MODE (1), TCP_MIXED_MODE (2), UDP_MODE (3)
+	uint8_t working_mode;			// TCP_CLIENT_MODE (0), TCP_SERVER_MODE (1), TCP_MIXED_MODE (2), UDP_MODE (3), MODBUS_TCP_MODE (4)
 	uint8_t state;					// WIZ107SR: BOOT(0), OPEN (1), CONNECT (2), UPGRADE (3), ATMODE (4) // WIZ550S2E: 소켓의 상태 TCP의 경우 Not Connected, Connected, UDP의 경우 UDP
 	uint8_t remote_ip[4];			// Must Be 4byte Alignment
 	uint16_t local_port;
@@ -36,7 +49,7 @@ struct __network_info {
 	uint16_t reconnection;
 
 	uint16_t packing_time;			// 0~65535
-	uint8_t packing_size;			// 0~255
+	uint16_t packing_size;			// 0~PACKING_SIZE_MAX
 	uint8_t packing_delimiter[4];
 	uint8_t packing_delimiter_length;	// 0~4
 	uint8_t packing_data_appendix;		// 0~2(구분자까지 전송, 구분자 +1바이트 까지 전송, 구분자 +2바이트 까지 전송)
@@ -66,7 +79,7 @@ struct __options {
 	uint8_t dhcp_use;
 	uint8_t dns_use;
 	uint8_t dns_server_ip[4];
-	char dns_domain_name[50];
+	char dns_domain_name[DNS_DOMAIN_NAME_SIZE];
 	uint8_t serial_command;			// Serial Command Mode 사용 여부
 	uint8_t serial_command_echo;	// Serial Command 입력 echoback 여부
 	uint8_t serial_trigger[3];		// Serial Command Mode 진입을 위한 Trigger 코드
@@ -95,6 +108,84 @@ struct __firmware_update_extend {
 	uint8_t fwup_server_binpath[FWUP_BINPATH_SIZE];
 } __attribute__((packed));
 
+// RS-485 driver enable (RTS pin) turnaround delays, unit: bit time
+// [pre] driver enable -> Tx start, [post] Tx complete (stop bit sent) -> driver disable
+#define RS485_PRE_DELAY_DEFAULT		1
+#define RS485_POST_DELAY_DEFAULT	1
+
+// Extended Fields: RS-485 driver enable (RTS pin) turnaround delays
+struct __serial_info_extend {
+	uint8_t rs485_pre_delay;	// Driver enable -> Tx start, unit: bit time (0~255)
+	uint8_t rs485_post_delay;	// Tx complete -> Driver disable, unit: bit time (0~255)
+} __attribute__((packed));
+
+// WZTOE H/W socket buffer profiles: Tx/Rx buffer sizes (KB) of the sockets, 16KB in total for each direction
+#define SOCK_BUF_PROFILE_BALANCED		0	// S2E data socket 4KB, service sockets 2KB
+#define SOCK_BUF_PROFILE_THROUGHPUT		1	// S2E data socket 8KB, service sockets 1KB / 2KB; for the long-RTT links
+#define SOCK_BUF_PROFILE_MULTISESSION	2	// 2KB for all sockets; for the multiple data sessions
+#define SOCK_BUF_PROFILE_MAX			SOCK_BUF_PROFILE_MULTISESSION
+#define SOCK_BUF_PROFILE_DEFAULT		SOCK_BUF_PROFILE_BALANCED
+
+// TCP server mode: number of the concurrent client sessions, [1] single session (legacy)
+#define TCP_SERVER_SESSIONS_MAX			4
+#define TCP_SERVER_SESSIONS_DEFAULT		1
+
+// TCP server multi-session: serial line arbitration, per-transaction timeout (msec), [0] arbitration disabled
+#define SERIAL_ARBITRATION_TIMEOUT_DEFAULT	0
+
+// Data packing time delimiter (packing_time) unit
+// [msec] counted by the 1ms tick after the last byte (legacy)
+// [usec] / [half character times] UART Rx gap timer re-armed per Rx burst, the packet ends at the last byte before the gap
+//		The gap time is not shorter than the UART Rx timeout (32 bit times, e.g., 3.2 character times at 8-N-1);
+//		a shorter setting is raised to it, the shorter gaps in the serial data do not split the packet
+#define PACKING_TIME_UNIT_MSEC			0
+#define PACKING_TIME_UNIT_USEC			1
+#define PACKING_TIME_UNIT_HALF_CHAR		2
+#define PACKING_TIME_UNIT_MAX			PACKING_TIME_UNIT_HALF_CHAR
+#define PACKING_TIME_UNIT_DEFAULT		PACKING_TIME_UNIT_MSEC
+
+// Data packing size delimiter (packing_size): up to the S2E data buffer size (DATA_BUF_SIZE)
+#define PACKING_SIZE_MAX				2048
+
+// Data packing coalesce to MSS: the serial data is held until the MSS of the data socket is buffered or the latency budget (msec) expires
+// [0] disabled
+#define PACKING_COALESCE_TIME_DEFAULT	0
+
+// Data packing character delimiter (packing_delimiter): 1 ~ 4 bytes, the appendix bytes after the delimiter are sent in the same packet
+#define PACKING_DATA_APPENDIX_MAX		2
+
+// Immediate flush mode: the serial data is sent from the UART Rx interrupt path (PendSV) without waiting for the main loop
+#define IMMEDIATE_FLUSH_DISABLE			0
+#define IMMEDIATE_FLUSH_ENABLE			1
+#define IMMEDIATE_FLUSH_DEFAULT			IMMEDIATE_FLUSH_DISABLE
+
+// UDP mode 1:N (remote_ip 0.0.0.0): delivery of the serial data to the peers learned from the received packets
+#define UDP_PEER_DELIVERY_LAST			0	// Reply to the last peer (legacy)
+#define UDP_PEER_DELIVERY_ALL			1	// Unicast to all live peers
+#define UDP_PEER_DELIVERY_ROUNDROBIN	2	// One live peer per packet, in turn
+#define UDP_PEER_DELIVERY_MAX			UDP_PEER_DELIVERY_ROUNDROBIN
+#define UDP_PEER_DELIVERY_DEFAULT		UDP_PEER_DELIVERY_LAST
+
+// UDP mode 1:N: peer table aging time (sec), the peer is removed when no packet is received during the aging time, [0] no aging
+#define UDP_PEER_AGING_DEFAULT			300
+
+// Extended Fields: Network options
+struct __network_info_extend {
+	uint8_t sock_buf_profile;	// WZTOE H/W socket buffer profile, applied at boot
+	uint8_t tcp_server_sessions;	// TCP server mode: max concurrent client sessions (1~4)
+	uint16_t arbitration_timeout;	// TCP server multi-session: serial line arbitration transaction timeout (msec), [0] disabled
+	uint8_t packing_time_unit;		// Data packing time delimiter unit: [0] msec, [1] usec, [2] half character times
+	uint16_t packing_coalesce_time;	// Data packing coalesce to MSS: latency budget (msec), [0] disabled
+	uint8_t udp_peer_delivery;		// UDP mode 1:N: [0] reply to the last peer, [1] all live peers, [2] round-robin
+	uint16_t udp_peer_aging;		// UDP mode 1:N: peer table aging time (sec), [0] no aging
+	uint8_t udp_multicast_ip[4];	// UDP mode: multicast group joined by the data socket (group port: local_port), [0.0.0.0] disabled
+	uint8_t immediate_flush;		// Immediate flush mode: [0] disabled, [1] the serial data is sent from the UART Rx interrupt path
+} __attribute__((packed));
+
+// Data socket protocol (telnet_en): [0] raw data (SEGCP_RAW), [1] Telnet COM port control, RFC 2217 (SEGCP_TELNET)
+// The Telnet mode is used by the TCP client / server (single session) / mixed modes, the connection password is not used
+#define DATA_PROTOCOL_DEFAULT			0
+
 typedef struct __DevConfig {
 	uint16_t packet_size;
 	uint8_t module_type[3];		// 모듈의 종류별로 코드를 부여하고 이를 사용한다.
@@ -107,9 +198,50 @@ typedef struct __DevConfig {
 	struct __user_io_info user_io_info;		// Enable / Type / Direction
 	struct __firmware_update firmware_update;					// ## Eric, Field added for compatibility with WIZ107SR
 	struct __firmware_update_extend firmware_update_extend;		// ## Eric, Field added for Extended function: Firmware update by HTTP (Remote) Server
+	struct __serial_info_extend serial_info_extend[1];			// Extended Fields: added at the end, the stored data of the previous version is extended by packet_size
+	struct __network_info_extend network_info_extend[1];
+	uint8_t telnet_en[1];						// Data socket protocol: [0] raw, [1] Telnet COM port control (RFC 2217)
 } __attribute__((packed)) DevConfig;
 
+// Compile-time check: the configuration data fits in the storage (a new field must not overflow the sector)
+typedef char DevConfig_size_check[(sizeof(DevConfig) <= DEVCONFIG_STORAGE_SIZE) ? 1 : -1];
+
+/* Dual data UART mode: channel 2 (UART1) configuration data */
+// Stored apart from DevConfig (the DevConfig sector is full): data flash DAT0 after the MAC address / EEPROM block 0
+// The channel has its own network / serial / packing / password / protocol settings, as channel 1 in DevConfig;
+// RS-232/TTL only without flow control and DTR/DSR, the device settings (IP address, options, SEGCP) are shared
+#define DEVCONFIG_CH2_VERSION		1
+#define DEVCONFIG_CH2_PACKET_SIZE	((DEVCONFIG_CH2_VERSION << DEVCONFIG_VERSION_SHIFT) | sizeof(DevConfig_ch2))
+#define DEVCONFIG_CH2_STORAGE_SIZE	(DEVCONFIG_STORAGE_SIZE - 0x10)	// DAT0 sector after the MAC address
+
+#define DATA_CH2_LOCAL_PORT_DEFAULT		5001
+
+typedef struct __DevConfig_ch2 {
+	uint16_t packet_size;						// [15:12] layout version, [11:0] size of the stored data, same as DevConfig
+	uint8_t channel_en;							// [0] channel 2 disabled, [1] enabled
+	struct __network_info network_info[1];
+	struct __serial_info serial_info[1];
+	struct __network_info_extend network_info_extend[1];	// sock_buf_profile: not used (channel 1 setting)
+	char pw_connect[10];
+	uint8_t pw_connect_en;
+	uint8_t telnet_en[1];
+} __attribute__((packed)) DevConfig_ch2;
+
+typedef char DevConfig_ch2_size_check[(sizeof(DevConfig_ch2) <= DEVCONFIG_CH2_STORAGE_SIZE) ? 1 : -1];
+
+// Data channel settings: the per-channel fields of DevConfig (channel 1) / DevConfig_ch2 (channel 2)
+typedef struct __DevConfig_channel {
+	struct __network_info * network_info;
+	struct __serial_info * serial_info;
+	struct __network_info_extend * network_info_extend;
+	char * pw_connect;
+	uint8_t * pw_connect_en;
+	uint8_t * telnet_en;
+} DevConfig_channel;
+
 DevConfig* get_DevConfig_pointer(void);
+DevConfig_ch2* get_DevConfig_ch2_pointer(void);
+const DevConfig_channel* get_DevConfig_channel(uint8_t ch); // ch: S2E_CH1, S2E_CH2 (common.h)
 void set_DevConfig_to_factory_value(void);
 void load_DevConfig_from_storage(void);
 void save_DevConfig_to_storage(void);
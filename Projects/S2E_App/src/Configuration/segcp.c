@@ -18,17 +18,51 @@
 #include "uartHandler.h"
 #include "gpioHandler.h"
 #include "timerHandler.h"
+#include "eventHandler.h"
 
 /* Private define ------------------------------------------------------------*/
 // Ring Buffer declaration
 BUFFER_DECLARATION(data_rx);
 
+// SEGCP response writer: the replies are appended to the response buffer, bounded by the buffer size.
+// When the reply of the next command may not fit, the response so far is sent and continued
+// in the next UDP datagram / TCP segment / UART output, starting with the same header (MA, PW).
+#define SEGCP_REPLY_MAX		(SEGCP_CMD_MAX + (SEGCP_PARAM_MAX * 2) + 2)	// A reply: command + value (domain name / file path) + delimiter
+
+#define SEGCP_REP_NONE		0	// No continuation: a reply that does not fit is truncated
+#define SEGCP_REP_UDP		1
+#define SEGCP_REP_TCP		2
+#define SEGCP_REP_UART		3
+
+typedef struct __segcp_writer {
+	uint8_t * buf;
+	uint16_t size;
+	uint16_t len;		// Written length, the buffer is kept null-terminated
+	uint16_t head;		// Header length: repeated at the start of the continued response
+	uint16_t port;		// SEGCP_REP_UDP: destination port of the reply
+	uint8_t out;		// Continuation output: SEGCP_REP_xxx
+} tsSEGCPWRITER;
+
 /* Private functions ---------------------------------------------------------*/
 uint16_t uart_get_commandline(uint8_t uartNum, uint8_t* buf, uint16_t maxSize);
 
+// SEGCP response writer
+void segcp_rep_init(uint8_t * buf, uint16_t size, uint8_t out, uint16_t port);
+void segcp_rep_header(uint8_t * pw, uint16_t pw_len);
+void segcp_rep_put(const uint8_t * data, uint16_t len);
+void segcp_rep_str(const char * str);
+void segcp_rep_char(uint8_t ch);
+void segcp_rep_dec(uint32_t val);
+void segcp_rep_ip(uint8_t * ip);
+void segcp_rep_hex(uint8_t * data, uint8_t len, uint8_t lowercase);
+void segcp_rep_rewind(uint16_t len);
+void segcp_rep_reserve(uint16_t len);
+void segcp_rep_flush(void);
+
 /* Private variables ---------------------------------------------------------*/
 static uint8_t gSEGCPREQ[CONFIG_BUF_SIZE];
 static uint8_t gSEGCPREP[CONFIG_BUF_SIZE];
+static tsSEGCPWRITER segcp_wr;
 
 uint8_t * strDEVSTATUS[]  = {"BOOT", "OPEN", "CONNECT", "UPGRADE", "ATMODE", "UDP", 0};
 
@@ -40,7 +74,13 @@ uint8_t * tbSEGCPCMD[] = {"MC", "VR", "MN", "IM", "OP", "DD", "CP", "PO", "DG",
 							"LG", "ER", "FW", "MA", "PW", "SV", "EX", "RT", "UN", "ST",
 							"FR", "EC", "K!", "UE", "GA", "GB", "GC", "GD", "CA", "CB", 
 							"CC", "CD", "SC", "S0", "S1", "RX", "FS", "FC", "FP", "FD",
-							"FH", "UI", 0};
+							"FH", "UI", "RB", "RA", "BP", "MS", "AR", "PA", "PC", "UD", "UA", "UM", "IF", "LS", "TS", "QC", "QE", 0};
+
+// Command lookup index: the commands are chained by the first character ('A' ~ 'Z'), built from tbSEGCPCMD once.
+// A lookup compares the second character of the commands in one chain (about 3 commands) instead of walking the whole table.
+static uint8_t tbSEGCPIDX[SEGCP_IDX_SIZE];	// The first command of each chain, SEGCP_UNKNOWN: empty chain
+static uint8_t tbSEGCPNEXT[SEGCP_CMD_NUM];	// The next command in the chain
+static uint8_t segcp_idx_ready = SEGCP_DISABLE;
 
 uint8_t * tbSEGCPERR[] = {"ERNULL", "ERNOTAVAIL", "ERNOPARAM", "ERIGNORED", "ERNOCOMMAND", "ERINVALIDPARAM", "ERNOPRIVILEGE"};
 
@@ -80,9 +120,10 @@ void do_segcp(void)
 	{
 		if(segcp_ret & SEGCP_RET_SWITCH)
 		{
+			lock_seg_data_path(); // The UART Ring buffer flushed: the flush by PendSV is held off
 			if(opmode == DEVICE_GW_MODE) 		init_trigger_modeswitch(DEVICE_AT_MODE); // DEVICE_GW_MODE -> DEVICE_AT_MODE
 			else 								init_trigger_modeswitch(DEVICE_GW_MODE); // DEVICE_AT_MODE -> DEVICE_GW_MODE
-			
+			unlock_seg_data_path();
 		}
 	
 		if(segcp_ret & SEGCP_RET_FACTORY)
@@ -140,6 +181,10 @@ void do_segcp(void)
 			status_bak = (teDEVSTATUS)get_device_status();
 			set_device_status(ST_UPGRADE);
 			
+			// The update blocks the main loop until it ends, the other tasks cannot run meanwhile:
+			// the system clock is 8MHz (the data UART baud rates are invalid), the download uses g_recv_buf (the data path buffer)
+			// and SOCK_FWUPDATE (the DNS socket of the network task); the device reboots after the update
+			
 			if((segcp_ret & SEGCP_RET_FWUP) == segcp_ret)				ret = device_firmware_update(NETWORK_APP_BACKUP); // Firmware update by Configuration tool
 #ifdef __USE_APPBACKUP_AREA__
 			// 'Firmware update via Web Server' function supports '__USE_APPBACKUP_AREA__' mode only
@@ -212,20 +257,43 @@ void do_segcp(void)
 }
 
 
+void init_SEGCP_index(void)
+{
+	uint8_t i;
+	uint8_t idx;
+	
+	memset(tbSEGCPIDX, SEGCP_UNKNOWN, sizeof(tbSEGCPIDX));
+	
+	// In reverse order: each chain keeps the table order
+	for(i = SEGCP_CMD_NUM; i > 0; i--)
+	{
+		idx = tbSEGCPCMD[i - 1][0] - 'A';
+		tbSEGCPNEXT[i - 1] = tbSEGCPIDX[idx];
+		tbSEGCPIDX[idx] = i - 1;
+	}
+	
+	segcp_idx_ready = SEGCP_ENABLE;
+}
+
 uint8_t parse_SEGCP(uint8_t * pmsg, uint8_t * param)
 {
-	uint8_t** pcmd;
-	uint8_t cmdnum = 0;
+	uint8_t cmdnum = SEGCP_UNKNOWN;
 	uint8_t i;
 
 	*param = 0;
-
-	for(pcmd = tbSEGCPCMD; *pcmd != 0; pcmd++)
+	
+	if(segcp_idx_ready == SEGCP_DISABLE) init_SEGCP_index();
+	
+	// Command: [A-Z] + 1 character, found by the first character index
+	if((pmsg[0] >= 'A') && (pmsg[0] <= 'Z'))
 	{
-		if(!strncmp((char *)pmsg, *pcmd, strlen(*pcmd))) break;
+		for(cmdnum = tbSEGCPIDX[pmsg[0] - 'A']; cmdnum != SEGCP_UNKNOWN; cmdnum = tbSEGCPNEXT[cmdnum])
+		{
+			if(tbSEGCPCMD[cmdnum][1] == pmsg[1]) break;
+		}
 	}
 	
-	if(*pcmd == 0) 
+	if(cmdnum == SEGCP_UNKNOWN) 
 	{
 #ifdef _SEGCP_DEBUG_   
 		printf("SEGCP[UNKNOWN]:%s\r\n", pmsg);
@@ -233,8 +301,6 @@ uint8_t parse_SEGCP(uint8_t * pmsg, uint8_t * param)
 		return SEGCP_UNKNOWN;
 	}
 	
-	cmdnum = (uint8_t)(pcmd - tbSEGCPCMD);
-	
 	if(cmdnum == (uint8_t)SEGCP_MA) 
 	{
 		if((pmsg[8] == '\r') && (pmsg[9] == '\n'))
@@ -268,7 +334,7 @@ uint8_t parse_SEGCP(uint8_t * pmsg, uint8_t * param)
 	}
 
 #ifdef _SEGCP_DEBUG_
-	printf("SEGCP[%d:%s:", cmdnum, *pcmd);
+	printf("SEGCP[%d:%s:", cmdnum, tbSEGCPCMD[cmdnum]);
 	if(cmdnum == SEGCP_MA)
 	{
 		for(i = 0; i < 6; i++) printf("%.2x", param[i]);
@@ -283,16 +349,160 @@ uint8_t parse_SEGCP(uint8_t * pmsg, uint8_t * param)
 	return cmdnum;
 }
 
-uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
+void segcp_rep_init(uint8_t * buf, uint16_t size, uint8_t out, uint16_t port)
+{
+	segcp_wr.buf = buf;
+	segcp_wr.size = size;
+	segcp_wr.len = 0;
+	segcp_wr.head = 0;
+	segcp_wr.port = port;
+	segcp_wr.out = out;
+	
+	buf[0] = 0;
+}
+
+// Response header: MA + MAC address (6-bytes, binary) and the PW line of the request, sent with each continued response
+void segcp_rep_header(uint8_t * pw, uint16_t pw_len)
+{
+	DevConfig *dev_config = get_DevConfig_pointer();
+	
+	segcp_rep_put(tbSEGCPCMD[SEGCP_MA], SEGCP_CMD_MAX);
+	segcp_rep_put(dev_config->network_info_common.mac, 6);
+	segcp_rep_str(SEGCP_DELIMETER);
+	segcp_rep_put(pw, pw_len);
+	
+	segcp_wr.head = segcp_wr.len;
+}
+
+// Bounded append: the data over the buffer size is dropped
+void segcp_rep_put(const uint8_t * data, uint16_t len)
+{
+	uint16_t room = segcp_wr.size - segcp_wr.len - 1; // null-terminated
+	
+	if(len > room) len = room;
+	
+	memcpy(&segcp_wr.buf[segcp_wr.len], data, len);
+	segcp_wr.len += len;
+	segcp_wr.buf[segcp_wr.len] = 0;
+}
+
+void segcp_rep_str(const char * str)
+{
+	segcp_rep_put((const uint8_t *)str, strlen(str));
+}
+
+void segcp_rep_char(uint8_t ch)
+{
+	segcp_rep_put(&ch, 1);
+}
+
+// Unsigned decimal
+void segcp_rep_dec(uint32_t val)
+{
+	uint8_t digits[10];
+	uint8_t i = sizeof(digits);
+	
+	do {
+		digits[--i] = '0' + (val % 10);
+		val /= 10;
+	} while(val);
+	
+	segcp_rep_put(&digits[i], sizeof(digits) - i);
+}
+
+// Dotted decimal IP address
+void segcp_rep_ip(uint8_t * ip)
+{
+	uint8_t i;
+	
+	for(i = 0; i < 4; i++)
+	{
+		if(i) segcp_rep_char('.');
+		segcp_rep_dec(ip[i]);
+	}
+}
+
+// 2 hex digits per byte
+void segcp_rep_hex(uint8_t * data, uint8_t len, uint8_t lowercase)
+{
+	const char * hexdigits = (lowercase ? "0123456789abcdef" : "0123456789ABCDEF");
+	uint8_t hex[2];
+	uint8_t i;
+	
+	for(i = 0; i < len; i++)
+	{
+		hex[0] = hexdigits[data[i] >> 4];
+		hex[1] = hexdigits[data[i] & 0x0F];
+		segcp_rep_put(hex, 2);
+	}
+}
+
+// Drop the reply written after the length 'len'
+void segcp_rep_rewind(uint16_t len)
+{
+	if(len < segcp_wr.len)
+	{
+		segcp_wr.len = len;
+		segcp_wr.buf[len] = 0;
+	}
+}
+
+// Continues the response when the room is less than 'len': the replies so far are sent and the buffer restarts after the header
+void segcp_rep_reserve(uint16_t len)
+{
+	if((segcp_wr.size - segcp_wr.len - 1) >= len) return;
+	if((segcp_wr.out == SEGCP_REP_NONE) || (segcp_wr.len <= segcp_wr.head)) return;
+	
+	segcp_rep_flush();
+	segcp_rep_rewind(segcp_wr.head);
+}
+
+void segcp_rep_flush(void)
 {
 	DevConfig *dev_config = get_DevConfig_pointer();
 	
-	//uint8_t  i = 0;
+	if(segcp_wr.len == 0) return;
+	
+	switch(segcp_wr.out)
+	{
+		case SEGCP_REP_UDP:
+			sendto(SEGCP_UDP_SOCK, segcp_wr.buf, segcp_wr.len, "\xFF\xFF\xFF\xFF", segcp_wr.port);
+			break;
+		
+		case SEGCP_REP_TCP:
+			send(SEGCP_TCP_SOCK, segcp_wr.buf, segcp_wr.len);
+			break;
+		
+		case SEGCP_REP_UART:
+			if(dev_config->serial_info[0].serial_debug_en == SEGCP_ENABLE)
+			{
+				printf("%s", segcp_wr.buf);
+			}
+			
+			uart_puts(SEG_DATA_UART, segcp_wr.buf, segcp_wr.len);
+			break;
+		
+		default:
+			break;
+	}
+}
+
+uint16_t proc_SEGCP(uint8_t* segcp_req)
+{
+	DevConfig *dev_config = get_DevConfig_pointer();
+	
+	// Data channel settings: channel 1 unless the request selects channel 2 by QC
+	uint8_t  ch = S2E_CH1;
+	const DevConfig_channel *chcfg = get_DevConfig_channel(S2E_CH1);
+	struct __network_info *net = chcfg->network_info;
+	struct __serial_info *serial = chcfg->serial_info;
+	struct __network_info_extend *netx = chcfg->network_info_extend;
+	
+	uint8_t  i = 0;
 	uint16_t ret = 0;
 	uint8_t  cmdnum = 0;
 	uint8_t* treq;
-	//uint8_t* trep = segcp_rep;
-	char * trep = segcp_rep;
+	uint16_t mark = 0; // Response length before the reply of the current command
 	uint16_t param_len = 0;
 	
 	uint8_t  io_num = 0;
@@ -302,16 +512,19 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 	uint8_t  tmp_byte = 0;
 	uint16_t tmp_int = 0;
 	uint32_t tmp_long = 0;
+	char * tmp_str;
 	
 	uint8_t tmp_ip[4];
 	
+	const char * task_name;
+	uint32_t task_msec, task_usec, task_runs;
+	
 
 	uint8_t param[SEGCP_PARAM_MAX*2];
 	
 #ifdef _SEGCP_DEBUG_   
 	printf("SEGCP_REQ : %s\r\n",segcp_req);
 #endif
-	memset(trep, 0, sizeof(trep));
 	treq = strtok(segcp_req, SEGCP_DELIMETER);
 	
 	while(treq)
@@ -319,145 +532,164 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 #ifdef _SEGCP_DEBUG_   
 		printf("SEGCP_REQ_TOK : %s\r\n",treq);
 #endif
+		mark = segcp_wr.len;
+		
 		if((cmdnum = parse_SEGCP(treq, param)) != SEGCP_UNKNOWN)
 		{
 			param_len = strlen(param);
 			
 			if(*param == 0)
 			{
-				memcpy(trep, tbSEGCPCMD[cmdnum], SEGCP_CMD_MAX);
-				trep+=SEGCP_CMD_MAX;
+				segcp_rep_reserve(SEGCP_REPLY_MAX);
+				mark = segcp_wr.len;
+				segcp_rep_put(tbSEGCPCMD[cmdnum], SEGCP_CMD_MAX);
 				
 				switch((teSEGCPCMDNUM)cmdnum)
 				{
-					case SEGCP_MC: sprintf(trep,"%02X:%02X:%02X:%02X:%02X:%02X", 
-											dev_config->network_info_common.mac[0], dev_config->network_info_common.mac[1], dev_config->network_info_common.mac[2],
-											dev_config->network_info_common.mac[3], dev_config->network_info_common.mac[4], dev_config->network_info_common.mac[5]);
-						break;
-					case SEGCP_VR: 
-						if(strcmp(STR_VERSION_STATUS, "Develop") == 0)
-						{
-							// Develop version 
-							sprintf(trep,"%d.%d.%ddev", dev_config->fw_ver[0], dev_config->fw_ver[1], dev_config->fw_ver[2]);
-						}
-						else
+					case SEGCP_MC:
+						for(i = 0; i < 6; i++)
 						{
-							sprintf(trep,"%d.%d.%d", dev_config->fw_ver[0], dev_config->fw_ver[1], dev_config->fw_ver[2]);
+							if(i) segcp_rep_char(':');
+							segcp_rep_hex(&dev_config->network_info_common.mac[i], 1, SEGCP_DISABLE);
 						}
 						break;
-					case SEGCP_MN: sprintf(trep,"%s", dev_config->module_name);
+					case SEGCP_VR: 
+						segcp_rep_dec(dev_config->fw_ver[0]);
+						segcp_rep_char('.');
+						segcp_rep_dec(dev_config->fw_ver[1]);
+						segcp_rep_char('.');
+						segcp_rep_dec(dev_config->fw_ver[2]);
+						
+						// Develop version 
+						if(strcmp(STR_VERSION_STATUS, "Develop") == 0) segcp_rep_str("dev");
 						break;
-					case SEGCP_IM: sprintf(trep,"%d", dev_config->options.dhcp_use);	// 0:STATIC, 1:DHCP (PPPoE X)
+					case SEGCP_MN: segcp_rep_str(dev_config->module_name);
 						break;
-					case SEGCP_OP: sprintf(trep,"%d", dev_config->network_info[0].working_mode); // opmode
+					case SEGCP_IM: segcp_rep_dec(dev_config->options.dhcp_use);	// 0:STATIC, 1:DHCP (PPPoE X)
+						break;
+					case SEGCP_OP: segcp_rep_dec(net->working_mode); // opmode
 						break;
 					//case SEGCP_DD: sprintf(trep,"%d", tsvDEVCONFnew.ddns_en);
-					case SEGCP_DD: sprintf(trep,"%d", 0);
+					case SEGCP_DD: segcp_rep_dec(0);
 						break;
-					//case SEGCP_PO: sprintf(trep,"%d", tsvDEVCONFnew.telnet_en[0]);
-					case SEGCP_PO: sprintf(trep,"%d", 0);
+					case SEGCP_PO: segcp_rep_dec(chcfg->telnet_en[0]); // 0:RAW, 1:TELNET (RFC 2217)
 						break;
-					case SEGCP_CP: sprintf(trep,"%d", dev_config->options.pw_connect_en);
+					case SEGCP_CP: segcp_rep_dec(*chcfg->pw_connect_en);
 						break;
-					case SEGCP_DG: sprintf(trep,"%d", dev_config->serial_info[0].serial_debug_en);
+					case SEGCP_DG: segcp_rep_dec(dev_config->serial_info[0].serial_debug_en);
 						break;
-					case SEGCP_KA: sprintf(trep,"%d", dev_config->network_info[0].keepalive_en);
+					case SEGCP_KA: segcp_rep_dec(net->keepalive_en);
 						break;
-					case SEGCP_KI: sprintf(trep,"%d", dev_config->network_info[0].keepalive_wait_time);
+					case SEGCP_KI: segcp_rep_dec(net->keepalive_wait_time);
 						break;
-					case SEGCP_KE: sprintf(trep,"%d", dev_config->network_info[0].keepalive_retry_time);
+					case SEGCP_KE: segcp_rep_dec(net->keepalive_retry_time);
 						break;
-					case SEGCP_RI: sprintf(trep,"%d", dev_config->network_info[0].reconnection);
+					case SEGCP_RI: segcp_rep_dec(net->reconnection);
 						break;
 					case SEGCP_LI:
-						sprintf(trep,"%d.%d.%d.%d", dev_config->network_info_common.local_ip[0], dev_config->network_info_common.local_ip[1],
-													dev_config->network_info_common.local_ip[2], dev_config->network_info_common.local_ip[3]);
+						segcp_rep_ip(dev_config->network_info_common.local_ip);
 						break;
 					case SEGCP_SM: 
-						sprintf(trep,"%d.%d.%d.%d", dev_config->network_info_common.subnet[0], dev_config->network_info_common.subnet[1],
-													dev_config->network_info_common.subnet[2], dev_config->network_info_common.subnet[3]);
+						segcp_rep_ip(dev_config->network_info_common.subnet);
 						break;
 					case SEGCP_GW: 
-						sprintf(trep,"%d.%d.%d.%d", dev_config->network_info_common.gateway[0], dev_config->network_info_common.gateway[1],
-													dev_config->network_info_common.gateway[2], dev_config->network_info_common.gateway[3]);
+						segcp_rep_ip(dev_config->network_info_common.gateway);
 						break;
 					case SEGCP_DS:
-						sprintf(trep,"%d.%d.%d.%d", dev_config->options.dns_server_ip[0], dev_config->options.dns_server_ip[1],
-													dev_config->options.dns_server_ip[2], dev_config->options.dns_server_ip[3]);
+						segcp_rep_ip(dev_config->options.dns_server_ip);
 						break;
 					case SEGCP_PI:
 						//if(tsvDEVCONFnew.pppoe_id[0] == 0) sprintf(trep,"%c",SEGCP_NULL);
 						//else sprintf(trep,"%s",tsvDEVCONFnew.pppoe_id);
-						sprintf(trep,"%c", SEGCP_NULL);
+						segcp_rep_char(SEGCP_NULL);
 						break;
 					case SEGCP_PP: 
 						//if(tsvDEVCONFnew.pppoe_pass[0] == 0) sprintf(trep,"%c",SEGCP_NULL);
 						//sprintf(trep,"%s",tsvDEVCONFnew.pppoe_pass);
-						sprintf(trep,"%c",SEGCP_NULL);
+						segcp_rep_char(SEGCP_NULL);
 						break;
 					//case SEGCP_DX: sprintf(trep,"%d",tsvDEVCONFnew.ddns_index);
-					case SEGCP_DX: sprintf(trep,"%d", 0);
+					case SEGCP_DX: segcp_rep_dec(0);
 						break;
 					//case SEGCP_DP: sprintf(trep,"%d",tsvDEVCONFnew.ddns_port);
-					case SEGCP_DP: sprintf(trep,"%d", DEVICE_DDNS_PORT);
+					case SEGCP_DP: segcp_rep_dec(DEVICE_DDNS_PORT);
 						break;
 					//case SEGCP_DI: sprintf(trep,"%s",tsvDEVCONFnew.ddns_id);
-					case SEGCP_DI: sprintf(trep,"%c", SEGCP_NULL);
+					case SEGCP_DI: segcp_rep_char(SEGCP_NULL);
 						break;
 					case SEGCP_DW: 
 						//if(tsvDEVCONFnew.ddns_pass[0] == 0) sprintf(trep,"%c",SEGCP_NULL);
 						//else sprintf(trep,"%s",tsvDEVCONFnew.ddns_pass);
-						sprintf(trep, "%c", SEGCP_NULL);
+						segcp_rep_char(SEGCP_NULL);
 						break;
 					case SEGCP_DH:
-						if(dev_config->module_name[0] == 0) sprintf(trep,"%c",SEGCP_NULL);
-						else sprintf(trep, "%s-%02x%02x%02x", dev_config->module_name, dev_config->network_info_common.mac[3], dev_config->network_info_common.mac[4], dev_config->network_info_common.mac[5]);
+						if(dev_config->module_name[0] == 0) segcp_rep_char(SEGCP_NULL);
+						else
+						{
+							segcp_rep_str(dev_config->module_name);
+							segcp_rep_char('-');
+							segcp_rep_hex(&dev_config->network_info_common.mac[3], 3, SEGCP_ENABLE);
+						}
 						break;
-					case SEGCP_LP: sprintf(trep, "%d", dev_config->network_info[0].local_port);
+					case SEGCP_LP: segcp_rep_dec(net->local_port);
 						break;
-					case SEGCP_RP: sprintf(trep, "%d", dev_config->network_info[0].remote_port);
+					case SEGCP_RP: segcp_rep_dec(net->remote_port);
 						break;
 					case SEGCP_RH: 
-						if(dev_config->options.dns_use == SEGCP_DISABLE)
+						if((ch != S2E_CH1) || (dev_config->options.dns_use == SEGCP_DISABLE)) // Channel 2: IP address only
 						{
-							sprintf(trep, "%d.%d.%d.%d", dev_config->network_info[0].remote_ip[0], dev_config->network_info[0].remote_ip[1],
-														dev_config->network_info[0].remote_ip[2], dev_config->network_info[0].remote_ip[3]);
+							segcp_rep_ip(net->remote_ip);
 						}
 						else
 						{
-							if(dev_config->options.dns_domain_name[0] == 0) sprintf(trep, "%c", SEGCP_NULL);
-							else sprintf(trep, "%s", dev_config->options.dns_domain_name);
+							if(dev_config->options.dns_domain_name[0] == 0) segcp_rep_char(SEGCP_NULL);
+							else segcp_rep_str(dev_config->options.dns_domain_name);
 						}
 						break;
-					case SEGCP_BR: sprintf(trep, "%d", dev_config->serial_info[0].baud_rate);
+					case SEGCP_BR: segcp_rep_dec(serial->baud_rate);
 						break;
-					case SEGCP_DB: sprintf(trep, "%d", dev_config->serial_info[0].data_bits);
+					case SEGCP_DB: segcp_rep_dec(serial->data_bits);
 						break;
-					case SEGCP_PR: sprintf(trep, "%d", dev_config->serial_info[0].parity);
+					case SEGCP_PR: segcp_rep_dec(serial->parity);
 						break;
-					case SEGCP_SB: sprintf(trep, "%d", dev_config->serial_info[0].stop_bits);
+					case SEGCP_SB: segcp_rep_dec(serial->stop_bits);
 						break;
-					case SEGCP_FL: sprintf(trep, "%d", dev_config->serial_info[0].flow_control);
+					case SEGCP_FL: segcp_rep_dec(serial->flow_control);
 						break;
-					case SEGCP_IT: sprintf(trep, "%d", dev_config->network_info[0].inactivity);
+					case SEGCP_IT: segcp_rep_dec(net->inactivity);
 						break;
-					case SEGCP_PT: sprintf(trep, "%d", dev_config->network_info[0].packing_time);
+					case SEGCP_PT:
+						if(netx->packing_time_unit == PACKING_TIME_UNIT_HALF_CHAR)
+						{
+							segcp_rep_dec(net->packing_time / 2);
+							segcp_rep_char('.');
+							segcp_rep_dec((net->packing_time % 2) * 5);
+							segcp_rep_char('c');
+						}
+						else
+						{
+							segcp_rep_dec(net->packing_time);
+							if(netx->packing_time_unit == PACKING_TIME_UNIT_USEC) segcp_rep_char('u');
+						}
 						break;
-					case SEGCP_PS: sprintf(trep, "%d", dev_config->network_info[0].packing_size);
+					case SEGCP_PS: segcp_rep_dec(net->packing_size);
 						break;
-					case SEGCP_PD: sprintf(trep, "%02X", dev_config->network_info[0].packing_delimiter[0]);
+					case SEGCP_PD:
+						// The first byte is always shown (00: no delimiter)
+						tmp_byte = net->packing_delimiter_length;
+						segcp_rep_hex(net->packing_delimiter, (tmp_byte ? tmp_byte : 1), SEGCP_DISABLE);
 						break;
-					case SEGCP_TE: sprintf(trep, "%d", dev_config->options.serial_command);
+					case SEGCP_TE: segcp_rep_dec(dev_config->options.serial_command);
 						break;
-					case SEGCP_SS: sprintf(trep, "%02X%02X%02X", dev_config->options.serial_trigger[0], dev_config->options.serial_trigger[1], dev_config->options.serial_trigger[2]);
+					case SEGCP_SS: segcp_rep_hex(dev_config->options.serial_trigger, 3, SEGCP_DISABLE);
 						break;
 					case SEGCP_NP:
-						if(dev_config->options.pw_connect[0] == 0) sprintf(trep,"%c",SEGCP_NULL);
-						else sprintf(trep, "%s", dev_config->options.pw_connect);
+						if(chcfg->pw_connect[0] == 0) segcp_rep_char(SEGCP_NULL);
+						else segcp_rep_str(chcfg->pw_connect);
 						break;
 					case SEGCP_SP:
-						if(dev_config->options.pw_search[0] == 0) sprintf(trep,"%c",SEGCP_NULL);
-						else sprintf(trep, "%s", dev_config->options.pw_search);
+						if(dev_config->options.pw_search[0] == 0) segcp_rep_char(SEGCP_NULL);
+						else segcp_rep_str(dev_config->options.pw_search);
 						break;
 					case SEGCP_LG: 
 					case SEGCP_ER: 
@@ -474,7 +706,7 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 					case SEGCP_GC:
 					case SEGCP_GD:
 						io_num = (teSEGCPCMDNUM)cmdnum - SEGCP_GA;
-						if(get_user_io_val(USER_IO_SEL[io_num], &tmp_int) != 0) sprintf(trep, "%d", tmp_int);
+						if(get_user_io_val(USER_IO_SEL[io_num], &tmp_int) != 0) segcp_rep_dec(tmp_int);
 						else ret |= SEGCP_RET_ERR_NOTAVAIL;
 						break;
 					
@@ -486,26 +718,29 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 						io_num = (teSEGCPCMDNUM)cmdnum - SEGCP_CA;
 						io_type = get_user_io_type(USER_IO_SEL[io_num]);
 						io_dir = get_user_io_direction(USER_IO_SEL[io_num]);
-						sprintf(trep, "%d", (((io_type & 0x01) << 1) | io_dir));
+						segcp_rep_dec((((io_type & 0x01) << 1) | io_dir));
 						//sprintf(trep, "%d%d", get_user_io_type(USER_IO_SEL[io_num]), get_user_io_direction(USER_IO_SEL[io_num]));
 						break;
 ///////////////////////////////////////////////////////////////////////////////////////////////
 // Status Pins
 					// GET Status pin's setting and status
 					case SEGCP_SC: // mode select
-						sprintf(trep, "%d%d", dev_config->serial_info[0].dtr_en, dev_config->serial_info[0].dsr_en);
+						segcp_rep_dec(dev_config->serial_info[0].dtr_en);
+						segcp_rep_dec(dev_config->serial_info[0].dsr_en);
 						break;
 					case SEGCP_S0:
-						sprintf(trep, "%d", get_connection_status_io(STATUS_PHYLINK_PIN)); // STATUS_PHYLINK_PIN (in) == DTR_PIN (out)
+						segcp_rep_dec(get_connection_status_io(STATUS_PHYLINK_PIN)); // STATUS_PHYLINK_PIN (in) == DTR_PIN (out)
 						break;
 					case SEGCP_S1:
-						sprintf(trep, "%d", get_connection_status_io(STATUS_TCPCONNECT_PIN)); // STATUS_TCPCONNECT_PIN (in) == DSR_PIN (in)
+						segcp_rep_dec(get_connection_status_io(STATUS_TCPCONNECT_PIN)); // STATUS_TCPCONNECT_PIN (in) == DSR_PIN (in)
 						break;
 ///////////////////////////////////////////////////////////////////////////////////////////////
 // UART Rx flush
 					case SEGCP_RX:
-						uart_rx_flush(SEG_DATA_UART);
-						sprintf(trep, "%s", "FLUSH");
+						lock_seg_data_path();
+						uart_rx_flush(S2E_CHANNEL_UART(ch));
+						unlock_seg_data_path();
+						segcp_rep_str("FLUSH");
 						//ret |= SEGCP_RET_ERR_NOTAVAIL;
 						break;
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -513,9 +748,9 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 					case SEGCP_FS: // Firmware update by HTTP Server
 						dev_config->firmware_update.fwup_flag = SEGCP_ENABLE;
 						dev_config->firmware_update_extend.fwup_server_flag = SEGCP_ENABLE;
-						process_socket_termination(SEG_SOCK);
+						process_data_sockets_termination();
 						
-						sprintf(trep, "%s%s", FWUP_SERVER_DOMAIN, FWUP_SERVER_BINPATH);
+						segcp_rep_str(FWUP_SERVER_DOMAIN FWUP_SERVER_BINPATH);
 						ret |= SEGCP_RET_FWUP_SERVER;
 #ifdef _SEGCP_DEBUG_
 						printf("SEGCP_FS:OK\r\n");
@@ -523,18 +758,18 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 						break;
 					
 					case SEGCP_FC: // Firmware update by HTTP Server using default server info enable / disable
-						sprintf(trep, "%d", dev_config->firmware_update_extend.fwup_server_use_default);
+						segcp_rep_dec(dev_config->firmware_update_extend.fwup_server_use_default);
 						break;
 					
 					case SEGCP_FP: // Firmware update HTTP Server Port
-						sprintf(trep, "%d", dev_config->firmware_update_extend.fwup_server_port);
+						segcp_rep_dec(dev_config->firmware_update_extend.fwup_server_port);
 						break;
 
 					case SEGCP_FD: // HTTP Server domain for Firmware update
 #ifdef FWUP_SERVER_DOMAIN
-						sprintf(trep, "%s", FWUP_SERVER_DOMAIN);
+						segcp_rep_str(FWUP_SERVER_DOMAIN);
 #else
-						sprintf(trep,"%c",SEGCP_NULL);
+						segcp_rep_char(SEGCP_NULL);
 #endif
 						// Planned to change
 						//if(dev_config->dev_config->firmware_update_extend.fwup_server_domain[0] == 0) sprintf(trep,"%c",SEGCP_NULL);
@@ -543,9 +778,9 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 					
 					case SEGCP_FH: // Firmware file path in HTTP server for Firmware update
 #ifdef FWUP_SERVER_BINPATH
-						sprintf(trep, "%s", FWUP_SERVER_BINPATH);
+						segcp_rep_str(FWUP_SERVER_BINPATH);
 #else
-						sprintf(trep,"%c",SEGCP_NULL);
+						segcp_rep_char(SEGCP_NULL);
 #endif
 						// Planned to change
 						//if(dev_config->dev_config->firmware_update_extend.fwup_server_binpath[0] == 0) sprintf(trep,"%c",SEGCP_NULL);
@@ -566,45 +801,108 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 						break;
 					case SEGCP_UN:
 						// NEW: UART Interface String - TTL/RS-232 or RS-422/485
-						sprintf(trep, "%s", uart_if_table[dev_config->serial_info[0].uart_interface]);
+						segcp_rep_str(uart_if_table[dev_config->serial_info[0].uart_interface]);
 						
 						// OLD: UART COUNT
 						//sprintf(trep, "%d", DEVICE_UART_CNT); 
 						break;
 					case SEGCP_UI: 
 						// NEW: UART Interface Number- [0] TTL/RS-232 or [1] RS-422/485
-						sprintf(trep, "%d", dev_config->serial_info[0].uart_interface);
+						segcp_rep_dec(dev_config->serial_info[0].uart_interface);
+						break;
+					case SEGCP_RB: // RS-485 driver enable -> Tx start delay (bit time)
+						segcp_rep_dec(dev_config->serial_info_extend[0].rs485_pre_delay);
+						break;
+					case SEGCP_RA: // RS-485 Tx complete -> driver disable delay (bit time)
+						segcp_rep_dec(dev_config->serial_info_extend[0].rs485_post_delay);
+						break;
+					case SEGCP_BP: // H/W socket buffer profile - [0] Balanced, [1] Throughput, [2] Multi-session
+						segcp_rep_dec(dev_config->network_info_extend[0].sock_buf_profile);
+						break;
+					case SEGCP_MS: // TCP server mode: max concurrent client sessions
+						segcp_rep_dec(netx->tcp_server_sessions);
+						break;
+					case SEGCP_AR: // TCP server multi-session: serial line arbitration timeout (msec), [0] disabled
+						segcp_rep_dec(netx->arbitration_timeout);
+						break;
+					case SEGCP_PA: // Data packing delimiter: appendix bytes sent after the delimiter (0 ~ 2)
+						segcp_rep_dec(net->packing_data_appendix);
+						break;
+					case SEGCP_PC: // Data packing coalesce to MSS: latency budget (msec), [0] disabled
+						segcp_rep_dec(netx->packing_coalesce_time);
+						break;
+					case SEGCP_UD: // UDP mode 1:N: [0] reply to the last peer, [1] all live peers, [2] round-robin
+						segcp_rep_dec(netx->udp_peer_delivery);
+						break;
+					case SEGCP_UA: // UDP mode 1:N: peer table aging time (sec), [0] no aging
+						segcp_rep_dec(netx->udp_peer_aging);
 						break;
-					case SEGCP_ST: sprintf(trep, "%s", strDEVSTATUS[dev_config->network_info[0].state]);
+					case SEGCP_UM: // UDP mode: multicast group, [0.0.0.0] disabled
+						segcp_rep_ip(netx->udp_multicast_ip);
+						break;
+					case SEGCP_IF: // Immediate flush mode: [0] disabled, [1] enabled
+						segcp_rep_dec(netx->immediate_flush);
+						break;
+					case SEGCP_LS: // Serial to Ethernet latency (usec): p50,p99,max,samples
+						segcp_rep_dec(get_u2e_latency_usec(50));
+						segcp_rep_char(',');
+						segcp_rep_dec(get_u2e_latency_usec(99));
+						segcp_rep_char(',');
+						segcp_rep_dec(get_u2e_latency_usec(100));
+						segcp_rep_char(',');
+						segcp_rep_dec(get_u2e_latency_count());
+						break;
+					case SEGCP_TS: // Main loop tasks: name:run time (msec)/max time slice (usec)/runs, ...
+						for(i = 0; get_task_status(i, &task_name, &task_msec, &task_usec, &task_runs); i++)
+						{
+							if(i) segcp_rep_char(',');
+							segcp_rep_str(task_name);
+							segcp_rep_char(':');
+							segcp_rep_dec(task_msec);
+							segcp_rep_char('/');
+							segcp_rep_dec(task_usec);
+							segcp_rep_char('/');
+							segcp_rep_dec(task_runs);
+						}
+						break;
+					case SEGCP_QC: // Data channel of the following commands in the request: [1] channel 1, [2] channel 2
+						segcp_rep_dec(ch + 1);
+						break;
+					case SEGCP_QE: // Dual data UART mode: channel 2 [0] disabled, [1] enabled
+#ifdef __USE_DUAL_DATA_UART__
+						segcp_rep_dec(get_DevConfig_ch2_pointer()->channel_en);
+#else
+						ret |= SEGCP_RET_ERR_NOTAVAIL;
+#endif
+						break;
+					case SEGCP_ST: segcp_rep_str(strDEVSTATUS[net->state]);
 						break;
 					case SEGCP_FR: 
 						if(gSEGCPPRIVILEGE & (SEGCP_PRIVILEGE_SET|SEGCP_PRIVILEGE_WRITE)) ret |= SEGCP_RET_FACTORY | SEGCP_RET_REBOOT;
 						else ret |= SEGCP_RET_ERR_NOPRIVILEGE;
 						break;
 					case SEGCP_EC:
-						sprintf(trep,"%d",dev_config->options.serial_command_echo);
+						segcp_rep_dec(dev_config->options.serial_command_echo);
 						break;
 					case SEGCP_K1:
 						ret |= SEGCP_RET_ERASE_EEPROM | SEGCP_RET_REBOOT;
 						break;
 					case SEGCP_UE: // User echo, not used.
-						sprintf(trep, "%d", 0);
+						segcp_rep_dec(0);
 						break;
 					default:
 						ret |= SEGCP_RET_ERR_NOCOMMAND;
-						sprintf(trep,"%s", strDEVSTATUS[dev_config->network_info[0].state]);
+						segcp_rep_str(strDEVSTATUS[dev_config->network_info[0].state]);
 						break;
 				}
 				
 				if(ret & (SEGCP_RET_ERR | SEGCP_RET_REBOOT | SEGCP_RET_SWITCH | SEGCP_RET_SAVE))
 				{
-					trep -= SEGCP_CMD_MAX;
-					*trep = 0;
+					segcp_rep_rewind(mark);
 				}
 				else
 				{
-					strcat(trep, SEGCP_DELIMETER);
-					trep += strlen(trep);
+					segcp_rep_str(SEGCP_DELIMETER);
 				}
 			}
 			else if(gSEGCPPRIVILEGE & (SEGCP_PRIVILEGE_SET|SEGCP_PRIVILEGE_WRITE))
@@ -626,14 +924,15 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 						break;
 					case SEGCP_OP: 
 						tmp_byte = is_hex(*param);
-						if(param_len != 1 || tmp_byte > UDP_MODE)
+						if(param_len != 1 || tmp_byte > MODBUS_TCP_MODE)
 						{
 							ret |= SEGCP_RET_ERR_INVALIDPARAM;
 						}
 						else
 						{
-							process_socket_termination(SEG_SOCK);
-							dev_config->network_info[0].working_mode = tmp_byte;
+							process_data_channel_termination(ch);
+							net->working_mode = tmp_byte;
+							init_seg_rx_gap_timer(ch);
 						}
 						break;
 				   case SEGCP_DD: // ## Does nothing
@@ -642,16 +941,15 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 						tmp_byte = is_hex(*param);
 						if(param_len != 1 || tmp_byte > SEGCP_ENABLE) ret |= SEGCP_RET_ERR_INVALIDPARAM;
 						break;               
-					case SEGCP_PO: // ## Does nothing
-						//if(param_len != 1 || tmp_byte > SEGCP_TELNET) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						//else tsvDEVCONFnew.telnet_en[0] = tmp_byte;
+					case SEGCP_PO: // Applied from the next data connection
 						tmp_byte = is_hex(*param);
 						if(param_len != 1 || tmp_byte > SEGCP_TELNET) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else chcfg->telnet_en[0] = tmp_byte;
 						break;
 					case SEGCP_CP:
 						tmp_byte = is_hex(*param);
 						if(param_len != 1 || tmp_byte > SEGCP_ENABLE) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->options.pw_connect_en = tmp_byte;
+						else *chcfg->pw_connect_en = tmp_byte;
 						break;
 					case SEGCP_DG:
 						tmp_byte = is_hex(*param);
@@ -661,22 +959,22 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 					case SEGCP_KA:
 						tmp_byte = is_hex(*param);
 						if(param_len != 1 || tmp_byte > SEGCP_ENABLE) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->network_info[0].keepalive_en = tmp_byte;
+						else net->keepalive_en = tmp_byte;
 						break;
 					case SEGCP_KI:
 						sscanf(param,"%ld", &tmp_long);
 						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->network_info[0].keepalive_wait_time = (uint16_t) tmp_long;
+						else net->keepalive_wait_time = (uint16_t) tmp_long;
 						break;
 					case SEGCP_KE:
 						sscanf(param,"%ld", &tmp_long);
 						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->network_info[0].keepalive_retry_time = (uint16_t) tmp_long;
+						else net->keepalive_retry_time = (uint16_t) tmp_long;
 						break;
 					case SEGCP_RI:
 						sscanf(param,"%ld", &tmp_long);
 						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->network_info[0].reconnection = (uint16_t) tmp_long;
+						else net->reconnection = (uint16_t) tmp_long;
 						break;
 					case SEGCP_LI:
 						if(is_ipaddr(param, tmp_ip))
@@ -784,21 +1082,25 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 					case SEGCP_LP:
 						sscanf(param,"%ld", &tmp_long);
 						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->network_info[0].local_port = (uint16_t)tmp_long;
+						else net->local_port = (uint16_t)tmp_long;
 						break;
 					case SEGCP_RP:
 						sscanf(param,"%ld", &tmp_long);
 						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;                  
-						else dev_config->network_info[0].remote_port = (uint16_t)tmp_long;
+						else net->remote_port = (uint16_t)tmp_long;
 						break;
 					case SEGCP_RH:
 						if(is_ipaddr(param, tmp_ip))
 						{
-							dev_config->options.dns_use = SEGCP_DISABLE;
-							dev_config->network_info[0].remote_ip[0] = tmp_ip[0];
-							dev_config->network_info[0].remote_ip[1] = tmp_ip[1];
-							dev_config->network_info[0].remote_ip[2] = tmp_ip[2];
-							dev_config->network_info[0].remote_ip[3] = tmp_ip[3];
+							if(ch == S2E_CH1) dev_config->options.dns_use = SEGCP_DISABLE;
+							net->remote_ip[0] = tmp_ip[0];
+							net->remote_ip[1] = tmp_ip[1];
+							net->remote_ip[2] = tmp_ip[2];
+							net->remote_ip[3] = tmp_ip[3];
+						}
+						else if((ch != S2E_CH1) || (param_len > DEVCONF_DOMAIN_MAX)) // Channel 2: the domain name is not supported
+						{
+							ret |= SEGCP_RET_ERR_INVALIDPARAM;
 						}
 						else
 						{
@@ -811,70 +1113,97 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 					case SEGCP_BR:
 						sscanf(param, "%d", &tmp_int);
 						if(param_len > 2 || tmp_int > baud_230400) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->serial_info[0].baud_rate = (uint8_t)tmp_int;
+						else serial->baud_rate = (uint8_t)tmp_int;
 						break;
 					case SEGCP_DB:
 						tmp_byte = is_hex(*param);
 						if(param_len != 1 || tmp_byte > word_len8) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->serial_info[0].data_bits = tmp_byte;
+						else serial->data_bits = tmp_byte;
 						break;
 					case SEGCP_PR:
 						tmp_byte = is_hex(*param);
 						if(param_len != 1 || tmp_byte > parity_even) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->serial_info[0].parity = tmp_byte;
+						else serial->parity = tmp_byte;
 						break;
 					case SEGCP_SB:
 						tmp_byte = is_hex(*param);
 						if(param_len != 1 || tmp_byte > stop_bit2) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->serial_info[0].stop_bits = tmp_byte;
+						else serial->stop_bits = tmp_byte;
 						break;
 					case SEGCP_FL:
 						tmp_byte = is_hex(*param);
-						if(param_len != 1 || tmp_byte > flow_rts_cts)
+						if(param_len != 1 || tmp_byte > flow_rts_cts || ((ch != S2E_CH1) && (tmp_byte != flow_none))) // Channel 2: no flow control
 						{
 							ret |= SEGCP_RET_ERR_INVALIDPARAM;
 						}
 						else
 						{
-							if(dev_config->serial_info[0].uart_interface == UART_IF_RS422_485)
+							if(serial->uart_interface == UART_IF_RS422_485)
 							{
-								dev_config->serial_info[0].flow_control = flow_none;
+								serial->flow_control = flow_none;
 							}
 							else
 							{
-								dev_config->serial_info[0].flow_control = tmp_byte;
+								serial->flow_control = tmp_byte;
 							}
 						}
 						break;
 					case SEGCP_IT:
 						sscanf(param, "%ld", &tmp_long);
 						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->network_info[0].inactivity = (uint16_t)tmp_long;
+						else net->inactivity = (uint16_t)tmp_long;
 						break;
 					case SEGCP_PT:
+						// Unit suffix: [none] msec, [u] usec, [c] character times in 0.5 steps (e.g., 3.5c)
+						// [u] / [c]: the gap time is not shorter than the UART Rx timeout (32 bit times), a shorter value is raised to it
+						tmp_byte = PACKING_TIME_UNIT_MSEC;
+						tmp_int = 0; // [0] .0 / [1] .5 / [2] invalid fraction
+						if((param[param_len-1] == 'u') || (param[param_len-1] == 'U')) tmp_byte = PACKING_TIME_UNIT_USEC;
+						else if((param[param_len-1] == 'c') || (param[param_len-1] == 'C')) tmp_byte = PACKING_TIME_UNIT_HALF_CHAR;
+						if(tmp_byte != PACKING_TIME_UNIT_MSEC) param[--param_len] = 0;
+						
+						if((tmp_byte == PACKING_TIME_UNIT_HALF_CHAR) && ((tmp_str = strchr((char *)param, '.')) != NULL))
+						{
+							if(!strcmp(tmp_str, ".5")) tmp_int = 1;
+							else if(strcmp(tmp_str, ".0")) tmp_int = 2;
+							*tmp_str = 0;
+						}
+						
+						tmp_long = 0;
 						sscanf(param, "%ld", &tmp_long);
-						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->network_info[0].packing_time = (uint16_t)tmp_long;
+						if(tmp_byte == PACKING_TIME_UNIT_HALF_CHAR) tmp_long = (tmp_long * 2) + tmp_int;
+						
+						if((param_len == 0) || (tmp_int > 1) || (tmp_long > 0xFFFF)) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else
+						{
+							net->packing_time = (uint16_t)tmp_long;
+							netx->packing_time_unit = tmp_byte;
+							init_seg_rx_gap_timer(ch);
+						}
 						break;
 					case SEGCP_PS:
-						sscanf(param, "%d", &tmp_int);
-						if(param_len > 3 || tmp_int > 0xFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->network_info[0].packing_size = (uint8_t)tmp_int;
+						sscanf(param, "%ld", &tmp_long);
+						if(param_len > 5 || tmp_long > PACKING_SIZE_MAX) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else net->packing_size = (uint16_t)tmp_long;
 						break;
-					case SEGCP_PD:
-						if(param_len != 2 || !is_hexstr(param))
+					case SEGCP_PD: // 1 ~ 4 bytes delimiter in hex (e.g., 0D0A), [00] disabled
+						if((param_len & 0x01) || (param_len > (sizeof(net->packing_delimiter) * 2)) || !is_hexstr(param))
 						{
 							ret |= SEGCP_RET_ERR_INVALIDPARAM;
 						}
 						else
 						{
-							sscanf(param,"%x", &tmp_int);
-							dev_config->network_info[0].packing_delimiter[0] = (uint8_t)tmp_int;
+							memset(net->packing_delimiter, 0x00, sizeof(net->packing_delimiter));
+							for(i = 0; i < (param_len / 2); i++)
+							{
+								sscanf(&param[i * 2], "%2lx", &tmp_long);
+								net->packing_delimiter[i] = (uint8_t)tmp_long;
+							}
 							
-							if(dev_config->network_info[0].packing_delimiter[0] == 0x00) 
-								dev_config->network_info[0].packing_delimiter_length = 0;
+							if((param_len == 2) && (net->packing_delimiter[0] == 0x00)) 
+								net->packing_delimiter_length = 0;
 							else 
-								dev_config->network_info[0].packing_delimiter_length = 1;
+								net->packing_delimiter_length = (uint8_t)(param_len / 2);
 						}
 						
 						break;
@@ -897,8 +1226,8 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 						}
 						else
 						{
-							if(param[0] == SEGCP_NULL) dev_config->options.pw_connect[0] = 0;
-							else sscanf(param,"%s", &dev_config->options.pw_connect[0]);
+							if(param[0] == SEGCP_NULL) chcfg->pw_connect[0] = 0;
+							else sscanf(param,"%s", chcfg->pw_connect);
 						}
 						break;
 					case SEGCP_SP:
@@ -935,10 +1264,15 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 #endif
 							dev_config->firmware_update.fwup_flag = SEGCP_ENABLE;
 							ret |= SEGCP_RET_FWUP;
-							sprintf(trep,"FW%d.%d.%d.%d:%d:%d\r\n", dev_config->network_info_common.local_ip[0], dev_config->network_info_common.local_ip[1]
-							,dev_config->network_info_common.local_ip[2] , dev_config->network_info_common.local_ip[3], (uint16_t)DEVICE_FWUP_PORT);
+							// FW<local ip>:<firmware update port>
+							segcp_rep_reserve(SEGCP_REPLY_MAX);
+							segcp_rep_str("FW");
+							segcp_rep_ip(dev_config->network_info_common.local_ip);
+							segcp_rep_char(':');
+							segcp_rep_dec(DEVICE_FWUP_PORT);
+							segcp_rep_str(SEGCP_DELIMETER);
 							
-							process_socket_termination(SEG_SOCK);
+							process_data_sockets_termination();
 #ifdef _SEGCP_DEBUG_
 							printf("SEGCP_FW:OK\r\n");
 #endif
@@ -1066,6 +1400,106 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 						if(param_len != 1 || tmp_byte > SEGCP_ENABLE) ret |= SEGCP_RET_ERR_INVALIDPARAM;
 						else ; 
 						break;
+					case SEGCP_RB:
+						sscanf(param, "%d", &tmp_int);
+						if(param_len > 3 || tmp_int > 0xFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else dev_config->serial_info_extend[0].rs485_pre_delay = (uint8_t)tmp_int;
+						break;
+					case SEGCP_RA:
+						sscanf(param, "%d", &tmp_int);
+						if(param_len > 3 || tmp_int > 0xFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else dev_config->serial_info_extend[0].rs485_post_delay = (uint8_t)tmp_int;
+						break;
+					case SEGCP_BP: // applied after reboot
+						tmp_byte = is_hex(*param);
+						if(param_len != 1 || tmp_byte > SOCK_BUF_PROFILE_MAX) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else dev_config->network_info_extend[0].sock_buf_profile = tmp_byte;
+						break;
+					case SEGCP_MS:
+						tmp_byte = is_hex(*param);
+						if(param_len != 1 || tmp_byte < 1 || tmp_byte > TCP_SERVER_SESSIONS_MAX) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else if((ch != S2E_CH1) && (tmp_byte > 1)) ret |= SEGCP_RET_ERR_INVALIDPARAM; // Channel 2: a single session
+						else
+						{
+							process_data_channel_termination(ch);
+							netx->tcp_server_sessions = tmp_byte;
+						}
+						break;
+					case SEGCP_AR:
+						sscanf(param, "%ld", &tmp_long);
+						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else netx->arbitration_timeout = (uint16_t)tmp_long;
+						break;
+					case SEGCP_PA:
+						tmp_byte = is_hex(*param);
+						if(param_len != 1 || tmp_byte > PACKING_DATA_APPENDIX_MAX) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else net->packing_data_appendix = tmp_byte;
+						break;
+					case SEGCP_PC:
+						sscanf(param, "%ld", &tmp_long);
+						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else netx->packing_coalesce_time = (uint16_t)tmp_long;
+						break;
+					case SEGCP_UD:
+						tmp_byte = is_hex(*param);
+						if(param_len != 1 || tmp_byte > UDP_PEER_DELIVERY_MAX) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else netx->udp_peer_delivery = tmp_byte;
+						break;
+					case SEGCP_UA:
+						sscanf(param, "%ld", &tmp_long);
+						if(tmp_long > 0xFFFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else netx->udp_peer_aging = (uint16_t)tmp_long;
+						break;
+					case SEGCP_UM:
+						// Multicast group address (224.0.0.0 ~ 239.255.255.255) or 0.0.0.0
+						if(!is_ipaddr(param, tmp_ip) || ((tmp_ip[0] != 0) && ((tmp_ip[0] < 224) || (tmp_ip[0] > 239))))
+						{
+							ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						}
+						else
+						{
+							process_data_channel_termination(ch); // The data socket is re-opened with the group
+							memcpy(netx->udp_multicast_ip, tmp_ip, sizeof(tmp_ip));
+						}
+						break;
+					case SEGCP_IF:
+						tmp_byte = is_hex(*param);
+						if(param_len != 1 || tmp_byte > IMMEDIATE_FLUSH_ENABLE) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else netx->immediate_flush = tmp_byte;
+						break;
+					case SEGCP_LS: // [0] clear the latency statistics
+						if(param_len != 1 || *param != '0') ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else clear_u2e_latency();
+						break;
+					case SEGCP_TS: // [0] clear the task runtime statistics
+						if(param_len != 1 || *param != '0') ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else clear_task_status();
+						break;
+					case SEGCP_QC:
+						tmp_byte = is_hex(*param);
+						if(param_len != 1 || tmp_byte < 1 || tmp_byte > S2E_CHANNELS) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else
+						{
+							ch = tmp_byte - 1;
+							chcfg = get_DevConfig_channel(ch);
+							net = chcfg->network_info;
+							serial = chcfg->serial_info;
+							netx = chcfg->network_info_extend;
+						}
+						break;
+					case SEGCP_QE:
+#ifdef __USE_DUAL_DATA_UART__
+						tmp_byte = is_hex(*param);
+						if(param_len != 1 || tmp_byte > SEGCP_ENABLE) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else
+						{
+							process_data_channel_termination(S2E_CH2);
+							get_DevConfig_ch2_pointer()->channel_en = tmp_byte;
+						}
+#else
+						ret |= SEGCP_RET_ERR_NOTAVAIL;
+#endif
+						break;
 
 					case SEGCP_UN:
 					case SEGCP_UI:
@@ -1098,11 +1532,19 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 		if(ret & SEGCP_RET_ERR)
 		{
 			treq[2] = 0;
-			sprintf(trep,"%s:%s\r\n",tbSEGCPERR[((ret-SEGCP_RET_ERR) >> 8)],(cmdnum!=SEGCP_UNKNOWN)? tbSEGCPCMD[cmdnum] : treq);
+			segcp_rep_rewind(mark);
+			segcp_rep_reserve(SEGCP_REPLY_MAX);
+			mark = segcp_wr.len;
+			segcp_rep_str(tbSEGCPERR[((ret-SEGCP_RET_ERR) >> 8)]);
+			segcp_rep_char(':');
+			segcp_rep_str((cmdnum!=SEGCP_UNKNOWN)? tbSEGCPCMD[cmdnum] : treq);
+			segcp_rep_str(SEGCP_DELIMETER);
 #ifdef _SEGCP_DEBUG_
-			printf("ERROR : %s\r\n",trep);
+			printf("ERROR : %s\r\n",&segcp_wr.buf[mark]);
 #endif
+			lock_seg_data_path();
 			uart_rx_flush(SEG_DATA_UART);
+			unlock_seg_data_path();
 			return ret;
 		}
 		
@@ -1132,7 +1574,6 @@ uint16_t proc_SEGCP_udp(uint8_t* segcp_req, uint8_t* segcp_rep)
 	
 	uint8_t tpar[SEGCP_PARAM_MAX*2];
 	uint8_t* treq;
-	uint8_t* trep;
 	
 	gSEGCPPRIVILEGE = SEGCP_PRIVILEGE_CLR;
 	switch(getSn_SR(SEGCP_UDP_SOCK))
@@ -1141,7 +1582,6 @@ uint16_t proc_SEGCP_udp(uint8_t* segcp_req, uint8_t* segcp_rep)
 			if((len = getSn_RX_RSR(SEGCP_UDP_SOCK)) > 0)
 			{
 				treq = segcp_req;
-				trep = segcp_rep;
 				len = recvfrom(SEGCP_UDP_SOCK, treq, len, destip, &destport);
 				treq[len-1] = 0;
 
@@ -1153,27 +1593,20 @@ uint16_t proc_SEGCP_udp(uint8_t* segcp_req, uint8_t* segcp_rep)
 					
 					if(gSEGCPPRIVILEGE & SEGCP_PRIVILEGE_SET)
 					{
-						sprintf(trep,"%s%c%c%c%c%c%c\r\n",tbSEGCPCMD[SEGCP_MA],
-							dev_config->network_info_common.mac[0], dev_config->network_info_common.mac[1], dev_config->network_info_common.mac[2],
-							dev_config->network_info_common.mac[3], dev_config->network_info_common.mac[4], dev_config->network_info_common.mac[5]);
-						
 						treq += 10;
-						trep += 10;
 						
 						if(SEGCP_PW == parse_SEGCP(treq, tpar))
 						{
 							if((tpar[0] == SEGCP_NULL && dev_config->options.pw_search[0] == 0) || !strcmp(tpar, dev_config->options.pw_search))
 							{
-								memcpy(trep,treq, strlen(tpar)+4);  // "PWxxxx\r\n"
+								segcp_rep_init(segcp_rep, CONFIG_BUF_SIZE, SEGCP_REP_UDP, destport);
+								segcp_rep_header(treq, strlen(tpar)+4);  // "PWxxxx\r\n"
 								treq += (strlen(tpar) + 4);
-								trep += (strlen(tpar) + 4);
 								
 								//printf(" >> treq: [%s]\r\n", treq);
-								//printf(" >> trep: [%s]\r\n", trep);
 								
-								ret = proc_SEGCP(treq,trep);
-								sendto(SEGCP_UDP_SOCK, segcp_rep, 14+strlen(tpar)+strlen(trep), "\xFF\xFF\xFF\xFF", destport);
-								//sendto(SEGCP_UDP_SOCK, segcp_rep, 14+strlen(tpar)+strlen(trep), destip, destport);
+								ret = proc_SEGCP(treq);
+								segcp_rep_flush();
 							}
 						}
 						
@@ -1209,11 +1642,9 @@ uint16_t proc_SEGCP_tcp(uint8_t* segcp_req, uint8_t* segcp_rep)
 	
 	uint16_t ret = 0;
 	uint16_t len = 0;
-	uint16_t i = 0;
 	
 	uint8_t tpar[SEGCP_PARAM_MAX+1];
 	uint8_t * treq;
-	uint8_t * trep;
 	
 	uint8_t state = getSn_SR(SEGCP_TCP_SOCK);
 	gSEGCPPRIVILEGE = SEGCP_PRIVILEGE_CLR;
@@ -1246,7 +1677,6 @@ uint16_t proc_SEGCP_tcp(uint8_t* segcp_req, uint8_t* segcp_rep)
 			if((len = getSn_RX_RSR(SEGCP_TCP_SOCK)) > 0)
 			{
 				treq = segcp_req;
-				trep = segcp_rep;
 				len = recv(SEGCP_TCP_SOCK,treq,len);
 				treq[len-1] = 0x00;
 
@@ -1258,22 +1688,17 @@ uint16_t proc_SEGCP_tcp(uint8_t* segcp_req, uint8_t* segcp_rep)
 					
 					if(gSEGCPPRIVILEGE & SEGCP_PRIVILEGE_SET)
 					{
-						sprintf(trep,"%s%c%c%c%c%c%c\r\n",tbSEGCPCMD[SEGCP_MA],
-							dev_config->network_info_common.mac[0], dev_config->network_info_common.mac[1], dev_config->network_info_common.mac[2],
-							dev_config->network_info_common.mac[3], dev_config->network_info_common.mac[4], dev_config->network_info_common.mac[5]);
-						
 						treq += 10;
-						trep += 10;
 						
 						if(SEGCP_PW == parse_SEGCP(treq,tpar))
 						{
 							if((tpar[0] == SEGCP_NULL && dev_config->options.pw_search[0] == 0) || !strcmp(tpar, dev_config->options.pw_search))
 							{
-								memcpy(trep,treq, strlen(tpar)+4);  // "PWxxxx\r\n"
+								segcp_rep_init(segcp_rep, CONFIG_BUF_SIZE, SEGCP_REP_TCP, 0);
+								segcp_rep_header(treq, strlen(tpar)+4);  // "PWxxxx\r\n"
 								treq += (strlen(tpar) + 4);
-								trep += (strlen(tpar) + 4);
-								ret = proc_SEGCP(treq,trep);
-								send(SEGCP_TCP_SOCK, segcp_rep, 14+strlen(tpar)+strlen(trep));
+								ret = proc_SEGCP(treq);
+								segcp_rep_flush();
 							}
 						}
 					}
@@ -1313,8 +1738,6 @@ uint16_t proc_SEGCP_tcp(uint8_t* segcp_req, uint8_t* segcp_rep)
 
 uint16_t proc_SEGCP_uart(uint8_t * segcp_rep)
 {
-	DevConfig *dev_config = get_DevConfig_pointer();
-	
 	uint16_t len = 0;
 	uint16_t ret = 0;
 	uint8_t segcp_req[SEGCP_PARAM_MAX*2];
@@ -1326,17 +1749,9 @@ uint16_t proc_SEGCP_uart(uint8_t * segcp_rep)
 		if(len != 0)
 		{
 			gSEGCPPRIVILEGE = SEGCP_PRIVILEGE_SET | SEGCP_PRIVILEGE_WRITE;
-			ret = proc_SEGCP(segcp_req, segcp_rep);
-			if(segcp_rep[0])
-			{
-				if(dev_config->serial_info[0].serial_debug_en == SEGCP_ENABLE)
-				{
-					printf("%s",segcp_rep);
-				}
-				
-				uart_puts(SEG_DATA_UART, segcp_rep, strlen(segcp_rep));
-				
-			}
+			segcp_rep_init(segcp_rep, CONFIG_BUF_SIZE, SEGCP_REP_UART, 0);
+			ret = proc_SEGCP(segcp_req);
+			segcp_rep_flush();
 		}
 	}
 	return ret;
@@ -1352,14 +1767,19 @@ uint16_t uart_get_commandline(uint8_t uartNum, uint8_t* buf, uint16_t maxSize)
 	
 	if(len >= 4) // Minimum of command: 4-bytes, e.g., MC\r\n (MC$0d$0a)
 	{
-		for(i = 0; i < maxSize; i++)
+		// Non-blocking: the command line is taken when the line feed is received or the buffer is full
+		if(len > maxSize) len = maxSize;
+		for(i = 0; i < len; i++)
 		{
-			buf[i] = uart_getc(uartNum);
-			//if(buf[i] == '\n') break;	// [\n]: end of command
-			if(buf[i] == 0x0a) break;	// [0x0a]: end of command (Line feed)
+			if(BUFFER_OUT_OFFSET(data_rx, i) == 0x0a) break; // [0x0a]: end of command (Line feed)
 		}
-		buf[i+1] = 0x00; // end of string
-		//buf[i] = 0x00; // end of string
+		
+		if(i < len) len = i + 1;
+		else if(len < maxSize) return 0; // Wait for the rest of the command line
+		
+		for(i = 0; i < len; i++) buf[i] = uart_getc(uartNum);
+		buf[len] = 0x00; // end of string
+		if(buf[len-1] == 0x0a) i = len - 1;
 		
 		/*
 		// for debugging
@@ -24,9 +24,13 @@ typedef enum {SEGCP_MC, SEGCP_VR, SEGCP_MN, SEGCP_IM, SEGCP_OP, SEGCP_DD, SEGCP_
               SEGCP_LG, SEGCP_ER, SEGCP_FW, SEGCP_MA, SEGCP_PW, SEGCP_SV, SEGCP_EX, SEGCP_RT, SEGCP_UN, SEGCP_ST, 
               SEGCP_FR, SEGCP_EC, SEGCP_K1, SEGCP_UE, SEGCP_GA, SEGCP_GB, SEGCP_GC, SEGCP_GD, SEGCP_CA, SEGCP_CB,
               SEGCP_CC, SEGCP_CD, SEGCP_SC, SEGCP_S0, SEGCP_S1, SEGCP_RX, SEGCP_FS, SEGCP_FC, SEGCP_FP, SEGCP_FD,
-              SEGCP_FH, SEGCP_UI, SEGCP_UNKNOWN=255
+              SEGCP_FH, SEGCP_UI, SEGCP_RB, SEGCP_RA, SEGCP_BP, SEGCP_MS, SEGCP_AR, SEGCP_PA, SEGCP_PC, SEGCP_UD, SEGCP_UA, SEGCP_UM,
+              SEGCP_IF, SEGCP_LS, SEGCP_TS, SEGCP_QC, SEGCP_QE, SEGCP_UNKNOWN=255
 } teSEGCPCMDNUM;
 
+#define SEGCP_CMD_NUM   (SEGCP_QE + 1)  // Number of the commands: the last command + 1, tbSEGCPCMD has the same order
+#define SEGCP_IDX_SIZE  26              // Command lookup index: the first character 'A' ~ 'Z'
+
 /*
 // Command [K1] : Hidden command, This command erase the configutation data in flash / or EEPROM
 typedef enum {SEGCP_MC, SEGCP_VR, SEGCP_MN, SEGCP_IM, SEGCP_OP, SEGCP_DD, SEGCP_CP, SEGCP_PO, SEGCP_DG, SEGCP_KA,
@@ -121,8 +125,9 @@ extern uint8_t gSEGCPPRIVILEGE;
 
 void do_segcp(void);
 
+void init_SEGCP_index(void);
 uint8_t parse_SEGCP(uint8_t * pmsg, uint8_t * param);
-uint16_t proc_SEGCP(uint8_t * segcp_req, uint8_t * segcp_rep);
+uint16_t proc_SEGCP(uint8_t * segcp_req);
 
 uint16_t proc_SEGCP_tcp(uint8_t * segcp_req, uint8_t * segcp_rep);
 uint16_t proc_SEGCP_udp(uint8_t * segcp_req, uint8_t * segcp_rep);
@@ -7,6 +7,7 @@
 #include "W7500x_wztoe.h"
 #include "socket.h"
 #include "seg.h"
+#include "uartHandler.h"
 #include "segcp.h"
 #include "flashHandler.h"
 #include "storageHandler.h"
@@ -65,6 +66,8 @@ void device_reboot(void)
 	
 	clear_data_transfer_bytecount(SEG_ALL);
 	
+	uart_tx_wait_complete(SEG_DATA_UART); // Sends the remaining serial data (e.g., AT mode 'REBOOT' message)
+	
 	NVIC_SystemReset();
 	while(1);
 }
@@ -0,0 +1,183 @@
+#include "W7500x.h"
+#include "W7500x_wztoe.h"
+#include "common.h"
+#include "timerHandler.h"
+#include "eventHandler.h"
+
+// WZTOE socket interrupts for the events; SENDOK / TIMEOUT are handled by the socket APIs
+#define EVENT_SOCK_INT_MASK		(Sn_IR_RECV | Sn_IR_DISCON | Sn_IR_CON)
+#define EVENT_WZTOE_IRQ_PRIORITY	2
+
+typedef struct {
+	const char * name;
+	uint8_t event;
+	void (*handler)(void);
+	uint32_t run_msec;	// Total run time
+	uint16_t run_usec;	// Total run time below 1 msec
+	uint32_t max_usec;	// Maximum time slice
+	uint32_t runs;
+} tsTASK;
+
+static volatile uint8_t pending_events = 0;
+static volatile uint8_t sock_int_masked = 0; // Sockets interrupted: masked until the main loop takes the events
+
+static tsTASK tasks[EVENT_TASK_MAX];
+static uint8_t task_cnt = 0;
+
+static uint8_t take_events(uint8_t sleep);
+
+// Socket number -> event
+static const uint8_t sock_event[SOCK_MAX_USED] = {
+	EVENT_SEG,		// SOCK_DATA
+	EVENT_SEGCP,	// SOCK_CONFIG_UDP
+	EVENT_SEGCP,	// SOCK_CONFIG_TCP
+	EVENT_DHCP,		// SOCK_DHCP
+	EVENT_SEGCP | EVENT_DHCP,	// SOCK_DNS / SOCK_FWUPDATE
+	EVENT_SEG,		// SOCK_DATA_SESSION2
+	EVENT_SEG,		// SOCK_DATA_SESSION3
+	EVENT_SEG		// SOCK_DATA_SESSION4
+};
+
+void Event_Configuration(void)
+{
+#ifdef __USE_EVENT_DRIVEN_LOOP__
+	uint8_t i;
+	
+	for(i = 0; i < SOCK_MAX_USED; i++) setSn_IMR(i, EVENT_SOCK_INT_MASK);
+	
+	setIMR(0x00); // Common interrupts (IP conflict, Destination unreachable) are not used
+	setSIMR((uint8_t)((1 << SOCK_MAX_USED) - 1));
+	
+	NVIC_SetPriority(WZTOE_IRQn, EVENT_WZTOE_IRQ_PRIORITY);
+	NVIC_EnableIRQ(WZTOE_IRQn);
+#endif
+}
+
+// The socket interrupt (Sn_IR & Sn_IMR) stays asserted until Sn_IR is cleared; the socket is masked here
+// and cleared / unmasked by the main loop, the Sn_IR_CON is checked and cleared by the socket handlers
+void WZTOE_IRQ_Handler(void)
+{
+	uint8_t sir = getSIR();
+	uint8_t i;
+	
+	setSIMR(getSIMR() & ~sir);
+	sock_int_masked |= sir;
+	
+	for(i = 0; i < SOCK_MAX_USED; i++)
+	{
+		if(sir & (1 << i)) set_event(sock_event[i]);
+	}
+}
+
+void set_event(uint8_t event)
+{
+	uint32_t primask = __get_PRIMASK();
+	
+	__disable_irq();
+	pending_events |= event;
+	__set_PRIMASK(primask);
+}
+
+uint8_t register_task(const char * name, uint8_t event, void (*handler)(void))
+{
+	if(task_cnt >= EVENT_TASK_MAX) return 0xFF;
+	
+	tasks[task_cnt].name = name;
+	tasks[task_cnt].event = event;
+	tasks[task_cnt].handler = handler;
+	
+	return task_cnt++;
+}
+
+void run_tasks(void)
+{
+	tsTASK * task;
+	uint32_t stamp, usec;
+	uint8_t events;
+	uint8_t i;
+	
+	// The events set while the tasks run are taken by the next pass; a task re-raising its own event
+	// cannot hold off the lower priority tasks
+	events = take_events(1);
+	
+	for(i = 0; i < task_cnt; i++)
+	{
+		task = &tasks[i];
+		if(!(events & task->event)) continue;
+		
+		stamp = getDeviceTimestamp();
+		task->handler();
+		usec = convertTimestamp_usec(getDeviceTimestamp() - stamp);
+		
+		task->runs++;
+		task->run_usec += (uint16_t)(usec % 1000);
+		task->run_msec += (usec / 1000) + (task->run_usec / 1000);
+		task->run_usec %= 1000;
+		if(usec > task->max_usec) task->max_usec = usec;
+	}
+}
+
+uint8_t get_task_status(uint8_t idx, const char ** name, uint32_t * run_msec, uint32_t * max_usec, uint32_t * runs)
+{
+	if(idx >= task_cnt) return 0;
+	
+	*name = tasks[idx].name;
+	*run_msec = tasks[idx].run_msec;
+	*max_usec = tasks[idx].max_usec;
+	*runs = tasks[idx].runs;
+	
+	return 1;
+}
+
+void clear_task_status(void)
+{
+	uint8_t i;
+	
+	for(i = 0; i < task_cnt; i++)
+	{
+		tasks[i].run_msec = 0;
+		tasks[i].run_usec = 0;
+		tasks[i].max_usec = 0;
+		tasks[i].runs = 0;
+	}
+}
+
+// ret: pending events (cleared), sleeps until an event occurs if required
+static uint8_t take_events(uint8_t sleep)
+{
+#ifdef __USE_EVENT_DRIVEN_LOOP__
+	uint8_t events;
+	uint8_t sock;
+	uint8_t i;
+	
+	__disable_irq();
+	while(sleep && (pending_events == 0))
+	{
+		__WFI(); // A pending interrupt wakes up the core even if the interrupts are disabled
+		__enable_irq(); // The interrupt handler runs here
+		__disable_irq();
+	}
+	events = pending_events;
+	pending_events = 0;
+	sock = sock_int_masked;
+	sock_int_masked = 0;
+	__enable_irq();
+	
+	if(sock)
+	{
+		// The interrupts after this point are new events for the handlers
+		for(i = 0; i < SOCK_MAX_USED; i++)
+		{
+			if(sock & (1 << i)) setSn_IR(i, (Sn_IR_RECV | Sn_IR_DISCON));
+		}
+		
+		__disable_irq();
+		setSIMR(getSIMR() | sock);
+		__enable_irq();
+	}
+	
+	return events;
+#else
+	return EVENT_ALL;
+#endif
+}
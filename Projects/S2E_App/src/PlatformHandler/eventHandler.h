@@ -0,0 +1,35 @@
+#ifndef EVENTHANDLER_H_
+#define EVENTHANDLER_H_
+
+#include <stdint.h>
+
+// Event-driven main loop: the interrupt handlers set the events, the main loop runs the handlers with the pending events only
+// and sleeps (WFI) when no event is pending. If this option is not defined, all the handlers are called every loop (polling).
+#define __USE_EVENT_DRIVEN_LOOP__
+
+// Main loop events
+#define EVENT_SEG				0x01	// S2E data: UART Rx / Tx, S2E data sockets, S2E timers
+#define EVENT_SEGCP				0x02	// Configuration: SEGCP sockets, serial command mode, firmware update socket
+#define EVENT_DHCP				0x04	// Network: DHCP / DNS client sockets, 1-second tick
+#define EVENT_ALL				(EVENT_SEG | EVENT_SEGCP | EVENT_DHCP)
+
+// The S2E / SEGCP timeouts (keep-alive, reconnection, inactivity...) are checked by the periodic events
+#define EVENT_POLL_INTERVAL_MSEC	10
+
+// Cooperative scheduler: the tasks run to completion without blocking
+// Each pass runs every task with a pending event once, in the registration order (the task registered first runs first)
+#define EVENT_TASK_MAX			4
+
+void Event_Configuration(void);
+void WZTOE_IRQ_Handler(void);
+
+void set_event(uint8_t event);		// Can be called by the interrupt handlers
+
+uint8_t register_task(const char * name, uint8_t event, void (*handler)(void)); // ret: task index, [0xFF] task table full
+void run_tasks(void);				// Main loop: runs the tasks with the pending events, sleeps until an event occurs
+
+// Task runtime accounting: total run time (msec), maximum time slice (usec), number of runs
+uint8_t get_task_status(uint8_t idx, const char ** name, uint32_t * run_msec, uint32_t * max_usec, uint32_t * runs); // ret: [0] no task
+void clear_task_status(void);
+
+#endif /* EVENTHANDLER_H_ */
@@ -13,6 +13,8 @@
 #ifdef __USE_EXT_EEPROM__
 	#include "eepromHandler.h"
 	uint16_t convert_eeprom_addr(uint32_t flash_addr);
+#else
+	static uint32_t write_flash_dat0(uint32_t addr, uint8_t *data, uint16_t size);
 #endif
 
 uint32_t read_storage(teDATASTORAGE stype, uint32_t addr, void *data, uint16_t size)
@@ -43,6 +45,14 @@ uint32_t read_storage(teDATASTORAGE stype, uint32_t addr, void *data, uint16_t s
 #endif
 			break;
 		
+		case STORAGE_CONFIG_CH2:
+#ifndef __USE_EXT_EEPROM__
+			ret_len = read_flash(DEVICE_CONFIG_CH2_ADDR, data, size);
+#else
+			ret_len = read_eeprom(convert_eeprom_addr(DEVICE_CONFIG_CH2_ADDR), data, size);
+#endif
+			break;
+		
 		case STORAGE_APP_MAIN:
 			ret_len = read_flash(addr, data, size);
 			break;
@@ -66,8 +76,7 @@ uint32_t write_storage(teDATASTORAGE stype, uint32_t addr, void *data, uint16_t
 	{
 		case STORAGE_MAC:
 #ifndef __USE_EXT_EEPROM__
-			erase_storage(STORAGE_MAC);
-			ret_len = write_flash(DEVICE_MAC_ADDR, data, 6); // internal data flash for configuration data (DAT0/1)
+			ret_len = write_flash_dat0(DEVICE_MAC_ADDR, data, 6); // internal data flash for configuration data (DAT0/1)
 #else
 			//erase_storage(STORAGE_MAC);
 			ret_len = write_eeprom(convert_eeprom_addr(DEVICE_MAC_ADDR), data, 6); // external eeprom for configuration data
@@ -90,6 +99,14 @@ uint32_t write_storage(teDATASTORAGE stype, uint32_t addr, void *data, uint16_t
 #endif
 			break;
 		
+		case STORAGE_CONFIG_CH2:
+#ifndef __USE_EXT_EEPROM__
+			ret_len = write_flash_dat0(DEVICE_CONFIG_CH2_ADDR, data, size);
+#else
+			ret_len = write_eeprom(convert_eeprom_addr(DEVICE_CONFIG_CH2_ADDR), data, size);
+#endif
+			break;
+		
 		case STORAGE_APP_MAIN:
 			ret_len = write_flash(addr, data, size);
 			break;
@@ -196,5 +213,24 @@ uint16_t convert_eeprom_addr(uint32_t flash_addr)
 {
 	return (uint16_t)(flash_addr-DAT0_START_ADDR);
 }
+#else
+// DAT0 sector: the MAC address and the channel 2 configuration data share the sector,
+// the sector is read, updated and rewritten as a whole (skipped if the data is not changed)
+static uint32_t write_flash_dat0(uint32_t addr, uint8_t *data, uint16_t size)
+{
+	uint8_t sector[SECT_SIZE];
+	uint32_t offset = addr - DAT0_START_ADDR;
+	
+	if((offset + size) > SECT_SIZE) return 0;
+	
+	read_flash(DAT0_START_ADDR, sector, SECT_SIZE);
+	if(memcmp(&sector[offset], data, size) == 0) return size;
+	
+	memcpy(&sector[offset], data, size);
+	erase_flash_sector(DAT0_START_ADDR);
+	write_flash(DAT0_START_ADDR, sector, SECT_SIZE);
+	
+	return size;
+}
 #endif
 
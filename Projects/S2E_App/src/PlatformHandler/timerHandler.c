@@ -6,6 +6,7 @@
 #include "segcp.h"
 #include "deviceHandler.h"
 #include "gpioHandler.h"
+#include "eventHandler.h"
 
 #include "dhcp.h"
 #include "dns.h"
@@ -14,6 +15,7 @@ static volatile uint16_t msec_cnt = 0;
 static volatile uint8_t  sec_cnt = 0;
 static volatile uint8_t  min_cnt = 0;
 static volatile uint32_t hour_cnt = 0;
+static uint8_t event_poll_msec = 0;
 
 static uint8_t enable_phylink_check = 1;
 static volatile uint32_t phylink_down_time_msec;
@@ -42,6 +44,19 @@ void Timer_Configuration(void)
 
 	/* Dualtimer 0_0 start */
 	DUALTIMER_Start(DUALTIMER0_0);
+	
+	/* Dualtimer 0_1: free-running 32-bit down counter for the time stamps, no interrupt */
+	DUALTIMER_ClockEnable(DUALTIMER0_1);
+	
+	Dualtimer_InitStructure.TimerLoad = 0xFFFFFFFF;
+	Dualtimer_InitStructure.TimerControl_Mode = DUALTIMER_TimerControl_FreeRunning;
+	Dualtimer_InitStructure.TimerControl_OneShot = DUALTIMER_TimerControl_Wrapping;
+	Dualtimer_InitStructure.TimerControl_Pre = DUALTIMER_TimerControl_Pre_1;
+	Dualtimer_InitStructure.TimerControl_Size = DUALTIMER_TimerControl_Size_32;
+	
+	DUALTIMER_Init(DUALTIMER0_1, &Dualtimer_InitStructure);
+	DUALTIMER_IntConfig(DUALTIMER0_1, DISABLE);
+	DUALTIMER_Start(DUALTIMER0_1);
 }
 
 void Timer_IRQ_Handler(void)
@@ -67,6 +82,13 @@ void Timer_IRQ_Handler(void)
 			gpio_handler_timer_msec();
 		}
 		
+		// Main loop: periodic events for the timeouts of the handlers
+		if(++event_poll_msec >= EVENT_POLL_INTERVAL_MSEC)
+		{
+			event_poll_msec = 0;
+			set_event(EVENT_SEG | EVENT_SEGCP);
+		}
+		
 		/* Second Process */
 		if(msec_cnt >= 1000 - 1) //second //if((msec_cnt % 1000) == 0) 
 		{
@@ -77,6 +99,8 @@ void Timer_IRQ_Handler(void)
 			
 			DHCP_time_handler();	// Time counter for DHCP timeout
 			DNS_time_handler();		// Time counter for DNS timeout
+			
+			set_event(EVENT_DHCP);
 		}
 		
 		/* Minute Process */
@@ -120,6 +144,17 @@ uint16_t getDeviceUptime_msec(void)
 	return msec_cnt;
 }
 
+// Time stamp in system clock ticks (wraps every 2^32 ticks), for the short intervals: (getDeviceTimestamp() - stamp)
+uint32_t getDeviceTimestamp(void)
+{
+	return ~DUALTIMER_GetTimerValue(DUALTIMER0_1); // down counter
+}
+
+uint32_t convertTimestamp_usec(uint32_t ticks)
+{
+	return ticks / (GetSystemClock() / 1000000);
+}
+
 
 void set_phylink_time_check(uint8_t enable)
 {
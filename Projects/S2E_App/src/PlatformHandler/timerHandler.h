@@ -11,6 +11,9 @@ uint8_t  getDeviceUptime_min(void);
 uint8_t  getDeviceUptime_sec(void);
 uint16_t getDeviceUptime_msec(void);
 
+uint32_t getDeviceTimestamp(void);				// Time stamp in system clock ticks
+uint32_t convertTimestamp_usec(uint32_t ticks);	// Time stamp interval (ticks) -> usec
+
 void set_phylink_time_check(uint8_t enable);
 uint32_t get_phylink_downtime(void);
 
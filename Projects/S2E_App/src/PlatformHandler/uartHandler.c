@@ -1,20 +1,33 @@
 #include <string.h>
 #include "W7500x_uart.h"
 #include "W7500x_gpio.h"
+#include "W7500x_dma.h"
+#include "W7500x_dualtimer.h"
 #include "common.h"
 #include "W7500x_board.h"
 #include "configdata.h"
 #include "uartHandler.h"
 #include "seg.h"
+#include "eventHandler.h"
 
 #include <stdio.h> // for debugging
 
 /* Private typedef -----------------------------------------------------------*/
+// RS-485 driver enable (RTS pin) state: [PRE] delay before the Tx start, [DRAIN] wait for the Tx complete, [POST] delay after the Tx complete
+typedef enum {RS485_DE_IDLE = 0, RS485_DE_PRE, RS485_DE_TX, RS485_DE_DRAIN, RS485_DE_POST} teRS485DE;
 
 /* Private define ------------------------------------------------------------*/
+// RS-485 driver enable turnaround timer: one-shot, counts the bit times
+#define UART_RS485_TIMER		DUALTIMER1_0
+#define UART_RS485_TIMER_IRQ	DUALTIMER1_IRQn
+
+// UART Rx gap timer: one-shot, re-armed by the Rx burst, expires when the Rx line is idle for the gap time (frame end)
+#define UART_RX_GAP_TIMER		DUALTIMER1_1
+#define UART_RX_GAP_TIMER_IRQ	DUALTIMER1_IRQn
+#define UART_RX_TIMEOUT_BITS	32 // Rx timeout interrupt: the Rx line has been idle for 32 bit times
+#define UART_RX_GAP_QUEUE_SIZE	4 // Frame ends not checked yet, must be a power of two
 
 /* Private functions prototypes ----------------------------------------------*/
-extern void delay(__IO uint32_t nCount);
 
 /* Private functions ---------------------------------------------------------*/
 int32_t uart_putc(uint8_t uartNum, uint8_t ch);
@@ -22,6 +35,8 @@ int32_t uart_puts(uint8_t uartNum, uint8_t* buf, uint16_t reqSize);
 int32_t uart_getc(uint8_t uartNum);
 int32_t uart_getc_nonblk(uint8_t uartNum);
 int32_t uart_gets(uint8_t uartNum, uint8_t* buf, uint16_t reqSize);
+int32_t uart_gets_delim(uint8_t uartNum, uint8_t* buf, uint16_t reqSize, uint8_t * delim, uint8_t delim_len, uint8_t * matched);
+static uint8_t uart_delim_match_next(uint8_t * delim, uint8_t matched, uint8_t ch);
 
 /* Private macro -------------------------------------------------------------*/
 
@@ -30,6 +45,13 @@ uint8_t flag_ringbuf_full = 0;
 
 // UART Ring buffer declaration
 BUFFER_DEFINITION(data_rx, SEG_DATA_BUF_SIZE);
+BUFFER_DEFINITION(data_tx, SEG_DATA_TX_BUF_SIZE); // UART Tx Ring buffer: drained by the UART Tx interrupt
+
+#ifdef __USE_DUAL_DATA_UART__
+// Dual data UART mode: channel 2 Ring buffers, accessed by the S2E channel 2 handler directly (zero-copy)
+BUFFER_DEFINITION(data2_rx, SEG_DATA2_BUF_SIZE);
+BUFFER_DEFINITION(data2_tx, SEG_DATA2_TX_BUF_SIZE);
+#endif
 
 // UART structure declaration for switching between UART0 and UART1 
 // UART selector [SEG_DATA_UART] and [SEG_DEBUG_UART] Defines are located at common.h file.
@@ -37,12 +59,19 @@ BUFFER_DEFINITION(data_rx, SEG_DATA_BUF_SIZE);
 #if (SEG_DATA_UART == 0)
 	UART_TypeDef * 		UART_data = UART0;
 	IRQn_Type 			UART_data_irq = UART0_IRQn;
+	dma_channel			UART_data_dma = DMA_UART0;
 #else
 	UART_TypeDef * 		UART_data = UART1;
 	IRQn_Type 			UART_data_irq = UART1_IRQn;
+	dma_channel			UART_data_dma = DMA_UART1;
 #endif
 
-//uint32_t baud_table[] = {300, 600, 1200, 1800, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200, 230400};
+#ifdef __USE_DUAL_DATA_UART__
+	UART_TypeDef * 		UART_data2 = UART1;
+	IRQn_Type 			UART_data2_irq = UART1_IRQn;
+#endif
+
+static const uint32_t baud_table[] = {300, 600, 1200, 1800, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200, 230400};
 uint8_t word_len_table[] = {7, 8, 9};
 uint8_t * parity_table[] = {(uint8_t *)"N", (uint8_t *)"ODD", (uint8_t *)"EVEN"};
 uint8_t stop_bit_table[] = {1, 2};
@@ -60,6 +89,64 @@ static uint8_t xonoff_status = UART_XON;
 // UART Interface selecter; RS-422 or RS-485 use only
 static uint8_t uart_if_mode = UART_IF_RS422;
 
+// Character timing of the data UART settings, for the one-shot timers
+static uint32_t uart_bit_ticks;			// timer ticks per bit time
+static uint8_t uart_frame_bits;			// start + data + parity + stop bits
+
+// RS-485 driver enable control by the UART Tx path; the delays are converted into the timer ticks
+static uint8_t rs485_de_ctrl = 0;
+static volatile uint8_t rs485_de_state = RS485_DE_IDLE;
+static uint8_t rs485_pre_delay;			// bit times
+static uint8_t rs485_post_delay;		// bit times
+
+// UART Rx data check options: loaded once for each Rx burst (FIFO / DMA landed data)
+static uint8_t rx_check_trigger;
+static uint8_t rx_trigger_ch;
+static uint8_t rx_trigger_idx;
+static uint8_t rx_check_xonxoff;
+static uint8_t rx_store_permitted;
+static uint16_t rx_cnt;
+
+// UART Rx gap timer
+static uint32_t rx_gap_ticks = 0;			// [0] disabled
+static volatile uint16_t rx_gap_wr;			// data_rx_wr index at the last Rx burst
+static volatile uint16_t rx_gap_end[UART_RX_GAP_QUEUE_SIZE];	// data_rx_wr index at the Rx line idle (frame end)
+static volatile uint8_t rx_gap_in = 0;		// updated by the timer IRQ handler only
+static volatile uint8_t rx_gap_out = 0;		// updated by the main loop only
+
+#ifdef __USE_UART_RX_DMA__
+// UART Rx DMA: the DMA writes the Rx data into data_rx ring buffer by blocks
+// [data_rx_wr ... dma_rx_scan): removed by the Rx data check (XON/XOFF, trigger code), filled by the next data
+// [dma_rx_scan ... dma_rx_landed): written by the DMA, not checked yet
+// The positions are the free-running ring buffer indices, same as data_rx_wr / data_rx_rd
+static volatile uint16_t dma_rx_landed = 0;
+static volatile uint16_t dma_rx_block = 0;		// ring buffer index of the DMA block in progress
+static volatile uint8_t dma_rx_active = 0;
+static uint16_t dma_rx_scan = 0;
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+static void uart_rx_check_init(void);
+static __INLINE void uart_rx_check_store(uint8_t ch);
+static void uart_rx_check_end(void);
+static void uart_tx_fill_fifo(void);
+static void uart_tx_kick(void);
+static void uart_tx_start(void);
+static void uart_rs485_de_init(void);
+static void uart_rs485_timer_start(uint32_t bits);
+static void uart_rs485_tx_begin(void);
+static void uart_putc_direct(uint8_t ch);
+static void uart_rx_gap_timer_start(uint16_t rx_wr, uint8_t rx_timeout);
+#ifdef __USE_UART_RX_DMA__
+static void uart_rx_dma_arm(void);
+static void uart_rx_dma_update(void);
+#endif
+static UART_TypeDef * get_uart_data_regs(uint8_t uartNum);
+#ifdef __USE_DUAL_DATA_UART__
+static void uart_ch2_tx_kick(void);
+static void uart_ch2_tx_start(void);
+#endif
+
 /* Public functions ----------------------------------------------------------*/
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -70,85 +157,279 @@ static uint8_t uart_if_mode = UART_IF_RS422;
 
 void S2E_UART_IRQ_Handler(UART_TypeDef * s2e_uart)
 {
-	uint8_t ch; // 1-byte character variable for UART Interrupt request handler
+#ifndef __USE_GPIO_HARDWARE_FLOWCONTROL__
 	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+#endif
 	
-	if(UART_GetITStatus(s2e_uart,  UART_IT_FLAG_RXI))
+#ifdef __USE_UART_RX_DMA__
+	// Rx data is transferred by DMA; Rx timeout: update the landed data position
+	if(UART_GetITStatus(s2e_uart, UART_IT_FLAG_RTI))
 	{
-		if(IS_BUFFER_FULL(data_rx))
-		{
-			//UartGetc(s2e_uart);
-			UART_ReceiveData(s2e_uart);
-			
-			flag_ringbuf_full = 1;
-			
-			// buffer full => Serial data discard
-			//BUFFER_CLEAR(data_rx); // Data-UART buffer flush -> Does not use
-		}
-		else
-		{
-#ifdef __USE_GPIO_HARDWARE_FLOWCONTROL__
-			if(serial->flow_control == flow_rts_cts)
-			{
-				;
-			}
+		uart_rx_dma_update();
+		init_time_delimiter_timer();
+		uart_rx_gap_timer_start(dma_rx_landed, 1);
+		notify_serial_rx();
+		
+		UART_ClearITPendingBit(s2e_uart, UART_IT_FLAG_RTI);
+	}
 #else
+	if(UART_GetITStatus(s2e_uart, (UART_IT_FLAG_RXI | UART_IT_FLAG_RTI)))
+	{
+		uint8_t rx_timeout = (UART_GetITStatus(s2e_uart, UART_IT_FLAG_RTI) != RESET);
+		uint8_t ch; // 1-byte character variable for UART Interrupt request handler
+		
+		uart_rx_check_init();
+		
+		// Drain the UART Rx FIFO at once (FIFO disabled: 1-byte)
+		while(!(s2e_uart->FR & UART_FR_RXFE))
+		{
+#ifndef __USE_GPIO_HARDWARE_FLOWCONTROL__
 			if((serial->flow_control == flow_rts_cts) && (BUFFER_USED_SIZE(data_rx) > UART_OFF_THRESHOLD)) // CTS/RTS
 			{
-				; // Does nothing => RTS signal inactive
+				break; // Does nothing => RTS signal inactive, the remaining data stays in the FIFO
 			}
-			else
 #endif
+			//ch = UartGetc(s2e_uart);
+			ch = (uint8_t)UART_ReceiveData(s2e_uart);
+			
+			if(IS_BUFFER_FULL(data_rx))
 			{
-				//ch = UartGetc(s2e_uart);
-				ch = UART_ReceiveData(s2e_uart);
+				flag_ringbuf_full = 1;
 				
-#ifdef _SEG_DEBUG_
-				UART_SendData(s2e_uart, ch);	// ## UART echo; for debugging
-#endif
-				if(!(check_modeswitch_trigger(ch))) // ret: [0] data / [!0] trigger code
-				{
-					if(check_serial_store_permitted(ch)) // ret: [0] not permitted / [1] permitted
-					{
-						BUFFER_IN(data_rx) = ch;
-						BUFFER_IN_MOVE(data_rx, 1);
-					}
-				}
+				// buffer full => Serial data discard
+				//BUFFER_CLEAR(data_rx); // Data-UART buffer flush -> Does not use
+				continue;
 			}
-		}
-		init_time_delimiter_timer();
-
-/*		else
-		{
-			//ch = UartGetc(s2e_uart);
-			ch = UART_ReceiveData(s2e_uart);
 			
 #ifdef _SEG_DEBUG_
 			UART_SendData(s2e_uart, ch);	// ## UART echo; for debugging
 #endif
-			if(!(check_modeswitch_trigger(ch))) // ret: [0] data / [!0] trigger code
-			{
-				if(check_serial_store_permitted(ch)) // ret: [0] not permitted / [1] permitted
-				{
-					BUFFER_IN(data_rx) = ch;
-					BUFFER_IN_MOVE(data_rx, 1);
-				}
-			}
+			uart_rx_check_store(ch);
 		}
-		init_time_delimiter_timer();
-*/
 		
-		UART_ClearITPendingBit(s2e_uart, UART_IT_FLAG_RXI);
+		uart_rx_check_end();
+		uart_rx_gap_timer_start(data_rx_wr, rx_timeout);
+		notify_serial_rx();
+		
+		UART_ClearITPendingBit(s2e_uart, (UART_IT_FLAG_RXI | UART_IT_FLAG_RTI));
 	}
-/*
-	// Does not use: UART Tx interrupt
+#endif
+	
+	// UART Tx interrupt: Tx ring buffer -> UART Tx FIFO
 	if(UART_GetITStatus(s2e_uart, UART_IT_FLAG_TXI)) 
 	{
+		uart_tx_kick(); // Tx ring buffer empty: Tx interrupt disabled
+		set_event(EVENT_SEG); // Tx ring buffer space for the Ethernet to UART data
+		
 		UART_ClearITPendingBit(s2e_uart, UART_IT_FLAG_TXI);
 	}
-*/
 }
 
+// RS-485 driver enable turnaround: the one-shot timer expired
+void S2E_UART_RS485_Timer_IRQ_Handler(void)
+{
+	if(!DUALTIMER_GetIntStatus(UART_RS485_TIMER)) return;
+	DUALTIMER_IntClear(UART_RS485_TIMER);
+	
+	switch(rs485_de_state)
+	{
+		case RS485_DE_PRE: // Driver enabled: Tx start
+			rs485_de_state = RS485_DE_TX;
+			uart_tx_kick(); // The UART IRQ has the same priority
+			break;
+		case RS485_DE_DRAIN: // Wait for the last character has been sent: 1-frame steps while the FIFO not empty, 1-bit steps while shifting out
+			if(!(UART_data->FR & UART_FR_TXFE))
+			{
+				uart_rs485_timer_start(uart_frame_bits);
+			}
+			else if(UART_data->FR & UART_FR_BUSY)
+			{
+				uart_rs485_timer_start(1);
+			}
+			else if(rs485_post_delay)
+			{
+				rs485_de_state = RS485_DE_POST;
+				uart_rs485_timer_start(rs485_post_delay);
+			}
+			else
+			{
+				uart_rs485_disable(SEG_DATA_UART);
+				rs485_de_state = RS485_DE_IDLE;
+			}
+			break;
+		case RS485_DE_POST: // Tx complete: Driver disabled
+			uart_rs485_disable(SEG_DATA_UART);
+			rs485_de_state = RS485_DE_IDLE;
+			break;
+		default:
+			break;
+	}
+}
+
+// UART Rx gap timer expired: the Rx line is idle, the data up to the last burst is a frame
+void S2E_UART_Rx_Gap_Timer_IRQ_Handler(void)
+{
+	if(!DUALTIMER_GetIntStatus(UART_RX_GAP_TIMER)) return;
+	DUALTIMER_IntClear(UART_RX_GAP_TIMER);
+	
+	// Rx data after the last burst (below the Rx FIFO trigger level, no Rx timeout yet): the line is not idle, the next burst re-arms the timer
+	if(!(UART_data->FR & UART_FR_RXFE)) return;
+#ifdef __USE_UART_RX_DMA__
+	uart_rx_dma_update();
+	if(dma_rx_landed != rx_gap_wr) return;
+#endif
+	
+	if((uint8_t)(rx_gap_in - rx_gap_out) < UART_RX_GAP_QUEUE_SIZE)
+	{
+		rx_gap_end[rx_gap_in & (UART_RX_GAP_QUEUE_SIZE - 1)] = rx_gap_wr;
+		rx_gap_in++;
+	}
+	else
+	{
+		rx_gap_end[(uint8_t)(rx_gap_in - 1) & (UART_RX_GAP_QUEUE_SIZE - 1)] = rx_gap_wr; // Queue full: merged into the last frame
+	}
+	
+	set_event(EVENT_SEG);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// UART Rx data check: Serial command mode trigger code, XON/XOFF
+// The per-byte checkers in seg.c are called only when required
+////////////////////////////////////////////////////////////////////////////////
+
+static void uart_rx_check_init(void)
+{
+	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
+	
+	rx_check_trigger = ((opmode == DEVICE_GW_MODE) && (option->serial_command == SEG_ENABLE));
+	rx_trigger_ch = option->serial_trigger[0];
+	rx_trigger_idx = get_modeswitch_trigger_idx();
+	rx_check_xonxoff = (serial->flow_control == flow_xon_xoff);
+	rx_store_permitted = get_serial_store_permitted();
+	rx_cnt = 0;
+}
+
+static __INLINE void uart_rx_check_store(uint8_t ch)
+{
+	// Serial command mode trigger code: only the first byte of a burst can be the start of trigger code (inter-gap time)
+	if(rx_check_trigger && (rx_trigger_idx || ((ch == rx_trigger_ch) && (rx_cnt == 0))))
+	{
+		rx_trigger_idx = check_modeswitch_trigger(ch); // ret: [0] data / [!0] trigger code
+		if(rx_trigger_idx) return;
+	}
+	rx_cnt++;
+	
+	// XON/XOFF start/stop commands are not stored
+	if(rx_check_xonxoff && ((ch == UART_XON) || (ch == UART_XOFF)))
+	{
+		check_serial_store_permitted(ch);
+		return;
+	}
+	
+	if(rx_store_permitted)
+	{
+		BUFFER_IN(data_rx) = ch;
+		BUFFER_IN_MOVE(data_rx, 1);
+	}
+}
+
+static void uart_rx_check_end(void)
+{
+	// Serial data received: reset the trigger code inter-gap time once for the burst
+	if(rx_check_trigger && rx_cnt) clear_modeswitch_gap_time();
+	
+	init_time_delimiter_timer();
+}
+
+#ifdef __USE_UART_RX_DMA__
+////////////////////////////////////////////////////////////////////////////////
+// UART Rx DMA
+//		DMA transfers the Rx data into the data_rx ring buffer by blocks,
+//		uart_rx_dma_process() checks the landed data and advances the data_rx_wr
+////////////////////////////////////////////////////////////////////////////////
+
+void S2E_UART_DMA_IRQ_Handler(void)
+{
+	uart_rx_dma_update(); // DMA block completed: the next block is started
+	set_event(EVENT_SEG);
+}
+
+// Start the DMA block at the landed position if the ring buffer has enough room
+static void uart_rx_dma_arm(void)
+{
+	uint16_t free_size = (uint16_t)(SEG_DATA_BUF_SIZE - (uint16_t)(dma_rx_landed - data_rx_rd));
+	
+	if(free_size < UART_RX_DMA_BLOCK_SIZE) // Ring buffer full: the Rx data stays in the UART FIFO
+	{
+		flag_ringbuf_full = 1;
+		return;
+	}
+	
+	dma_rx_block = dma_rx_landed;
+	dma_rx_active = 1;
+	dma_peripheral_to_memory(UART_data_dma, (uint32_t)&UART_data->DR, (uint32_t)&data_rx_buf[BUFFER_POS(data_rx, dma_rx_block)], byte, UART_RX_DMA_BLOCK_SIZE);
+}
+
+// Update the landed data position from the DMA progress
+static void uart_rx_dma_update(void)
+{
+	uint16_t remain;
+	
+	if(!dma_rx_active) return;
+	
+	remain = dma_get_remaining(UART_data_dma);
+	if(remain == 0) // DMA block completed
+	{
+		dma_rx_landed = dma_rx_block + UART_RX_DMA_BLOCK_SIZE;
+		dma_rx_active = 0;
+		uart_rx_dma_arm();
+	}
+	else
+	{
+		dma_rx_landed = dma_rx_block + (UART_RX_DMA_BLOCK_SIZE - remain);
+	}
+}
+
+// This function have to call by main loop: scan the landed data and publish it to the ring buffer users
+void uart_rx_dma_process(void)
+{
+	uint16_t landed;
+	uint8_t ch;
+	
+	__disable_irq();
+	uart_rx_dma_update();
+	landed = dma_rx_landed;
+	if(!dma_rx_active) uart_rx_dma_arm(); // restart the DMA stopped by ring buffer full
+	__enable_irq();
+	
+	if(dma_rx_scan == landed) return;
+	
+	uart_rx_check_init();
+	
+	if(!rx_check_trigger && !rx_check_xonxoff && rx_store_permitted && (dma_rx_scan == data_rx_wr))
+	{
+		// Fast path: the landed data is used as it is
+		BUFFER_IN_MOVE(data_rx, landed - data_rx_wr);
+	}
+	else
+	{
+		// Trigger code restore (seg_timer_msec) writes to the ring buffer; IRQ disabled during the data check
+		if(rx_check_trigger) __disable_irq();
+		while(dma_rx_scan != landed)
+		{
+			ch = data_rx_buf[BUFFER_POS(data_rx, dma_rx_scan)];
+			dma_rx_scan++;
+			uart_rx_check_store(ch);
+		}
+		if(rx_check_trigger) __enable_irq();
+	}
+	dma_rx_scan = landed;
+	
+	uart_rx_check_end();
+}
+#endif
+
 void S2E_UART_Configuration(void)
 {
 	DevConfig *value = get_DevConfig_pointer();
@@ -158,14 +439,129 @@ void S2E_UART_Configuration(void)
 	
 	/* Configure UARTx Interrupt Enable */
 	//UART_ITConfig(UART_data, (UART_IT_FLAG_TXI | UART_IT_FLAG_RXI), ENABLE);
+#if defined(__USE_UART_RX_DMA__)
+	/* Configure the DMA: UARTx Rx -> data_rx ring buffer */
+	dma_data_struct_init();
+	dma_init();
+	uart_rx_dma_arm();
+	UART_data->DMACR = UART_DMACR_RXDMAE;
+	
+	NVIC_ClearPendingIRQ(DMA_IRQn);
+	NVIC_SetPriority(DMA_IRQn, 1);
+	NVIC_EnableIRQ(DMA_IRQn);
+	
+	UART_ITConfig(UART_data, UART_IT_FLAG_RTI, ENABLE); // Rx timeout
+#elif defined(__USE_UART_RX_FIFO__)
+	UART_ITConfig(UART_data, (UART_IT_FLAG_RXI | UART_IT_FLAG_RTI), ENABLE); // Rx FIFO trigger level / Rx timeout
+#else
 	UART_ITConfig(UART_data, UART_IT_FLAG_RXI, ENABLE);
+#endif
 	
 	/* NVIC configuration */
+	if(rs485_de_ctrl)
+	{
+		NVIC_ClearPendingIRQ(UART_RS485_TIMER_IRQ);
+		NVIC_SetPriority(UART_RS485_TIMER_IRQ, 1);
+		NVIC_EnableIRQ(UART_RS485_TIMER_IRQ);
+	}
+	
 	NVIC_ClearPendingIRQ(UART_data_irq);
 	NVIC_SetPriority(UART_data_irq, 1);
 	NVIC_EnableIRQ(UART_data_irq);
 }
 
+#ifdef __USE_DUAL_DATA_UART__
+////////////////////////////////////////////////////////////////////////////////
+// Dual data UART mode: channel 2 (UART1)
+//		The serial settings are the channel 2 settings (DevConfig_ch2)
+//		RS-232/TTL only, no flow control; the RS-485 / Rx gap timer / DMA / trigger code options are the data UART only
+////////////////////////////////////////////////////////////////////////////////
+
+void S2E_UART_CH2_Configuration(void)
+{
+	struct __serial_info *serial = get_DevConfig_ch2_pointer()->serial_info;
+	
+	serial->uart_interface = UART_IF_RS232_TTL;
+	serial->flow_control = flow_none;
+	serial->dtr_en = SEG_DISABLE;
+	serial->dsr_en = SEG_DISABLE;
+	
+	serial_info_init(UART_data2, serial);
+	
+#ifdef __USE_UART_RX_FIFO__
+	UART_ITConfig(UART_data2, (UART_IT_FLAG_RXI | UART_IT_FLAG_RTI), ENABLE); // Rx FIFO trigger level / Rx timeout
+#else
+	UART_ITConfig(UART_data2, UART_IT_FLAG_RXI, ENABLE);
+#endif
+	
+	NVIC_ClearPendingIRQ(UART_data2_irq);
+	NVIC_SetPriority(UART_data2_irq, 1);
+	NVIC_EnableIRQ(UART_data2_irq);
+}
+
+void S2E_UART_CH2_IRQ_Handler(void)
+{
+	uint8_t permitted;
+	uint16_t cnt = 0;
+	
+	if(UART_GetITStatus(UART_data2, (UART_IT_FLAG_RXI | UART_IT_FLAG_RTI)))
+	{
+		permitted = get_serial_ch2_store_permitted();
+		
+		// Drain the UART Rx FIFO at once, the ring buffer write index is updated once for the burst
+		while(!(UART_data2->FR & UART_FR_RXFE))
+		{
+			if(!permitted || (BUFFER_FREE_SIZE(data2_rx) <= cnt))
+			{
+				if(permitted) flag_ringbuf_full = 1;
+				UART_ReceiveData(UART_data2); // discard
+				continue;
+			}
+			BUFFER_IN_OFFSET(data2_rx, cnt) = (uint8_t)UART_ReceiveData(UART_data2);
+			cnt++;
+		}
+		
+		if(cnt)
+		{
+			BUFFER_IN_MOVE(data2_rx, cnt);
+			notify_serial_ch2_rx();
+		}
+		
+		UART_ClearITPendingBit(UART_data2, (UART_IT_FLAG_RXI | UART_IT_FLAG_RTI));
+	}
+	
+	// UART Tx interrupt: Tx ring buffer -> UART Tx FIFO
+	if(UART_GetITStatus(UART_data2, UART_IT_FLAG_TXI))
+	{
+		uart_ch2_tx_kick();
+		set_event(EVENT_SEG); // Tx ring buffer space for the Ethernet to UART data
+		
+		UART_ClearITPendingBit(UART_data2, UART_IT_FLAG_TXI);
+	}
+}
+
+// Start the transmission if the Tx interrupt is idle
+static void uart_ch2_tx_start(void)
+{
+	NVIC_DisableIRQ(UART_data2_irq);
+	if(!(UART_data2->IMSC & UART_IT_FLAG_TXI)) uart_ch2_tx_kick();
+	NVIC_EnableIRQ(UART_data2_irq);
+}
+
+// Fill the UART Tx FIFO, the Tx interrupt is enabled while the Tx ring buffer data remains
+static void uart_ch2_tx_kick(void)
+{
+	while(!IS_BUFFER_EMPTY(data2_tx) && !(UART_data2->FR & UART_FR_TXFF))
+	{
+		UART_SendData(UART_data2, BUFFER_OUT(data2_tx));
+		BUFFER_OUT_MOVE(data2_tx, 1);
+	}
+	
+	if(!IS_BUFFER_EMPTY(data2_tx))	UART_data2->IMSC |= UART_IT_FLAG_TXI;
+	else							UART_data2->IMSC &= ~(UART_IT_FLAG_TXI);
+}
+#endif
+
 /*
 void UART1_Configuration(void)
 {
@@ -189,7 +585,6 @@ void serial_info_init(UART_TypeDef *pUART, struct __serial_info *serial)
 {
 	UART_InitTypeDef UART_InitStructure;
 	uint32_t valid_arg = 0;
-	uint32_t baud_table[] = {300, 600, 1200, 1800, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200, 230400};
 
 	/* Set Baud Rate */
 	if(serial->baud_rate < (sizeof(baud_table) / sizeof(baud_table[0])))
@@ -246,6 +641,13 @@ void serial_info_init(UART_TypeDef *pUART, struct __serial_info *serial)
 			break;
 	}
 	
+	/* Character timing for the one-shot timers: RS-485 driver enable turnaround, Rx gap (data UART only) */
+	if(pUART == UART_data)
+	{
+		uart_bit_ticks = GetSystemClock() / UART_InitStructure.UART_BaudRate;
+		uart_frame_bits = 1 + word_len_table[serial->data_bits] + ((serial->parity != parity_none)?1:0) + stop_bit_table[serial->stop_bits];
+	}
+	
 	/* Flow Control */
 	if(serial->uart_interface == UART_IF_RS232_TTL)
 	{
@@ -289,14 +691,33 @@ void serial_info_init(UART_TypeDef *pUART, struct __serial_info *serial)
 		// GPIO configration (RTS pin -> GPIO: 485SEL)
 		get_uart_rs485_sel(SEG_DATA_UART);
 		uart_rs485_rs422_init(SEG_DATA_UART);
+		uart_rs485_de_init();
 		//printf("UART Interface: %s mode\r\n", uart_if_mode?"RS-485":"RS-422");
 	}
 	
 	/* Configure the UARTx */
 	UART_InitStructure.UART_Mode = UART_Mode_Rx | UART_Mode_Tx;
 	UART_Init(pUART, &UART_InitStructure);
+	
+#ifdef __USE_UART_RX_FIFO__
+	UART_FIFO_Enable(pUART, UART_RX_FIFO_LEVEL, UART_TX_FIFO_LEVEL);
+#else
+	UART_FIFO_Disable(pUART);
+#endif
 }
 
+// One character time of the serial settings in usec (rounded up), e.g., the Rx gap time of the channel without the gap timer
+uint32_t get_uart_char_usec(struct __serial_info *serial)
+{
+	uint32_t baud = baud_table[baud_115200];
+	uint32_t bits = 1 + 8 + 1;
+	
+	if(serial->baud_rate < (sizeof(baud_table) / sizeof(baud_table[0]))) baud = baud_table[serial->baud_rate];
+	if((serial->data_bits <= word_len9) && (serial->stop_bits <= stop_bit2))
+		bits = 1 + word_len_table[serial->data_bits] + ((serial->parity != parity_none)?1:0) + stop_bit_table[serial->stop_bits];
+	
+	return ((bits * 1000000UL) + baud - 1) / baud;
+}
 
 void check_uart_flow_control(uint8_t flow_ctrl)
 {
@@ -304,7 +725,7 @@ void check_uart_flow_control(uint8_t flow_ctrl)
 	{
 		if((xonoff_status == UART_XON) && (BUFFER_USED_SIZE(data_rx) > UART_OFF_THRESHOLD)) // Send the transmit stop command to peer - go XOFF
 		{
-			UartPutc(UART_data, UART_XOFF);
+			uart_putc_direct(UART_XOFF);
 			xonoff_status = UART_XOFF;
 #ifdef _UART_DEBUG_
 			printf(" >> SEND XOFF [%d / %d]\r\n", BUFFER_USED_SIZE(data_rx), SEG_DATA_BUF_SIZE);
@@ -312,7 +733,7 @@ void check_uart_flow_control(uint8_t flow_ctrl)
 		}
 		else if((xonoff_status == UART_XOFF) && (BUFFER_USED_SIZE(data_rx) < UART_ON_THRESHOLD)) // Send the transmit start command to peer. -go XON
 		{
-			UartPutc(UART_data, UART_XON);
+			uart_putc_direct(UART_XON);
 			xonoff_status = UART_XON;
 #ifdef _UART_DEBUG_
 			printf(" >> SEND XON [%d / %d]\r\n", BUFFER_USED_SIZE(data_rx), SEG_DATA_BUF_SIZE);
@@ -345,11 +766,9 @@ void check_uart_flow_control(uint8_t flow_ctrl)
 
 int32_t uart_putc(uint8_t uartNum, uint8_t ch)
 {
-	DevConfig *value = get_DevConfig_pointer();
-	
 	if(uartNum == SEG_DATA_UART)
 	{
-		UartPutc(UART_data, ch); 
+		while(uart_write(uartNum, &ch, 1) == 0); // Wait for the Tx ring buffer space
 	}
 	else if(uartNum == SEG_DEBUG_UART)
 	{
@@ -382,13 +801,116 @@ int32_t uart_puts(uint8_t uartNum, uint8_t* buf, uint16_t reqSize)
 	return lentot;
 }
 
+// Non-blocking UART write: returns the number of bytes queued to the Tx ring buffer
+int32_t uart_write(uint8_t uartNum, uint8_t* buf, uint16_t reqSize)
+{
+	const tsRINGBUF * tx = get_uart_tx_ring(uartNum);
+	uint16_t len, len1st;
+	
+	if(tx == 0) return RET_NOK;
+	
+	len = RING_FREE_SIZE(tx);
+	if(len > reqSize) len = reqSize;
+	if(len == 0) return 0;
+	
+	// Contiguous free space from the write position
+	len1st = RING_IN_SPAN(tx);
+	if(len1st > len) len1st = len;
+	
+	memcpy(RING_IN_PTR(tx), buf, len1st);
+	if(len > len1st) memcpy(tx->buf, buf + len1st, len - len1st);
+	RING_IN_MOVE(tx, len);
+	
+#ifdef __USE_DUAL_DATA_UART__
+	if(uartNum == SEG_DATA2_UART)
+	{
+		uart_ch2_tx_start();
+		return len;
+	}
+#endif
+	uart_tx_start();
+	
+	return len;
+}
+
+// Wait until the Tx ring buffer is empty and the last character has been sent
+void uart_tx_wait_complete(uint8_t uartNum)
+{
+	if(uartNum != SEG_DATA_UART) return;
+	
+	while(!IS_BUFFER_EMPTY(data_tx));
+	while(UART_data->FR & UART_FR_BUSY);
+	while(rs485_de_state != RS485_DE_IDLE); // RS-485: wait for the driver disabled
+}
+
+// Tx ring buffer -> UART Tx FIFO (FIFO disabled: 1-byte)
+static void uart_tx_fill_fifo(void)
+{
+	while(!IS_BUFFER_EMPTY(data_tx) && !(UART_data->FR & UART_FR_TXFF))
+	{
+		UART_SendData(UART_data, BUFFER_OUT(data_tx));
+		BUFFER_OUT_MOVE(data_tx, 1);
+	}
+}
+
+// Fill the UART Tx FIFO, the Tx interrupt is enabled while the Tx ring buffer data remains
+// RS-485: the Tx ring buffer empty, wait for the Tx complete to disable the driver
+static void uart_tx_kick(void)
+{
+	uart_tx_fill_fifo();
+	if(!IS_BUFFER_EMPTY(data_tx))
+	{
+		UART_data->IMSC |= UART_IT_FLAG_TXI;
+	}
+	else
+	{
+		UART_data->IMSC &= ~(UART_IT_FLAG_TXI);
+		if(rs485_de_ctrl && (rs485_de_state == RS485_DE_TX))
+		{
+			rs485_de_state = RS485_DE_DRAIN;
+			uart_rs485_timer_start(uart_frame_bits);
+		}
+	}
+}
+
+// Start the transmission if the Tx interrupt is idle; the Tx interrupt occurs only when the FIFO level passes through the trigger level
+static void uart_tx_start(void)
+{
+	NVIC_DisableIRQ(UART_data_irq);
+	if(rs485_de_ctrl)
+	{
+		NVIC_DisableIRQ(UART_RS485_TIMER_IRQ);
+		if(rs485_de_state != RS485_DE_TX) uart_rs485_tx_begin();
+		else if(!(UART_data->IMSC & UART_IT_FLAG_TXI)) uart_tx_kick();
+		NVIC_EnableIRQ(UART_RS485_TIMER_IRQ);
+	}
+	else if(!(UART_data->IMSC & UART_IT_FLAG_TXI))
+	{
+		uart_tx_kick();
+	}
+	NVIC_EnableIRQ(UART_data_irq);
+}
+
+// Send the character directly to the UART Tx FIFO, ahead of the Tx ring buffer data (XON/XOFF)
+static void uart_putc_direct(uint8_t ch)
+{
+	NVIC_DisableIRQ(UART_data_irq);
+	while(UART_data->FR & UART_FR_TXFF);
+	UART_SendData(UART_data, ch);
+	NVIC_EnableIRQ(UART_data_irq);
+}
+
 int32_t uart_getc(uint8_t uartNum)
 {
-	int32_t ch;
+	int32_t ch = RET_NOK; // SEG_DEBUG_UART: not read by this handler
 
 	if(uartNum == SEG_DATA_UART)
 	{
+#ifdef __USE_UART_RX_DMA__
+		while(IS_BUFFER_EMPTY(data_rx)) uart_rx_dma_process();
+#else
 		while(IS_BUFFER_EMPTY(data_rx));
+#endif
 		ch = (int32_t)BUFFER_OUT(data_rx);
 		BUFFER_OUT_MOVE(data_rx, 1);
 	}
@@ -404,7 +926,7 @@ int32_t uart_getc(uint8_t uartNum)
 
 int32_t uart_getc_nonblk(uint8_t uartNum)
 {
-	int32_t ch;
+	int32_t ch = RET_NOK; // SEG_DEBUG_UART: not read by this handler
 
 	if(uartNum == SEG_DATA_UART)
 	{
@@ -422,20 +944,24 @@ int32_t uart_getc_nonblk(uint8_t uartNum)
 	return ch;
 }
 
+// Non-blocking bulk copy: ring buffer -> user's buffer, returns the copied length
+// The data is copied by two segments; [rd ... end of buffer) and [0 ... wr), the write index is read once
 int32_t uart_gets(uint8_t uartNum, uint8_t* buf, uint16_t reqSize)
 {
+	const tsRINGBUF * rx = get_uart_rx_ring(uartNum);
 	uint16_t lentot = 0, len1st = 0;
 
-	if(uartNum == SEG_DATA_UART)
+	if(rx != 0)
 	{
-		lentot = reqSize = MIN(BUFFER_USED_SIZE(data_rx), reqSize);
-		if(IS_BUFFER_OUT_SEPARATED(data_rx) && (len1st = BUFFER_OUT_1ST_SIZE(data_rx)) < reqSize) {
-			memcpy(buf, &BUFFER_OUT(data_rx), len1st);
-			BUFFER_OUT_MOVE(data_rx, len1st);
-			reqSize -= len1st;
-		}
-		memcpy(buf+len1st, &BUFFER_OUT(data_rx), reqSize);
-		BUFFER_OUT_MOVE(data_rx,reqSize);
+		lentot = RING_USED_SIZE(rx);
+		if(lentot > reqSize) lentot = reqSize;
+		
+		len1st = RING_OUT_SPAN(rx);
+		if(len1st > lentot) len1st = lentot;
+		
+		memcpy(buf, RING_OUT_PTR(rx), len1st);
+		if(lentot > len1st) memcpy(buf + len1st, rx->buf, lentot - len1st);
+		RING_OUT_MOVE(rx, lentot);
 	}
 	else if(uartNum == SEG_DEBUG_UART)
 	{
@@ -447,12 +973,269 @@ int32_t uart_gets(uint8_t uartNum, uint8_t* buf, uint16_t reqSize)
 	return lentot;
 }
 
+// Non-blocking bulk copy with the delimiter scan: the copy stops after the delimiter (1 ~ 4 bytes)
+// Each contiguous span of the ring buffer is scanned by memchr for the first byte of the delimiter, and the delimiter
+// is matched by the KMP-style fallback. 'matched' keeps the delimiter bytes matched so far across the calls (and the ring wrap);
+// when the delimiter is found, returns with (*matched == delim_len). The caller have to clear the 'matched' value for the next match.
+int32_t uart_gets_delim(uint8_t uartNum, uint8_t* buf, uint16_t reqSize, uint8_t * delim, uint8_t delim_len, uint8_t * matched)
+{
+	const tsRINGBUF * rx = get_uart_rx_ring(uartNum);
+	uint16_t lentot = 0, len = 0, span = 0, i;
+	uint8_t * ptr;
+	uint8_t * pdelim;
+
+	if(rx == 0) return RET_NOK;
+	if(*matched >= delim_len) *matched = 0;
+	
+	len = RING_USED_SIZE(rx);
+	if(len > reqSize) len = reqSize;
+	
+	while((lentot < len) && (*matched < delim_len))
+	{
+		span = RING_OUT_SPAN(rx);
+		if(span > (len - lentot)) span = len - lentot;
+		ptr = RING_OUT_PTR(rx);
+		
+		for(i = 0; i < span; )
+		{
+			if(*matched == 0)
+			{
+				// Skip to the next candidate of the delimiter
+				pdelim = (uint8_t *)memchr(&ptr[i], delim[0], span - i);
+				if(pdelim == 0) { i = span; break; }
+				i = (uint16_t)(pdelim - ptr);
+			}
+			
+			*matched = uart_delim_match_next(delim, *matched, ptr[i++]);
+			if(*matched == delim_len) break;
+		}
+		
+		memcpy(buf + lentot, ptr, i);
+		RING_OUT_MOVE(rx, i);
+		lentot += i;
+	}
+	
+	return lentot;
+}
+
+// Delimiter matcher: next state of the matched length by the input character
+// On a mismatch, falls back to the longest proper prefix of the delimiter which is also a suffix of the matched bytes
+static uint8_t uart_delim_match_next(uint8_t * delim, uint8_t matched, uint8_t ch)
+{
+	uint8_t k;
+	
+	while(1)
+	{
+		if(ch == delim[matched]) return (matched + 1);
+		if(matched == 0) return 0;
+		
+		for(k = matched - 1; k > 0; k--)
+		{
+			if(!memcmp(delim, &delim[matched - k], k)) break;
+		}
+		matched = k;
+	}
+}
+
 void uart_rx_flush(uint8_t uartNum)
 {
 	if(uartNum == SEG_DATA_UART)
 	{
+#ifdef __USE_UART_RX_DMA__
+		// The DMA block in progress is kept; the landed data is discarded
+		__disable_irq();
+		uart_rx_dma_update();
+		dma_rx_scan = dma_rx_landed;
+		data_rx_wr = dma_rx_landed;
+		data_rx_rd = dma_rx_landed;
+		__enable_irq();
+#else
 		BUFFER_CLEAR(data_rx);
+#endif
+	}
+#ifdef __USE_DUAL_DATA_UART__
+	else if(uartNum == SEG_DATA2_UART)
+	{
+		BUFFER_CLEAR(data2_rx);
 	}
+#endif
+}
+
+// Discards the data not sent yet: the Tx ring buffer is cleared, the characters in the UART Tx FIFO are sent
+void uart_tx_flush(uint8_t uartNum)
+{
+	const tsRINGBUF * tx = get_uart_tx_ring(uartNum);
+	
+	if(tx == 0) return;
+	
+	__disable_irq(); // The Tx ring buffer consumer is the UART IRQ handler
+	RING_CLEAR(tx);
+	__enable_irq();
+}
+
+void uart_set_break(uint8_t uartNum, uint8_t on)
+{
+	UART_TypeDef * pUART = get_uart_data_regs(uartNum);
+	
+	if(pUART == 0) return;
+	
+	if(on)	UART_SendBreak(pUART);
+	else	pUART->LCR_H &= ~(UART_LCR_H_BRK);
+}
+
+// ret: the receive errors (UART_RECV_STATUS_xx) latched since the last call, the errors are cleared
+uint8_t uart_get_recv_errors(uint8_t uartNum)
+{
+	UART_TypeDef * pUART = get_uart_data_regs(uartNum);
+	uint8_t errors;
+	
+	if(pUART == 0) return 0;
+	
+	errors = (uint8_t)(pUART->STATUS.RSR & (UART_RECV_STATUS_OE | UART_RECV_STATUS_BE | UART_RECV_STATUS_PE | UART_RECV_STATUS_FE));
+	if(errors) UART_ClearRecvStatus(pUART, errors);
+	
+	return errors;
+}
+
+// ret: [1] CTS asserted (the peer permits the transmission) / [0] negated
+uint8_t uart_get_cts_status(uint8_t uartNum)
+{
+#ifdef __USE_DUAL_DATA_UART__
+	if(uartNum == SEG_DATA2_UART) return 1; // Channel 2: no flow control, the CTS input is not used
+#endif
+	if(uartNum != SEG_DATA_UART) return 0;
+	
+#ifdef __USE_GPIO_HARDWARE_FLOWCONTROL__
+	return (get_uart_cts_pin(uartNum) == UART_CTS_LOW);
+#else
+	return ((UART_data->FR & UART_FR_CTS) != 0);
+#endif
+}
+
+// Runtime change of the data UART line settings (e.g., Telnet COM port control): the UART is re-initialized by the serial settings
+// of its channel, the ring buffers and the interrupt / DMA settings are kept
+void S2E_UART_Reconfiguration(uint8_t uartNum)
+{
+	UART_TypeDef * pUART = get_uart_data_regs(uartNum);
+	struct __serial_info *serial = get_DevConfig_pointer()->serial_info;
+	
+	if(pUART == 0) return;
+#ifdef __USE_DUAL_DATA_UART__
+	if(uartNum == SEG_DATA2_UART) serial = get_DevConfig_ch2_pointer()->serial_info;
+#endif
+	
+	// UART_Init() sets the line control / hardware flow control bits by OR: the previous settings are cleared first
+	pUART->LCR_H &= ~(UART_LCR_H_SPS | UART_LCR_H_WLEN(3) | UART_LCR_H_STP2 | UART_LCR_H_EPS | UART_LCR_H_PEN);
+	pUART->CR &= ~(UART_CR_CTSEn | UART_CR_RTSEn);
+	
+	serial_info_init(pUART, serial);
+}
+
+// Ring buffers and UART registers of the data UARTs
+const tsRINGBUF * get_uart_rx_ring(uint8_t uartNum)
+{
+	if(uartNum == SEG_DATA_UART) return &data_rx_ring;
+#ifdef __USE_DUAL_DATA_UART__
+	if(uartNum == SEG_DATA2_UART) return &data2_rx_ring;
+#endif
+	return 0;
+}
+
+const tsRINGBUF * get_uart_tx_ring(uint8_t uartNum)
+{
+	if(uartNum == SEG_DATA_UART) return &data_tx_ring;
+#ifdef __USE_DUAL_DATA_UART__
+	if(uartNum == SEG_DATA2_UART) return &data2_tx_ring;
+#endif
+	return 0;
+}
+
+static UART_TypeDef * get_uart_data_regs(uint8_t uartNum)
+{
+	if(uartNum == SEG_DATA_UART) return UART_data;
+#ifdef __USE_DUAL_DATA_UART__
+	if(uartNum == SEG_DATA2_UART) return UART_data2;
+#endif
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// UART Rx gap timer: detects the Rx frame end by the Rx line idle time (e.g., Modbus RTU t3.5)
+//		The gap time is counted in the bit times of the data UART settings, not by the 1ms tick
+//		The data below the Rx FIFO trigger level is taken by the Rx timeout interrupt (32 bit times idle),
+//		so the gap time shorter than the Rx timeout is raised to it; the shorter gaps do not end the frame
+////////////////////////////////////////////////////////////////////////////////
+
+// gap_half_chars: gap time in half character times, gap_min_usec: the lower limit of the gap time (usec)
+// gap_half_chars = 0 and gap_min_usec = 0: the timer disabled
+// This function have to call after the data UART configured (S2E_UART_Configuration)
+void uart_rx_gap_timer_init(uint16_t gap_half_chars, uint16_t gap_min_usec)
+{
+	DUALTIMER_InitTypDef Dualtimer_InitStructure;
+	uint32_t min_ticks = gap_min_usec * (GetSystemClock() / 1000000);
+	
+	DUALTIMER_ClockEnable(UART_RX_GAP_TIMER);
+	
+	NVIC_DisableIRQ(UART_data_irq);
+	DUALTIMER_Stop(UART_RX_GAP_TIMER);
+	DUALTIMER_IntClear(UART_RX_GAP_TIMER);
+	
+	rx_gap_ticks = ((uint32_t)gap_half_chars * uart_frame_bits * uart_bit_ticks) / 2;
+	if(rx_gap_ticks < min_ticks) rx_gap_ticks = min_ticks;
+	if((rx_gap_ticks != 0) && (rx_gap_ticks < (UART_RX_TIMEOUT_BITS * uart_bit_ticks))) rx_gap_ticks = UART_RX_TIMEOUT_BITS * uart_bit_ticks;
+	rx_gap_out = rx_gap_in;
+	
+	NVIC_EnableIRQ(UART_data_irq);
+	if(rx_gap_ticks == 0) return;
+	
+	Dualtimer_InitStructure.TimerLoad = rx_gap_ticks;
+	Dualtimer_InitStructure.TimerControl_Mode = DUALTIMER_TimerControl_Periodic;
+	Dualtimer_InitStructure.TimerControl_OneShot = DUALTIMER_TimerControl_OneShot;
+	Dualtimer_InitStructure.TimerControl_Pre = DUALTIMER_TimerControl_Pre_1;
+	Dualtimer_InitStructure.TimerControl_Size = DUALTIMER_TimerControl_Size_32;
+	
+	DUALTIMER_Init(UART_RX_GAP_TIMER, &Dualtimer_InitStructure);
+	DUALTIMER_IntClear(UART_RX_GAP_TIMER);
+	DUALTIMER_IntConfig(UART_RX_GAP_TIMER, ENABLE);
+	
+	NVIC_ClearPendingIRQ(UART_RX_GAP_TIMER_IRQ);
+	NVIC_SetPriority(UART_RX_GAP_TIMER_IRQ, 1);
+	NVIC_EnableIRQ(UART_RX_GAP_TIMER_IRQ);
+}
+
+// ret: [1] the Rx line is idle after the data up to the rx_end (data_rx ring buffer index) / [0] no frame end queued
+// The frame ends are returned in order; DMA mode: the data up to the rx_end may not be published to the ring buffer yet (uart_rx_dma_process)
+uint8_t uart_rx_gap_check(uint16_t * rx_end)
+{
+	if(rx_gap_in == rx_gap_out) return 0;
+	
+	*rx_end = rx_gap_end[rx_gap_out & (UART_RX_GAP_QUEUE_SIZE - 1)];
+	BUFFER_BARRIER();
+	rx_gap_out++;
+	
+	return 1;
+}
+
+// Discards the frame ends queued, e.g., the Rx ring buffer flushed
+void uart_rx_gap_flush(void)
+{
+	rx_gap_out = rx_gap_in;
+}
+
+// Called by the UART IRQ handler for each Rx burst; Rx timeout interrupt: the idle time already elapsed is excluded
+static void uart_rx_gap_timer_start(uint16_t rx_wr, uint8_t rx_timeout)
+{
+	uint32_t ticks = rx_gap_ticks;
+	uint32_t elapsed = UART_RX_TIMEOUT_BITS * uart_bit_ticks;
+	
+	if(ticks == 0) return;
+	if(rx_timeout) ticks = (ticks > elapsed) ? (ticks - elapsed) : 1;
+	
+	rx_gap_wr = rx_wr;
+	
+	DUALTIMER_Stop(UART_RX_GAP_TIMER);
+	DUALTIMER_SetTimerLoad(UART_RX_GAP_TIMER, ticks);
+	DUALTIMER_Start(UART_RX_GAP_TIMER);
 }
 
 uint8_t get_uart_rs485_sel(uint8_t uartNum)
@@ -518,7 +1301,6 @@ void uart_rs485_enable(uint8_t uartNum)
 		{
 			GPIO_SetBits(UART1_RTS_PORT, UART1_RTS_PIN);
 		}
-		delay(1);
 	}
 	
 	//UART_IF_RS422: None
@@ -538,17 +1320,77 @@ void uart_rs485_disable(uint8_t uartNum)
 		{
 			GPIO_ResetBits(UART1_RTS_PORT, UART1_RTS_PIN);
 		}
-		delay(1);
 	}
 	
 	//UART_IF_RS422: None
 }
 
+// RS-485 driver enable control: the driver is enabled by the Tx start and disabled by the Tx complete event (one-shot timer)
+static void uart_rs485_de_init(void)
+{
+	DevConfig *value = get_DevConfig_pointer();
+	DUALTIMER_InitTypDef Dualtimer_InitStructure;
+	
+	rs485_de_ctrl = (uart_if_mode == UART_IF_RS485)?1:0;
+	rs485_de_state = RS485_DE_IDLE;
+	if(!rs485_de_ctrl) return;
+	
+	rs485_pre_delay = value->serial_info_extend[0].rs485_pre_delay;
+	rs485_post_delay = value->serial_info_extend[0].rs485_post_delay;
+	
+	DUALTIMER_ClockEnable(UART_RS485_TIMER);
+	
+	Dualtimer_InitStructure.TimerLoad = uart_bit_ticks;
+	Dualtimer_InitStructure.TimerControl_Mode = DUALTIMER_TimerControl_Periodic;
+	Dualtimer_InitStructure.TimerControl_OneShot = DUALTIMER_TimerControl_OneShot;
+	Dualtimer_InitStructure.TimerControl_Pre = DUALTIMER_TimerControl_Pre_1;
+	Dualtimer_InitStructure.TimerControl_Size = DUALTIMER_TimerControl_Size_32;
+	
+	DUALTIMER_Init(UART_RS485_TIMER, &Dualtimer_InitStructure);
+	DUALTIMER_IntClear(UART_RS485_TIMER);
+	DUALTIMER_IntConfig(UART_RS485_TIMER, ENABLE);
+}
+
+static void uart_rs485_timer_start(uint32_t bits)
+{
+	DUALTIMER_Stop(UART_RS485_TIMER);
+	DUALTIMER_SetTimerLoad(UART_RS485_TIMER, bits * uart_bit_ticks);
+	DUALTIMER_Start(UART_RS485_TIMER);
+}
+
+// Called with the UART / timer IRQ disabled
+static void uart_rs485_tx_begin(void)
+{
+	switch(rs485_de_state)
+	{
+		case RS485_DE_IDLE:
+			uart_rs485_enable(SEG_DATA_UART);
+			if(rs485_pre_delay)
+			{
+				rs485_de_state = RS485_DE_PRE;
+				uart_rs485_timer_start(rs485_pre_delay);
+				break;
+			}
+			rs485_de_state = RS485_DE_TX;
+			uart_tx_kick();
+			break;
+		case RS485_DE_DRAIN: // New data queued before the driver disabled: keep the driver enabled
+		case RS485_DE_POST:
+			DUALTIMER_Stop(UART_RS485_TIMER);
+			DUALTIMER_IntClear(UART_RS485_TIMER);
+			rs485_de_state = RS485_DE_TX;
+			uart_tx_kick();
+			break;
+		default: // RS485_DE_PRE: Tx starts by the timer
+			break;
+	}
+}
+
 #ifdef __USE_GPIO_HARDWARE_FLOWCONTROL__
 	
 uint8_t get_uart_cts_pin(uint8_t uartNum)
 {
-	uint8_t cts_pin;
+	uint8_t cts_pin = UART_CTS_HIGH; // No CTS pin: not clear to send
 
 #ifdef _UART_DEBUG_
 	static uint8_t prev_cts_pin;
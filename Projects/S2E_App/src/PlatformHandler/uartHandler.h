@@ -19,6 +19,20 @@
 #define UART_ON_THRESHOLD	(uint16_t)(SEG_DATA_BUF_SIZE / 10)
 #define UART_OFF_THRESHOLD	(uint16_t)(SEG_DATA_BUF_SIZE - UART_ON_THRESHOLD)
 
+// UART Rx FIFO mode: Rx interrupt occurs by the FIFO trigger level or Rx timeout, IRQ handler drains the FIFO at once
+// If the define '__USE_UART_RX_FIFO__' disabled, Rx interrupt occurs for each byte received
+#define __USE_UART_RX_FIFO__
+#define UART_RX_FIFO_LEVEL		2 // Rx FIFO trigger level; [0] 1/8, [1] 1/4, [2] 1/2, [3] 3/4, [4] 7/8 full
+#define UART_TX_FIFO_LEVEL		0 // Tx FIFO trigger level; [0] 1/8, [1] 1/4, [2] 1/2, [3] 3/4, [4] 7/8 full
+
+// UART Rx DMA mode: Rx data is transferred into the ring buffer by DMA (UART0: DMA channel 2, UART1: channel 3)
+// The landed data is checked (trigger code, XON/XOFF) by uart_rx_dma_process() in main loop, not by the UART IRQ handler
+//#define __USE_UART_RX_DMA__
+#define UART_RX_DMA_BLOCK_SIZE	256 // DMA transfer block size (bytes), SEG_DATA_BUF_SIZE must be a multiple of the block size
+#if defined(__USE_UART_RX_DMA__) && ((SEG_DATA_BUF_SIZE % UART_RX_DMA_BLOCK_SIZE) != 0)
+	#error "SEG_DATA_BUF_SIZE must be a multiple of UART_RX_DMA_BLOCK_SIZE"
+#endif
+
 // UART interface selector, RS-232/TTL or RS-422/485
 #define UART_IF_RS232_TTL			0
 #define UART_IF_RS422_485			1
@@ -122,11 +136,21 @@ extern uint8_t * uart_if_table[];
 void S2E_UART_IRQ_Handler(UART_TypeDef * s2e_uart);
 void S2E_UART_Configuration(void);
 
+#ifdef __USE_UART_RX_DMA__
+void S2E_UART_DMA_IRQ_Handler(void);
+void uart_rx_dma_process(void); // This function have to call by main loop
+#endif
+
+// Dual data UART mode (__USE_DUAL_DATA_UART__, seg.h): channel 2 (UART1), RS-232/TTL without flow control
+void S2E_UART_CH2_IRQ_Handler(void);
+void S2E_UART_CH2_Configuration(void);
+
 //void UART0_Configuration(void); // This function was incorporated into the function "S2E_UART_Configuration()"
 //void UART1_Configuration(void); // This function was incorporated into the function "S2E_UART_Configuration()"
 void UART2_Configuration(void);
 
 void serial_info_init(UART_TypeDef *pUART, struct __serial_info *serial);
+uint32_t get_uart_char_usec(struct __serial_info *serial); // One character time (start + data + parity + stop bits) in usec
 
 // #1 XON/XOFF Software flow control: Check the Buffer usage and Send the start/stop commands
 void check_uart_flow_control(uint8_t flow_ctrl);
@@ -147,49 +171,118 @@ int32_t uart_putc(uint8_t uartNum, uint8_t ch);
 int32_t uart_getc(uint8_t uartNum);
 int32_t uart_puts(uint8_t uartNum, uint8_t* buf, uint16_t reqSize);
 int32_t uart_gets(uint8_t uartNum, uint8_t* buf, uint16_t reqSize);
+int32_t uart_gets_delim(uint8_t uartNum, uint8_t* buf, uint16_t reqSize, uint8_t * delim, uint8_t delim_len, uint8_t * matched); // Stops after the delimiter (multi-byte)
+
+int32_t uart_write(uint8_t uartNum, uint8_t* buf, uint16_t reqSize); // Non-blocking, returns the number of bytes queued
+void uart_tx_wait_complete(uint8_t uartNum);
 
 void uart_rx_flush(uint8_t uartNum);
+void uart_tx_flush(uint8_t uartNum);	// The data in the Tx ring buffer is discarded
+
+// Telnet COM port control (RFC 2217): line / modem control and status of the data UART
+void uart_set_break(uint8_t uartNum, uint8_t on);
+uint8_t uart_get_recv_errors(uint8_t uartNum);	// ret: UART_RECV_STATUS_xx latched since the last call (cleared)
+uint8_t uart_get_cts_status(uint8_t uartNum);	// ret: [1] CTS asserted
+void S2E_UART_Reconfiguration(uint8_t uartNum);	// The serial settings (serial_info) of the channel are applied to the data UART at runtime
 
 uint8_t get_uart_rs485_sel(uint8_t uartNum);
 void uart_rs485_rs422_init(uint8_t uartNum);
 void uart_rs485_disable(uint8_t uartNum);
 void uart_rs485_enable(uint8_t uartNum);
+void S2E_UART_RS485_Timer_IRQ_Handler(void); // RS-485 driver enable turnaround timer, call by DUALTIMER1_Handler
+
+// UART Rx gap timer: Rx frame end detection by the Rx line idle time in character times (one-shot timer re-armed per Rx burst)
+void uart_rx_gap_timer_init(uint16_t gap_half_chars, uint16_t gap_min_usec); // [0, 0] disabled
+uint8_t uart_rx_gap_check(uint16_t * rx_end); // ret: [1] frame end, rx_end: data_rx ring buffer index of the frame end
+void uart_rx_gap_flush(void);
+void S2E_UART_Rx_Gap_Timer_IRQ_Handler(void); // call by DUALTIMER1_Handler
 
 #define MIN(_a, _b) (_a < _b) ? _a : _b
 #define MEM_FREE(mem_p) do{ if(mem_p) { free(mem_p); mem_p = NULL; } }while(0)	//
 //#define BITSET(var_v, bit_v) SET_BIT(var_v, bit_v)	//(var_v |= bit_v)
 //#define BITCLR(var_v, bit_v) CLEAR_BIT(var_v, bit_v)//(var_v &= ~(bit_v))
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Ring buffer: single-producer / single-consumer byte queue (UART IRQ handler <-> main loop)
+//	- _size must be a power of two (<= 32768): the buffer position is the index masked by (_size - 1)
+//	- _wr / _rd are free-running indices; used size = (_wr - _rd), all of the _size bytes are usable
+//	- _wr is updated by the producer only, _rd by the consumer only; no IRQ disable is required
+//	- xxx_MOVE: the barrier orders the data access before the index update (publish / release)
+//	- BUFFER_OUT / BUFFER_OUT_OFFSET / BUFFER_OUT_PTR: the barrier orders the index read (used size) before the data read (acquire)
+//	- Zero-copy access: BUFFER_IN_PTR / BUFFER_OUT_PTR up to the span (xxx_SPAN) limited by the free / used size,
+//	  then commit by BUFFER_IN_MOVE / BUFFER_OUT_MOVE
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+typedef struct __ringbuf {
+	uint8_t * buf;
+	volatile uint16_t * wr;
+	volatile uint16_t * rd;
+	uint16_t sz;
+} tsRINGBUF;
+
 #define BUFFER_DEFINITION(_name, _size) \
+	typedef char _name##_size_check[(((_size) & ((_size) - 1)) == 0 && (_size) <= 0x8000) ? 1 : -1]; \
 	uint8_t _name##_buf[_size]; \
 	volatile uint16_t _name##_wr=0; \
 	volatile uint16_t _name##_rd=0; \
-	volatile uint16_t _name##_sz=_size;
+	const uint16_t _name##_sz=_size; \
+	const tsRINGBUF _name##_ring = {_name##_buf, &_name##_wr, &_name##_rd, _size};
 #define BUFFER_DECLARATION(_name) \
 	extern uint8_t _name##_buf[]; \
-	extern uint16_t _name##_wr, _name##_rd, _name##_sz;
+	extern volatile uint16_t _name##_wr, _name##_rd; \
+	extern const uint16_t _name##_sz; \
+	extern const tsRINGBUF _name##_ring;
 #define BUFFER_CLEAR(_name) \
-	_name##_wr=0;\
-	_name##_rd=0;
+	_name##_rd=_name##_wr; // Called by the consumer: discards the stored data
+
+#define BUFFER_BARRIER()			__DMB()
+#define BUFFER_MASK(_name)			(_name##_sz - 1)
+#define BUFFER_POS(_name, _idx)		((uint16_t)(_idx) & BUFFER_MASK(_name))
 
-#define BUFFER_USED_SIZE(_name) ((_name##_sz + _name##_wr - _name##_rd) % _name##_sz)
-#define BUFFER_FREE_SIZE(_name) ((_name##_sz + _name##_rd - _name##_wr - 1) % _name##_sz)
+#define BUFFER_USED_SIZE(_name) ((uint16_t)(_name##_wr - _name##_rd))
+#define BUFFER_FREE_SIZE(_name) ((uint16_t)(_name##_sz - BUFFER_USED_SIZE(_name)))
 #define IS_BUFFER_EMPTY(_name) ( (_name##_rd) == (_name##_wr))
-#define IS_BUFFER_FULL(_name) (BUFFER_FREE_SIZE(_name) == 0)	// I guess % calc takes time a lot, so...
-//#define IS_BUFFER_FULL(_name) ((_name##_rd!=0 && _name##_wr==_name##_rd-1)||(_name##_rd==0 && _name##_wr==_name##_sz-1))
-
-#define BUFFER_IN(_name) _name##_buf[_name##_wr]
-#define BUFFER_IN_OFFSET(_name, _offset) _name##_buf[_name##_wr + _offset]
-#define BUFFER_IN_MOVE(_name, _num) _name##_wr = (_name##_wr + _num) % _name##_sz
-#define BUFFER_IN_1ST_SIZE(_name) (_name##_sz - _name##_wr - ((_name##_rd==0)?1:0))
-#define BUFFER_IN_2ND_SIZE(_name) ((_name##_rd==0) ? 0 : _name##_rd-1)
-#define IS_BUFFER_IN_SEPARATED(_name) (_name##_rd <= _name##_wr)
-
-#define BUFFER_OUT(_name) _name##_buf[_name##_rd]
-#define BUFFER_OUT_OFFSET(_name, _offset) _name##_buf[_name##_rd + _offset]
-#define BUFFER_OUT_MOVE(_name, _num) _name##_rd = (_name##_rd + _num) % _name##_sz
-#define BUFFER_OUT_1ST_SIZE(_name) (_name##_sz - _name##_rd)
-#define BUFFER_OUT_2ND_SIZE(_name) (_name##_wr)
-#define IS_BUFFER_OUT_SEPARATED(_name) (_name##_rd > _name##_wr)
+#define IS_BUFFER_FULL(_name) (BUFFER_USED_SIZE(_name) == _name##_sz)
+
+// Producer
+#define BUFFER_IN(_name) _name##_buf[BUFFER_POS(_name, _name##_wr)]
+#define BUFFER_IN_OFFSET(_name, _offset) _name##_buf[BUFFER_POS(_name, _name##_wr + (_offset))]
+#define BUFFER_IN_PTR(_name) (&BUFFER_IN(_name))
+#define BUFFER_IN_SPAN(_name) ((uint16_t)(_name##_sz - BUFFER_POS(_name, _name##_wr))) // Contiguous bytes from the write position to the buffer end
+#define BUFFER_IN_MOVE(_name, _num) do { BUFFER_BARRIER(); _name##_wr += (uint16_t)(_num); } while(0)
+
+// Consumer
+#define BUFFER_OUT(_name) (*BUFFER_OUT_PTR(_name))
+#define BUFFER_OUT_OFFSET(_name, _offset) (*(BUFFER_BARRIER(), &_name##_buf[BUFFER_POS(_name, _name##_rd + (_offset))]))
+#define BUFFER_OUT_PTR(_name) (BUFFER_BARRIER(), &_name##_buf[BUFFER_POS(_name, _name##_rd)])
+#define BUFFER_OUT_SPAN(_name) ((uint16_t)(_name##_sz - BUFFER_POS(_name, _name##_rd))) // Contiguous bytes from the read position to the buffer end
+#define BUFFER_OUT_MOVE(_name, _num) do { BUFFER_BARRIER(); _name##_rd += (uint16_t)(_num); } while(0)
+
+// Ring buffer reference: the same ring buffer accessed through a pointer (&xxx_ring),
+// the data path code shared by the data channels works on the ring buffers of its channel
+#define RING_POS(_r, _idx)			((uint16_t)(_idx) & ((_r)->sz - 1))
+
+#define RING_USED_SIZE(_r)			((uint16_t)(*(_r)->wr - *(_r)->rd))
+#define RING_FREE_SIZE(_r)			((uint16_t)((_r)->sz - RING_USED_SIZE(_r)))
+#define IS_RING_EMPTY(_r)			(*(_r)->rd == *(_r)->wr)
+#define IS_RING_FULL(_r)			(RING_USED_SIZE(_r) == (_r)->sz)
+#define RING_CLEAR(_r)				(*(_r)->rd = *(_r)->wr)
+
+// Producer
+#define RING_IN(_r)					(_r)->buf[RING_POS(_r, *(_r)->wr)]
+#define RING_IN_PTR(_r)				(&RING_IN(_r))
+#define RING_IN_SPAN(_r)			((uint16_t)((_r)->sz - RING_POS(_r, *(_r)->wr)))
+#define RING_IN_MOVE(_r, _num)		do { BUFFER_BARRIER(); *(_r)->wr += (uint16_t)(_num); } while(0)
+
+// Consumer
+#define RING_OUT(_r)				(*RING_OUT_PTR(_r))
+#define RING_OUT_OFFSET(_r, _offset)	(*(BUFFER_BARRIER(), &(_r)->buf[RING_POS(_r, *(_r)->rd + (_offset))]))
+#define RING_OUT_PTR(_r)			(BUFFER_BARRIER(), &(_r)->buf[RING_POS(_r, *(_r)->rd)])
+#define RING_OUT_SPAN(_r)			((uint16_t)((_r)->sz - RING_POS(_r, *(_r)->rd)))
+#define RING_OUT_MOVE(_r, _num)		do { BUFFER_BARRIER(); *(_r)->rd += (uint16_t)(_num); } while(0)
+
+// Ring buffers of the data UARTs: NULL if the UART has no ring buffer
+const tsRINGBUF * get_uart_rx_ring(uint8_t uartNum);
+const tsRINGBUF * get_uart_tx_ring(uint8_t uartNum);
 
 #endif /* UARTHANDLER_H_ */
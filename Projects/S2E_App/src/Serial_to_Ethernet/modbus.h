@@ -0,0 +1,42 @@
+#ifndef MODBUS_H_
+#define MODBUS_H_
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+// Modbus TCP <-> Modbus RTU frame conversion for the Modbus TCP gateway mode (MODBUS_TCP_MODE)
+//	Modbus TCP ADU: MBAP header [Transaction ID (2) | Protocol ID (2) | Length (2) | Unit ID (1)] + PDU
+//	Modbus RTU ADU: [Address (1)] + PDU + CRC16 (2, low byte first)
+//	The Unit ID / Address and the PDU are the same in both ADUs: the frame is converted in place
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define MODBUS_MBAP_HEADER_LEN			7		// Unit ID included
+#define MODBUS_MBAP_UNIT_OFFSET			6		// The RTU frame starts at the Unit ID
+#define MODBUS_PDU_MAX					253
+#define MODBUS_RTU_ADU_MIN				4		// Address + Function code + CRC
+#define MODBUS_RTU_ADU_MAX				(1 + MODBUS_PDU_MAX + 2)
+#define MODBUS_TCP_ADU_MAX				(MODBUS_MBAP_UNIT_OFFSET + 1 + MODBUS_PDU_MAX)
+
+#define MODBUS_BROADCAST_ADDR			0		// RTU broadcast request: no response
+
+#define MODBUS_EXCEPTION_FLAG			0x80	// Function code of the exception response
+#define MODBUS_EXCEPTION_GW_PATH		0x0A	// Gateway path unavailable
+#define MODBUS_EXCEPTION_GW_TARGET		0x0B	// Gateway target device failed to respond
+
+// RTU frame timing: t3.5 inter-frame silence, 1750us fixed for the baud rates over 19200
+#define MODBUS_RTU_T35_HALF_CHARS		7
+#define MODBUS_RTU_T35_MIN_USEC			1750
+
+#define MODBUS_RESPONSE_TIMEOUT_DEFAULT	1000	// msec, used when the serial arbitration timeout is not set
+#define MODBUS_TURNAROUND_DELAY			100		// msec, the serial line is released after the broadcast request
+
+uint16_t modbus_crc16(uint8_t * buf, uint16_t len);
+
+uint16_t modbus_get_mbap_length(uint8_t * mbap);	// ret: Length field (Unit ID + PDU) / [0] invalid header
+void modbus_set_mbap_header(uint8_t * adu, uint16_t tid, uint16_t len); // Transaction ID, Protocol ID and Length fields, the Unit ID follows
+
+uint16_t modbus_add_rtu_crc(uint8_t * frame, uint16_t len);		// ret: RTU frame length with CRC
+uint8_t modbus_check_rtu_frame(uint8_t * frame, uint16_t len);		// ret: [1] valid length and CRC / [0] invalid
+uint16_t modbus_set_exception(uint8_t * frame, uint8_t addr, uint8_t func, uint8_t code); // ret: exception frame length without CRC
+
+#endif /* MODBUS_H_ */
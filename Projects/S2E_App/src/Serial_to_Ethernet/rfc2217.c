@@ -0,0 +1,577 @@
+#include <string.h>
+#include "common.h"
+#include "W7500x_wztoe.h"
+#include "socket.h"
+#include "ConfigData.h"
+#include "seg.h"
+#include "uartHandler.h"
+#include "gpioHandler.h"
+#include "rfc2217.h"
+
+/* Private define ------------------------------------------------------------*/
+// Telnet stream parser states, kept across the received packets
+#define TELNET_ST_DATA				0
+#define TELNET_ST_IAC				1
+#define TELNET_ST_OPTION			2	// WILL / WONT / DO / DONT, the option code follows
+#define TELNET_ST_SB				3
+#define TELNET_ST_SB_IAC			4
+
+// Supported options: flags of the negotiated option states
+#define TELNET_OPTF_BINARY			0x01
+#define TELNET_OPTF_SGA				0x02
+#define TELNET_OPTF_COM_PORT		0x04
+
+#define RFC2217_LINE_ERRORS			(RFC2217_LINE_OVERRUN | RFC2217_LINE_PARITY_ERROR | RFC2217_LINE_FRAMING_ERROR | RFC2217_LINE_BREAK)
+
+typedef struct {
+	uint8_t active;
+	uint8_t state;				// Telnet stream parser state
+	uint8_t cmd;				// WILL / WONT / DO / DONT in progress
+	uint8_t sb_len;
+	uint8_t sb[RFC2217_SB_MAX];
+	uint8_t opt_local;			// Enabled options of this device (WILL)
+	uint8_t opt_remote;			// Enabled options of the peer (DO)
+	uint8_t opt_local_req;		// Offered by this device, waiting for the answer: the answer is not replied
+	uint8_t opt_remote_req;
+	uint8_t linestate_mask;
+	uint8_t modemstate_mask;
+	uint8_t linestate;			// The last line state / modem state, notified by the changes
+	uint8_t modemstate;
+	uint8_t brk;
+	uint8_t dtr;
+	uint8_t reply_len;
+	uint8_t reply[RFC2217_REPLY_MAX];
+	struct __serial_info serial_stored;	// The serial settings before the connection
+	uint8_t ch;					// S2E channel of the data connection
+	uint8_t uart;				// Data UART of the channel
+} tsTELNET;
+
+/* Private variables ---------------------------------------------------------*/
+static tsTELNET tn_channel[S2E_CHANNELS];
+
+static const uint32_t rfc2217_baud_table[] = {300, 600, 1200, 1800, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200, 230400};
+
+/* Private functions prototypes ----------------------------------------------*/
+static void telnet_queue(tsTELNET * tn, uint8_t * data, uint8_t len);
+static void telnet_send_option(tsTELNET * tn, uint8_t cmd, uint8_t opt);
+static uint8_t telnet_option_flag(uint8_t opt);
+static void telnet_negotiate(tsTELNET * tn, uint8_t cmd, uint8_t opt);
+
+static void rfc2217_reply(tsTELNET * tn, uint8_t cmd, uint8_t * value, uint8_t len);
+static void rfc2217_subnegotiation(tsTELNET * tn);
+static uint8_t rfc2217_set_control(tsTELNET * tn, uint8_t val);
+static void rfc2217_set_serial(tsTELNET * tn, uint8_t * setting, uint8_t val);
+static uint8_t rfc2217_baud_index(uint32_t baud);
+static uint8_t rfc2217_get_linestate(tsTELNET * tn);
+static uint8_t rfc2217_get_modemstate(tsTELNET * tn);
+
+/* Public functions ----------------------------------------------------------*/
+
+void rfc2217_open(uint8_t ch, uint8_t sock)
+{
+	tsTELNET * tn = &tn_channel[ch];
+	
+	memset(tn, 0x00, sizeof(tsTELNET));
+	tn->ch = ch;
+	tn->uart = S2E_CHANNEL_UART(ch);
+	tn->active = SEG_ENABLE;
+	tn->state = TELNET_ST_DATA;
+	tn->linestate_mask = RFC2217_LINESTATE_MASK_DEFAULT;
+	tn->modemstate_mask = RFC2217_MODEMSTATE_MASK_DEFAULT;
+	tn->dtr = SEG_ENABLE;
+	memcpy(&tn->serial_stored, get_DevConfig_channel(ch)->serial_info, sizeof(struct __serial_info));
+	
+	// Binary transmission and suppress go ahead in both directions, the client enables the COM port control
+	tn->opt_local_req = TELNET_OPTF_BINARY | TELNET_OPTF_SGA;
+	tn->opt_remote_req = TELNET_OPTF_BINARY | TELNET_OPTF_SGA | TELNET_OPTF_COM_PORT;
+	telnet_send_option(tn, TELNET_WILL, TELNET_OPT_BINARY);
+	telnet_send_option(tn, TELNET_DO, TELNET_OPT_BINARY);
+	telnet_send_option(tn, TELNET_WILL, TELNET_OPT_SGA);
+	telnet_send_option(tn, TELNET_DO, TELNET_OPT_SGA);
+	telnet_send_option(tn, TELNET_DO, TELNET_OPT_COM_PORT);
+	
+	rfc2217_process(ch, sock, SEG_ENABLE);
+}
+
+void rfc2217_close(uint8_t ch)
+{
+	tsTELNET * tn = &tn_channel[ch];
+	struct __serial_info *serial = get_DevConfig_channel(ch)->serial_info;
+	
+	if(tn->active != SEG_ENABLE) return;
+	tn->active = SEG_DISABLE;
+	
+	if(tn->brk) uart_set_break(tn->uart, OFF);
+	if(!tn->dtr && (serial->dtr_en == SEG_ENABLE)) set_flowcontrol_dtr_pin(ON);
+	
+	if(memcmp(&tn->serial_stored, serial, sizeof(struct __serial_info)) != 0)
+	{
+		memcpy(serial, &tn->serial_stored, sizeof(struct __serial_info));
+		S2E_UART_Reconfiguration(tn->uart);
+		init_seg_rx_gap_timer(ch);
+	}
+}
+
+uint8_t rfc2217_has_iac(uint8_t * buf, uint16_t len)
+{
+	return (len && (memchr(buf, TELNET_IAC, len) != NULL));
+}
+
+// The IAC bytes are counted by the memchr() scan first (most of the data has none),
+// then the data is moved from the end and the IAC bytes are doubled until the first IAC
+uint16_t rfc2217_escape(uint8_t * buf, uint16_t len)
+{
+	uint8_t * end = buf + len;
+	uint8_t * src = buf;
+	uint8_t * dst;
+	uint16_t iac = 0;
+	
+	while((src < end) && ((src = memchr(src, TELNET_IAC, end - src)) != NULL))
+	{
+		iac++;
+		src++;
+	}
+	if(iac == 0) return len;
+	
+	src = end;
+	dst = end + iac;
+	while(dst != src)
+	{
+		if((*--dst = *--src) == TELNET_IAC) *--dst = TELNET_IAC;
+	}
+	
+	return (len + iac);
+}
+
+// The data between the IAC bytes is moved at once, the commands are processed byte by byte
+uint16_t rfc2217_unescape(uint8_t ch, uint8_t * buf, uint16_t len)
+{
+	tsTELNET * tn = &tn_channel[ch];
+	uint8_t * src = buf;
+	uint8_t * dst = buf;
+	uint8_t * end = buf + len;
+	uint8_t * iac;
+	uint16_t n;
+	uint8_t c;
+	
+	while(src < end)
+	{
+		if(tn->state == TELNET_ST_DATA)
+		{
+			iac = memchr(src, TELNET_IAC, end - src);
+			n = (uint16_t)(((iac != NULL) ? iac : end) - src);
+			if(dst != src) memmove(dst, src, n);
+			dst += n;
+			src += n;
+			
+			if(iac == NULL) break;
+			src++;
+			tn->state = TELNET_ST_IAC;
+			continue;
+		}
+		
+		c = *src++;
+		switch(tn->state)
+		{
+			case TELNET_ST_IAC:
+				if(c == TELNET_IAC)
+				{
+					*dst++ = TELNET_IAC; // Escaped data byte
+					tn->state = TELNET_ST_DATA;
+				}
+				else if(c >= TELNET_WILL)
+				{
+					tn->cmd = c;
+					tn->state = TELNET_ST_OPTION;
+				}
+				else if(c == TELNET_SB)
+				{
+					tn->sb_len = 0;
+					tn->state = TELNET_ST_SB;
+				}
+				else
+				{
+					tn->state = TELNET_ST_DATA; // NOP, GA and the other commands: ignored
+				}
+				break;
+			
+			case TELNET_ST_OPTION:
+				telnet_negotiate(tn, tn->cmd, c);
+				tn->state = TELNET_ST_DATA;
+				break;
+			
+			case TELNET_ST_SB:
+				if(c == TELNET_IAC) tn->state = TELNET_ST_SB_IAC;
+				else if(tn->sb_len < RFC2217_SB_MAX) tn->sb[tn->sb_len++] = c;
+				break;
+			
+			case TELNET_ST_SB_IAC:
+				if(c == TELNET_IAC)
+				{
+					if(tn->sb_len < RFC2217_SB_MAX) tn->sb[tn->sb_len++] = TELNET_IAC; // Escaped value byte
+					tn->state = TELNET_ST_SB;
+				}
+				else
+				{
+					if(c == TELNET_SE) rfc2217_subnegotiation(tn);
+					tn->state = TELNET_ST_DATA;
+				}
+				break;
+			
+			default:
+				tn->state = TELNET_ST_DATA;
+				break;
+		}
+	}
+	
+	return (uint16_t)(dst - buf);
+}
+
+void rfc2217_process(uint8_t ch, uint8_t sock, uint8_t send_permitted)
+{
+	tsTELNET * tn = &tn_channel[ch];
+	uint8_t state, changes, notify;
+	
+	// Line state / modem state notifications: the client enabled the COM port control
+	if(tn->opt_remote & TELNET_OPTF_COM_PORT)
+	{
+		state = rfc2217_get_linestate(tn);
+		if(((state ^ tn->linestate) | (state & RFC2217_LINE_ERRORS)) & tn->linestate_mask)
+		{
+			notify = state & tn->linestate_mask;
+			rfc2217_reply(tn, RFC2217_NOTIFY_LINESTATE, &notify, 1);
+		}
+		tn->linestate = state;
+		
+		state = rfc2217_get_modemstate(tn);
+		changes = state ^ tn->modemstate;
+		if(changes & RFC2217_MODEM_CTS) changes |= RFC2217_MODEM_CTS_DELTA;
+		if(changes & RFC2217_MODEM_DSR) changes |= RFC2217_MODEM_DSR_DELTA;
+		if(changes & tn->modemstate_mask)
+		{
+			notify = (state | (changes & 0x0F)) & tn->modemstate_mask;
+			rfc2217_reply(tn, RFC2217_NOTIFY_MODEMSTATE, &notify, 1);
+		}
+		tn->modemstate = state;
+	}
+	
+	// The queued commands are sent as a whole: not split by the data
+	if(!send_permitted || (tn->reply_len == 0)) return;
+	if(getSn_TX_FSR(sock) < tn->reply_len) return;
+	
+	if(send(sock, tn->reply, tn->reply_len) == tn->reply_len) tn->reply_len = 0;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+// The reply queue full: the command is dropped
+static void telnet_queue(tsTELNET * tn, uint8_t * data, uint8_t len)
+{
+	if((tn->reply_len + len) > RFC2217_REPLY_MAX) return;
+	
+	memcpy(&tn->reply[tn->reply_len], data, len);
+	tn->reply_len += len;
+}
+
+static void telnet_send_option(tsTELNET * tn, uint8_t cmd, uint8_t opt)
+{
+	uint8_t buf[3];
+	
+	buf[0] = TELNET_IAC;
+	buf[1] = cmd;
+	buf[2] = opt;
+	telnet_queue(tn, buf, 3);
+}
+
+static uint8_t telnet_option_flag(uint8_t opt)
+{
+	switch(opt)
+	{
+		case TELNET_OPT_BINARY:		return TELNET_OPTF_BINARY;
+		case TELNET_OPT_SGA:		return TELNET_OPTF_SGA;
+		case TELNET_OPT_COM_PORT:	return TELNET_OPTF_COM_PORT;
+		default:					break;
+	}
+	
+	return 0;
+}
+
+// The option state changes are acknowledged once; the answers to the offers of this device are not replied (no negotiation loop)
+static void telnet_negotiate(tsTELNET * tn, uint8_t cmd, uint8_t opt)
+{
+	uint8_t flag = telnet_option_flag(opt);
+	
+	switch(cmd)
+	{
+		case TELNET_DO:
+			if(flag == 0)
+			{
+				telnet_send_option(tn, TELNET_WONT, opt);
+			}
+			else if(tn->opt_local_req & flag)
+			{
+				tn->opt_local_req &= ~flag;
+				tn->opt_local |= flag;
+			}
+			else if(!(tn->opt_local & flag))
+			{
+				tn->opt_local |= flag;
+				telnet_send_option(tn, TELNET_WILL, opt);
+			}
+			break;
+		
+		case TELNET_DONT:
+			if(tn->opt_local_req & flag)
+			{
+				tn->opt_local_req &= ~flag;
+			}
+			else if(tn->opt_local & flag)
+			{
+				tn->opt_local &= ~flag;
+				telnet_send_option(tn, TELNET_WONT, opt);
+			}
+			break;
+		
+		case TELNET_WILL:
+			if(flag == 0)
+			{
+				telnet_send_option(tn, TELNET_DONT, opt);
+			}
+			else if(tn->opt_remote_req & flag)
+			{
+				tn->opt_remote_req &= ~flag;
+				tn->opt_remote |= flag;
+			}
+			else if(!(tn->opt_remote & flag))
+			{
+				tn->opt_remote |= flag;
+				telnet_send_option(tn, TELNET_DO, opt);
+			}
+			break;
+		
+		case TELNET_WONT:
+			if(tn->opt_remote_req & flag)
+			{
+				tn->opt_remote_req &= ~flag;
+			}
+			else if(tn->opt_remote & flag)
+			{
+				tn->opt_remote &= ~flag;
+				telnet_send_option(tn, TELNET_DONT, opt);
+			}
+			break;
+		
+		default:
+			break;
+	}
+}
+
+// IAC SB COM-PORT-OPTION <cmd> <value, IAC doubled> IAC SE
+static void rfc2217_reply(tsTELNET * tn, uint8_t cmd, uint8_t * value, uint8_t len)
+{
+	uint8_t buf[RFC2217_REPLY_MAX];
+	uint8_t n = 0;
+	uint8_t i;
+	
+	if((6 + (len * 2)) > RFC2217_REPLY_MAX) return;
+	
+	buf[n++] = TELNET_IAC;
+	buf[n++] = TELNET_SB;
+	buf[n++] = TELNET_OPT_COM_PORT;
+	buf[n++] = cmd + RFC2217_SERVER_OFFSET;
+	for(i = 0; i < len; i++)
+	{
+		if(value[i] == TELNET_IAC) buf[n++] = TELNET_IAC;
+		buf[n++] = value[i];
+	}
+	buf[n++] = TELNET_IAC;
+	buf[n++] = TELNET_SE;
+	
+	telnet_queue(tn, buf, n);
+}
+
+static void rfc2217_subnegotiation(tsTELNET * tn)
+{
+	struct __serial_info *serial = get_DevConfig_channel(tn->ch)->serial_info;
+	uint8_t * name = get_DevConfig_pointer()->module_name;
+	uint8_t cmd, val;
+	uint8_t buf[4];
+	uint32_t baud;
+	uint8_t len;
+	
+	if((tn->sb_len < 2) || (tn->sb[0] != TELNET_OPT_COM_PORT)) return;
+	
+	cmd = tn->sb[1];
+	val = tn->sb[2];
+	
+	// The commands with a value
+	if((cmd != RFC2217_SIGNATURE) && (tn->sb_len < 3)) return;
+	
+	switch(cmd)
+	{
+		case RFC2217_SIGNATURE: // The signature of the client is ignored
+			if(tn->sb_len != 2) break;
+			for(len = 0; (len < sizeof(get_DevConfig_pointer()->module_name)) && name[len]; len++);
+			rfc2217_reply(tn, cmd, name, len);
+			break;
+		
+		case RFC2217_SET_BAUDRATE: // 4-bytes, network byte order
+			if(tn->sb_len < 6) return;
+			baud = ((uint32_t)tn->sb[2] << 24) | ((uint32_t)tn->sb[3] << 16) | ((uint32_t)tn->sb[4] << 8) | tn->sb[5];
+			if(baud != 0) rfc2217_set_serial(tn, &serial->baud_rate, rfc2217_baud_index(baud));
+			
+			baud = rfc2217_baud_table[serial->baud_rate];
+			buf[0] = (uint8_t)(baud >> 24);
+			buf[1] = (uint8_t)(baud >> 16);
+			buf[2] = (uint8_t)(baud >> 8);
+			buf[3] = (uint8_t)baud;
+			rfc2217_reply(tn, cmd, buf, 4);
+			break;
+		
+		case RFC2217_SET_DATASIZE:
+			if(val == 7) rfc2217_set_serial(tn, &serial->data_bits, word_len7);
+			else if(val == 8) rfc2217_set_serial(tn, &serial->data_bits, word_len8);
+			
+			val = word_len_table[serial->data_bits];
+			rfc2217_reply(tn, cmd, &val, 1);
+			break;
+		
+		case RFC2217_SET_PARITY: // NONE / ODD / EVEN: parity_none / parity_odd / parity_even, MARK / SPACE not supported
+			if((val >= RFC2217_PARITY_NONE) && (val <= RFC2217_PARITY_EVEN)) rfc2217_set_serial(tn, &serial->parity, val - RFC2217_PARITY_NONE);
+			
+			val = serial->parity + RFC2217_PARITY_NONE;
+			rfc2217_reply(tn, cmd, &val, 1);
+			break;
+		
+		case RFC2217_SET_STOPSIZE: // 1.5 stop bits not supported
+			if((val == RFC2217_STOPSIZE_1) || (val == RFC2217_STOPSIZE_2)) rfc2217_set_serial(tn, &serial->stop_bits, val - RFC2217_STOPSIZE_1);
+			
+			val = serial->stop_bits + RFC2217_STOPSIZE_1;
+			rfc2217_reply(tn, cmd, &val, 1);
+			break;
+		
+		case RFC2217_SET_CONTROL:
+			val = rfc2217_set_control(tn, val);
+			rfc2217_reply(tn, cmd, &val, 1);
+			break;
+		
+		case RFC2217_SET_LINESTATE_MASK:
+			tn->linestate_mask = val;
+			rfc2217_reply(tn, cmd, &val, 1);
+			break;
+		
+		case RFC2217_SET_MODEMSTATE_MASK:
+			tn->modemstate_mask = val;
+			rfc2217_reply(tn, cmd, &val, 1);
+			break;
+		
+		case RFC2217_PURGE_DATA:
+			lock_seg_data_path(); // The UART Ring buffers flushed: the flush by PendSV is held off
+			if(val & RFC2217_PURGE_RX) uart_rx_flush(tn->uart);
+			if(val & RFC2217_PURGE_TX) uart_tx_flush(tn->uart);
+			unlock_seg_data_path();
+			rfc2217_reply(tn, cmd, &val, 1);
+			break;
+		
+		default: // FLOWCONTROL-SUSPEND / RESUME: the data to the client is limited by the TCP window
+			break;
+	}
+}
+
+// ret: the actual value
+static uint8_t rfc2217_set_control(tsTELNET * tn, uint8_t val)
+{
+	struct __serial_info *serial = get_DevConfig_channel(tn->ch)->serial_info;
+	
+	switch(val)
+	{
+		case RFC2217_REQUEST:
+			break;
+		
+		case RFC2217_CONTROL_FLOW_NONE: // flow_none / flow_xon_xoff / flow_rts_cts, RS-422/485 and channel 2: none only
+		case RFC2217_CONTROL_FLOW_XONXOFF:
+		case RFC2217_CONTROL_FLOW_HARDWARE:
+			if((serial->uart_interface == UART_IF_RS232_TTL) && (tn->ch == S2E_CH1)) rfc2217_set_serial(tn, &serial->flow_control, val - RFC2217_CONTROL_FLOW_NONE);
+			break;
+		
+		case RFC2217_CONTROL_BREAK_REQUEST:
+			return (tn->brk ? RFC2217_CONTROL_BREAK_ON : RFC2217_CONTROL_BREAK_OFF);
+		
+		case RFC2217_CONTROL_BREAK_ON:
+		case RFC2217_CONTROL_BREAK_OFF:
+			tn->brk = (val == RFC2217_CONTROL_BREAK_ON);
+			uart_set_break(tn->uart, tn->brk);
+			return val;
+		
+		case RFC2217_CONTROL_DTR_REQUEST:
+			return (tn->dtr ? RFC2217_CONTROL_DTR_ON : RFC2217_CONTROL_DTR_OFF);
+		
+		case RFC2217_CONTROL_DTR_ON: // DTR pin: DTR/DSR handshake enabled only
+		case RFC2217_CONTROL_DTR_OFF:
+			tn->dtr = (val == RFC2217_CONTROL_DTR_ON);
+			if(serial->dtr_en == SEG_ENABLE) set_flowcontrol_dtr_pin(tn->dtr ? ON : OFF);
+			return val;
+		
+		case RFC2217_CONTROL_RTS_REQUEST: // RTS pin: hardware flow control / RS-485 driver enable, not controlled by the client
+			return RFC2217_CONTROL_RTS_ON;
+		
+		default: // RTS ON / OFF, inbound flow control: acknowledged
+			return val;
+	}
+	
+	return (serial->flow_control + RFC2217_CONTROL_FLOW_NONE);
+}
+
+// The line settings are applied at once, the data queued to the UART before the command is sent by the new settings
+static void rfc2217_set_serial(tsTELNET * tn, uint8_t * setting, uint8_t val)
+{
+	if(*setting == val) return;
+	
+	*setting = val;
+	S2E_UART_Reconfiguration(tn->uart);
+	init_seg_rx_gap_timer(tn->ch); // Rx gap in character times
+}
+
+// ret: enum baud, the nearest supported baud rate not above the request (300 at least)
+static uint8_t rfc2217_baud_index(uint32_t baud)
+{
+	uint8_t i;
+	
+	for(i = baud_230400; i > baud_300; i--)
+	{
+		if(baud >= rfc2217_baud_table[i]) break;
+	}
+	
+	return i;
+}
+
+static uint8_t rfc2217_get_linestate(tsTELNET * tn)
+{
+	const tsRINGBUF * rx = get_uart_rx_ring(tn->uart);
+	const tsRINGBUF * tx = get_uart_tx_ring(tn->uart);
+	uint8_t errors = uart_get_recv_errors(tn->uart);
+	uint8_t state = 0;
+	
+	if(errors & UART_RECV_STATUS_OE) state |= RFC2217_LINE_OVERRUN;
+	if(errors & UART_RECV_STATUS_PE) state |= RFC2217_LINE_PARITY_ERROR;
+	if(errors & UART_RECV_STATUS_FE) state |= RFC2217_LINE_FRAMING_ERROR;
+	if(errors & UART_RECV_STATUS_BE) state |= RFC2217_LINE_BREAK;
+	
+	if(RING_USED_SIZE(rx)) state |= RFC2217_LINE_DATA_READY;
+	if(IS_RING_EMPTY(tx)) state |= (RFC2217_LINE_THR_EMPTY | RFC2217_LINE_TSR_EMPTY);
+	
+	return state;
+}
+
+// CTS: RTS/CTS flow control only, DSR: DTR/DSR handshake only, the signals not used are reported as asserted
+// DCD: the data connection established
+static uint8_t rfc2217_get_modemstate(tsTELNET * tn)
+{
+	struct __serial_info *serial = get_DevConfig_channel(tn->ch)->serial_info;
+	uint8_t state = RFC2217_MODEM_DCD;
+	
+	if((serial->flow_control != flow_rts_cts) || uart_get_cts_status(tn->uart)) state |= RFC2217_MODEM_CTS;
+	if((serial->dsr_en != SEG_ENABLE) || get_flowcontrol_dsr_pin()) state |= RFC2217_MODEM_DSR;
+	
+	return state;
+}
@@ -0,0 +1,104 @@
+#ifndef RFC2217_H_
+#define RFC2217_H_
+
+#include <stdint.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+// Telnet COM Port Control Option (RFC 2217) for the data socket, SEGCP_PO: SEGCP_TELNET
+//	Telnet stream: the data byte 0xFF is sent as IAC IAC, the commands start with IAC
+//	COM port commands: IAC SB COM-PORT-OPTION <command> <value> IAC SE, the access server (this device)
+//	replies with <command + 100> and the actual value. The line settings are applied to the data UART
+//	of the channel without saving, the stored settings are restored when the connection is closed.
+//	The binary transmission option is offered in both directions: no CR NUL / CR LF translation
+///////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Telnet commands
+#define TELNET_SE						240
+#define TELNET_SB						250
+#define TELNET_WILL						251
+#define TELNET_WONT						252
+#define TELNET_DO						253
+#define TELNET_DONT						254
+#define TELNET_IAC						255
+
+// Telnet options
+#define TELNET_OPT_BINARY				0
+#define TELNET_OPT_SGA					3		// Suppress go ahead
+#define TELNET_OPT_COM_PORT				44		// COM port control
+
+// COM port commands: client -> access server, the access server uses (command + RFC2217_SERVER_OFFSET)
+#define RFC2217_SIGNATURE				0
+#define RFC2217_SET_BAUDRATE			1
+#define RFC2217_SET_DATASIZE			2
+#define RFC2217_SET_PARITY				3
+#define RFC2217_SET_STOPSIZE			4
+#define RFC2217_SET_CONTROL				5
+#define RFC2217_NOTIFY_LINESTATE		6
+#define RFC2217_NOTIFY_MODEMSTATE		7
+#define RFC2217_FLOWCONTROL_SUSPEND		8
+#define RFC2217_FLOWCONTROL_RESUME		9
+#define RFC2217_SET_LINESTATE_MASK		10
+#define RFC2217_SET_MODEMSTATE_MASK		11
+#define RFC2217_PURGE_DATA				12
+#define RFC2217_SERVER_OFFSET			100
+
+// SET-DATASIZE / SET-PARITY / SET-STOPSIZE / SET-CONTROL: [0] request the current value
+#define RFC2217_REQUEST					0
+
+#define RFC2217_PARITY_NONE				1
+#define RFC2217_PARITY_ODD				2
+#define RFC2217_PARITY_EVEN				3
+
+#define RFC2217_STOPSIZE_1				1
+#define RFC2217_STOPSIZE_2				2
+
+#define RFC2217_CONTROL_FLOW_NONE		1
+#define RFC2217_CONTROL_FLOW_XONXOFF	2
+#define RFC2217_CONTROL_FLOW_HARDWARE	3
+#define RFC2217_CONTROL_BREAK_REQUEST	4
+#define RFC2217_CONTROL_BREAK_ON		5
+#define RFC2217_CONTROL_BREAK_OFF		6
+#define RFC2217_CONTROL_DTR_REQUEST		7
+#define RFC2217_CONTROL_DTR_ON			8
+#define RFC2217_CONTROL_DTR_OFF			9
+#define RFC2217_CONTROL_RTS_REQUEST		10
+#define RFC2217_CONTROL_RTS_ON			11
+#define RFC2217_CONTROL_RTS_OFF			12
+
+#define RFC2217_PURGE_RX				1		// Access server receive buffer: serial -> network
+#define RFC2217_PURGE_TX				2		// Access server transmit buffer: network -> serial
+#define RFC2217_PURGE_BOTH				3
+
+// NOTIFY-LINESTATE
+#define RFC2217_LINE_DATA_READY			0x01
+#define RFC2217_LINE_OVERRUN			0x02
+#define RFC2217_LINE_PARITY_ERROR		0x04
+#define RFC2217_LINE_FRAMING_ERROR		0x08
+#define RFC2217_LINE_BREAK				0x10
+#define RFC2217_LINE_THR_EMPTY			0x20
+#define RFC2217_LINE_TSR_EMPTY			0x40
+#define RFC2217_LINESTATE_MASK_DEFAULT	0x00
+
+// NOTIFY-MODEMSTATE: [7:4] the signals, [3:0] the changes
+#define RFC2217_MODEM_CTS_DELTA			0x01
+#define RFC2217_MODEM_DSR_DELTA			0x02
+#define RFC2217_MODEM_CTS				0x10
+#define RFC2217_MODEM_DSR				0x20
+#define RFC2217_MODEM_DCD				0x80
+#define RFC2217_MODEMSTATE_MASK_DEFAULT	0xFF
+
+#define RFC2217_SB_MAX					6		// Option, command and the value (baud rate: 4-bytes); the longer signature is truncated
+#define RFC2217_REPLY_MAX				64		// Queued replies / notifications, sent as a whole between the data packets
+
+// ch: S2E channel of the data connection (seg.h), each channel has its own Telnet state and serial settings
+void rfc2217_open(uint8_t ch, uint8_t sock);	// The data connection established: the option negotiation starts
+void rfc2217_close(uint8_t ch);					// The data connection closed: the stored serial settings are restored
+
+uint8_t rfc2217_has_iac(uint8_t * buf, uint16_t len);
+uint16_t rfc2217_escape(uint8_t * buf, uint16_t len);		// In place, the buffer must have room for the doubled IAC bytes (up to len * 2); ret: escaped length
+uint16_t rfc2217_unescape(uint8_t ch, uint8_t * buf, uint16_t len);		// In place, the commands are processed; ret: data length
+
+// The replies and the line / modem state notifications are sent when no escaped data is partially sent (send_permitted)
+void rfc2217_process(uint8_t ch, uint8_t sock, uint8_t send_permitted);
+
+#endif /* RFC2217_H_ */
@@ -9,55 +9,179 @@
 #include "timerHandler.h"
 #include "uartHandler.h"
 #include "gpioHandler.h"
+#include "modbus.h"
+#include "rfc2217.h"
+#include "eventHandler.h"
 
 /* Private define ------------------------------------------------------------*/
+#define SEG_ARB_OWNER_NONE		0xFF	// Serial line arbitration: no transaction in progress
+
+// TCP server multi-session: the number of the session sockets, SOCK_DATA_SESSION4 is the data socket of channel 2 in the dual data UART mode
+#ifdef __USE_DUAL_DATA_UART__
+	#define SEG_SESSIONS			(TCP_SERVER_SESSIONS_MAX - 1)
+#else
+	#define SEG_SESSIONS			TCP_SERVER_SESSIONS_MAX
+#endif
+
+// S2E session timers: the timer table of the session context, a running timer is counted up by the tick of its unit (saturated at 0xFFFF)
+// The connection timers come first, the TCP server multi-session contexts have the connection timers only
+typedef enum {S2E_TIMER_KEEPALIVE, S2E_TIMER_CONNECTION_AUTH, S2E_TIMER_INACTIVITY, S2E_TIMER_CONN_MAX,
+              S2E_TIMER_RECONNECTION = S2E_TIMER_CONN_MAX, S2E_TIMER_SERIAL_INPUT, S2E_TIMER_COALESCE, S2E_TIMER_RX_GAP, S2E_TIMER_MAX
+} teS2ETIMER;
+
+#define S2E_TIMER_UNIT_MSEC		0
+#define S2E_TIMER_UNIT_SEC		1
+
+// The run flags are byte-wide: set / cleared by the main loop without the read-modify-write of the timer IRQ handler
+#define S2E_TIMER_RUN(ctx, id)		((ctx)->timer_run[S2E_TIMER_##id])
+#define S2E_TIMER_TIME(ctx, id)		((ctx)->timer_time[S2E_TIMER_##id])
+
+// TCP server multi-session: connection state / timers of the sessions, session [0] uses the S2E data socket of the channel
+typedef struct {
+	uint8_t sock;
+	uint8_t flag_connect_pw_auth;
+	uint8_t flag_sent_first_keepalive;
+	volatile uint8_t timer_run[S2E_TIMER_CONN_MAX];		// Connection timers of the session
+	volatile uint16_t timer_time[S2E_TIMER_CONN_MAX];
+	uint16_t u2e_sent;						// Sent length of the pending serial data
+} tsSEGSESSION;
+
+// UDP mode 1:N: peer table learned from the received packets, the least recently heard peer is replaced when the table is full
+typedef struct {
+	uint8_t valid;
+	uint8_t ip[4];
+	uint16_t port;
+	volatile uint16_t age;	// sec, time since the last packet received from the peer
+} tsUDPPEER;
+
+// S2E session context: the state of a data channel (data UART <-> data socket),
+// the state machine / data path / timer entry points operate on the context, the settings are the channel settings (get_DevConfig_channel)
+struct __s2e_session {
+	uint8_t ch;								// S2E_CH1 / S2E_CH2
+	uint8_t sock;							// S2E data socket
+	uint8_t uart;							// Data UART
+	const tsRINGBUF * rx;					// UART Rx / Tx ring buffers of the data UART
+	const tsRINGBUF * tx;
+	uint8_t * send_buf;						// User's buffers: UART to Ethernet / Ethernet to UART
+	uint8_t * recv_buf;
+	uint16_t buf_size;
+	tsSEGSESSION * session;					// TCP server multi-session: the sessions of the channel
+	uint8_t sessions_max;
+	uint8_t mixed_state;					// TCP_MIXED_MODE: MIXED_SERVER / MIXED_CLIENT
+	uint8_t isXON;							// XON/XOFF (Software flow control), Serial data can be transmitted to peer when XON enabled
+	uint8_t arb_owner;						// Serial line arbitration: session index of the requester
+	uint8_t flag_connect_pw_auth;			// TCP_SERVER_MODE only (+ MIXED_SERVER)
+	uint8_t flag_sent_first_keepalive;
+	uint8_t flag_serial_input_time_elapse;	// for Time delimiter
+	uint8_t flag_u2e_remainder;				// Partially sent data is left in the user's buffer (non-block io mode)
+	uint8_t delim_matched;					// Packing delimiter (multi-byte): delimiter bytes matched
+	uint8_t delim_appendix;					// and the appendix bytes remaining, kept across the calls
+	uint8_t telnet;							// Telnet COM port control (RFC 2217) of the current connection
+	uint8_t reconnection_count;				// TCP_MIXED_MODE: connection retries of MIXED_CLIENT
+	uint16_t u2e_size;						// User's buffer size idx
+	uint16_t e2u_size;
+	uint8_t peerip[4];						// UDP: Peer netinfo
+	uint16_t peerport;
+	tsUDPPEER udp_peer[UDP_PEER_TABLE_SIZE];
+	uint8_t udp_peer_next;					// [ALL] next peer of the packet in progress / [ROUNDROBIN] next peer for the next packet
+	uint8_t e2u_session_turn;				// Round-robin start index of the sessions for Ethernet to UART
+	volatile uint16_t arb_time;				// Transaction time after the request is sent (msec)
+	// Modbus TCP gateway: the transaction on the serial line, the requester is the serial line arbitration owner
+	uint16_t mb_tid;						// Transaction ID of the request
+	uint8_t mb_addr;						// RTU slave address (Unit ID)
+	uint8_t mb_func;						// Function code
+	uint16_t mb_frame_end;					// Rx ring buffer index of the RTU frame end (t3.5 silence)
+	uint8_t flag_mb_frame_end;
+	// Time delimiter by the Rx gap: Rx ring buffer index of the frame end
+	uint8_t flag_rx_frame_end;
+	uint16_t rx_frame_end;
+	// Rx gap of the UART without the gap timer (channel 2): the idle time counted by the 1ms tick (S2E_TIMER_RX_GAP)
+	uint16_t gap_msec;						// [0] disabled
+	volatile uint16_t gap_wr;				// Rx ring buffer index at the last Rx burst
+	volatile uint16_t gap_end;				// Rx ring buffer index at the Rx line idle (frame end), the last one
+	volatile uint8_t gap_in;				// updated by the timer IRQ handler only
+	uint8_t gap_out;						// updated by the main loop only
+	volatile uint16_t timer_time[S2E_TIMER_MAX];
+	volatile uint8_t timer_run[S2E_TIMER_MAX];
+};
+
 // Ring Buffer
 BUFFER_DECLARATION(data_rx);
+BUFFER_DECLARATION(data_tx);
+#ifdef __USE_DUAL_DATA_UART__
+BUFFER_DECLARATION(data2_rx);
+BUFFER_DECLARATION(data2_tx);
+#endif
 
 /* Private variables ---------------------------------------------------------*/
 uint8_t flag_s2e_application_running = 0;
 
 uint8_t opmode = DEVICE_GW_MODE;
-static uint8_t mixed_state = MIXED_SERVER;
 static uint8_t sw_modeswitch_at_mode_on = SEG_DISABLE;
 static uint16_t client_any_port = 0;
 
-// Timer Enable flags / Time
-uint8_t enable_inactivity_timer = SEG_DISABLE;
-volatile uint16_t inactivity_time = 0;
-
-uint8_t enable_keepalive_timer = SEG_DISABLE;
-volatile uint16_t keepalive_time = 0;
-
+// Mode switch timer (msec): serial command mode trigger code, the device operation mode
 uint8_t enable_modeswitch_timer = SEG_DISABLE;
 volatile uint16_t modeswitch_time = 0;
 volatile uint16_t modeswitch_gap_time = DEFAULT_MODESWITCH_INTER_GAP;
 
-uint8_t enable_reconnection_timer = SEG_DISABLE;
-volatile uint16_t reconnection_time = 0;
+// Immediate flush mode: the PendSV flush is held off (pending) while the main loop uses the data path
+static volatile uint8_t seg_data_path_lock = 0;
+static volatile uint8_t flag_flush_pending = SEG_DISABLE;
 
-uint8_t enable_serial_input_timer = SEG_DISABLE;
-volatile uint16_t serial_input_time = 0;
-uint8_t flag_serial_input_time_elapse = SEG_DISABLE; // for Time delimiter
+// Event-driven main loop: the data moved (sent, received or queued to the UART) since the last check
+static volatile uint8_t flag_seg_progress = SEG_DISABLE;
 
-// added for auth timeout
-uint8_t enable_connection_auth_timer = SEG_DISABLE;
-volatile uint16_t connection_auth_time = 0;
-
-// flags
-uint8_t flag_connect_pw_auth = SEG_DISABLE; // TCP_SERVER_MODE only
-uint8_t flag_sent_keepalive = SEG_DISABLE;
-uint8_t flag_sent_first_keepalive = SEG_DISABLE;
+// Serial to Ethernet latency (channel 1): time stamp of the first serial data not sent yet, histogram of the samples (usec)
+static volatile uint32_t u2e_rx_stamp;
+static volatile uint8_t flag_u2e_rx_stamp = SEG_DISABLE;
+static uint16_t u2e_latency_hist[SEG_LATENCY_BUCKETS + 1]; // the last bucket: overflow
+static uint32_t u2e_latency_count = 0;
+static uint32_t u2e_latency_max = 0;
 
 // static variables for function: check_modeswitch_trigger()
 static uint8_t triggercode_idx;
 static uint8_t ch_tmp[3];
 
-// User's buffer / size idx
+// User's buffer
 extern uint8_t g_send_buf[DATA_BUF_SIZE];
 extern uint8_t g_recv_buf[DATA_BUF_SIZE];
-uint16_t u2e_size = 0;
-uint16_t e2u_size = 0;
+
+// TCP server multi-session of channel 1, SOCK_DATA_SESSION4 is the data socket of channel 2 in the dual data UART mode
+static tsSEGSESSION seg_session[SEG_SESSIONS] = {
+	{SOCK_DATA}, {SOCK_DATA_SESSION2}, {SOCK_DATA_SESSION3},
+#ifndef __USE_DUAL_DATA_UART__
+	{SOCK_DATA_SESSION4}
+#endif
+};
+
+#ifdef __USE_DUAL_DATA_UART__
+// Channel 2: a single session (the data socket), the user's buffers of its own
+static tsSEGSESSION seg_ch2_session[1] = {{SOCK_DATA_CH2}};
+static uint8_t g_ch2_send_buf[SEG_DATA2_USER_BUF_SIZE];
+static uint8_t g_ch2_recv_buf[SEG_DATA2_USER_BUF_SIZE];
+#endif
+
+// S2E session contexts: channel 1 (SEG_DATA_UART <-> SOCK_DATA) and channel 2 of the dual data UART mode (SEG_DATA2_UART <-> SOCK_DATA_CH2)
+static s2e_session_t s2e_channel[S2E_CHANNELS] = {
+	{S2E_CH1, SOCK_DATA, SEG_DATA_UART, &data_rx_ring, &data_tx_ring, g_send_buf, g_recv_buf, DATA_BUF_SIZE,
+	 seg_session, SEG_SESSIONS, MIXED_SERVER, SEG_ENABLE, SEG_ARB_OWNER_NONE},
+#ifdef __USE_DUAL_DATA_UART__
+	{S2E_CH2, SOCK_DATA_CH2, SEG_DATA2_UART, &data2_rx_ring, &data2_tx_ring, g_ch2_send_buf, g_ch2_recv_buf, SEG_DATA2_USER_BUF_SIZE,
+	 seg_ch2_session, 1, MIXED_SERVER, SEG_ENABLE, SEG_ARB_OWNER_NONE}
+#endif
+};
+
+// Timer unit of the S2E session timers
+static const uint8_t s2e_timer_unit[S2E_TIMER_MAX] = {
+	S2E_TIMER_UNIT_MSEC,	// S2E_TIMER_KEEPALIVE
+	S2E_TIMER_UNIT_MSEC,	// S2E_TIMER_CONNECTION_AUTH
+	S2E_TIMER_UNIT_SEC,		// S2E_TIMER_INACTIVITY
+	S2E_TIMER_UNIT_MSEC,	// S2E_TIMER_RECONNECTION
+	S2E_TIMER_UNIT_MSEC,	// S2E_TIMER_SERIAL_INPUT
+	S2E_TIMER_UNIT_MSEC,	// S2E_TIMER_COALESCE
+	S2E_TIMER_UNIT_MSEC		// S2E_TIMER_RX_GAP
+};
 
 // S2E Data byte count variables
 volatile uint32_t s2e_uart_rx_bytecount = 0;
@@ -65,15 +189,10 @@ volatile uint32_t s2e_uart_tx_bytecount = 0;
 volatile uint32_t s2e_ether_rx_bytecount = 0;
 volatile uint32_t s2e_ether_tx_bytecount = 0;
 
-// UDP: Peer netinfo
-uint8_t peerip[4] = {0, };
+// UDP: the last peer IP printed out
 uint8_t peerip_tmp[4] = {0xff, };
-uint16_t peerport = 0;
-
-// XON/XOFF (Software flow control) flag, Serial data can be transmitted to peer when XON enabled. 
-uint8_t isXON = SEG_ENABLE;
 
-char * str_working[] = {"TCP_CLIENT_MODE", "TCP_SERVER_MODE", "TCP_MIXED_MODE", "UDP_MODE"};
+char * str_working[] = {"TCP_CLIENT_MODE", "TCP_SERVER_MODE", "TCP_MIXED_MODE", "UDP_MODE", "MODBUS_TCP_MODE"};
 
 uint8_t flag_process_dhcp_success = OFF;
 uint8_t flag_process_dns_success = OFF;
@@ -84,19 +203,67 @@ uint8_t isSocketOpen_TCPclient = OFF;
 uint8_t tmp_timeflag_for_debug = 0;
 
 /* Private functions prototypes ----------------------------------------------*/
-void proc_SEG_tcp_client(uint8_t sock);
-void proc_SEG_tcp_server(uint8_t sock);
-void proc_SEG_tcp_mixed(uint8_t sock);
-void proc_SEG_udp(uint8_t sock);
-
-void uart_to_ether(uint8_t sock);
-void ether_to_uart(uint8_t sock);
-uint16_t get_serial_data(void);
-void reset_SEG_timeflags(void);
-uint8_t check_connect_pw_auth(uint8_t * buf, uint16_t len);
+void proc_SEG_tcp_client(s2e_session_t * ctx);
+void proc_SEG_tcp_server(s2e_session_t * ctx);
+void proc_SEG_tcp_mixed(s2e_session_t * ctx);
+void proc_SEG_udp(s2e_session_t * ctx);
+void update_udp_peer(s2e_session_t * ctx, uint8_t * ip, uint16_t port);
+void clear_udp_peers(s2e_session_t * ctx);
+int32_t send_udp_peers(s2e_session_t * ctx, uint8_t sock, uint8_t * buf, uint16_t len1st, uint16_t len);
+uint8_t check_udp_multicast(s2e_session_t * ctx);
+
+// TCP server multi-session
+void proc_SEG_tcp_multi_server(s2e_session_t * ctx);
+void proc_SEG_tcp_server_sessions(s2e_session_t * ctx);
+void proc_SEG_tcp_server_session(s2e_session_t * ctx, tsSEGSESSION * session);
+void uart_to_ether_sessions(s2e_session_t * ctx);
+void ether_to_uart_session(s2e_session_t * ctx, tsSEGSESSION * session);
+uint8_t get_tcp_server_sessions(s2e_session_t * ctx);
+void reset_SEG_session(tsSEGSESSION * session);
+uint16_t get_arbitration_timeout(s2e_session_t * ctx);
+void end_serial_arbitration(s2e_session_t * ctx);
+
+// Modbus TCP gateway
+void proc_SEG_modbus_gateway(s2e_session_t * ctx);
+void modbus_tcp_to_rtu(s2e_session_t * ctx, tsSEGSESSION * session);
+void modbus_rtu_to_tcp(s2e_session_t * ctx);
+uint8_t send_modbus_response(s2e_session_t * ctx, uint8_t sock, uint16_t len);
+uint16_t get_modbus_response_timeout(s2e_session_t * ctx);
+
+void uart_to_ether(s2e_session_t * ctx);
+void ether_to_uart(s2e_session_t * ctx);
+uint8_t check_uart_cts_permitted(s2e_session_t * ctx);
+void put_serial_data(s2e_session_t * ctx);
+uint16_t get_serial_data(s2e_session_t * ctx);
+void consume_sent_data(s2e_session_t * ctx, uint8_t zerocopy, uint16_t len);
+void reset_SEG_timeflags(s2e_session_t * ctx);
+uint8_t check_connect_pw_auth(s2e_session_t * ctx, uint8_t * buf, uint16_t len);
 void restore_serial_data(uint8_t idx);
-
-uint8_t check_tcp_connect_exception(void);
+uint16_t get_packing_time_msec(s2e_session_t * ctx);
+uint8_t check_packing_options(s2e_session_t * ctx);
+static uint8_t check_e2u_permitted(s2e_session_t * ctx);
+static uint8_t check_u2e_permitted(s2e_session_t * ctx, uint8_t state);
+static uint8_t check_seg_channel_pending(s2e_session_t * ctx);
+uint8_t check_immediate_flush(s2e_session_t * ctx);
+void add_u2e_latency_sample(s2e_session_t * ctx);
+uint16_t get_packing_coalesce_size(s2e_session_t * ctx);
+
+uint8_t check_tcp_connect_exception(s2e_session_t * ctx);
+uint8_t check_telnet_mode(s2e_session_t * ctx);
+
+// Data channels: channel 1 has the serial command mode / flow control / UART Rx gap timer, channel 2 has its own settings only
+static uint8_t check_seg_channel_active(s2e_session_t * ctx);
+static void set_seg_status(s2e_session_t * ctx, teDEVSTATUS status);
+static uint8_t get_seg_status(s2e_session_t * ctx);
+static uint8_t get_seg_store_permitted(s2e_session_t * ctx);
+static void init_modeswitch_gap_time(s2e_session_t * ctx);
+static uint8_t seg_rx_gap_check(s2e_session_t * ctx, uint16_t * rx_end);
+static void seg_rx_gap_flush(s2e_session_t * ctx);
+
+// S2E session timers
+void tick_s2e_timers(volatile uint16_t * time, volatile uint8_t * run, uint8_t num, uint8_t unit);
+void seg_session_timer_msec(s2e_session_t * ctx);
+void seg_session_timer_sec(s2e_session_t * ctx);
 
 void set_device_status(teDEVSTATUS status);
 uint16_t get_tcp_any_port(void);
@@ -106,11 +273,11 @@ void add_data_transfer_bytecount(teDATADIR dir, uint16_t len);
 
 /* Public & Private functions ------------------------------------------------*/
 
-void do_seg(uint8_t sock)
+void do_seg(s2e_session_t * ctx)
 {
 	//DevConfig *s2e = get_DevConfig_pointer();
-	struct __network_info *net = (struct __network_info *)get_DevConfig_pointer()->network_info;
-	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	struct __network_info *net = get_DevConfig_channel(ctx->ch)->network_info;
+	struct __serial_info *serial = get_DevConfig_channel(ctx->ch)->serial_info;
 	struct __firmware_update *fwupdate = (struct __firmware_update *)&(get_DevConfig_pointer()->firmware_update);
 	
 //#ifdef _SEG_DEBUG_
@@ -119,15 +286,15 @@ void do_seg(uint8_t sock)
 	{
 		//if(opmode == DEVICE_GW_MODE) 	printf("working mode: %s, mixed: %s\r\n", str_working[net->working_mode], (net->working_mode == 2)?(mixed_state ? "CLIENT":"SERVER"):("NONE"));
 		//else 							printf("opmode: DEVICE_AT_MODE\r\n");
-		//printf("UART2Ether - ringbuf: %d, rd: %d, wr: %d, u2e_size: %d\r\n", BUFFER_USED_SIZE(data_rx), data_rx_rd, data_rx_wr, u2e_size);
-		//printf("UART2Ether - ringbuf: %d, rd: %d, wr: %d, u2e_size: %d peer xon/off: %s\r\n", BUFFER_USED_SIZE(data_rx), data_rx_rd, data_rx_wr, u2e_size, isXON?"XON":"XOFF");
+		//printf("UART2Ether - ringbuf: %d, rd: %d, wr: %d, u2e_size: %d\r\n", BUFFER_USED_SIZE(data_rx), data_rx_rd, data_rx_wr, ctx->u2e_size);
+		//printf("UART2Ether - ringbuf: %d, rd: %d, wr: %d, u2e_size: %d peer xon/off: %s\r\n", BUFFER_USED_SIZE(data_rx), data_rx_rd, data_rx_wr, ctx->u2e_size, ctx->isXON?"XON":"XOFF");
 		//printf("modeswitch_time [%d] : modeswitch_gap_time [%d]\r\n", modeswitch_time, modeswitch_gap_time);
 		//printf("[%d]: [%d] ", modeswitch_time, modeswitch_gap_time);
 		//printf("idx = %d\r\n", triggercode_idx);
 		//printf("opmode: %d\r\n", opmode);
-		//printf("flag_connect_pw_auth: %d\r\n", flag_connect_pw_auth);
-		//printf("UART2Ether - ringbuf: %d, u2e_size: %d\r\n", BUFFER_USED_SIZE(data_rx), u2e_size);
-		//printf("Ether2UART - RX_RSR: %d, e2u_size: %d\r\n", getSn_RX_RSR(sock), e2u_size);
+		//printf("flag_connect_pw_auth: %d\r\n", ctx->flag_connect_pw_auth);
+		//printf("UART2Ether - ringbuf: %d, u2e_size: %d\r\n", BUFFER_USED_SIZE(data_rx), ctx->u2e_size);
+		//printf("Ether2UART - RX_RSR: %d, e2u_size: %d\r\n", getSn_RX_RSR(sock), ctx->e2u_size);
 		//printf("sock_state: %x\r\n", getSn_SR(sock));
 		//printf("\r\nringbuf_usedlen = %d\r\n", BUFFER_USED_SIZE(data_rx));
 		//printf(" >> UART: [Rx] %u / [Tx] %u\r\n", get_data_transfer_bytecount(SEG_UART_RX), get_data_transfer_bytecount(SEG_UART_TX));
@@ -140,11 +307,11 @@ void do_seg(uint8_t sock)
 	// Firmware update: Do not run SEG process
 	if(fwupdate->fwup_flag == SEG_ENABLE) return;
 	
-	// Serial AT command mode enabled, initial settings
-	if((opmode == DEVICE_GW_MODE) && (sw_modeswitch_at_mode_on == SEG_ENABLE))
+	// Serial AT command mode enabled, initial settings: channel 1 only, channel 2 keeps running
+	if((ctx->ch == S2E_CH1) && (opmode == DEVICE_GW_MODE) && (sw_modeswitch_at_mode_on == SEG_ENABLE))
 	{
 		// Socket disconnect (TCP only) / close
-		process_socket_termination(sock);
+		process_data_channel_termination(S2E_CH1);
 		
 		// Mode switch
 		init_trigger_modeswitch(DEVICE_AT_MODE);
@@ -153,24 +320,29 @@ void do_seg(uint8_t sock)
 		sw_modeswitch_at_mode_on = SEG_DISABLE;
 	}
 	
-	if(opmode == DEVICE_GW_MODE) 
+	if(check_seg_channel_active(ctx)) 
 	{
 		switch(net->working_mode)
 		{
 			case TCP_CLIENT_MODE:
-				proc_SEG_tcp_client(sock);
+				proc_SEG_tcp_client(ctx);
 				break;
 			
 			case TCP_SERVER_MODE:
-				proc_SEG_tcp_server(sock);
+				if(get_tcp_server_sessions(ctx) > 1)	proc_SEG_tcp_multi_server(ctx);
+				else								proc_SEG_tcp_server(ctx);
 				break;
 			
 			case TCP_MIXED_MODE:
-				proc_SEG_tcp_mixed(sock);
+				proc_SEG_tcp_mixed(ctx);
 				break;
 			
 			case UDP_MODE:
-				proc_SEG_udp(sock);
+				proc_SEG_udp(ctx);
+				break;
+			
+			case MODBUS_TCP_MODE:
+				proc_SEG_modbus_gateway(ctx);
 				break;
 			
 			default:
@@ -178,15 +350,35 @@ void do_seg(uint8_t sock)
 		}
 		
 		// XON/XOFF Software flow control: Check the Buffer usage and Send the start/stop commands
-		// [WIZnet Device] -> [Peer]
-		if((serial->flow_control == flow_xon_xoff) || serial->flow_control == flow_rts_cts) check_uart_flow_control(serial->flow_control);
+		// [WIZnet Device] -> [Peer], the data UART of channel 1 only
+		if((ctx->ch == S2E_CH1) && ((serial->flow_control == flow_xon_xoff) || serial->flow_control == flow_rts_cts)) check_uart_flow_control(serial->flow_control);
 	}
 }
 
+// Channel 1 runs in the gateway mode, channel 2 runs while it is enabled (the serial command mode is channel 1 only)
+static uint8_t check_seg_channel_active(s2e_session_t * ctx)
+{
+#ifdef __USE_DUAL_DATA_UART__
+	if(ctx->ch == S2E_CH2) return (get_DevConfig_ch2_pointer()->channel_en == SEG_ENABLE);
+#endif
+	return (opmode == DEVICE_GW_MODE);
+}
+
+// Connection status of the channel: channel 1 is the device status (status indicator pin)
+static void set_seg_status(s2e_session_t * ctx, teDEVSTATUS status)
+{
+	if(ctx->ch == S2E_CH1)	set_device_status(status);
+	else					get_DevConfig_channel(ctx->ch)->network_info->state = status;
+}
+
+static uint8_t get_seg_status(s2e_session_t * ctx)
+{
+	return get_DevConfig_channel(ctx->ch)->network_info->state;
+}
+
 void set_device_status(teDEVSTATUS status)
 {
 	struct __network_info *net = (struct __network_info *)get_DevConfig_pointer()->network_info;
-	struct __serial_info *serial = (struct __serial_info *)&(get_DevConfig_pointer()->serial_info);
 	
 	switch(status)
 	{
@@ -226,36 +418,58 @@ uint8_t get_device_status(void)
 }
 
 
-void proc_SEG_udp(uint8_t sock)
+void proc_SEG_udp(s2e_session_t * ctx)
 {
-	DevConfig *s2e = get_DevConfig_pointer();
-	struct __network_info *net = (struct __network_info *)get_DevConfig_pointer()->network_info;
-	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	struct __network_info *net = cfg->network_info;
+	struct __serial_info *serial = cfg->serial_info;
+	uint8_t sock = ctx->sock;
+	uint8_t * mcast_ip = cfg->network_info_extend->udp_multicast_ip;
+	uint8_t mcast_mac[6];
+	uint8_t flag = SF_IO_NONBLOCK;
 	
 	uint8_t state = getSn_SR(sock);
 	switch(state)
 	{
 		case SOCK_UDP:
-			if(BUFFER_USED_SIZE(data_rx) || u2e_size)	uart_to_ether(sock);
-			if(getSn_RX_RSR(sock) 	|| e2u_size)		ether_to_uart(sock);
+			if(RING_USED_SIZE(ctx->rx) || ctx->u2e_size)	uart_to_ether(ctx);
+			if(getSn_RX_RSR(sock) 	|| ctx->e2u_size)		ether_to_uart(ctx);
 			break;
 			
 		case SOCK_CLOSED:
-			//reset_SEG_timeflags();
-			BUFFER_CLEAR(data_rx);
+			//reset_SEG_timeflags(ctx);
+			uart_rx_flush(ctx->uart);
 		
-			u2e_size = 0;
-			e2u_size = 0;
+			ctx->u2e_size = 0;
+			ctx->e2u_size = 0;
+			clear_udp_peers(ctx);
+			
+			// UDP multicast: the group address / port and the group MAC address (01:00:5E + lower 23-bit of the group address) are set before the socket open
+			if(check_udp_multicast(ctx))
+			{
+				mcast_mac[0] = 0x01;
+				mcast_mac[1] = 0x00;
+				mcast_mac[2] = 0x5E;
+				mcast_mac[3] = mcast_ip[1] & 0x7F;
+				mcast_mac[4] = mcast_ip[2];
+				mcast_mac[5] = mcast_ip[3];
+				
+				setSn_DHAR(sock, mcast_mac);
+				setSn_DIPR(sock, mcast_ip);
+				setSn_DPORT(sock, net->local_port);
+				flag |= SF_MULTI_ENABLE;
+			}
 			
-			if(socket(sock, Sn_MR_UDP, net->local_port, 0) == sock)
+			if(socket(sock, Sn_MR_UDP, net->local_port, flag) == sock)
 			{
-				set_device_status(ST_UDP);
+				set_seg_status(ctx, ST_UDP);
 				
-				if(net->packing_time) modeswitch_gap_time = net->packing_time; // replace the GAP time (default: 500ms)
+				init_modeswitch_gap_time(ctx); // replace the GAP time (default: 500ms)
 				
 				if(serial->serial_debug_en == SEG_ENABLE)
 				{
 					printf(" > SEG:UDP_MODE:SOCKOPEN\r\n");
+					if(flag & SF_MULTI_ENABLE) printf(" > SEG:UDP_MODE:MULTICAST GROUP %d.%d.%d.%d : %d\r\n", mcast_ip[0], mcast_ip[1], mcast_ip[2], mcast_ip[3], net->local_port);
 				}
 			}
 			break;
@@ -264,12 +478,12 @@ void proc_SEG_udp(uint8_t sock)
 	}
 }
 
-void proc_SEG_tcp_client(uint8_t sock)
+void proc_SEG_tcp_client(s2e_session_t * ctx)
 {
-	DevConfig *s2e = get_DevConfig_pointer();
-	struct __network_info *net = (struct __network_info *)get_DevConfig_pointer()->network_info;
-	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	struct __network_info *net = get_DevConfig_channel(ctx->ch)->network_info;
+	struct __serial_info *serial = get_DevConfig_channel(ctx->ch)->serial_info;
 	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
+	uint8_t sock = ctx->sock;
 	
 	uint16_t source_port;
 	uint8_t destip[4] = {0, };
@@ -279,12 +493,12 @@ void proc_SEG_tcp_client(uint8_t sock)
 	switch(state)
 	{
 		case SOCK_INIT:
-			if(reconnection_time >= net->reconnection)
+			if(S2E_TIMER_TIME(ctx, RECONNECTION) >= net->reconnection)
 			{
-				reconnection_time = 0; // reconnection time variable clear
+				S2E_TIMER_TIME(ctx, RECONNECTION) = 0; // reconnection time variable clear
 				
 				// TCP connect exception checker; e.g., dns failed / zero srcip ... and etc.
-				if(check_tcp_connect_exception() == ON) return;
+				if(check_tcp_connect_exception(ctx) == ON) return;
 				
 				// TCP connect
 				connect(sock, net->remote_ip, net->remote_port);
@@ -301,20 +515,24 @@ void proc_SEG_tcp_client(uint8_t sock)
 				// S2E: TCP client mode initialize after connection established (only once)
 				///////////////////////////////////////////////////////////////////////////////////////////////////
 				//net->state = ST_CONNECT;
-				set_device_status(ST_CONNECT);
+				set_seg_status(ctx, ST_CONNECT);
 				
-				if(!inactivity_time && net->inactivity)		enable_inactivity_timer = SEG_ENABLE;
-				if(!keepalive_time && net->keepalive_en)	enable_keepalive_timer = SEG_ENABLE;
+				if(!S2E_TIMER_TIME(ctx, INACTIVITY) && net->inactivity)		S2E_TIMER_RUN(ctx, INACTIVITY) = SEG_ENABLE;
+				if(!S2E_TIMER_TIME(ctx, KEEPALIVE) && net->keepalive_en)	S2E_TIMER_RUN(ctx, KEEPALIVE) = SEG_ENABLE;
 				
 				// TCP server mode only, This flag have to be enabled always at TCP client mode
-				//if(option->pw_connect_en == SEG_ENABLE)		flag_connect_pw_auth = SEG_ENABLE;
-				flag_connect_pw_auth = SEG_ENABLE;
+				//if(option->pw_connect_en == SEG_ENABLE)		ctx->flag_connect_pw_auth = SEG_ENABLE;
+				ctx->flag_connect_pw_auth = SEG_ENABLE;
+				
+				// Telnet COM port control: the option negotiation starts
+				ctx->telnet = check_telnet_mode(ctx);
+				if(ctx->telnet) rfc2217_open(ctx->ch, sock);
 				
 				// Reconnection timer disable
-				if(enable_reconnection_timer == SEG_ENABLE)
+				if(S2E_TIMER_RUN(ctx, RECONNECTION) == SEG_ENABLE)
 				{
-					enable_reconnection_timer = SEG_DISABLE;
-					reconnection_time = 0;
+					S2E_TIMER_RUN(ctx, RECONNECTION) = SEG_DISABLE;
+					S2E_TIMER_TIME(ctx, RECONNECTION) = 0;
 				}
 				
 				// Serial debug message printout
@@ -326,7 +544,7 @@ void proc_SEG_tcp_client(uint8_t sock)
 				}
 				
 				// UART Ring buffer clear
-				BUFFER_CLEAR(data_rx);
+				uart_rx_flush(ctx->uart);
 				
 				// Debug message enable flag: TCP client sokect open 
 				isSocketOpen_TCPclient = OFF;
@@ -335,74 +553,80 @@ void proc_SEG_tcp_client(uint8_t sock)
 			}
 			
 			// Serial to Ethernet process
-			if(BUFFER_USED_SIZE(data_rx) || u2e_size)	uart_to_ether(sock);
-			if(getSn_RX_RSR(sock) 	|| e2u_size)		ether_to_uart(sock);
+			if(RING_USED_SIZE(ctx->rx) || ctx->u2e_size)	uart_to_ether(ctx);
+			if(getSn_RX_RSR(sock) 	|| ctx->e2u_size)		ether_to_uart(ctx);
+			if(ctx->telnet) rfc2217_process(ctx->ch, sock, (ctx->flag_u2e_remainder == SEG_DISABLE));
 			
 			// Check the inactivity timer
-			if((enable_inactivity_timer == SEG_ENABLE) && (inactivity_time >= net->inactivity))
+			if((S2E_TIMER_RUN(ctx, INACTIVITY) == SEG_ENABLE) && (S2E_TIMER_TIME(ctx, INACTIVITY) >= net->inactivity))
 			{
 				//disconnect(sock);
 				process_socket_termination(sock);
 				
 				// Keep-alive timer disabled
-				enable_keepalive_timer = DISABLE;
-				keepalive_time = 0;
+				S2E_TIMER_RUN(ctx, KEEPALIVE) = DISABLE;
+				S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 #ifdef _SEG_DEBUG_
 				printf(" > INACTIVITY TIMER: TIMEOUT\r\n");
 #endif
 			}
 			
 			// Check the keee-alive timer
-			if((net->keepalive_en == SEG_ENABLE) && (enable_keepalive_timer == SEG_ENABLE))
+			if((net->keepalive_en == SEG_ENABLE) && (S2E_TIMER_RUN(ctx, KEEPALIVE) == SEG_ENABLE))
 			{
 				// Send the first keee-alive packet
-				if((flag_sent_first_keepalive == SEG_DISABLE) && (keepalive_time >= net->keepalive_wait_time) && (net->keepalive_wait_time != 0))
+				if((ctx->flag_sent_first_keepalive == SEG_DISABLE) && (S2E_TIMER_TIME(ctx, KEEPALIVE) >= net->keepalive_wait_time) && (net->keepalive_wait_time != 0))
 				{
 #ifdef _SEG_DEBUG_
-					printf(" >> send_keepalive_packet_first [%d]\r\n", keepalive_time);
+					printf(" >> send_keepalive_packet_first [%d]\r\n", S2E_TIMER_TIME(ctx, KEEPALIVE));
 #endif
 					send_keepalive_packet_manual(sock); // <-> send_keepalive_packet_auto()
-					keepalive_time = 0;
+					S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 					
-					flag_sent_first_keepalive = SEG_ENABLE;
+					ctx->flag_sent_first_keepalive = SEG_ENABLE;
 				}
 				// Send the keee-alive packet periodically
-				if((flag_sent_first_keepalive == SEG_ENABLE) && (keepalive_time >= net->keepalive_retry_time) && (net->keepalive_retry_time != 0))
+				if((ctx->flag_sent_first_keepalive == SEG_ENABLE) && (S2E_TIMER_TIME(ctx, KEEPALIVE) >= net->keepalive_retry_time) && (net->keepalive_retry_time != 0))
 				{
 #ifdef _SEG_DEBUG_
-					printf(" >> send_keepalive_packet_manual [%d]\r\n", keepalive_time);
+					printf(" >> send_keepalive_packet_manual [%d]\r\n", S2E_TIMER_TIME(ctx, KEEPALIVE));
 #endif
 					send_keepalive_packet_manual(sock);
-					keepalive_time = 0;
+					S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 				}
 			}
 			
 			break;
 		
 		case SOCK_CLOSE_WAIT:
-			while(getSn_RX_RSR(sock) || e2u_size) ether_to_uart(sock); // receive remaining packets
-			disconnect(sock);
+			// Receive the remaining packets in turn as the UART Tx ring drains, then disconnect
+			if(getSn_RX_RSR(sock) || ctx->e2u_size)	ether_to_uart(ctx);
+			else									disconnect(sock);
 			break;
 		
 		case SOCK_FIN_WAIT:
 		case SOCK_CLOSED:
-			set_device_status(ST_OPEN);
-			reset_SEG_timeflags();
+			set_seg_status(ctx, ST_OPEN);
+			
+			// Telnet COM port control: the stored serial settings are restored
+			if(ctx->telnet) rfc2217_close(ctx->ch);
+			ctx->telnet = SEG_DISABLE;
+			reset_SEG_timeflags(ctx);
 			
-			u2e_size = 0;
-			e2u_size = 0;
+			ctx->u2e_size = 0;
+			ctx->e2u_size = 0;
 			
 			source_port = get_tcp_any_port();
 #ifdef _SEG_DEBUG_
 			printf(" > TCP CLIENT: client_any_port = %d\r\n", client_any_port);
 #endif		
-			if(socket(sock, Sn_MR_TCP, source_port, Sn_MR_ND) == sock)
+			if(socket(sock, Sn_MR_TCP, source_port, Sn_MR_ND | SF_IO_NONBLOCK) == sock)
 			{
 				// Replace the command mode switch code GAP time (default: 500ms)
-				if((option->serial_command == SEG_ENABLE) && net->packing_time) modeswitch_gap_time = net->packing_time;
+				if(option->serial_command == SEG_ENABLE) init_modeswitch_gap_time(ctx);
 				
 				// Enable the reconnection Timer
-				if((enable_reconnection_timer == SEG_DISABLE) && net->reconnection) enable_reconnection_timer = SEG_ENABLE;
+				if((S2E_TIMER_RUN(ctx, RECONNECTION) == SEG_DISABLE) && net->reconnection) S2E_TIMER_RUN(ctx, RECONNECTION) = SEG_ENABLE;
 				
 				if(serial->serial_debug_en == SEG_ENABLE)
 				{
@@ -421,12 +645,13 @@ void proc_SEG_tcp_client(uint8_t sock)
 	}
 }
 
-void proc_SEG_tcp_server(uint8_t sock)
+void proc_SEG_tcp_server(s2e_session_t * ctx)
 {
-	DevConfig *s2e = get_DevConfig_pointer();
-	struct __network_info *net = (struct __network_info *)get_DevConfig_pointer()->network_info;
-	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	struct __network_info *net = cfg->network_info;
+	struct __serial_info *serial = cfg->serial_info;
 	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
+	uint8_t sock = ctx->sock;
 	
 	uint8_t destip[4] = {0, };
 	uint16_t destport = 0;
@@ -448,17 +673,20 @@ void proc_SEG_tcp_server(uint8_t sock)
 				// S2E: TCP server mode initialize after connection established (only once)
 				///////////////////////////////////////////////////////////////////////////////////////////////////
 				//net->state = ST_CONNECT;
-				set_device_status(ST_CONNECT);
+				set_seg_status(ctx, ST_CONNECT);
 				
-				if(!inactivity_time && net->inactivity)		enable_inactivity_timer = SEG_ENABLE;
-				//if(!keepalive_time && net->keepalive_en)	enable_keepalive_timer = SEG_ENABLE;
+				if(!S2E_TIMER_TIME(ctx, INACTIVITY) && net->inactivity)		S2E_TIMER_RUN(ctx, INACTIVITY) = SEG_ENABLE;
+				//if(!S2E_TIMER_TIME(ctx, KEEPALIVE) && net->keepalive_en)	S2E_TIMER_RUN(ctx, KEEPALIVE) = SEG_ENABLE;
 				
-				if(option->pw_connect_en == SEG_DISABLE)	flag_connect_pw_auth = SEG_ENABLE;		// TCP server mode only (+ mixed_server)
+				// Telnet COM port control: the connection password is not used
+				ctx->telnet = check_telnet_mode(ctx);
+				
+				if((*cfg->pw_connect_en == SEG_DISABLE) || ctx->telnet)	ctx->flag_connect_pw_auth = SEG_ENABLE;		// TCP server mode only (+ mixed_server)
 				else
 				{
 					// Connection password auth timer initialize
-					enable_connection_auth_timer = SEG_ENABLE;
-					connection_auth_time  = 0;
+					S2E_TIMER_RUN(ctx, CONNECTION_AUTH) = SEG_ENABLE;
+					S2E_TIMER_TIME(ctx, CONNECTION_AUTH)  = 0;
 				}
 				
 				// Serial debug message printout
@@ -470,64 +698,67 @@ void proc_SEG_tcp_server(uint8_t sock)
 				}
 				
 				// UART Ring buffer clear
-				BUFFER_CLEAR(data_rx);
+				uart_rx_flush(ctx->uart);
+				
+				if(ctx->telnet) rfc2217_open(ctx->ch, sock);
 				
 				setSn_IR(sock, Sn_IR_CON);
 			}
 			
 			// Serial to Ethernet process
-			if(BUFFER_USED_SIZE(data_rx) || u2e_size)	uart_to_ether(sock);
-			if(getSn_RX_RSR(sock) || e2u_size)	ether_to_uart(sock);
+			if(RING_USED_SIZE(ctx->rx) || ctx->u2e_size)	uart_to_ether(ctx);
+			if(getSn_RX_RSR(sock) || ctx->e2u_size)	ether_to_uart(ctx);
+			if(ctx->telnet) rfc2217_process(ctx->ch, sock, (ctx->flag_u2e_remainder == SEG_DISABLE));
 			
 			// Check the inactivity timer
-			if((enable_inactivity_timer == SEG_ENABLE) && (inactivity_time >= net->inactivity))
+			if((S2E_TIMER_RUN(ctx, INACTIVITY) == SEG_ENABLE) && (S2E_TIMER_TIME(ctx, INACTIVITY) >= net->inactivity))
 			{
 				//disconnect(sock);
 				process_socket_termination(sock);
 				
 				// Keep-alive timer disabled
-				enable_keepalive_timer = DISABLE;
-				keepalive_time = 0;
+				S2E_TIMER_RUN(ctx, KEEPALIVE) = DISABLE;
+				S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 #ifdef _SEG_DEBUG_
 				printf(" > INACTIVITY TIMER: TIMEOUT\r\n");
 #endif
 			}
 			
 			// Check the keee-alive timer
-			if((net->keepalive_en == SEG_ENABLE) && (enable_keepalive_timer == SEG_ENABLE))
+			if((net->keepalive_en == SEG_ENABLE) && (S2E_TIMER_RUN(ctx, KEEPALIVE) == SEG_ENABLE))
 			{
 				// Send the first keee-alive packet
-				if((flag_sent_first_keepalive == SEG_DISABLE) && (keepalive_time >= net->keepalive_wait_time) && (net->keepalive_wait_time != 0))
+				if((ctx->flag_sent_first_keepalive == SEG_DISABLE) && (S2E_TIMER_TIME(ctx, KEEPALIVE) >= net->keepalive_wait_time) && (net->keepalive_wait_time != 0))
 				{
 #ifdef _SEG_DEBUG_
-					printf(" >> send_keepalive_packet_first [%d]\r\n", keepalive_time);
+					printf(" >> send_keepalive_packet_first [%d]\r\n", S2E_TIMER_TIME(ctx, KEEPALIVE));
 #endif
 					send_keepalive_packet_manual(sock); // <-> send_keepalive_packet_auto()
-					keepalive_time = 0;
+					S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 					
-					flag_sent_first_keepalive = SEG_ENABLE;
+					ctx->flag_sent_first_keepalive = SEG_ENABLE;
 				}
 				// Send the keee-alive packet periodically
-				if((flag_sent_first_keepalive == SEG_ENABLE) && (keepalive_time >= net->keepalive_retry_time) && (net->keepalive_retry_time != 0))
+				if((ctx->flag_sent_first_keepalive == SEG_ENABLE) && (S2E_TIMER_TIME(ctx, KEEPALIVE) >= net->keepalive_retry_time) && (net->keepalive_retry_time != 0))
 				{
 #ifdef _SEG_DEBUG_
-					printf(" >> send_keepalive_packet_manual [%d]\r\n", keepalive_time);
+					printf(" >> send_keepalive_packet_manual [%d]\r\n", S2E_TIMER_TIME(ctx, KEEPALIVE));
 #endif
 					send_keepalive_packet_manual(sock);
-					keepalive_time = 0;
+					S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 				}
 			}
 			
 			// Check the connection password auth timer
-			if(option->pw_connect_en == SEG_ENABLE)
+			if(*cfg->pw_connect_en == SEG_ENABLE)
 			{
-				if((flag_connect_pw_auth == SEG_DISABLE) && (connection_auth_time >= MAX_CONNECTION_AUTH_TIME)) // timeout default: 5000ms (5 sec)
+				if((ctx->flag_connect_pw_auth == SEG_DISABLE) && (S2E_TIMER_TIME(ctx, CONNECTION_AUTH) >= MAX_CONNECTION_AUTH_TIME)) // timeout default: 5000ms (5 sec)
 				{
 					//disconnect(sock);
 					process_socket_termination(sock);
 					
-					enable_connection_auth_timer = DISABLE;
-					connection_auth_time = 0;
+					S2E_TIMER_RUN(ctx, CONNECTION_AUTH) = DISABLE;
+					S2E_TIMER_TIME(ctx, CONNECTION_AUTH) = 0;
 #ifdef _SEG_DEBUG_
 					printf(" > CONNECTION PW: AUTH TIMEOUT\r\n");
 #endif
@@ -536,22 +767,27 @@ void proc_SEG_tcp_server(uint8_t sock)
 			break;
 		
 		case SOCK_CLOSE_WAIT:
-			while(getSn_RX_RSR(sock) || e2u_size) ether_to_uart(sock); // receive remaining packets
-			disconnect(sock);
+			// Receive the remaining packets in turn as the UART Tx ring drains, then disconnect
+			if(getSn_RX_RSR(sock) || ctx->e2u_size)	ether_to_uart(ctx);
+			else									disconnect(sock);
 			break;
 		
 		case SOCK_FIN_WAIT:
 		case SOCK_CLOSED:
-			set_device_status(ST_OPEN);
-			reset_SEG_timeflags();
+			set_seg_status(ctx, ST_OPEN);
 			
-			u2e_size = 0;
-			e2u_size = 0;
+			// Telnet COM port control: the stored serial settings are restored
+			if(ctx->telnet) rfc2217_close(ctx->ch);
+			ctx->telnet = SEG_DISABLE;
+			reset_SEG_timeflags(ctx);
+			
+			ctx->u2e_size = 0;
+			ctx->e2u_size = 0;
 
-			if(socket(sock, Sn_MR_TCP, net->local_port, Sn_MR_ND) == sock)
+			if(socket(sock, Sn_MR_TCP, net->local_port, Sn_MR_ND | SF_IO_NONBLOCK) == sock)
 			{
 				// Replace the command mode switch code GAP time (default: 500ms)
-				if((option->serial_command == SEG_ENABLE) && net->packing_time) modeswitch_gap_time = net->packing_time;
+				if(option->serial_command == SEG_ENABLE) init_modeswitch_gap_time(ctx);
 				
 				// TCP Server listen
 				listen(sock);
@@ -568,40 +804,424 @@ void proc_SEG_tcp_server(uint8_t sock)
 	}
 }
 
+// TCP server multi-session: up to TCP_SERVER_SESSIONS_MAX clients on the local port.
+// The serial data is broadcast to all authenticated sessions,
+// and the data from the sessions is interleaved onto the UART by the received packet.
+void proc_SEG_tcp_multi_server(s2e_session_t * ctx)
+{
+	uint8_t state;
+	
+	// Serial to Ethernet process: broadcast
+	if(RING_USED_SIZE(ctx->rx) || ctx->u2e_size) uart_to_ether_sessions(ctx);
+	
+	// Serial line arbitration: the transaction also ends by the timeout or the requester disconnection
+	if(ctx->arb_owner != SEG_ARB_OWNER_NONE)
+	{
+		state = getSn_SR(ctx->session[ctx->arb_owner].sock);
+		if((get_arbitration_timeout(ctx) == 0) || (ctx->arb_time >= get_arbitration_timeout(ctx)) || ((state != SOCK_ESTABLISHED) && (state != SOCK_CLOSE_WAIT)))
+		{
+			end_serial_arbitration(ctx);
+		}
+	}
+	
+	// Ethernet to Serial process: the queued packet is sent first, then the sessions take turns
+	if(ctx->e2u_size) put_serial_data(ctx);
+	
+	proc_SEG_tcp_server_sessions(ctx);
+}
 
-void proc_SEG_tcp_mixed(uint8_t sock)
+// TCP server sessions in turn: connection / timers / Ethernet to Serial process of each session
+void proc_SEG_tcp_server_sessions(s2e_session_t * ctx)
 {
-	DevConfig *s2e = get_DevConfig_pointer();
-	struct __network_info *net = (struct __network_info *)get_DevConfig_pointer()->network_info;
-	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	uint8_t sessions = get_tcp_server_sessions(ctx);
+	uint8_t connected = SEG_DISABLE;
+	uint8_t i, idx;
+	
+	for(i = 0; i < sessions; i++)
+	{
+		idx = (ctx->e2u_session_turn + i) % sessions;
+		if(getSn_TXBUF_SIZE(ctx->session[idx].sock) == 0) continue; // No H/W socket buffer allocated, refer to SOCK_BUF_PROFILE_MULTISESSION
+		
+		proc_SEG_tcp_server_session(ctx, &ctx->session[idx]);
+		if(getSn_SR(ctx->session[idx].sock) == SOCK_ESTABLISHED) connected = SEG_ENABLE;
+	}
+	
+	if(++ctx->e2u_session_turn >= sessions) ctx->e2u_session_turn = 0;
+	
+	// Device status: connected while any session is established
+	if((connected == SEG_ENABLE) && (get_seg_status(ctx) != ST_CONNECT)) set_seg_status(ctx, ST_CONNECT);
+	else if((connected == SEG_DISABLE) && (get_seg_status(ctx) == ST_CONNECT)) set_seg_status(ctx, ST_OPEN);
+}
+
+void proc_SEG_tcp_server_session(s2e_session_t * ctx, tsSEGSESSION * session)
+{
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	struct __network_info *net = cfg->network_info;
+	struct __serial_info *serial = cfg->serial_info;
 	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
 	
-	uint16_t source_port = 0;
+	uint8_t sock = session->sock;
 	uint8_t destip[4] = {0, };
 	uint16_t destport = 0;
 	
-#ifdef MIXED_CLIENT_LIMITED_CONNECT
-	static uint8_t reconnection_count;
+	uint8_t state = getSn_SR(sock);
+	switch(state)
+	{
+		case SOCK_INIT:
+		case SOCK_LISTEN:
+			break;
+		
+		case SOCK_ESTABLISHED:
+			if(getSn_IR(sock) & Sn_IR_CON)
+			{
+				///////////////////////////////////////////////////////////////////////////////////////////////////
+				// S2E: TCP server session initialize after connection established (only once)
+				///////////////////////////////////////////////////////////////////////////////////////////////////
+				if(get_seg_status(ctx) != ST_CONNECT)
+				{
+					// The first session: UART Ring buffer clear
+					uart_rx_flush(ctx->uart);
+					ctx->u2e_size = 0;
+					ctx->flag_u2e_remainder = SEG_DISABLE;
+				}
+				
+				if(net->inactivity) S2E_TIMER_RUN(session, INACTIVITY) = SEG_ENABLE;
+				
+				// Modbus TCP gateway: binary protocol, the connection password is not used
+				if((*cfg->pw_connect_en == SEG_DISABLE) || (net->working_mode == MODBUS_TCP_MODE))	session->flag_connect_pw_auth = SEG_ENABLE;
+				else
+				{
+					// Connection password auth timer initialize
+					S2E_TIMER_RUN(session, CONNECTION_AUTH) = SEG_ENABLE;
+					S2E_TIMER_TIME(session, CONNECTION_AUTH) = 0;
+				}
+				
+				// Serial debug message printout
+				if(serial->serial_debug_en == SEG_ENABLE)
+				{
+					getsockopt(sock, SO_DESTIP, &destip);
+					getsockopt(sock, SO_DESTPORT, &destport);
+					printf(" > SEG:CONNECTED FROM - %d.%d.%d.%d : %d [SOCK %d]\r\n",destip[0], destip[1], destip[2], destip[3], destport, sock);
+				}
+				
+				setSn_IR(sock, Sn_IR_CON);
+			}
+			
+			// Ethernet to Serial process
+			if(getSn_RX_RSR(sock)) ether_to_uart_session(ctx, session);
+			
+			// Check the inactivity timer
+			if((S2E_TIMER_RUN(session, INACTIVITY) == SEG_ENABLE) && (S2E_TIMER_TIME(session, INACTIVITY) >= net->inactivity))
+			{
+				process_socket_termination(sock);
+				
+				// Keep-alive timer disabled
+				S2E_TIMER_RUN(session, KEEPALIVE) = SEG_DISABLE;
+				S2E_TIMER_TIME(session, KEEPALIVE) = 0;
+#ifdef _SEG_DEBUG_
+				printf(" > INACTIVITY TIMER: TIMEOUT [SOCK %d]\r\n", sock);
+#endif
+			}
+			
+			// Check the keee-alive timer
+			if((net->keepalive_en == SEG_ENABLE) && (S2E_TIMER_RUN(session, KEEPALIVE) == SEG_ENABLE))
+			{
+				// Send the first keee-alive packet
+				if((session->flag_sent_first_keepalive == SEG_DISABLE) && (S2E_TIMER_TIME(session, KEEPALIVE) >= net->keepalive_wait_time) && (net->keepalive_wait_time != 0))
+				{
+					send_keepalive_packet_manual(sock);
+					S2E_TIMER_TIME(session, KEEPALIVE) = 0;
+					
+					session->flag_sent_first_keepalive = SEG_ENABLE;
+				}
+				// Send the keee-alive packet periodically
+				if((session->flag_sent_first_keepalive == SEG_ENABLE) && (S2E_TIMER_TIME(session, KEEPALIVE) >= net->keepalive_retry_time) && (net->keepalive_retry_time != 0))
+				{
+					send_keepalive_packet_manual(sock);
+					S2E_TIMER_TIME(session, KEEPALIVE) = 0;
+				}
+			}
+			
+			// Check the connection password auth timer
+			if(*cfg->pw_connect_en == SEG_ENABLE)
+			{
+				if((session->flag_connect_pw_auth == SEG_DISABLE) && (S2E_TIMER_TIME(session, CONNECTION_AUTH) >= MAX_CONNECTION_AUTH_TIME)) // timeout default: 5000ms (5 sec)
+				{
+					process_socket_termination(sock);
+					
+					S2E_TIMER_RUN(session, CONNECTION_AUTH) = SEG_DISABLE;
+					S2E_TIMER_TIME(session, CONNECTION_AUTH) = 0;
+#ifdef _SEG_DEBUG_
+					printf(" > CONNECTION PW: AUTH TIMEOUT [SOCK %d]\r\n", sock);
 #endif
+				}
+			}
+			break;
+		
+		case SOCK_CLOSE_WAIT:
+			// Receive the remaining packets in turn, then disconnect
+			if(getSn_RX_RSR(sock))	ether_to_uart_session(ctx, session);
+			else					disconnect(sock);
+			break;
+		
+		case SOCK_FIN_WAIT:
+		case SOCK_CLOSED:
+			reset_SEG_session(session);
+			
+			if(socket(sock, Sn_MR_TCP, net->local_port, Sn_MR_ND | SF_IO_NONBLOCK) == sock)
+			{
+				// Replace the command mode switch code GAP time (default: 500ms)
+				if(option->serial_command == SEG_ENABLE) init_modeswitch_gap_time(ctx);
+				
+				// TCP Server listen
+				listen(sock);
+				
+				if(serial->serial_debug_en == SEG_ENABLE)
+				{
+					printf(" > SEG:TCP_SERVER_MODE:SOCKOPEN [SOCK %d]\r\n", sock);
+				}
+			}
+			break;
+			
+		default:
+			break;
+	}
+}
+
+uint8_t get_tcp_server_sessions(s2e_session_t * ctx)
+{
+	uint8_t sessions = get_DevConfig_channel(ctx->ch)->network_info_extend->tcp_server_sessions;
+	
+	if((sessions == 0) || (sessions > TCP_SERVER_SESSIONS_MAX)) sessions = TCP_SERVER_SESSIONS_DEFAULT;
+	if(sessions > ctx->sessions_max) sessions = ctx->sessions_max;
+	return sessions;
+}
+
+uint16_t get_arbitration_timeout(s2e_session_t * ctx)
+{
+	return get_DevConfig_channel(ctx->ch)->network_info_extend->arbitration_timeout;
+}
+
+// Serial line arbitration: the line is released, the response data not sent yet is discarded
+void end_serial_arbitration(s2e_session_t * ctx)
+{
+	uint8_t i;
+	
+	ctx->arb_owner = SEG_ARB_OWNER_NONE;
+	ctx->arb_time = 0;
+	
+	ctx->u2e_size = 0;
+	ctx->flag_u2e_remainder = SEG_DISABLE;
+	for(i = 0; i < ctx->sessions_max; i++) ctx->session[i].u2e_sent = 0;
+}
+
+void reset_SEG_session(tsSEGSESSION * session)
+{
+	uint8_t sock = session->sock;
+	
+	memset(session, 0x00, sizeof(tsSEGSESSION));
+	session->sock = sock;
+}
+
+// Modbus TCP gateway: Modbus TCP clients (the TCP server sessions) <-> Modbus RTU slaves on the serial line.
+// One transaction on the serial line at a time by the serial line arbitration; the request is converted from the MBAP header
+// into the RTU address / CRC, and the response frame ends by the t3.5 silence detected by the UART Rx gap timer.
+void proc_SEG_modbus_gateway(s2e_session_t * ctx)
+{
+	// Modbus RTU to TCP: the response / timeout of the transaction in progress
+	modbus_rtu_to_tcp(ctx);
+	
+	// Modbus TCP to RTU: the sessions take turns for the next request
+	proc_SEG_tcp_server_sessions(ctx);
+}
+
+// A complete request ADU is taken from the socket buffer while the serial line is free,
+// the MBAP header is replaced by the RTU CRC in place and the transaction starts
+void modbus_tcp_to_rtu(s2e_session_t * ctx, tsSEGSESSION * session)
+{
+	uint8_t sock = session->sock;
+	uint8_t * frame = &ctx->recv_buf[MODBUS_MBAP_UNIT_OFFSET];
+	uint16_t rsr, len = 0;
+	
+	if(check_uart_cts_permitted(ctx) == SEG_DISABLE) return;
+	if(ctx->arb_owner != SEG_ARB_OWNER_NONE) return; // Serial line busy: the request stays in the socket buffer
+	if(RING_FREE_SIZE(ctx->tx) < MODBUS_RTU_ADU_MAX) return;
+	
+	rsr = getSn_RX_RSR(sock);
+	if(rsr >= MODBUS_MBAP_HEADER_LEN)
+	{
+		wiz_recv_peek(sock, ctx->recv_buf, MODBUS_MBAP_HEADER_LEN);
+		len = modbus_get_mbap_length(ctx->recv_buf);
+		if(len == 0) // Invalid MBAP header: the stream cannot be resynchronized
+		{
+			process_socket_termination(sock);
+			return;
+		}
+	}
+	
+	if((len == 0) || (rsr < (MODBUS_MBAP_UNIT_OFFSET + len)))
+	{
+		// Incomplete request: wait for the rest, discarded if the peer has closed the connection
+		if(getSn_SR(sock) == SOCK_CLOSE_WAIT) recv(sock, ctx->recv_buf, (rsr > ctx->buf_size) ? ctx->buf_size : rsr);
+		return;
+	}
+	
+	recv(sock, ctx->recv_buf, MODBUS_MBAP_UNIT_OFFSET + len);
+	add_data_transfer_bytecount(SEG_ETHER_RX, MODBUS_MBAP_UNIT_OFFSET + len);
+	
+	S2E_TIMER_TIME(session, INACTIVITY) = 0;
+	S2E_TIMER_TIME(session, KEEPALIVE) = 0;
+	session->flag_sent_first_keepalive = SEG_DISABLE;
+	
+	// Transaction start: the serial data received before the request is not a response
+	uart_rx_flush(ctx->uart);
+	seg_rx_gap_flush(ctx);
+	ctx->flag_mb_frame_end = SEG_DISABLE;
+	
+	ctx->mb_tid = ((uint16_t)ctx->recv_buf[0] << 8) | ctx->recv_buf[1];
+	ctx->mb_addr = frame[0];
+	ctx->mb_func = frame[1];
+	
+	ctx->arb_owner = (uint8_t)(session - ctx->session);
+	ctx->arb_time = 0;
+	
+	len = modbus_add_rtu_crc(frame, len);
+	uart_write(ctx->uart, frame, len);
+	add_data_transfer_bytecount(SEG_ETHER_TX, len);
+}
+
+// The RTU frame is checked (CRC, slave address, function code) and sent to the requester with the MBAP header of the request,
+// an invalid frame is discarded. No response until the timeout: the gateway answers the exception response
+void modbus_rtu_to_tcp(s2e_session_t * ctx)
+{
+	uint8_t * frame = &ctx->send_buf[MODBUS_MBAP_UNIT_OFFSET];
+	uint8_t sock;
+	uint16_t rx_end, len, len1st;
+	
+	if(ctx->arb_owner == SEG_ARB_OWNER_NONE)
+	{
+		// No transaction: the serial data is not a response
+		if(RING_USED_SIZE(ctx->rx)) uart_rx_flush(ctx->uart);
+		seg_rx_gap_flush(ctx);
+		return;
+	}
+	
+	sock = ctx->session[ctx->arb_owner].sock;
+	
+	if(seg_rx_gap_check(ctx, &rx_end))
+	{
+		ctx->mb_frame_end = rx_end;
+		ctx->flag_mb_frame_end = SEG_ENABLE;
+	}
+	
+	// Broadcast request: no response, the serial line is released after the turnaround delay
+	if(ctx->mb_addr == MODBUS_BROADCAST_ADDR)
+	{
+		if(ctx->arb_time >= MODBUS_TURNAROUND_DELAY) end_serial_arbitration(ctx);
+		return;
+	}
+	
+	if(ctx->flag_mb_frame_end == SEG_ENABLE)
+	{
+		len = (uint16_t)(ctx->mb_frame_end - *ctx->rx->rd);
+		if((len == 0) || (len > MODBUS_RTU_ADU_MAX))
+		{
+			// Not a frame of the response: the received data is discarded
+			uart_rx_flush(ctx->uart);
+			ctx->flag_mb_frame_end = SEG_DISABLE;
+		}
+		else if(len <= RING_USED_SIZE(ctx->rx)) // UART Rx DMA: the frame may not be published to the ring buffer yet
+		{
+			len1st = RING_OUT_SPAN(ctx->rx);
+			if(len1st > len) len1st = len;
+			memcpy(frame, RING_OUT_PTR(ctx->rx), len1st);
+			if(len > len1st) memcpy(frame + len1st, ctx->rx->buf, len - len1st);
+			
+			if(modbus_check_rtu_frame(frame, len) && (frame[0] == ctx->mb_addr) && ((frame[1] & ~MODBUS_EXCEPTION_FLAG) == ctx->mb_func))
+			{
+				// Response: RTU CRC removed, the MBAP header added in front of the frame
+				if(send_modbus_response(ctx, sock, len - 2) == 0) return; // The frame is kept until the socket buffer is available
+				
+				RING_OUT_MOVE(ctx->rx, len);
+				add_data_transfer_bytecount(SEG_UART_RX, len);
+				end_serial_arbitration(ctx);
+				return;
+			}
+			
+			// CRC error or not the response of the request: wait for the response until the timeout
+			RING_OUT_MOVE(ctx->rx, len);
+			add_data_transfer_bytecount(SEG_UART_RX, len);
+			ctx->flag_mb_frame_end = SEG_DISABLE;
+		}
+	}
+	
+	if(ctx->arb_time >= get_modbus_response_timeout(ctx))
+	{
+		len = modbus_set_exception(frame, ctx->mb_addr, ctx->mb_func, MODBUS_EXCEPTION_GW_TARGET);
+		if(send_modbus_response(ctx, sock, len) == 0) return;
+		
+		end_serial_arbitration(ctx);
+	}
+}
+
+// g_send_buf: the frame (Unit ID + PDU) of the len follows the MBAP header space
+// ret: [1] sent or discarded (the requester disconnected) / [0] not sent, the socket buffer is not available
+uint8_t send_modbus_response(s2e_session_t * ctx, uint8_t sock, uint16_t len)
+{
+	uint8_t state = getSn_SR(sock);
+	
+	if((state != SOCK_ESTABLISHED) && (state != SOCK_CLOSE_WAIT)) return 1;
+	if(getSn_TX_FSR(sock) < (MODBUS_MBAP_UNIT_OFFSET + len)) return 0;
+	
+	modbus_set_mbap_header(ctx->send_buf, ctx->mb_tid, len);
+	if(send(sock, ctx->send_buf, MODBUS_MBAP_UNIT_OFFSET + len) > 0)
+	{
+		add_data_transfer_bytecount(SEG_UART_TX, MODBUS_MBAP_UNIT_OFFSET + len);
+	}
+	
+	return 1;
+}
+
+// Slave response timeout: the serial line arbitration timeout (SEGCP AR) if set
+uint16_t get_modbus_response_timeout(s2e_session_t * ctx)
+{
+	uint16_t timeout = get_arbitration_timeout(ctx);
+	
+	if(timeout == 0) timeout = MODBUS_RESPONSE_TIMEOUT_DEFAULT;
+	return timeout;
+}
+
+
+void proc_SEG_tcp_mixed(s2e_session_t * ctx)
+{
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	struct __network_info *net = cfg->network_info;
+	struct __serial_info *serial = cfg->serial_info;
+	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
+	uint8_t sock = ctx->sock;
+	
+	uint16_t source_port = 0;
+	uint8_t destip[4] = {0, };
+	uint16_t destport = 0;
 	
 	uint8_t state = getSn_SR(sock);
 	switch(state)
 	{
 		case SOCK_INIT:
-			if(mixed_state == MIXED_CLIENT)
+			if(ctx->mixed_state == MIXED_CLIENT)
 			{
-				if(reconnection_time >= net->reconnection)
+				if(S2E_TIMER_TIME(ctx, RECONNECTION) >= net->reconnection)
 				{
-					reconnection_time = 0; // reconnection time variable clear
+					S2E_TIMER_TIME(ctx, RECONNECTION) = 0; // reconnection time variable clear
 					
 					// TCP connect exception checker; e.g., dns failed / zero srcip ... and etc.
-					if(check_tcp_connect_exception() == ON)
+					if(check_tcp_connect_exception(ctx) == ON)
 					{
 #ifdef MIXED_CLIENT_LIMITED_CONNECT
 						process_socket_termination(sock);
-						reconnection_count = 0;
-						BUFFER_CLEAR(data_rx);
-						mixed_state = MIXED_SERVER;
+						ctx->reconnection_count = 0;
+						uart_rx_flush(ctx->uart);
+						ctx->mixed_state = MIXED_SERVER;
 #endif
 						return;
 					}
@@ -610,16 +1230,16 @@ void proc_SEG_tcp_mixed(uint8_t sock)
 					connect(sock, net->remote_ip, net->remote_port);
 					
 #ifdef MIXED_CLIENT_LIMITED_CONNECT
-					reconnection_count++;
-					if(reconnection_count >= MAX_RECONNECTION_COUNT)
+					ctx->reconnection_count++;
+					if(ctx->reconnection_count >= MAX_RECONNECTION_COUNT)
 					{
 						process_socket_termination(sock);
-						reconnection_count = 0;
-						BUFFER_CLEAR(data_rx);
-						mixed_state = MIXED_SERVER;
+						ctx->reconnection_count = 0;
+						uart_rx_flush(ctx->uart);
+						ctx->mixed_state = MIXED_SERVER;
 					}
 	#ifdef _SEG_DEBUG_
-					if(reconnection_count != 0)	printf(" > SEG:TCP_MIXED_MODE:CLIENT_CONNECTION [%d]\r\n", reconnection_count);
+					if(ctx->reconnection_count != 0)	printf(" > SEG:TCP_MIXED_MODE:CLIENT_CONNECTION [%d]\r\n", ctx->reconnection_count);
 					else						printf(" > SEG:TCP_MIXED_MODE:CLIENT_CONNECTION_RETRY FAILED\r\n");
 	#endif
 #endif
@@ -630,12 +1250,12 @@ void proc_SEG_tcp_mixed(uint8_t sock)
 		case SOCK_LISTEN:
 			// UART Rx interrupt detection in MIXED_SERVER mode
 			// => Switch to MIXED_CLIENT mode
-			if((mixed_state == MIXED_SERVER) && (BUFFER_USED_SIZE(data_rx)))
+			if((ctx->mixed_state == MIXED_SERVER) && (RING_USED_SIZE(ctx->rx)))
 			{
 				process_socket_termination(sock);
-				mixed_state = MIXED_CLIENT;
+				ctx->mixed_state = MIXED_CLIENT;
 				
-				reconnection_time = net->reconnection; // rapid initial connection
+				S2E_TIMER_TIME(ctx, RECONNECTION) = net->reconnection; // rapid initial connection
 			}
 			break;
 		
@@ -646,21 +1266,24 @@ void proc_SEG_tcp_mixed(uint8_t sock)
 				// S2E: TCP mixed (server or client) mode initialize after connection established (only once)
 				///////////////////////////////////////////////////////////////////////////////////////////////////
 				//net->state = ST_CONNECT;
-				set_device_status(ST_CONNECT);
+				set_seg_status(ctx, ST_CONNECT);
 				
-				if(!inactivity_time && net->inactivity)		enable_inactivity_timer = SEG_ENABLE;
-				if(!keepalive_time && net->keepalive_en)	enable_keepalive_timer = SEG_ENABLE;
+				if(!S2E_TIMER_TIME(ctx, INACTIVITY) && net->inactivity)		S2E_TIMER_RUN(ctx, INACTIVITY) = SEG_ENABLE;
+				if(!S2E_TIMER_TIME(ctx, KEEPALIVE) && net->keepalive_en)	S2E_TIMER_RUN(ctx, KEEPALIVE) = SEG_ENABLE;
+				
+				// Telnet COM port control: the connection password is not used
+				ctx->telnet = check_telnet_mode(ctx);
 				
 				// Connection Password option: TCP server mode only (+ mixed_server)
-				if((option->pw_connect_en == SEG_DISABLE) || (mixed_state == MIXED_CLIENT))
+				if((*cfg->pw_connect_en == SEG_DISABLE) || (ctx->mixed_state == MIXED_CLIENT) || ctx->telnet)
 				{
-					flag_connect_pw_auth = SEG_ENABLE;
+					ctx->flag_connect_pw_auth = SEG_ENABLE;
 				}
-				else if((mixed_state == MIXED_SERVER) && (flag_connect_pw_auth == SEG_DISABLE))
+				else if((ctx->mixed_state == MIXED_SERVER) && (ctx->flag_connect_pw_auth == SEG_DISABLE))
 				{
 					// Connection password auth timer initialize
-					enable_connection_auth_timer = SEG_ENABLE;
-					connection_auth_time  = 0;
+					S2E_TIMER_RUN(ctx, CONNECTION_AUTH) = SEG_ENABLE;
+					S2E_TIMER_TIME(ctx, CONNECTION_AUTH)  = 0;
 				}
 				
 				// Serial debug message printout
@@ -669,85 +1292,88 @@ void proc_SEG_tcp_mixed(uint8_t sock)
 					getsockopt(sock, SO_DESTIP, &destip);
 					getsockopt(sock, SO_DESTPORT, &destport);
 					
-					if(mixed_state == MIXED_SERVER)		printf(" > SEG:CONNECTED FROM - %d.%d.%d.%d : %d\r\n",destip[0], destip[1], destip[2], destip[3], destport);
+					if(ctx->mixed_state == MIXED_SERVER)		printf(" > SEG:CONNECTED FROM - %d.%d.%d.%d : %d\r\n",destip[0], destip[1], destip[2], destip[3], destport);
 					else								printf(" > SEG:CONNECTED TO - %d.%d.%d.%d : %d\r\n",destip[0], destip[1], destip[2], destip[3], destport);
 				}
 				
 				
 				// Mixed mode option init
-				if(mixed_state == MIXED_SERVER)
+				if(ctx->mixed_state == MIXED_SERVER)
 				{
 					// UART Ring buffer clear
-					BUFFER_CLEAR(data_rx);
+					uart_rx_flush(ctx->uart);
 				}
-				else if(mixed_state == MIXED_CLIENT)
+				else if(ctx->mixed_state == MIXED_CLIENT)
 				{
 					// Mixed-mode flag switching in advance
-					mixed_state = MIXED_SERVER;
+					ctx->mixed_state = MIXED_SERVER;
 				}
 				
 #ifdef MIXED_CLIENT_LIMITED_CONNECT
-				reconnection_count = 0;
+				ctx->reconnection_count = 0;
 #endif
 				
+				if(ctx->telnet) rfc2217_open(ctx->ch, sock);
+				
 				setSn_IR(sock, Sn_IR_CON);
 			}
 			
 			// Serial to Ethernet process
-			if(BUFFER_USED_SIZE(data_rx) || u2e_size)	uart_to_ether(sock);
-			if(getSn_RX_RSR(sock) 	|| e2u_size)		ether_to_uart(sock);
+			if(RING_USED_SIZE(ctx->rx) || ctx->u2e_size)	uart_to_ether(ctx);
+			if(getSn_RX_RSR(sock) 	|| ctx->e2u_size)		ether_to_uart(ctx);
+			if(ctx->telnet) rfc2217_process(ctx->ch, sock, (ctx->flag_u2e_remainder == SEG_DISABLE));
 			
 			// Check the inactivity timer
-			if((enable_inactivity_timer == SEG_ENABLE) && (inactivity_time >= net->inactivity))
+			if((S2E_TIMER_RUN(ctx, INACTIVITY) == SEG_ENABLE) && (S2E_TIMER_TIME(ctx, INACTIVITY) >= net->inactivity))
 			{
 				//disconnect(sock);
 				process_socket_termination(sock);
 				
 				// Keep-alive timer disabled
-				enable_keepalive_timer = DISABLE;
-				keepalive_time = 0;
+				S2E_TIMER_RUN(ctx, KEEPALIVE) = DISABLE;
+				S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 #ifdef _SEG_DEBUG_
 				printf(" > INACTIVITY TIMER: TIMEOUT\r\n");
 #endif
 				// TCP mixed mode state transition: initial state
-				mixed_state = MIXED_SERVER;
+				ctx->mixed_state = MIXED_SERVER;
 			}
 			
 			// Check the keee-alive timer
-			if((net->keepalive_en == SEG_ENABLE) && (enable_keepalive_timer == SEG_ENABLE))
+			if((net->keepalive_en == SEG_ENABLE) && (S2E_TIMER_RUN(ctx, KEEPALIVE) == SEG_ENABLE))
 			{
 				// Send the first keee-alive packet
-				if((flag_sent_first_keepalive == SEG_DISABLE) && (keepalive_time >= net->keepalive_wait_time) && (net->keepalive_wait_time != 0))
+				if((ctx->flag_sent_first_keepalive == SEG_DISABLE) && (S2E_TIMER_TIME(ctx, KEEPALIVE) >= net->keepalive_wait_time) && (net->keepalive_wait_time != 0))
 				{
 #ifdef _SEG_DEBUG_
-					printf(" >> send_keepalive_packet_first [%d]\r\n", keepalive_time);
+					printf(" >> send_keepalive_packet_first [%d]\r\n", S2E_TIMER_TIME(ctx, KEEPALIVE));
 #endif
 					send_keepalive_packet_manual(sock); // <-> send_keepalive_packet_auto()
-					keepalive_time = 0;
+					S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 					
-					flag_sent_first_keepalive = SEG_ENABLE;
+					ctx->flag_sent_first_keepalive = SEG_ENABLE;
 				}
 				// Send the keee-alive packet periodically
-				if((flag_sent_first_keepalive == SEG_ENABLE) && (keepalive_time >= net->keepalive_retry_time) && (net->keepalive_retry_time != 0))
+				if((ctx->flag_sent_first_keepalive == SEG_ENABLE) && (S2E_TIMER_TIME(ctx, KEEPALIVE) >= net->keepalive_retry_time) && (net->keepalive_retry_time != 0))
 				{
 #ifdef _SEG_DEBUG_
-					printf(" >> send_keepalive_packet_manual [%d]\r\n", keepalive_time);
+					printf(" >> send_keepalive_packet_manual [%d]\r\n", S2E_TIMER_TIME(ctx, KEEPALIVE));
 #endif
 					send_keepalive_packet_manual(sock);
-					keepalive_time = 0;
+					S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 				}
 			}
 			
 			// Check the connection password auth timer
-			if((mixed_state == MIXED_SERVER) && (option->pw_connect_en == SEG_ENABLE))
+			if((ctx->mixed_state == MIXED_SERVER) && (*cfg->pw_connect_en == SEG_ENABLE))
 			{
-				if((flag_connect_pw_auth == SEG_DISABLE) && (connection_auth_time >= MAX_CONNECTION_AUTH_TIME)) // timeout default: 5000ms (5 sec)
+				if((ctx->flag_connect_pw_auth == SEG_DISABLE) && (S2E_TIMER_TIME(ctx, CONNECTION_AUTH) >= MAX_CONNECTION_AUTH_TIME)) // timeout default: 5000ms (5 sec)
 				{
 					//disconnect(sock);
 					process_socket_termination(sock);
 					
-					enable_connection_auth_timer = DISABLE;
-					connection_auth_time = 0;
+					S2E_TIMER_RUN(ctx, CONNECTION_AUTH) = DISABLE;
+					S2E_TIMER_TIME(ctx, CONNECTION_AUTH) = 0;
 #ifdef _SEG_DEBUG_
 					printf(" > CONNECTION PW: AUTH TIMEOUT\r\n");
 #endif
@@ -756,25 +1382,30 @@ void proc_SEG_tcp_mixed(uint8_t sock)
 			break;
 		
 		case SOCK_CLOSE_WAIT:
-			while(getSn_RX_RSR(sock) || e2u_size) ether_to_uart(sock); // receive remaining packets
-			disconnect(sock);
+			// Receive the remaining packets in turn as the UART Tx ring drains, then disconnect
+			if(getSn_RX_RSR(sock) || ctx->e2u_size)	ether_to_uart(ctx);
+			else									disconnect(sock);
 			break;
 		
 		case SOCK_FIN_WAIT:
 		case SOCK_CLOSED:
-			set_device_status(ST_OPEN);
+			set_seg_status(ctx, ST_OPEN);
+			
+			// Telnet COM port control: the stored serial settings are restored
+			if(ctx->telnet) rfc2217_close(ctx->ch);
+			ctx->telnet = SEG_DISABLE;
 
-			if(mixed_state == MIXED_SERVER) // MIXED_SERVER
+			if(ctx->mixed_state == MIXED_SERVER) // MIXED_SERVER
 			{
-				reset_SEG_timeflags();
+				reset_SEG_timeflags(ctx);
 				
-				u2e_size = 0;
-				e2u_size = 0;
+				ctx->u2e_size = 0;
+				ctx->e2u_size = 0;
 				
-				if(socket(sock, Sn_MR_TCP, net->local_port, Sn_MR_ND) == sock)
+				if(socket(sock, Sn_MR_TCP, net->local_port, Sn_MR_ND | SF_IO_NONBLOCK) == sock)
 				{
 					// Replace the command mode switch code GAP time (default: 500ms)
-					if((option->serial_command == SEG_ENABLE) && net->packing_time) modeswitch_gap_time = net->packing_time;
+					if(option->serial_command == SEG_ENABLE) init_modeswitch_gap_time(ctx);
 					
 					// TCP Server listen
 					listen(sock);
@@ -787,19 +1418,19 @@ void proc_SEG_tcp_mixed(uint8_t sock)
 			}
 			else	// MIXED_CLIENT
 			{
-				e2u_size = 0;
+				ctx->e2u_size = 0;
 				
 				source_port = get_tcp_any_port();
 #ifdef _SEG_DEBUG_
 				printf(" > TCP CLIENT: any_port = %d\r\n", source_port);
 #endif		
-				if(socket(sock, Sn_MR_TCP, source_port, Sn_MR_ND) == sock)
+				if(socket(sock, Sn_MR_TCP, source_port, Sn_MR_ND | SF_IO_NONBLOCK) == sock)
 				{
 					// Replace the command mode switch code GAP time (default: 500ms)
-					if((option->serial_command == SEG_ENABLE) && net->packing_time) modeswitch_gap_time = net->packing_time;
+					if(option->serial_command == SEG_ENABLE) init_modeswitch_gap_time(ctx);
 					
 					// Enable the reconnection Timer
-					if((enable_reconnection_timer == SEG_DISABLE) && net->reconnection) enable_reconnection_timer = SEG_ENABLE;
+					if((S2E_TIMER_RUN(ctx, RECONNECTION) == SEG_DISABLE) && net->reconnection) S2E_TIMER_RUN(ctx, RECONNECTION) = SEG_ENABLE;
 					
 					if(serial->serial_debug_en == SEG_ENABLE)
 					{
@@ -814,12 +1445,15 @@ void proc_SEG_tcp_mixed(uint8_t sock)
 	}
 }
 
-void uart_to_ether(uint8_t sock)
+void uart_to_ether(s2e_session_t * ctx)
 {
-	struct __network_info *netinfo = (struct __network_info *)&(get_DevConfig_pointer()->network_info);
-	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	struct __network_info *netinfo = get_DevConfig_channel(ctx->ch)->network_info;
+	uint8_t sock = ctx->sock;
 	uint16_t len;
-	int16_t sent_len;
+	int16_t sent_len = 0;
+	uint8_t * buf = ctx->send_buf;
+	uint16_t len1st;
+	uint8_t zerocopy;
 	//uint16_t ret;
 	//uint16_t i; // ## for debugging
 	
@@ -827,17 +1461,57 @@ void uart_to_ether(uint8_t sock)
 	if(get_phylink_in_pin() != 0) return; // PHY link down
 #endif
 	
-	// UART ring buffer -> user's buffer
-	len = get_serial_data();
-	add_data_transfer_bytecount(SEG_UART_RX, len);
+	// No packing option: the data is sent straight from the UART ring buffer (zero-copy),
+	// the 1st span runs up to the ring buffer end and the remainder wraps to the start of the buffer.
+	zerocopy = ((ctx->u2e_size == 0) && (!check_packing_options(ctx)));
 	
-	/*
-	// ## for debugging
-	if(len)
+	if(zerocopy)
 	{
-		printf("flag_connect_pw_auth: %d\r\n", flag_connect_pw_auth);
-		printf("uart_to_ether: ");
-		for(i = 0; i < len; i++) printf("%c ", g_send_buf[i]);
+		len = RING_USED_SIZE(ctx->rx);
+		buf = RING_OUT_PTR(ctx->rx);
+		len1st = RING_OUT_SPAN(ctx->rx);
+		if(len1st > len) len1st = len;
+		
+		// Telnet COM port control: the data including 0xFF (IAC) is escaped in the user's buffer
+		if(ctx->telnet && (rfc2217_has_iac(buf, len1st) || rfc2217_has_iac(ctx->rx->buf, len - len1st)))
+		{
+			zerocopy = SEG_DISABLE;
+			buf = ctx->send_buf;
+		}
+	}
+	
+	if(!zerocopy)
+	{
+		if((ctx->flag_u2e_remainder == SEG_ENABLE) && (ctx->u2e_size != 0))
+		{
+			// Retry the remainder of the partially sent data first
+			len = ctx->u2e_size;
+		}
+		else
+		{
+			// UART ring buffer -> user's buffer
+			ctx->flag_u2e_remainder = SEG_DISABLE;
+			len = get_serial_data(ctx);
+			add_data_transfer_bytecount(SEG_UART_RX, len);
+			
+			// Telnet COM port control: the escaped data is kept as the remainder until it is sent
+			if(ctx->telnet && (len > 0))
+			{
+				len = rfc2217_escape(ctx->send_buf, len);
+				ctx->u2e_size = len;
+				ctx->flag_u2e_remainder = SEG_ENABLE;
+			}
+		}
+		len1st = len;
+	}
+	
+	/*
+	// ## for debugging
+	if(len)
+	{
+		printf("flag_connect_pw_auth: %d\r\n", ctx->flag_connect_pw_auth);
+		printf("uart_to_ether: ");
+		for(i = 0; i < len; i++) printf("%c ", ctx->send_buf[i]);
 		printf("\r\n");
 	}
 	*/
@@ -848,80 +1522,99 @@ void uart_to_ether(uint8_t sock)
 		/*
 		// ## for debugging
 		printf("> U2E len: %d, ", len); // ## for debugging
-		for(i = 0; i < len; i++) printf("%c", g_send_buf[i]);
+		for(i = 0; i < len; i++) printf("%c", ctx->send_buf[i]);
 		printf("\r\n");
 		*/
 		
 		switch(getSn_SR(sock))
 		{
 			case SOCK_UDP: // UDP_MODE
-				if((netinfo->remote_ip[0] == 0x00) && (netinfo->remote_ip[1] == 0x00) && (netinfo->remote_ip[2] == 0x00) && (netinfo->remote_ip[3] == 0x00))
+				if(check_udp_multicast(ctx))
+				{
+					// UDP multicast: the serial data is sent to the group
+					sent_len = (int16_t)sendto_sg(sock, buf, len1st, ctx->rx->buf, len - len1st, get_DevConfig_channel(ctx->ch)->network_info_extend->udp_multicast_ip, netinfo->local_port);
+				}
+				else if((netinfo->remote_ip[0] == 0x00) && (netinfo->remote_ip[1] == 0x00) && (netinfo->remote_ip[2] == 0x00) && (netinfo->remote_ip[3] == 0x00))
 				{
-					if((peerip[0] == 0x00) && (peerip[1] == 0x00) && (peerip[2] == 0x00) && (peerip[3] == 0x00))
+					if(get_DevConfig_channel(ctx->ch)->network_info_extend->udp_peer_delivery != UDP_PEER_DELIVERY_LAST)
+					{
+						// UDP 1:N mode: the peers of the peer table
+						sent_len = (int16_t)send_udp_peers(ctx, sock, buf, len1st, len);
+					}
+					else if((ctx->peerip[0] == 0x00) && (ctx->peerip[1] == 0x00) && (ctx->peerip[2] == 0x00) && (ctx->peerip[3] == 0x00))
 					{
-						if(serial->serial_debug_en == SEG_ENABLE) printf(" > SEG:UDP_MODE:DATA SEND FAILED - UDP Peer IP/Port required (0.0.0.0)\r\n");
+						; // UDP Peer IP/Port required (0.0.0.0): the data is kept until a peer sends the data
 					}
 					else
 					{
 						// UDP 1:N mode
-						sent_len = (int16_t)sendto(sock, g_send_buf, len, peerip, peerport);
+						sent_len = (int16_t)sendto_sg(sock, buf, len1st, ctx->rx->buf, len - len1st, ctx->peerip, ctx->peerport);
 					}
 				}
 				else
 				{
 					// UDP 1:1 mode
-					sent_len = (int16_t)sendto(sock, g_send_buf, len, netinfo->remote_ip, netinfo->remote_port);
+					sent_len = (int16_t)sendto_sg(sock, buf, len1st, ctx->rx->buf, len - len1st, netinfo->remote_ip, netinfo->remote_port);
 				}
 				
-				if(sent_len > 0) u2e_size-=sent_len;
+				if(sent_len > 0)
+				{
+					consume_sent_data(ctx, zerocopy, sent_len);
+					add_u2e_latency_sample(ctx);
+				}
 				
 				break;
 			
 			case SOCK_ESTABLISHED: // TCP_SERVER_MODE, TCP_CLIENT_MODE, TCP_MIXED_MODE
 			case SOCK_CLOSE_WAIT:
 				// Connection password is only checked in the TCP SERVER MODE / TCP MIXED MODE (MIXED_SERVER)
-				if(flag_connect_pw_auth == SEG_ENABLE)
+				if(ctx->flag_connect_pw_auth == SEG_ENABLE)
 				{
 					
 					/* ## 1
-					len = send(sock, g_send_buf, len);
-					u2e_size = 0;
+					len = send(sock, ctx->send_buf, len);
+					ctx->u2e_size = 0;
 					*/
 					
 					// ## 2: TCP send operation- Stability improvements
 					/*
 					do {
-						ret = send(sock, g_send_buf, len);
+						ret = send(sock, ctx->send_buf, len);
 					} while(ret != len);
-					u2e_size = 0;
+					ctx->u2e_size = 0;
 					*/
 					
 					// ## 3: 
-					sent_len = (int16_t)send(sock, g_send_buf, len);
-					if(sent_len > 0) u2e_size-=sent_len;
-					
-					add_data_transfer_bytecount(SEG_UART_TX, len);
+					sent_len = (int16_t)send_sg(sock, buf, len1st, ctx->rx->buf, len - len1st);
+					if(sent_len > 0)
+					{
+						consume_sent_data(ctx, zerocopy, sent_len);
+						add_data_transfer_bytecount(SEG_UART_TX, sent_len);
+						add_u2e_latency_sample(ctx);
+					}
 					//printf("sent len = %d\r\n", len); // ## for debugging
 					
-					//if(!keepalive_time && netinfo->keepalive_en)
-					//if((netinfo->keepalive_en == ENABLE) && (flag_sent_first_keepalive == DISABLE))
+					//if(!S2E_TIMER_TIME(ctx, KEEPALIVE) && netinfo->keepalive_en)
+					//if((netinfo->keepalive_en == ENABLE) && (ctx->flag_sent_first_keepalive == DISABLE))
 					if(netinfo->keepalive_en == ENABLE)
 					{
-						if(flag_sent_first_keepalive == DISABLE)
+						if(ctx->flag_sent_first_keepalive == DISABLE)
 						{
-							enable_keepalive_timer = SEG_ENABLE;
+							S2E_TIMER_RUN(ctx, KEEPALIVE) = SEG_ENABLE;
 						}
 						else
 						{
-							flag_sent_first_keepalive = SEG_DISABLE;
+							ctx->flag_sent_first_keepalive = SEG_DISABLE;
 						}
-						keepalive_time = 0;
+						S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
 					}
 				}
 				break;
 			
 			case SOCK_LISTEN:
-				u2e_size = 0;
+				if(zerocopy) consume_sent_data(ctx, zerocopy, len); // discard
+				ctx->u2e_size = 0;
+				if(ctx->ch == S2E_CH1) flag_u2e_rx_stamp = SEG_DISABLE;
 				return;
 			
 			default:
@@ -929,103 +1622,309 @@ void uart_to_ether(uint8_t sock)
 		}
 	}
 	
-	inactivity_time = 0;
-	//flag_serial_input_time_elapse = SEG_DISABLE; // this flag is cleared in the 'Data packing delimiter:time' checker routine
+	S2E_TIMER_TIME(ctx, INACTIVITY) = 0;
+	//ctx->flag_serial_input_time_elapse = SEG_DISABLE; // this flag is cleared in the 'Data packing delimiter:time' checker routine
 }
 
-uint16_t get_serial_data(void)
+// TCP server multi-session: the serial data is sent to each authenticated session from its own offset (u2e_sent),
+// the data is released when all the sessions have sent it. A slow session holds the data back (flow control).
+void uart_to_ether_sessions(s2e_session_t * ctx)
 {
-	struct __network_info *netinfo = (struct __network_info *)&(get_DevConfig_pointer()->network_info);
-	uint16_t i;
-	uint16_t len;
+	struct __network_info *netinfo = get_DevConfig_channel(ctx->ch)->network_info;
+	tsSEGSESSION * session;
+	uint8_t sessions = get_tcp_server_sessions(ctx);
+	uint8_t arbitration = (get_arbitration_timeout(ctx) != 0);
+	uint8_t connected = SEG_DISABLE;
+	uint8_t authenticated = SEG_DISABLE;
+	uint16_t len, pending, pos, len1st;
+	uint16_t release = 0xFFFF;
+	int16_t sent_len;
+	uint8_t * buf;
+	uint8_t zerocopy;
+	uint8_t i;
+	
+#if (DEVICE_BOARD_NAME == WIZ750SR)
+	if(get_phylink_in_pin() != 0) return; // PHY link down
+#endif
+	
+	zerocopy = ((ctx->u2e_size == 0) && (!check_packing_options(ctx)));
+	
+	if(zerocopy)
+	{
+		len = RING_USED_SIZE(ctx->rx);
+	}
+	else if((ctx->flag_u2e_remainder == SEG_ENABLE) && (ctx->u2e_size != 0))
+	{
+		len = ctx->u2e_size; // The packed data is still being sent to the sessions
+	}
+	else
+	{
+		// UART ring buffer -> user's buffer
+		ctx->flag_u2e_remainder = SEG_DISABLE;
+		len = get_serial_data(ctx);
+		add_data_transfer_bytecount(SEG_UART_RX, len);
+		if(len) ctx->flag_u2e_remainder = SEG_ENABLE;
+	}
 	
-	len = BUFFER_USED_SIZE(data_rx);
+	if(len == 0) return;
 	
-	if((len + u2e_size) >= DATA_BUF_SIZE) // Avoiding u2e buffer (g_send_buf) overflow	
+	for(i = 0; i < sessions; i++)
 	{
-		/* Checking Data packing option: charactor delimiter */
-		if((netinfo->packing_delimiter[0] != 0x00) && (len == 1))
+		session = &ctx->session[i];
+		if(getSn_TXBUF_SIZE(session->sock) == 0) continue;
+		if((getSn_SR(session->sock) != SOCK_ESTABLISHED) && (getSn_SR(session->sock) != SOCK_CLOSE_WAIT)) continue;
+		if(arbitration && (i != ctx->arb_owner)) continue; // Serial line arbitration: the response is routed to the requester only
+		
+		connected = SEG_ENABLE;
+		if(session->flag_connect_pw_auth != SEG_ENABLE) continue; // The data is sent after the authentication
+		
+		authenticated = SEG_ENABLE;
+		if(session->u2e_sent < len)
 		{
-			g_send_buf[u2e_size] = (uint8_t)uart_getc(SEG_DATA_UART);
-			if(netinfo->packing_delimiter[0] == g_send_buf[u2e_size])
+			pending = len - session->u2e_sent;
+			if(zerocopy)
+			{
+				pos = RING_POS(ctx->rx, *ctx->rx->rd + session->u2e_sent);
+				buf = &ctx->rx->buf[pos];
+				len1st = ctx->rx->sz - pos;
+			}
+			else
 			{
-				return u2e_size;
+				buf = &ctx->send_buf[session->u2e_sent];
+				len1st = pending;
+			}
+			if(len1st > pending) len1st = pending;
+			
+			sent_len = (int16_t)send_sg(session->sock, buf, len1st, ctx->rx->buf, pending - len1st);
+			if(sent_len > 0)
+			{
+				session->u2e_sent += sent_len;
+				add_data_transfer_bytecount(SEG_UART_TX, sent_len);
+				
+				if(netinfo->keepalive_en == ENABLE)
+				{
+					if(session->flag_sent_first_keepalive == DISABLE)
+					{
+						S2E_TIMER_RUN(session, KEEPALIVE) = SEG_ENABLE;
+					}
+					else
+					{
+						session->flag_sent_first_keepalive = SEG_DISABLE;
+					}
+					S2E_TIMER_TIME(session, KEEPALIVE) = 0;
+				}
+				S2E_TIMER_TIME(session, INACTIVITY) = 0;
 			}
 		}
 		
+		if(session->u2e_sent < release) release = session->u2e_sent;
+	}
+	
+	if(connected == SEG_DISABLE)			release = len;	// No session: the data is discarded
+	else if(authenticated == SEG_DISABLE)	release = 0;	// Hold the data until a session is authenticated
+	
+	if(release != 0)
+	{
+		consume_sent_data(ctx, zerocopy, release);
+		if(authenticated) add_u2e_latency_sample(ctx);
+		
+		for(i = 0; i < ctx->sessions_max; i++)
+		{
+			if(ctx->session[i].u2e_sent > release)	ctx->session[i].u2e_sent -= release;
+			else									ctx->session[i].u2e_sent = 0;
+		}
+		
+		// Serial line arbitration: the transaction ends when the response (packed data) is sent
+		if(arbitration && !zerocopy && (ctx->u2e_size == 0)) end_serial_arbitration(ctx);
+	}
+}
+
+// Release the sent data: from the UART ring buffer (zero-copy) or from the user's buffer
+// A partial write (non-block io mode) leaves the remainder at the head of the user's buffer for the next try
+void consume_sent_data(s2e_session_t * ctx, uint8_t zerocopy, uint16_t len)
+{
+	flag_seg_progress = SEG_ENABLE;
+	
+	if(zerocopy)
+	{
+		RING_OUT_MOVE(ctx->rx, len);
+		add_data_transfer_bytecount(SEG_UART_RX, len);
+	}
+	else if(len < ctx->u2e_size)
+	{
+		ctx->u2e_size -= len;
+		memmove(ctx->send_buf, &ctx->send_buf[len], ctx->u2e_size);
+		ctx->flag_u2e_remainder = SEG_ENABLE;
+	}
+	else
+	{
+		ctx->u2e_size = 0;
+		ctx->flag_u2e_remainder = SEG_DISABLE;
+	}
+}
+
+uint16_t get_serial_data(s2e_session_t * ctx)
+{
+	struct __network_info *netinfo = get_DevConfig_channel(ctx->ch)->network_info;
+	struct __network_info_extend *netinfo_ext = get_DevConfig_channel(ctx->ch)->network_info_extend;
+	uint8_t rx_gap = ((netinfo->packing_time != 0) && (get_packing_time_msec(ctx) == 0));
+	uint16_t coalesce_size = 0;
+	uint16_t len, frame_len, copied;
+	uint16_t buf_size = (ctx->telnet ? (ctx->buf_size / 2) : ctx->buf_size); // Telnet COM port control: room for the escaped data
+	
+	len = RING_USED_SIZE(ctx->rx);
+	
+	// The delimiter match state belongs to the data in the u2e buffer
+	if(ctx->u2e_size == 0)
+	{
+		ctx->delim_matched = 0;
+		ctx->delim_appendix = 0;
+		S2E_TIMER_RUN(ctx, COALESCE) = SEG_DISABLE;
+	}
+	
+	if((len + ctx->u2e_size) >= buf_size) // Avoiding u2e buffer (ctx->send_buf) overflow	
+	{
 		//BUFFER_CLEAR(data_rx);
 		//return 0; 
 		
 		// serial data length value update for avoiding u2e buffer overflow
-		len = DATA_BUF_SIZE - u2e_size;
+		len = buf_size - ctx->u2e_size;
 	}
 	
-	if((!netinfo->packing_time) && (!netinfo->packing_size) && (!netinfo->packing_delimiter[0])) // No Packing delimiters.
+	// Packing delimiter: time option by the UART Rx gap timer, the copy length is limited by the frame end
+	if(rx_gap)
 	{
-		//ret = uart_gets(SEG_DATA_UART, g_send_buf, len);
-		//return (uint16_t)ret;
+		if((ctx->flag_rx_frame_end == SEG_DISABLE) && seg_rx_gap_check(ctx, &ctx->rx_frame_end)) ctx->flag_rx_frame_end = SEG_ENABLE;
 		
-		// ## 20150427 bugfix: Incorrect serial data storing (UART ring buffer to g_send_buf)
-		for(i = 0; i < len; i++)
+		if(ctx->flag_rx_frame_end == SEG_ENABLE)
 		{
-			g_send_buf[u2e_size++] = (uint8_t)uart_getc(SEG_DATA_UART);
+			frame_len = (uint16_t)(ctx->rx_frame_end - *ctx->rx->rd);
+			if(frame_len > ctx->rx->sz)	ctx->flag_rx_frame_end = SEG_DISABLE; // The frame end of the flushed data
+			else if(frame_len < len)	len = frame_len;
 		}
+	}
+	
+	if(!check_packing_options(ctx)) // No Packing delimiters.
+	{
+		// ## 20150427 bugfix: Incorrect serial data storing (UART ring buffer to g_send_buf)
+		// Bulk copy by the contiguous segments of the ring buffer
+		ctx->u2e_size += (uint16_t)uart_gets(ctx->uart, &ctx->send_buf[ctx->u2e_size], len);
 		
-		return u2e_size;
+		return ctx->u2e_size;
 	}
 	else
 	{
 		/* Checking Data packing options */
-		for(i = 0; i < len; i++)
+		// Packing delimiter: size option, the copy length is limited by the remaining size
+		if((netinfo->packing_size != 0) && (netinfo->packing_size > ctx->u2e_size) && ((netinfo->packing_size - ctx->u2e_size) < len))
+		{
+			len = netinfo->packing_size - ctx->u2e_size;
+		}
+		
+		// Packing delimiter: coalesce to MSS option, the copy length is limited by the MSS
+		if(netinfo_ext->packing_coalesce_time != 0)
 		{
-			g_send_buf[u2e_size++] = (uint8_t)uart_getc(SEG_DATA_UART);
+			coalesce_size = get_packing_coalesce_size(ctx);
+			if((coalesce_size > ctx->u2e_size) && ((coalesce_size - ctx->u2e_size) < len)) len = coalesce_size - ctx->u2e_size;
+		}
+		
+		if(netinfo->packing_delimiter_length != 0)
+		{
+			// Packing delimiter: character option, the delimiter (1 ~ 4 bytes) and the appendix bytes (0 ~ 2 bytes) after the delimiter
+			if(ctx->delim_appendix == 0)
+			{
+				copied = (uint16_t)uart_gets_delim(ctx->uart, &ctx->send_buf[ctx->u2e_size], len, netinfo->packing_delimiter, netinfo->packing_delimiter_length, &ctx->delim_matched);
+				ctx->u2e_size += copied;
+				len -= copied;
+				
+				if(ctx->delim_matched == netinfo->packing_delimiter_length)
+				{
+					ctx->delim_matched = 0;
+					ctx->delim_appendix = netinfo->packing_data_appendix;
+					if(ctx->delim_appendix == 0) return ctx->u2e_size;
+				}
+			}
 			
-			// Packing delimiter: character option
-			if((netinfo->packing_delimiter[0] != 0x00) && (netinfo->packing_delimiter[0] == g_send_buf[u2e_size - 1]))
+			if(ctx->delim_appendix != 0)
+			{
+				if(len > ctx->delim_appendix) len = ctx->delim_appendix;
+				copied = (uint16_t)uart_gets(ctx->uart, &ctx->send_buf[ctx->u2e_size], len);
+				ctx->u2e_size += copied;
+				ctx->delim_appendix -= copied;
+				if(ctx->delim_appendix == 0) return ctx->u2e_size;
+			}
+		}
+		else
+		{
+			ctx->u2e_size += (uint16_t)uart_gets(ctx->uart, &ctx->send_buf[ctx->u2e_size], len);
+		}
+		
+		// Packing delimiter: size option
+		if((netinfo->packing_size != 0) && (netinfo->packing_size == ctx->u2e_size))
+		{
+			return ctx->u2e_size;
+		}
+		
+		// Packing delimiter: coalesce to MSS option, the data is held until the MSS is buffered or the latency budget expires
+		if((netinfo_ext->packing_coalesce_time != 0) && (ctx->u2e_size != 0))
+		{
+			if(S2E_TIMER_RUN(ctx, COALESCE) == SEG_DISABLE)
 			{
-				return u2e_size;
+				S2E_TIMER_TIME(ctx, COALESCE) = 0;
+				S2E_TIMER_RUN(ctx, COALESCE) = SEG_ENABLE;
 			}
 			
-			// Packing delimiter: size option
-			if((netinfo->packing_size != 0) && (netinfo->packing_size == u2e_size))
+			if((ctx->u2e_size >= coalesce_size) || (S2E_TIMER_TIME(ctx, COALESCE) >= netinfo_ext->packing_coalesce_time))
 			{
-				return u2e_size;
+				S2E_TIMER_RUN(ctx, COALESCE) = SEG_DISABLE;
+				return ctx->u2e_size;
 			}
 		}
 	}
 	
+	// The u2e buffer full: sent without waiting for the packing delimiters
+	if(ctx->u2e_size >= buf_size) return ctx->u2e_size;
+	
+	// Packing delimiter: time option (UART Rx gap timer), the data up to the frame end
+	if(rx_gap && (ctx->flag_rx_frame_end == SEG_ENABLE) && (*ctx->rx->rd == ctx->rx_frame_end))
+	{
+		ctx->flag_rx_frame_end = SEG_DISABLE;
+		if(ctx->u2e_size != 0) return ctx->u2e_size;
+	}
+	
 	// Packing delimiter: time option
-	if((netinfo->packing_time != 0) && (u2e_size != 0) && (flag_serial_input_time_elapse))
+	if((netinfo->packing_time != 0) && (ctx->u2e_size != 0) && (ctx->flag_serial_input_time_elapse))
 	{
-		if(BUFFER_USED_SIZE(data_rx) == 0) flag_serial_input_time_elapse = SEG_DISABLE; // ##
+		if(RING_USED_SIZE(ctx->rx) == 0) ctx->flag_serial_input_time_elapse = SEG_DISABLE; // ##
 		
-		return u2e_size;
+		return ctx->u2e_size;
 	}
 	
 	return 0;
 }
 
-void ether_to_uart(uint8_t sock)
+void ether_to_uart(s2e_session_t * ctx)
 {
-	struct __network_info *netinfo = (struct __network_info *)&(get_DevConfig_pointer()->network_info);
-	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
-	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	struct __network_info *netinfo = cfg->network_info;
+	struct __serial_info *serial = cfg->serial_info;
+	uint8_t sock = ctx->sock;
 	uint16_t len;
-	uint16_t i;
-
-	if(serial->flow_control == flow_rts_cts)
-	{
-#ifdef __USE_GPIO_HARDWARE_FLOWCONTROL__
-		if(get_uart_cts_pin(SEG_DATA_UART) != UART_CTS_LOW) return;
-#else
-		; // check the CTS reg
-#endif
-	}
 
+	if(check_uart_cts_permitted(ctx) == SEG_DISABLE) return;
 
 	// H/W Socket buffer -> User's buffer
-	len = getSn_RX_RSR(sock);
-	if(len > DATA_BUF_SIZE) len = DATA_BUF_SIZE; // avoiding buffer overflow
+	// Pulls only as much as the UART Tx ring buffer can accept, the pending data (ctx->e2u_size) is sent first
+	if(ctx->e2u_size != 0) 
+	{
+		len = 0;
+	}
+	else
+	{
+		len = getSn_RX_RSR(sock);
+		if(len > ctx->buf_size) len = ctx->buf_size; // avoiding buffer overflow
+		if(len > RING_FREE_SIZE(ctx->tx)) len = RING_FREE_SIZE(ctx->tx);
+	}
 	
 	//printf("ether_to_uart: %d\r\n", len); // ## for debugging
 	
@@ -1034,48 +1933,53 @@ void ether_to_uart(uint8_t sock)
 		switch(getSn_SR(sock))
 		{
 			case SOCK_UDP: // UDP_MODE
-				e2u_size = recvfrom(sock, g_recv_buf, len, peerip, &peerport);
+				ctx->e2u_size = recvfrom(sock, ctx->recv_buf, len, ctx->peerip, &ctx->peerport);
+				if((int16_t)ctx->e2u_size > 0) update_udp_peer(ctx, ctx->peerip, ctx->peerport);
 				
-				if(memcmp(peerip_tmp, peerip, 4) !=  0)
+				if(memcmp(peerip_tmp, ctx->peerip, 4) !=  0)
 				{
-					memcpy(peerip_tmp, peerip, 4);
-					if(serial->serial_debug_en == SEG_ENABLE) printf(" > UDP Peer IP/Port: %d.%d.%d.%d : %d\r\n", peerip[0], peerip[1], peerip[2], peerip[3], peerport);
+					memcpy(peerip_tmp, ctx->peerip, 4);
+					if(serial->serial_debug_en == SEG_ENABLE) printf(" > UDP Peer IP/Port: %d.%d.%d.%d : %d\r\n", ctx->peerip[0], ctx->peerip[1], ctx->peerip[2], ctx->peerip[3], ctx->peerport);
 				}
 				break;
 			
 			case SOCK_ESTABLISHED: // TCP_SERVER_MODE, TCP_CLIENT_MODE, TCP_MIXED_MODE
 			case SOCK_CLOSE_WAIT:
-				e2u_size = recv(sock, g_recv_buf, len);
+				ctx->e2u_size = recv(sock, ctx->recv_buf, len);
+				
+				// Telnet COM port control: the commands are processed, the data is left in the buffer
+				if(ctx->telnet && ((int16_t)ctx->e2u_size > 0)) ctx->e2u_size = rfc2217_unescape(ctx->ch, ctx->recv_buf, ctx->e2u_size);
 				break;
 			
 			default:
 				break;
 		}
 		
-		inactivity_time = 0;
-		keepalive_time = 0;
-		flag_sent_first_keepalive = DISABLE;
+		S2E_TIMER_TIME(ctx, INACTIVITY) = 0;
+		S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
+		ctx->flag_sent_first_keepalive = DISABLE;
 		
-		add_data_transfer_bytecount(SEG_ETHER_RX, e2u_size);
+		add_data_transfer_bytecount(SEG_ETHER_RX, ctx->e2u_size);
+		flag_seg_progress = SEG_ENABLE;
 	}
 	
-	if((netinfo->state == TCP_SERVER_MODE) || ((netinfo->state == TCP_MIXED_MODE) && (mixed_state == MIXED_SERVER)))
+	if((netinfo->state == TCP_SERVER_MODE) || ((netinfo->state == TCP_MIXED_MODE) && (ctx->mixed_state == MIXED_SERVER)))
 	{
 		// Connection password authentication
-		if((option->pw_connect_en == SEG_ENABLE) && (flag_connect_pw_auth == SEG_DISABLE))
+		if((*cfg->pw_connect_en == SEG_ENABLE) && (ctx->flag_connect_pw_auth == SEG_DISABLE))
 		{
-			if(check_connect_pw_auth(g_recv_buf, len) == SEG_ENABLE)
+			if(check_connect_pw_auth(ctx, ctx->recv_buf, len) == SEG_ENABLE)
 			{
-				flag_connect_pw_auth = SEG_ENABLE;
+				ctx->flag_connect_pw_auth = SEG_ENABLE;
 			}
 			else
 			{
-				flag_connect_pw_auth = SEG_DISABLE;
+				ctx->flag_connect_pw_auth = SEG_DISABLE;
 			}
 			
-			e2u_size = 0;
+			ctx->e2u_size = 0;
 			
-			if(flag_connect_pw_auth == SEG_DISABLE)
+			if(ctx->flag_connect_pw_auth == SEG_DISABLE)
 			{
 				disconnect(sock);
 				return;
@@ -1084,46 +1988,120 @@ void ether_to_uart(uint8_t sock)
 	}
 	
 	// Ethernet data transfer to DATA UART
-	if(e2u_size != 0)
+	put_serial_data(ctx);
+}
+
+// TCP server multi-session: a received packet of the session is queued to the UART at once,
+// the next session takes its turn when the queue (ctx->e2u_size) is empty
+void ether_to_uart_session(s2e_session_t * ctx, tsSEGSESSION * session)
+{
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	uint8_t sock = session->sock;
+	uint16_t len;
+	int32_t ret;
+	
+	if(cfg->network_info->working_mode == MODBUS_TCP_MODE)
 	{
-		if(serial->dsr_en == SEG_ENABLE) // DTR / DSR handshake (flowcontrol)
-		{
-			if(get_flowcontrol_dsr_pin() == 0) return;
-		}
-//////////////////////////////////////////////////////////////////////
-		if(serial->uart_interface == UART_IF_RS422_485)
-		{
-			uart_rs485_enable(SEG_DATA_UART);
-			//uart_puts(SEG_DATA_UART, g_recv_buf, e2u_size);
-			for(i = 0; i < e2u_size; i++) uart_putc(SEG_DATA_UART, g_recv_buf[i]);
-			uart_rs485_disable(SEG_DATA_UART);
-			
-			add_data_transfer_bytecount(SEG_ETHER_TX, e2u_size);
-			e2u_size = 0;
-		}
-//////////////////////////////////////////////////////////////////////
-		else if(serial->flow_control == flow_xon_xoff) 
-		{
-			if(isXON == SEG_ENABLE)
-			{
-				//uart_puts(SEG_DATA_UART, g_recv_buf, e2u_size);
-				for(i = 0; i < e2u_size; i++) uart_putc(SEG_DATA_UART, g_recv_buf[i]);
-				add_data_transfer_bytecount(SEG_ETHER_TX, e2u_size);
-				e2u_size = 0;
-			}
-			//else
-			//{
-			//	;//XOFF!!
-			//}
-		}
-		else
+		modbus_tcp_to_rtu(ctx, session);
+		return;
+	}
+	
+	if(check_uart_cts_permitted(ctx) == SEG_DISABLE) return;
+	if(ctx->e2u_size != 0) return;
+	if(get_arbitration_timeout(ctx) && (ctx->arb_owner != SEG_ARB_OWNER_NONE)) return; // Serial line busy: the request is queued in the socket buffer
+	
+	len = getSn_RX_RSR(sock);
+	if(len > ctx->buf_size) len = ctx->buf_size; // avoiding buffer overflow
+	if(len > RING_FREE_SIZE(ctx->tx)) len = RING_FREE_SIZE(ctx->tx);
+	if(len == 0) return;
+	
+	ret = recv(sock, ctx->recv_buf, len);
+	if(ret <= 0) return;
+	ctx->e2u_size = (uint16_t)ret;
+	flag_seg_progress = SEG_ENABLE;
+	
+	S2E_TIMER_TIME(session, INACTIVITY) = 0;
+	S2E_TIMER_TIME(session, KEEPALIVE) = 0;
+	session->flag_sent_first_keepalive = SEG_DISABLE;
+	
+	add_data_transfer_bytecount(SEG_ETHER_RX, ctx->e2u_size);
+	
+	// Connection password authentication
+	if((*cfg->pw_connect_en == SEG_ENABLE) && (session->flag_connect_pw_auth == SEG_DISABLE))
+	{
+		session->flag_connect_pw_auth = check_connect_pw_auth(ctx, ctx->recv_buf, ctx->e2u_size);
+		ctx->e2u_size = 0;
+		
+		if(session->flag_connect_pw_auth == SEG_DISABLE) disconnect(sock);
+		return;
+	}
+	
+	// Serial line arbitration: a received packet is a request, the transaction starts
+	// the response boundary is determined by the data packing options (time / size / delimiter)
+	if(get_arbitration_timeout(ctx))
+	{
+		uart_rx_flush(ctx->uart); // the serial data received before the request is not a response
+		ctx->u2e_size = 0;
+		ctx->flag_u2e_remainder = SEG_DISABLE;
+		
+		ctx->arb_owner = (uint8_t)(session - ctx->session);
+		ctx->arb_time = 0;
+	}
+	
+	put_serial_data(ctx);
+}
+
+// RTS/CTS flow control: the data can be sent to the UART while the CTS pin is low
+uint8_t check_uart_cts_permitted(s2e_session_t * ctx)
+{
+	struct __serial_info *serial = get_DevConfig_channel(ctx->ch)->serial_info;
+	
+	if(serial->flow_control == flow_rts_cts)
+	{
+#ifdef __USE_GPIO_HARDWARE_FLOWCONTROL__
+		if(get_uart_cts_pin(ctx->uart) != UART_CTS_LOW) return SEG_DISABLE;
+#else
+		; // check the CTS reg
+#endif
+	}
+	
+	return SEG_ENABLE;
+}
+
+// User's buffer (g_recv_buf) -> UART Tx ring buffer: the received length is limited by the ring buffer free size, queued at once
+// RS-485: the driver enable is controlled by the UART Tx path (uartHandler)
+void put_serial_data(s2e_session_t * ctx)
+{
+	struct __serial_info *serial = get_DevConfig_channel(ctx->ch)->serial_info;
+	
+	if(ctx->e2u_size == 0) return;
+	
+	if(serial->dsr_en == SEG_ENABLE) // DTR / DSR handshake (flowcontrol)
+	{
+		if(get_flowcontrol_dsr_pin() == 0) return;
+	}
+	
+	if(serial->flow_control == flow_xon_xoff) 
+	{
+		if(ctx->isXON == SEG_ENABLE)
 		{
-			//uart_puts(SEG_DATA_UART, g_recv_buf, e2u_size);
-			for(i = 0; i < e2u_size; i++) uart_putc(SEG_DATA_UART, g_recv_buf[i]);
-			
-			add_data_transfer_bytecount(SEG_ETHER_TX, e2u_size);
-			e2u_size = 0;
+			uart_write(ctx->uart, ctx->recv_buf, ctx->e2u_size);
+			add_data_transfer_bytecount(SEG_ETHER_TX, ctx->e2u_size);
+			ctx->e2u_size = 0;
+			flag_seg_progress = SEG_ENABLE;
 		}
+		//else
+		//{
+		//	;//XOFF!!
+		//}
+	}
+	else
+	{
+		uart_write(ctx->uart, ctx->recv_buf, ctx->e2u_size);
+		
+		add_data_transfer_bytecount(SEG_ETHER_TX, ctx->e2u_size);
+		ctx->e2u_size = 0;
+		flag_seg_progress = SEG_ENABLE;
 	}
 }
 
@@ -1158,17 +2136,14 @@ void send_keepalive_packet_manual(uint8_t sock)
 
 uint8_t process_socket_termination(uint8_t sock)
 {
-	struct __network_info *net = (struct __network_info *)get_DevConfig_pointer()->network_info;
 	uint8_t sock_status = getSn_SR(sock);
 	
 	if(sock_status == SOCK_CLOSED) return sock;
 	
-	if(net->working_mode != UDP_MODE) // TCP_SERVER_MODE / TCP_CLIENT_MODE / TCP_MIXED_MODE
+	// TCP connection (TCP_SERVER_MODE / TCP_CLIENT_MODE / TCP_MIXED_MODE): checked by the socket state, each data channel has its own working mode
+	if((sock_status == SOCK_ESTABLISHED) || (sock_status == SOCK_CLOSE_WAIT))
 	{
-		if((sock_status == SOCK_ESTABLISHED) || (sock_status == SOCK_CLOSE_WAIT))
-		{
-			disconnect(sock);
-		}
+		disconnect(sock);
 	}
 	
 	close(sock);
@@ -1177,22 +2152,54 @@ uint8_t process_socket_termination(uint8_t sock)
 }
 
 
-uint8_t check_connect_pw_auth(uint8_t * buf, uint16_t len)
+void process_data_sockets_termination(void)
 {
-	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
+	uint8_t i;
+	
+	for(i = 0; i < S2E_CHANNELS; i++) process_data_channel_termination(i);
+}
+
+void process_data_channel_termination(uint8_t ch)
+{
+	s2e_session_t * ctx = get_s2e_session(ch);
+	uint8_t i;
+	
+	if(ctx == NULL) return;
+	
+	lock_seg_data_path();
+	
+	// session[0]: the data socket of the channel
+	for(i = 0; i < ctx->sessions_max; i++)
+	{
+		process_socket_termination(ctx->session[i].sock);
+	}
+	
+	// Telnet COM port control: restored here, the state machine is not run in the AT mode
+	if(ctx->telnet)
+	{
+		rfc2217_close(ctx->ch);
+		ctx->telnet = SEG_DISABLE;
+	}
+	
+	unlock_seg_data_path();
+}
+
+uint8_t check_connect_pw_auth(s2e_session_t * ctx, uint8_t * buf, uint16_t len)
+{
+	char * pw_connect = get_DevConfig_channel(ctx->ch)->pw_connect;
 	uint8_t ret = SEG_DISABLE;
 	uint8_t pwbuf[11] = {0,};
 	
 	if(len >= sizeof(pwbuf)) len = sizeof(pwbuf) - 1;
 	
 	memcpy(pwbuf, buf, len);
-	if((len == strlen(option->pw_connect)) && (memcmp(option->pw_connect, pwbuf, len) == 0))
+	if((len == strlen(pw_connect)) && (memcmp(pw_connect, pwbuf, len) == 0))
 	{
 		ret = SEG_ENABLE; // Connection password auth success
 	}
 	
 #ifdef _SEG_DEBUG_
-	printf(" > Connection password: %s, len: %d\r\n", option->pw_connect, strlen(option->pw_connect));
+	printf(" > Connection password: %s, len: %d\r\n", pw_connect, strlen(pw_connect));
 	printf(" > Entered password: %s, len: %d\r\n", pwbuf, len);
 	printf(" >> Auth %s\r\n", ret ? "success":"failed");
 #endif
@@ -1200,11 +2207,17 @@ uint8_t check_connect_pw_auth(uint8_t * buf, uint16_t len)
 	return ret;
 }
 
+// Mode switch trigger code: the gap time before / after the code is the packing time delimiter of channel 1 (if set)
+static void init_modeswitch_gap_time(s2e_session_t * ctx)
+{
+	if((ctx->ch == S2E_CH1) && get_packing_time_msec(ctx)) modeswitch_gap_time = get_packing_time_msec(ctx);
+}
 
 void init_trigger_modeswitch(uint8_t mode)
 {
 	struct __network_info *netinfo = (struct __network_info *)&(get_DevConfig_pointer()->network_info);
 	struct __serial_info *serial = (struct __serial_info *)&(get_DevConfig_pointer()->serial_info);
+	s2e_session_t * ctx = &s2e_channel[S2E_CH1];
 	
 	if(mode == DEVICE_AT_MODE)
 	{
@@ -1214,41 +2227,40 @@ void init_trigger_modeswitch(uint8_t mode)
 		if(serial->serial_debug_en)
 		{
 			printf(" > SEG:AT Mode\r\n");
-			uart_puts(SEG_DATA_UART, (uint8_t *)"SEG:AT Mode\r\n", sizeof("SEG:AT Mode\r\n"));
+			uart_puts(ctx->uart, (uint8_t *)"SEG:AT Mode\r\n", sizeof("SEG:AT Mode\r\n"));
 		}
 	}
 	else // DEVICE_GW_MODE
 	{
 		opmode = DEVICE_GW_MODE;
 		set_device_status(ST_OPEN);
-		if(netinfo->working_mode == TCP_MIXED_MODE) mixed_state = MIXED_SERVER;
+		if(netinfo->working_mode == TCP_MIXED_MODE) ctx->mixed_state = MIXED_SERVER;
 				
 		if(serial->serial_debug_en)
 		{
 			printf(" > SEG:GW Mode\r\n");
-			uart_puts(SEG_DATA_UART, (uint8_t *)"SEG:GW Mode\r\n", sizeof("SEG:GW Mode\r\n"));
+			uart_puts(ctx->uart, (uint8_t *)"SEG:GW Mode\r\n", sizeof("SEG:GW Mode\r\n"));
 		}
 	}
 	
-	u2e_size = 0;
-	BUFFER_CLEAR(data_rx);
+	ctx->u2e_size = 0;
+	uart_rx_flush(ctx->uart);
 	
-	enable_inactivity_timer = SEG_DISABLE;
-	enable_keepalive_timer = SEG_DISABLE;
-	enable_serial_input_timer = SEG_DISABLE;
+	S2E_TIMER_RUN(ctx, INACTIVITY) = SEG_DISABLE;
+	S2E_TIMER_RUN(ctx, KEEPALIVE) = SEG_DISABLE;
+	S2E_TIMER_RUN(ctx, SERIAL_INPUT) = SEG_DISABLE;
 	enable_modeswitch_timer = SEG_DISABLE;
 	
-	inactivity_time = 0;
-	keepalive_time = 0;
-	serial_input_time = 0;
+	S2E_TIMER_TIME(ctx, INACTIVITY) = 0;
+	S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
+	S2E_TIMER_TIME(ctx, SERIAL_INPUT) = 0;
 	modeswitch_time = 0;
 	
-	flag_serial_input_time_elapse = 0;
+	ctx->flag_serial_input_time_elapse = 0;
 }
 
 uint8_t check_modeswitch_trigger(uint8_t ch)
 {
-	struct __network_info *netinfo = (struct __network_info *)&(get_DevConfig_pointer()->network_info);
 	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
 	
 	uint8_t modeswitch_failed = SEG_DISABLE;
@@ -1315,10 +2327,38 @@ void restore_serial_data(uint8_t idx)
 	triggercode_idx = 0;
 }
 
-uint8_t check_serial_store_permitted(uint8_t ch)
+uint8_t get_modeswitch_trigger_idx(void)
 {
-	struct __network_info *net = (struct __network_info *)get_DevConfig_pointer()->network_info;
-	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	return triggercode_idx;
+}
+
+void clear_modeswitch_gap_time(void)
+{
+	modeswitch_time = 0; // reset the inter gap time count (Allowable interval)
+}
+
+// This function have to call by UART Rx IRQ handler, after the received data stored
+void notify_serial_rx(void)
+{
+	if(flag_u2e_rx_stamp == SEG_DISABLE)
+	{
+		u2e_rx_stamp = getDeviceTimestamp();
+		flag_u2e_rx_stamp = SEG_ENABLE;
+	}
+	
+	set_event(EVENT_SEG | EVENT_SEGCP); // Serial command mode: the serial data is processed by SEGCP
+	
+	if(check_immediate_flush(&s2e_channel[S2E_CH1])) SCB->ICSR = SCB_ICSR_PENDSVSET_Msk; // do_seg_immediate_flush() at the lowest priority
+}
+
+uint8_t get_serial_store_permitted(void)
+{
+	return get_seg_store_permitted(&s2e_channel[S2E_CH1]);
+}
+
+static uint8_t get_seg_store_permitted(s2e_session_t * ctx)
+{
+	struct __network_info *net = get_DevConfig_channel(ctx->ch)->network_info;
 	
 	uint8_t ret = SEG_DISABLE; // SEG_DISABLE: Doesn't put the serial data in a ring buffer
 	
@@ -1335,66 +2375,552 @@ uint8_t check_serial_store_permitted(uint8_t ch)
 			break;
 	}
 	
-	// Software flow control: Check the XON/XOFF start/stop commands
-	// [Peer] -> [WIZnet Device]
-	if((ret == SEG_ENABLE) && (serial->flow_control == flow_xon_xoff))
-	{
-		if(ch == UART_XON)
-		{
-			isXON = SEG_ENABLE;
-			ret = SEG_DISABLE; 
-		}
-		else if(ch == UART_XOFF)
-		{
-			isXON = SEG_DISABLE;
-			ret = SEG_DISABLE;
-		}
-	}
-	
 	return ret;
 }
 
-void reset_SEG_timeflags(void)
+#ifdef __USE_DUAL_DATA_UART__
+uint8_t get_serial_ch2_store_permitted(void)
+{
+	if(get_DevConfig_ch2_pointer()->channel_en != SEG_ENABLE) return SEG_DISABLE;
+	return get_seg_store_permitted(&s2e_channel[S2E_CH2]);
+}
+
+// This function have to call by UART1 Rx IRQ handler, after the received data stored
+void notify_serial_ch2_rx(void)
+{
+	s2e_session_t * ctx = &s2e_channel[S2E_CH2];
+	
+	if(get_packing_time_msec(ctx) != 0)
+	{
+		S2E_TIMER_TIME(ctx, SERIAL_INPUT) = 0;
+		S2E_TIMER_RUN(ctx, SERIAL_INPUT) = SEG_ENABLE;
+	}
+	
+	// Rx gap: counted again from the last Rx burst
+	if(ctx->gap_msec != 0)
+	{
+		ctx->gap_wr = *ctx->rx->wr;
+		S2E_TIMER_TIME(ctx, RX_GAP) = 0;
+		S2E_TIMER_RUN(ctx, RX_GAP) = SEG_ENABLE;
+	}
+	
+	set_event(EVENT_SEG);
+	
+	if(check_immediate_flush(ctx)) SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+#endif
+
+uint8_t check_serial_store_permitted(uint8_t ch)
+{
+	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	s2e_session_t * ctx = &s2e_channel[S2E_CH1];
+	
+	uint8_t ret = get_serial_store_permitted();
+	
+	// Software flow control: Check the XON/XOFF start/stop commands
+	// [Peer] -> [WIZnet Device]
+	if((ret == SEG_ENABLE) && (serial->flow_control == flow_xon_xoff))
+	{
+		if(ch == UART_XON)
+		{
+			ctx->isXON = SEG_ENABLE;
+			ret = SEG_DISABLE; 
+		}
+		else if(ch == UART_XOFF)
+		{
+			ctx->isXON = SEG_DISABLE;
+			ret = SEG_DISABLE;
+		}
+	}
+	
+	return ret;
+}
+
+void reset_SEG_timeflags(s2e_session_t * ctx)
 {
 	// Timer disable
-	enable_inactivity_timer = SEG_DISABLE;
-	enable_serial_input_timer = SEG_DISABLE;
-	enable_keepalive_timer = SEG_DISABLE;
-	enable_connection_auth_timer = SEG_DISABLE;
+	S2E_TIMER_RUN(ctx, INACTIVITY) = SEG_DISABLE;
+	S2E_TIMER_RUN(ctx, SERIAL_INPUT) = SEG_DISABLE;
+	S2E_TIMER_RUN(ctx, KEEPALIVE) = SEG_DISABLE;
+	S2E_TIMER_RUN(ctx, CONNECTION_AUTH) = SEG_DISABLE;
 	
 	// Flag clear
-	flag_serial_input_time_elapse = SEG_DISABLE;
-	flag_sent_keepalive = SEG_DISABLE;
+	ctx->flag_serial_input_time_elapse = SEG_DISABLE;
 	//flag_sent_keepalive_wait = SEG_DISABLE;
-	flag_connect_pw_auth = SEG_DISABLE; // TCP_SERVER_MODE only (+ MIXED_SERVER)
+	ctx->flag_connect_pw_auth = SEG_DISABLE; // TCP_SERVER_MODE only (+ MIXED_SERVER)
 	
 	// Timer value clear
-	inactivity_time = 0;
-	serial_input_time = 0;
-	keepalive_time = 0;
-	connection_auth_time = 0;
+	S2E_TIMER_TIME(ctx, INACTIVITY) = 0;
+	S2E_TIMER_TIME(ctx, SERIAL_INPUT) = 0;
+	S2E_TIMER_TIME(ctx, KEEPALIVE) = 0;
+	S2E_TIMER_TIME(ctx, CONNECTION_AUTH) = 0;
 }
 
 void init_time_delimiter_timer(void)
 {
-	struct __network_info *netinfo = (struct __network_info *)&(get_DevConfig_pointer()->network_info);
 	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
+	s2e_session_t * ctx = &s2e_channel[S2E_CH1];
 	//DevConfig *s2e = get_DevConfig_pointer();
 	
 	if((option->serial_command == SEG_ENABLE) && (opmode == DEVICE_GW_MODE))
 	{
-		if(netinfo->packing_time != 0)
+		if(get_packing_time_msec(ctx) != 0)
 		{
-			if(enable_serial_input_timer == SEG_DISABLE) enable_serial_input_timer = SEG_ENABLE;
-			serial_input_time = 0;
+			if(S2E_TIMER_RUN(ctx, SERIAL_INPUT) == SEG_DISABLE) S2E_TIMER_RUN(ctx, SERIAL_INPUT) = SEG_ENABLE;
+			S2E_TIMER_TIME(ctx, SERIAL_INPUT) = 0;
 		}
 	}
 }
 
-uint8_t check_tcp_connect_exception(void)
+// Data packing time delimiter counted by the 1ms tick, ret: [0] not used or the UART Rx gap timer is used
+uint16_t get_packing_time_msec(s2e_session_t * ctx)
 {
-	struct __network_info *net = (struct __network_info *)get_DevConfig_pointer()->network_info;
-	struct __serial_info *serial = (struct __serial_info *)get_DevConfig_pointer()->serial_info;
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	
+	if(cfg->network_info_extend->packing_time_unit != PACKING_TIME_UNIT_MSEC) return 0;
+	return cfg->network_info->packing_time;
+}
+
+// UDP mode 1:N: the peer is learned / refreshed by the received packet
+void update_udp_peer(s2e_session_t * ctx, uint8_t * ip, uint16_t port)
+{
+	uint8_t i, idx = UDP_PEER_TABLE_SIZE;
+	
+	for(i = 0; i < UDP_PEER_TABLE_SIZE; i++)
+	{
+		if(ctx->udp_peer[i].valid && (ctx->udp_peer[i].port == port) && !memcmp(ctx->udp_peer[i].ip, ip, 4))
+		{
+			ctx->udp_peer[i].age = 0;
+			return;
+		}
+	}
+	
+	// New peer: an empty entry, or the least recently heard peer is replaced
+	for(i = 0; i < UDP_PEER_TABLE_SIZE; i++)
+	{
+		if(!ctx->udp_peer[i].valid) { idx = i; break; }
+		if((idx == UDP_PEER_TABLE_SIZE) || (ctx->udp_peer[i].age > ctx->udp_peer[idx].age)) idx = i;
+	}
+	
+	memcpy(ctx->udp_peer[idx].ip, ip, 4);
+	ctx->udp_peer[idx].port = port;
+	ctx->udp_peer[idx].age = 0;
+	ctx->udp_peer[idx].valid = SEG_ENABLE;
+}
+
+void clear_udp_peers(s2e_session_t * ctx)
+{
+	memset(ctx->udp_peer, 0x00, sizeof(ctx->udp_peer));
+	ctx->udp_peer_next = 0;
+}
+
+// UDP mode 1:N: the serial data is sent to the peers of the peer table by the delivery option
+// ret: [len] sent to all / one peer; the data is consumed, [0] busy or no live peer; the data is kept and retried
+int32_t send_udp_peers(s2e_session_t * ctx, uint8_t sock, uint8_t * buf, uint16_t len1st, uint16_t len)
+{
+	int32_t ret = 0;
+	uint8_t i, idx;
+	uint8_t sent;
+	
+	if(get_DevConfig_channel(ctx->ch)->network_info_extend->udp_peer_delivery == UDP_PEER_DELIVERY_ALL)
+	{
+		// The same packet is sent to each live peer in turn, resumed from the next peer when busy
+		sent = (ctx->udp_peer_next != 0);
+		for(; ctx->udp_peer_next < UDP_PEER_TABLE_SIZE; ctx->udp_peer_next++)
+		{
+			if(!ctx->udp_peer[ctx->udp_peer_next].valid) continue;
+			
+			ret = sendto_sg(sock, buf, len1st, ctx->rx->buf, len - len1st, ctx->udp_peer[ctx->udp_peer_next].ip, ctx->udp_peer[ctx->udp_peer_next].port);
+			if(ret == SOCK_BUSY) return 0;
+			if(ret < 0) ctx->udp_peer[ctx->udp_peer_next].valid = SEG_DISABLE; // e.g., ARP timeout: the peer is removed
+			sent = SEG_ENABLE;
+		}
+		
+		ctx->udp_peer_next = 0;
+		return (sent ? len : 0);
+	}
+	
+	// Round-robin: one packet to the next live peer
+	for(i = 0; i < UDP_PEER_TABLE_SIZE; i++)
+	{
+		idx = (ctx->udp_peer_next + i) % UDP_PEER_TABLE_SIZE;
+		if(!ctx->udp_peer[idx].valid) continue;
+		
+		ret = sendto_sg(sock, buf, len1st, ctx->rx->buf, len - len1st, ctx->udp_peer[idx].ip, ctx->udp_peer[idx].port);
+		if(ret == SOCK_BUSY) return 0;
+		if(ret > 0)
+		{
+			ctx->udp_peer_next = (idx + 1) % UDP_PEER_TABLE_SIZE;
+			return ret;
+		}
+		ctx->udp_peer[idx].valid = SEG_DISABLE;
+	}
+	
+	return 0;
+}
+
+// UDP mode: multicast group joined by the data socket, ret: [0] disabled
+uint8_t check_udp_multicast(s2e_session_t * ctx)
+{
+	uint8_t * mcast_ip = get_DevConfig_channel(ctx->ch)->network_info_extend->udp_multicast_ip;
+	
+	return ((mcast_ip[0] >= 224) && (mcast_ip[0] <= 239));
+}
+
+// Data packing options, ret: [0] no packing option, the serial data is sent as received
+uint8_t check_packing_options(s2e_session_t * ctx)
+{
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	
+	return ((cfg->network_info->packing_time != 0) || (cfg->network_info->packing_size != 0) || 
+			(cfg->network_info->packing_delimiter_length != 0) || (cfg->network_info_extend->packing_coalesce_time != 0));
+}
+
+// Data packing coalesce to MSS: the packet size, the MSS of the S2E data socket (up to the u2e buffer size)
+uint16_t get_packing_coalesce_size(s2e_session_t * ctx)
+{
+	uint16_t mss = getSn_MSSR(ctx->sock);
+	
+	if((mss == 0) || (mss > ctx->buf_size)) mss = ctx->buf_size;
+	return mss;
+}
+
+// UART Rx gap timer by the working mode / options: Modbus RTU t3.5 or the Data packing time delimiter in usec / character times
+// This function have to call after the data UART configured, and when the working mode or the packing time changed
+// The UART without the gap timer (channel 2): the gap is rounded up to the 1ms tick, counted after the last Rx burst
+void init_seg_rx_gap_timer(uint8_t ch)
+{
+	s2e_session_t * ctx = get_s2e_session(ch);
+	const DevConfig_channel *cfg;
+	uint16_t packing_time;
+	uint16_t half_chars = 0;
+	uint16_t min_usec = 0;
+	uint32_t usec;
+	
+	if(ctx == NULL) return;
+	
+	cfg = get_DevConfig_channel(ctx->ch);
+	packing_time = cfg->network_info->packing_time;
+	
+	if(cfg->network_info->working_mode == MODBUS_TCP_MODE)
+	{
+		half_chars = MODBUS_RTU_T35_HALF_CHARS;
+		min_usec = MODBUS_RTU_T35_MIN_USEC;
+	}
+	else if((packing_time != 0) && (cfg->network_info_extend->packing_time_unit == PACKING_TIME_UNIT_USEC))
+	{
+		min_usec = packing_time;
+	}
+	else if((packing_time != 0) && (cfg->network_info_extend->packing_time_unit == PACKING_TIME_UNIT_HALF_CHAR))
+	{
+		half_chars = packing_time;
+	}
+	
+	if(ctx->uart == SEG_DATA_UART)
+	{
+		uart_rx_gap_timer_init(half_chars, min_usec);
+	}
+	else
+	{
+		usec = ((uint32_t)half_chars * get_uart_char_usec(cfg->serial_info) + 1) / 2;
+		if(usec < min_usec) usec = min_usec;
+		
+		ctx->timer_run[S2E_TIMER_RX_GAP] = SEG_DISABLE;
+		ctx->gap_msec = usec ? (uint16_t)((usec + 999) / 1000 + 1) : 0; // +1: the first tick comes at any time within 1ms
+		ctx->gap_out = ctx->gap_in;
+	}
+	
+	ctx->flag_rx_frame_end = SEG_DISABLE;
+	ctx->flag_mb_frame_end = SEG_DISABLE;
+}
+
+// Rx gap (frame end) of the channel: ret [1] the line idle detected, *end: the Rx ring buffer index of the frame end
+static uint8_t seg_rx_gap_check(s2e_session_t * ctx, uint16_t * end)
+{
+	uint8_t in;
+	
+	if(ctx->uart == SEG_DATA_UART) return uart_rx_gap_check(end);
+	
+	if(ctx->gap_in == ctx->gap_out) return 0;
+	
+	// gap_end is written by the timer IRQ handler before gap_in; read again when the handler came in between
+	do {
+		in = ctx->gap_in;
+		BUFFER_BARRIER();
+		*end = ctx->gap_end;
+		BUFFER_BARRIER();
+	} while(in != ctx->gap_in);
+	
+	ctx->gap_out = in;
+	return 1;
+}
+
+static void seg_rx_gap_flush(s2e_session_t * ctx)
+{
+	if(ctx->uart == SEG_DATA_UART) uart_rx_gap_flush();
+	else ctx->gap_out = ctx->gap_in;
+}
+
+// Event-driven main loop: ret [1] the data moved since the last call (cleared)
+uint8_t take_seg_progress(void)
+{
+	uint8_t progress = flag_seg_progress;
+	
+	flag_seg_progress = SEG_DISABLE;
+	return progress;
+}
+
+// Event-driven main loop: the data path has more work to do without a new event
+// (the data left in the socket Rx buffer, the partially sent data or the unpacked serial data)
+// The blocked data is not pending: the data waits for the event which removes the blocking reason
+// (XON / DSR / CTS by the UART and the polling events, the UDP peer and the password by the socket events)
+uint8_t check_seg_pending(void)
+{
+	uint8_t ch;
+	
+	for(ch = 0; ch < S2E_CHANNELS; ch++)
+	{
+		if(check_seg_channel_pending(&s2e_channel[ch])) return SEG_ENABLE;
+	}
+	
+	return SEG_DISABLE;
+}
+
+static uint8_t check_seg_channel_pending(s2e_session_t * ctx)
+{
+	uint8_t state = getSn_SR(ctx->sock);
+	uint8_t i;
+	
+	if(!check_seg_channel_active(ctx)) return SEG_DISABLE;
+	
+	// Ethernet to UART: the UART Tx interrupt resumes the data when the Tx ring buffer is full
+	if(!IS_RING_FULL(ctx->tx) && check_e2u_permitted(ctx))
+	{
+		if(ctx->e2u_size) return SEG_ENABLE;
+		if(!(get_arbitration_timeout(ctx) && (ctx->arb_owner != SEG_ARB_OWNER_NONE)))
+		{
+			for(i = 0; i < ctx->sessions_max; i++)
+			{
+				if(getSn_RX_RSR(ctx->session[i].sock)) return SEG_ENABLE;
+			}
+		}
+	}
+	
+	// Closed by the peer: the disconnect follows the remaining data sent out to the UART
+	if((state == SOCK_CLOSE_WAIT) && !ctx->e2u_size && !getSn_RX_RSR(ctx->sock)) return SEG_ENABLE;
+	
+	// UART to Ethernet
+	if((state == SOCK_UDP) || (state == SOCK_ESTABLISHED) || (state == SOCK_CLOSE_WAIT))
+	{
+		if(!check_u2e_permitted(ctx, state)) return SEG_DISABLE;
+		if(ctx->flag_u2e_remainder == SEG_ENABLE) return SEG_ENABLE;
+		if(RING_USED_SIZE(ctx->rx) && !check_packing_options(ctx)) return SEG_ENABLE;
+	}
+	
+	return SEG_DISABLE;
+}
+
+// Ethernet to UART: ret [0] the data is held back by the flow control (CTS high, DSR low, XOFF)
+static uint8_t check_e2u_permitted(s2e_session_t * ctx)
+{
+	struct __serial_info *serial = get_DevConfig_channel(ctx->ch)->serial_info;
+	
+	if(check_uart_cts_permitted(ctx) == SEG_DISABLE) return SEG_DISABLE;
+	if((ctx->ch == S2E_CH1) && (serial->dsr_en == SEG_ENABLE) && (get_flowcontrol_dsr_pin() == 0)) return SEG_DISABLE; // DSR pin: channel 1
+	if((serial->flow_control == flow_xon_xoff) && (ctx->isXON != SEG_ENABLE)) return SEG_DISABLE;
+	
+	return SEG_ENABLE;
+}
+
+// UART to Ethernet: ret [0] the data cannot be sent (PHY link down, no UDP peer, connection password not authenticated)
+static uint8_t check_u2e_permitted(s2e_session_t * ctx, uint8_t state)
+{
+	struct __network_info *netinfo = get_DevConfig_channel(ctx->ch)->network_info;
+	uint8_t sessions = get_tcp_server_sessions(ctx);
+	uint8_t i;
+	
+#if (DEVICE_BOARD_NAME == WIZ750SR)
+	if(get_phylink_in_pin() != 0) return SEG_DISABLE;
+#endif
+	
+	if(state == SOCK_UDP)
+	{
+		if(check_udp_multicast(ctx)) return SEG_ENABLE;
+		if((netinfo->remote_ip[0] | netinfo->remote_ip[1] | netinfo->remote_ip[2] | netinfo->remote_ip[3]) != 0) return SEG_ENABLE;
+		if(get_DevConfig_channel(ctx->ch)->network_info_extend->udp_peer_delivery != UDP_PEER_DELIVERY_LAST) return SEG_ENABLE;
+		
+		return ((ctx->peerip[0] | ctx->peerip[1] | ctx->peerip[2] | ctx->peerip[3]) != 0);
+	}
+	
+	// TCP server multi-session: the data is sent after a session is authenticated
+	if((netinfo->working_mode == TCP_SERVER_MODE) && (sessions > 1))
+	{
+		for(i = 0; i < sessions; i++)
+		{
+			if(ctx->session[i].flag_connect_pw_auth == SEG_ENABLE) return SEG_ENABLE;
+		}
+		return SEG_DISABLE;
+	}
+	
+	return (ctx->flag_connect_pw_auth == SEG_ENABLE);
+}
+
+// Immediate flush mode: PendSV runs at the lowest priority, after the UART / timer interrupt handlers returned
+void init_seg_immediate_flush(void)
+{
+	NVIC_SetPriority(PendSV_IRQn, (1 << __NVIC_PRIO_BITS) - 1);
+}
+
+// Immediate flush mode: the single data socket working modes of the active channel only,
+// the TCP server multi-session and the Modbus TCP gateway send the data by the main loop
+uint8_t check_immediate_flush(s2e_session_t * ctx)
+{
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	
+	if(cfg->network_info_extend->immediate_flush != IMMEDIATE_FLUSH_ENABLE) return SEG_DISABLE;
+	if((flag_s2e_application_running == 0) || !check_seg_channel_active(ctx)) return SEG_DISABLE;
+	if(get_DevConfig_pointer()->firmware_update.fwup_flag == SEG_ENABLE) return SEG_DISABLE;
+	
+	switch(cfg->network_info->working_mode)
+	{
+		case TCP_CLIENT_MODE:
+		case TCP_MIXED_MODE:
+		case UDP_MODE:
+			return SEG_ENABLE;
+		
+		case TCP_SERVER_MODE:
+			return (get_tcp_server_sessions(ctx) == 1);
+		
+		default:
+			break;
+	}
+	
+	return SEG_DISABLE;
+}
+
+// This function have to call by PendSV handler
+void do_seg_immediate_flush(void)
+{
+	s2e_session_t * ctx;
+	uint8_t state;
+	uint8_t ch;
+	
+	for(ch = 0; ch < S2E_CHANNELS; ch++)
+	{
+		if(check_immediate_flush(&s2e_channel[ch])) break;
+	}
+	if(ch == S2E_CHANNELS) return;
+	
+	if(seg_data_path_lock)
+	{
+		flag_flush_pending = SEG_ENABLE; // unlock_seg_data_path() requests the flush again
+		return;
+	}
+	
+#ifdef __USE_UART_RX_DMA__
+	uart_rx_dma_process();
+#endif
+	
+	for( ; ch < S2E_CHANNELS; ch++)
+	{
+		ctx = &s2e_channel[ch];
+		if(!check_immediate_flush(ctx)) continue;
+		
+		state = getSn_SR(ctx->sock);
+		
+		// The TCP connection event (the UART Ring buffer clear) is processed by the main loop first
+		if(((state == SOCK_ESTABLISHED) || (state == SOCK_CLOSE_WAIT)) && (getSn_IR(ctx->sock) & Sn_IR_CON)) continue;
+		
+		if((state == SOCK_UDP) || (state == SOCK_ESTABLISHED) || (state == SOCK_CLOSE_WAIT))
+		{
+			if(RING_USED_SIZE(ctx->rx) || ctx->u2e_size) uart_to_ether(ctx);
+		}
+	}
+}
+
+// The data path (UART ring buffer, user's buffer and the data sockets) is used by the main loop, nested calls allowed
+void lock_seg_data_path(void)
+{
+	seg_data_path_lock++;
+}
+
+void unlock_seg_data_path(void)
+{
+	if(seg_data_path_lock) seg_data_path_lock--;
+	
+	if((seg_data_path_lock == 0) && (flag_flush_pending == SEG_ENABLE))
+	{
+		flag_flush_pending = SEG_DISABLE;
+		SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+	}
+}
+
+// Serial to Ethernet latency: UART Rx interrupt of the first byte not sent yet -> the send command of the data
+void add_u2e_latency_sample(s2e_session_t * ctx)
+{
+	uint32_t stamp = u2e_rx_stamp;
+	uint32_t usec;
+	uint16_t idx;
+	uint8_t i;
+	
+	if(ctx->ch != S2E_CH1) return; // the Rx time stamp is taken by the channel 1 UART Rx IRQ handler
+	if(flag_u2e_rx_stamp == SEG_DISABLE) return;
+	flag_u2e_rx_stamp = SEG_DISABLE;
+	
+	usec = convertTimestamp_usec(getDeviceTimestamp() - stamp);
+	
+	idx = (usec / SEG_LATENCY_BUCKET_USEC < SEG_LATENCY_BUCKETS) ? (usec / SEG_LATENCY_BUCKET_USEC) : SEG_LATENCY_BUCKETS;
+	
+	// Bucket count saturated: all the counts are halved, the distribution is kept
+	if(u2e_latency_hist[idx] == 0xFFFF)
+	{
+		for(i = 0; i <= SEG_LATENCY_BUCKETS; i++) u2e_latency_hist[i] >>= 1;
+	}
+	
+	u2e_latency_hist[idx]++;
+	u2e_latency_count++;
+	if(usec > u2e_latency_max) u2e_latency_max = usec;
+}
+
+// ret: upper bound of the histogram bucket that contains the percentile (usec), the max for the overflow bucket
+uint32_t get_u2e_latency_usec(uint8_t percentile)
+{
+	uint32_t total = 0;
+	uint32_t target, sum = 0;
+	uint8_t i;
+	
+	for(i = 0; i <= SEG_LATENCY_BUCKETS; i++) total += u2e_latency_hist[i];
+	if((total == 0) || (percentile >= 100)) return u2e_latency_max;
+	
+	target = ((total * percentile) + 99) / 100;
+	for(i = 0; i < SEG_LATENCY_BUCKETS; i++)
+	{
+		sum += u2e_latency_hist[i];
+		if(sum >= target) break;
+	}
+	
+	if((i == SEG_LATENCY_BUCKETS) || ((uint32_t)(i + 1) * SEG_LATENCY_BUCKET_USEC > u2e_latency_max)) return u2e_latency_max;
+	
+	return (uint32_t)(i + 1) * SEG_LATENCY_BUCKET_USEC;
+}
+
+uint32_t get_u2e_latency_count(void)
+{
+	return u2e_latency_count;
+}
+
+void clear_u2e_latency(void)
+{
+	memset(u2e_latency_hist, 0x00, sizeof(u2e_latency_hist));
+	u2e_latency_count = 0;
+	u2e_latency_max = 0;
+	flag_u2e_rx_stamp = SEG_DISABLE;
+}
+
+uint8_t check_tcp_connect_exception(s2e_session_t * ctx)
+{
+	struct __network_info *net = get_DevConfig_channel(ctx->ch)->network_info;
+	struct __serial_info *serial = get_DevConfig_channel(ctx->ch)->serial_info;
 	struct __options *option = (struct __options *)&(get_DevConfig_pointer()->options);
 	
 	uint8_t srcip[4] = {0, };
@@ -1402,8 +2928,8 @@ uint8_t check_tcp_connect_exception(void)
 	
 	getSIPR(srcip);
 	
-	// DNS failed
-	if((option->dns_use == SEG_ENABLE) && (flag_process_dns_success != ON))
+	// DNS failed (the remote host name is the channel 1 setting)
+	if((ctx->ch == S2E_CH1) && (option->dns_use == SEG_ENABLE) && (flag_process_dns_success != ON))
 	{
 		if(serial->serial_debug_en == SEG_ENABLE) printf(" > SEG:CONNECTION FAILED - DNS Failed\r\n");
 		ret = ON;
@@ -1441,6 +2967,20 @@ uint8_t check_tcp_connect_exception(void)
 	
 	return ret;
 }
+
+// Telnet COM port control (RFC 2217): the data channel of the TCP client / server (single session) / mixed mode
+uint8_t check_telnet_mode(s2e_session_t * ctx)
+{
+	const DevConfig_channel *cfg = get_DevConfig_channel(ctx->ch);
+	struct __network_info *net = cfg->network_info;
+	
+	if(cfg->telnet_en[0] != 1) return SEG_DISABLE;
+	
+	if((net->working_mode == TCP_CLIENT_MODE) || (net->working_mode == TCP_MIXED_MODE)) return SEG_ENABLE;
+	if((net->working_mode == TCP_SERVER_MODE) && (get_tcp_server_sessions(ctx) == 1)) return SEG_ENABLE;
+	
+	return SEG_DISABLE;
+}
 	
 
 void clear_data_transfer_bytecount(teDATADIR dir)
@@ -1538,30 +3078,99 @@ uint32_t get_data_transfer_bytecount(teDATADIR dir)
 }
 
 
-// This function have to call every 1 millisecond by Timer IRQ handler routine.
-void seg_timer_msec(void)
+
+s2e_session_t * get_s2e_session(uint8_t ch)
 {
-	struct __network_info *netinfo = (struct __network_info *)&(get_DevConfig_pointer()->network_info);
+	if(ch >= S2E_CHANNELS) return NULL;
+	return &s2e_channel[ch];
+}
+
+// S2E session timer table: the running timers of the unit are counted up, saturated at 0xFFFF
+void tick_s2e_timers(volatile uint16_t * time, volatile uint8_t * run, uint8_t num, uint8_t unit)
+{
+	uint8_t i;
 	
-	// Firmware update timer for timeout
-	// DHCP timer for timeout
+	for(i = 0; i < num; i++)
+	{
+		if(run[i] && (s2e_timer_unit[i] == unit) && (time[i] < 0xFFFF)) time[i]++;
+	}
+}
+
+// S2E session timers (msec) and the expiry events of the data packing timers
+void seg_session_timer_msec(s2e_session_t * ctx)
+{
+	uint8_t i;
 	
-	// SEGCP Keep-alive timer (for configuration tool, TCP mode)
+	tick_s2e_timers(ctx->timer_time, ctx->timer_run, S2E_TIMER_MAX, S2E_TIMER_UNIT_MSEC);
+	
+	// TCP server multi-session: Keep-alive timer / Connection password auth timer
+	for(i = 0; i < ctx->sessions_max; i++) tick_s2e_timers(ctx->session[i].timer_time, ctx->session[i].timer_run, S2E_TIMER_CONN_MAX, S2E_TIMER_UNIT_MSEC);
 	
-	// Reconnection timer: Time count routine (msec)
-	if(enable_reconnection_timer)
+	// Rx gap of the UART without the gap timer: the line idle after the last Rx burst, the frame end index published
+	if(S2E_TIMER_RUN(ctx, RX_GAP) && (S2E_TIMER_TIME(ctx, RX_GAP) >= ctx->gap_msec))
 	{
-		if(reconnection_time < 0xFFFF) 	reconnection_time++;
-		else 							reconnection_time = 0;
+		S2E_TIMER_RUN(ctx, RX_GAP) = SEG_DISABLE;
+		ctx->gap_end = ctx->gap_wr;
+		BUFFER_BARRIER();
+		ctx->gap_in++;
+		set_event(EVENT_SEG);
 	}
 	
-	// Keep-alive timer: Time count routine (msec)
-	if(enable_keepalive_timer)
+	// Serial data packing time delimiter timer
+	if(S2E_TIMER_RUN(ctx, SERIAL_INPUT) && (S2E_TIMER_TIME(ctx, SERIAL_INPUT) >= get_packing_time_msec(ctx)))
 	{
-		if(keepalive_time < 0xFFFF) 	keepalive_time++;
-		else							keepalive_time = 0;
+		S2E_TIMER_RUN(ctx, SERIAL_INPUT) = SEG_DISABLE;
+		S2E_TIMER_TIME(ctx, SERIAL_INPUT) = 0;
+		ctx->flag_serial_input_time_elapse = SEG_ENABLE;
+		set_event(EVENT_SEG);
 	}
 	
+	// Serial data packing coalesce to MSS: latency budget timer
+	if(S2E_TIMER_RUN(ctx, COALESCE) && (S2E_TIMER_TIME(ctx, COALESCE) == get_DevConfig_channel(ctx->ch)->network_info_extend->packing_coalesce_time))
+	{
+		set_event(EVENT_SEG); // latency budget expired
+	}
+	
+	// Serial line arbitration: the transaction time is counted after the request is sent out from the UART Tx ring buffer
+	if((ctx->arb_owner != SEG_ARB_OWNER_NONE) && IS_RING_EMPTY(ctx->tx))
+	{
+		if(ctx->arb_time < 0xFFFF) ctx->arb_time++;
+	}
+}
+
+// S2E session timers (sec) and the UDP peer table aging
+void seg_session_timer_sec(s2e_session_t * ctx)
+{
+	uint16_t aging = get_DevConfig_channel(ctx->ch)->network_info_extend->udp_peer_aging;
+	uint8_t i;
+	
+	tick_s2e_timers(ctx->timer_time, ctx->timer_run, S2E_TIMER_MAX, S2E_TIMER_UNIT_SEC);
+	for(i = 0; i < ctx->sessions_max; i++) tick_s2e_timers(ctx->session[i].timer_time, ctx->session[i].timer_run, S2E_TIMER_CONN_MAX, S2E_TIMER_UNIT_SEC);
+	
+	// UDP mode 1:N: peer table aging
+	for(i = 0; i < UDP_PEER_TABLE_SIZE; i++)
+	{
+		if(ctx->udp_peer[i].valid)
+		{
+			if(ctx->udp_peer[i].age < 0xFFFF) ctx->udp_peer[i].age++;
+			if(aging && (ctx->udp_peer[i].age >= aging)) ctx->udp_peer[i].valid = SEG_DISABLE;
+		}
+	}
+}
+
+// This function have to call every 1 millisecond by Timer IRQ handler routine.
+void seg_timer_msec(void)
+{
+	uint8_t i;
+	
+	// Firmware update timer for timeout
+	// DHCP timer for timeout
+	
+	// SEGCP Keep-alive timer (for configuration tool, TCP mode)
+	
+	// S2E session timers: Reconnection / Keep-alive / Connection password auth / Packing time delimiter / Packing coalesce / Rx gap timers (msec)
+	for(i = 0; i < S2E_CHANNELS; i++) seg_session_timer_msec(&s2e_channel[i]);
+	
 	// Mode switch timer: Time count routine (msec) (GW mode <-> Serial command mode, for s/w mode switch trigger code)
 	if(modeswitch_time < modeswitch_gap_time) modeswitch_time++;
 	
@@ -1573,39 +3182,17 @@ void seg_timer_msec(void)
 		
 		triggercode_idx = 0;
 		enable_modeswitch_timer = SEG_DISABLE;
-	}
-	
-	// Serial data packing time delimiter timer
-	if(enable_serial_input_timer)
-	{
-		if(serial_input_time < netinfo->packing_time)
-		{
-			serial_input_time++;
-		}
-		else
-		{
-			serial_input_time = 0;
-			enable_serial_input_timer = 0;
-			flag_serial_input_time_elapse = 1;
-		}
-	}
-	
-	// Connection password auth timer
-	if(enable_connection_auth_timer)
-	{
-		if(connection_auth_time < 0xffff) 	connection_auth_time++;
-		else								connection_auth_time = 0;
+		set_event(EVENT_SEG);
 	}
 }
 
 // This function have to call every 1 second by Timer IRQ handler routine.
 void seg_timer_sec(void)
 {
-	// Inactivity timer: Time count routine (sec)
-	if(enable_inactivity_timer)
-	{
-		if(inactivity_time < 0xFFFF) inactivity_time++;
-	}
+	uint8_t i;
+	
+	// Inactivity timer: Time count routine (sec), UDP peer table aging
+	for(i = 0; i < S2E_CHANNELS; i++) seg_session_timer_sec(&s2e_channel[i]);
 
 	tmp_timeflag_for_debug = 1;
 }
@@ -11,9 +11,24 @@
 #define SEG_DATA_UART		0	// S2E Data UART selector, [0] UART0 or [1] UART1
 #define SEG_DEBUG_UART		2	// S2E Debug UART, fixed
 
-//#define SEG_DATA_BUF_SIZE	2048	// UART Ring buffer size
-//#define SEG_DATA_BUF_SIZE	3072	// UART Ring buffer size
+// Dual data UART mode (__USE_DUAL_DATA_UART__, common.h): channel 2 uses UART1
+#ifdef __USE_DUAL_DATA_UART__
+	#define SEG_DATA2_UART		1	// Channel 2 data UART, fixed
+	#if (SEG_DATA_UART != 0)
+		#error "Dual data UART mode: SEG_DATA_UART must be UART0"
+	#endif
+#endif
+
+// UART Ring buffer sizes must be a power of two
+#ifdef __USE_DUAL_DATA_UART__
+#define SEG_DATA_BUF_SIZE	2048	// UART Ring buffer size
+#define SEG_DATA2_BUF_SIZE		512		// Channel 2: UART Ring buffer size
+#define SEG_DATA2_TX_BUF_SIZE	512		// Channel 2: UART Tx Ring buffer size
+#define SEG_DATA2_USER_BUF_SIZE	512		// Channel 2: send / recv user buffers (channel 1: DATA_BUF_SIZE, g_send_buf / g_recv_buf)
+#else
 #define SEG_DATA_BUF_SIZE	4096	// UART Ring buffer size
+#endif
+#define SEG_DATA_TX_BUF_SIZE	1024	// UART Tx Ring buffer size
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 #define DEFAULT_MODESWITCH_INTER_GAP	500 // 500ms (0.5sec)
@@ -25,6 +40,12 @@
 #endif
 
 #define MAX_CONNECTION_AUTH_TIME		5000 // 5000ms (5sec)
+
+#define UDP_PEER_TABLE_SIZE				4	 // UDP mode 1:N: peers learned from the received packets
+
+// Serial to Ethernet latency (UART Rx interrupt -> Sn_CR_SEND) histogram: 50us buckets up to 3.2ms and the overflow bucket
+#define SEG_LATENCY_BUCKET_USEC			50
+#define SEG_LATENCY_BUCKETS				64
 ///////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #ifndef DATA_BUF_SIZE
@@ -43,8 +64,20 @@ extern char * str_working[];
 
 typedef enum{SEG_UART_RX, SEG_UART_TX, SEG_ETHER_RX, SEG_ETHER_TX, SEG_ALL} teDATADIR;
 
-// Serial to Ethernet function handler; call by main loop
-void do_seg(uint8_t sock);
+// S2E session: the context of a data channel (data UART <-> data socket); connection state, timers and the data path state
+typedef struct __s2e_session s2e_session_t;
+
+// S2E_CH1, S2E_CH2, S2E_CHANNELS: common.h
+#ifdef __USE_DUAL_DATA_UART__
+	#define S2E_CHANNEL_UART(ch)	(((ch) == S2E_CH1) ? SEG_DATA_UART : SEG_DATA2_UART)
+#else
+	#define S2E_CHANNEL_UART(ch)	SEG_DATA_UART
+#endif
+
+s2e_session_t * get_s2e_session(uint8_t ch);	// ret: [NULL] no channel
+
+// Serial to Ethernet function handler; call by main loop for each channel
+void do_seg(s2e_session_t * ctx);
 
 // Timer for S2E core operations
 void seg_timer_sec(void);
@@ -56,6 +89,8 @@ void set_device_status(teDEVSTATUS status);
 uint8_t get_device_status(void);
 
 uint8_t process_socket_termination(uint8_t socket);
+void process_data_sockets_termination(void);	// S2E data sockets and the TCP server session sockets of all channels
+void process_data_channel_termination(uint8_t ch);	// The data sockets of the channel
 
 // Send Keep-alive packet manually (once)
 void send_keepalive_packet_manual(uint8_t sock);
@@ -64,6 +99,34 @@ void send_keepalive_packet_manual(uint8_t sock);
 uint8_t check_serial_store_permitted(uint8_t ch);
 uint8_t check_modeswitch_trigger(uint8_t ch);	// Serial command mode switch trigger code (3-bytes) checker
 void init_time_delimiter_timer(void); 			// Serial data packing option [Time]: Timer enalble function for Time delimiter
+void init_seg_rx_gap_timer(uint8_t ch);			// UART Rx gap timer: Modbus RTU frame / Time delimiter in usec or character times
+
+// UART Rx burst (FIFO) handler: per-burst checkers, the per-byte checkers above are called only when required
+uint8_t get_serial_store_permitted(void);		// ret: [0] not permitted / [1] permitted, without XON/XOFF check
+uint8_t get_modeswitch_trigger_idx(void);		// ret: [0] trigger code not in progress / [!0] index of trigger code
+void clear_modeswitch_gap_time(void);			// Serial data received: reset the trigger code inter-gap time
+void notify_serial_rx(void);					// Serial data received: latency time stamp, immediate flush request
+
+// Event-driven main loop: [1] the data path has more work to do, the handler is called again without a new event
+uint8_t check_seg_pending(void);
+uint8_t take_seg_progress(void);				// ret: [1] the data moved since the last call, the handler is called again only while the data moves
+
+#ifdef __USE_DUAL_DATA_UART__
+// Channel 2: These functions must be located in UART1 Rx IRQ Handler.
+uint8_t get_serial_ch2_store_permitted(void);
+void notify_serial_ch2_rx(void);
+#endif
+
+// Immediate flush mode: PendSV handler sends the serial data when the main loop does not use the data path
+void init_seg_immediate_flush(void);
+void do_seg_immediate_flush(void);
+void lock_seg_data_path(void);
+void unlock_seg_data_path(void);
+
+// Serial to Ethernet latency statistics (usec)
+uint32_t get_u2e_latency_usec(uint8_t percentile);	// percentile: 1 ~ 100, [100] max
+uint32_t get_u2e_latency_count(void);
+void clear_u2e_latency(void);
 
 // UART tx/rx and Ethernet tx/rx data transfer bytes counter
 void clear_data_transfer_bytecount(teDATADIR dir);
@@ -25,6 +25,8 @@
 #include "W7500x_board.h"
 #include "timerHandler.h"
 #include "uartHandler.h"
+#include "seg.h"
+#include "eventHandler.h"
 
 
 /* Private typedef -----------------------------------------------------------*/
@@ -69,7 +71,9 @@ void SVC_Handler(void)
   * @retval None
   */
 void PendSV_Handler(void)
-{}
+{
+	do_seg_immediate_flush();
+}
 
 /**
   * @brief  This function handles SysTick Handler.
@@ -122,7 +126,11 @@ void UART0_Handler(void)
   */
 void UART1_Handler(void)
 {
+#ifdef __USE_DUAL_DATA_UART__
+	S2E_UART_CH2_IRQ_Handler(); // Dual data UART mode: channel 2
+#else
 	S2E_UART_IRQ_Handler(UART1);
+#endif
 }
 
 
@@ -195,7 +203,11 @@ void PORT3_Handler(void)
   * @retval None
   */
 void DMA_Handler(void)
-{}
+{
+#ifdef __USE_UART_RX_DMA__
+	S2E_UART_DMA_IRQ_Handler();
+#endif
+}
 
 
 /**
@@ -215,7 +227,10 @@ void DUALTIMER0_Handler(void)
   * @retval None
   */
 void DUALTIMER1_Handler(void)
-{}
+{
+	S2E_UART_RS485_Timer_IRQ_Handler();
+	S2E_UART_Rx_Gap_Timer_IRQ_Handler();
+}
 
 
 /**
@@ -296,7 +311,9 @@ void ADC_Handler(void)
   * @retval None
   */
 void WZTOE_Handler(void)
-{}
+{
+	WZTOE_IRQ_Handler();
+}
 
 /**
   * @brief  This function handles EXTI Handler.
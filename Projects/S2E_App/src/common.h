@@ -18,7 +18,8 @@
 // W7500x HW Socket Definition//
 ////////////////////////////////
 // 0 ~ 6, Changed the S2E data socket(0)'s buffer to double
-#define SOCK_MAX_USED		7
+// 5 ~ 7, TCP server multi-session: additional S2E data sockets
+#define SOCK_MAX_USED		8
 
 #define SOCK_DATA			0
 #define SOCK_CONFIG_UDP		1
@@ -32,6 +33,24 @@
 #define SOCK_DNS			4
 #define SOCK_FWUPDATE		4
 
+#define SOCK_DATA_SESSION2	5
+#define SOCK_DATA_SESSION3	6
+#define SOCK_DATA_SESSION4	7
+
+#define SOCK_DATA_CH2		SOCK_DATA_SESSION4	// Dual data UART mode: S2E data socket of channel 2 (UART1)
+
+// Dual data UART mode: channel 2, UART1 <-> SOCK_DATA_CH2 (TCP client / TCP server / UDP mode)
+// The TCP server sessions of channel 1 are limited to (TCP_SERVER_SESSIONS_MAX - 1), SOCK_DATA_SESSION4 is used by channel 2
+//#define __USE_DUAL_DATA_UART__
+
+#define S2E_CH1				0	// SEG_DATA_UART <-> SOCK_DATA
+#define S2E_CH2				1	// Dual data UART mode: SEG_DATA2_UART <-> SOCK_DATA_CH2
+#ifdef __USE_DUAL_DATA_UART__
+	#define S2E_CHANNELS	2
+#else
+	#define S2E_CHANNELS	1
+#endif
+
 ////////////////////////////////
 // In/External Clock Setting  //
 ////////////////////////////////
@@ -81,6 +100,7 @@ typedef enum{ST_BOOT, ST_OPEN, ST_CONNECT, ST_UPGRADE, ST_ATMODE, ST_UDP} teDEVS
 #define TCP_SERVER_MODE		1
 #define TCP_MIXED_MODE		2
 #define UDP_MODE			3
+#define MODBUS_TCP_MODE		4	// Modbus TCP (server) <-> Modbus RTU (serial) gateway
 
 #define MIXED_SERVER		0
 #define MIXED_CLIENT		1
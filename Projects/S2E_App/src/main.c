@@ -47,21 +47,32 @@
 #include "deviceHandler.h"
 #include "flashHandler.h"
 #include "gpioHandler.h"
+#include "eventHandler.h"
 
 // ## for debugging
 //#include "loopback.h"
 
 
 /* Private typedef -----------------------------------------------------------*/
+// Network task: DHCP client / DNS client states
+typedef enum {NET_STATE_DHCP, NET_STATE_CONFIGURED, NET_STATE_DNS, NET_STATE_RUNNING} teNETSTATE;
 
 /* Private define ------------------------------------------------------------*/
 //#define _MAIN_DEBUG_	// debugging message enable
 
+#define NET_SERVICE_BUF_SIZE	548		// DHCP message (RIP_MSG_SIZE), DNS message: MAX_DNS_BUF_SIZE
+#define NET_DHCP_RETRY_MAX		3
+#define NET_DNS_RETRY_MAX		2
+
 /* Private function prototypes -----------------------------------------------*/
 static void W7500x_Init(void);
 static void W7500x_WZTOE_Init(void);
-int8_t process_dhcp(void);
-int8_t process_dns(void);
+
+// Main loop tasks
+static void task_seg(void);
+static void task_network(void);
+static void init_network_task(void);
+static void start_s2e_application(void);
 
 // Debug messages
 void display_Dev_Info_header(void);
@@ -75,6 +86,11 @@ void TimingDelay_Decrement(void);
 /* Private variables ---------------------------------------------------------*/
 static __IO uint32_t TimingDelay;
 
+// DHCP / DNS message buffer: not shared with the S2E data buffers, the network task runs with the S2E data transfer
+static uint8_t net_service_buf[NET_SERVICE_BUF_SIZE];
+static uint8_t net_state = NET_STATE_DHCP;
+static uint8_t net_retry = 0;
+
 /* Public variables ---------------------------------------------------------*/
 // Shared buffer declaration
 uint8_t g_send_buf[DATA_BUF_SIZE];
@@ -96,9 +112,6 @@ int main(void)
 	/* W7500x MCU Initialization */
 	W7500x_Init(); // includes UART2 initialize code for print out debugging messages
 	
-	/* W7500x WZTOE (Hardwired TCP/IP stack) Initialization */
-	W7500x_WZTOE_Init();
-	
 	/* W7500x Board Initialization */
 	W7500x_Board_Init();
 	
@@ -109,11 +122,20 @@ int main(void)
 	/* Load the Configuration data */
 	load_DevConfig_from_storage();
 	
+	/* W7500x WZTOE (Hardwired TCP/IP stack) Initialization: H/W socket buffers are allocated by the stored profile */
+	W7500x_WZTOE_Init();
+	
 	/* Set the MAC address to WIZCHIP */
 	Mac_Conf();
 	
 	/* UART Initialization */
 	S2E_UART_Configuration();
+	init_seg_rx_gap_timer(S2E_CH1);
+	init_seg_immediate_flush();
+#ifdef __USE_DUAL_DATA_UART__
+	S2E_UART_CH2_Configuration(); // Dual data UART mode: channel 2 (UART1)
+	init_seg_rx_gap_timer(S2E_CH2);
+#endif
 	
 	/* GPIO Initialization*/
 	IO_Configuration();
@@ -125,73 +147,26 @@ int main(void)
 		display_Dev_Info_main();
 	}
 	
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	// W7500x Application: DHCP client / DNS client handler
-	////////////////////////////////////////////////////////////////////////////////////////////////////
-	
-	/* Network Configuration - DHCP client */
-	// Initialize Network Information: DHCP or Static IP allocation
-	if(dev_config->options.dhcp_use)
-	{
-		if(process_dhcp() == DHCP_IP_LEASED) // DHCP success
-		{
-			flag_process_dhcp_success = ON;
-		}
-		else // DHCP failed
-		{
-			Net_Conf(); // Set default static IP settings
-		}
-	}
-	else
-	{
-		Net_Conf(); // Set default static IP settings
-	}
-	
-	// Debug UART: Network information print out (includes DHCP IP allocation result)
-	if(dev_config->serial_info[0].serial_debug_en)
-	{
-		display_Net_Info();
-		display_Dev_Info_dhcp();
-	}
-	
-	/* DNS client */
-	//if((value->network_info[0].working_mode == TCP_CLIENT_MODE) || (value->network_info[0].working_mode == TCP_MIXED_MODE))
-	if(dev_config->network_info[0].working_mode != TCP_SERVER_MODE)
-	{
-		if(dev_config->options.dns_use) 
-		{
-			if(process_dns()) // DNS success
-			{
-				flag_process_dns_success = ON;
-			}
-		}
-	}
-	
-	// Debug UART: DNS results print out
-	if(dev_config->serial_info[0].serial_debug_en)
-	{
-		display_Dev_Info_dns();
-	}
-	
 	////////////////////////////////////////////////////////////////////////////////////////////////////
 	// W7500x Application: Main Routine
 	////////////////////////////////////////////////////////////////////////////////////////////////////
 	
-	flag_s2e_application_running = ON;
+	/* Event-driven main loop: WZTOE socket interrupts */
+	Event_Configuration();
 	
-	// HW_TRIG switch ON
-	if(flag_hw_trig_enable)
-	{
-		init_trigger_modeswitch(DEVICE_AT_MODE);
-		flag_hw_trig_enable = 0;
-	}
+	/* Cooperative scheduler: the tasks are registered in priority order */
+	register_task("SEG", EVENT_SEG, task_seg);
+	register_task("SEGCP", EVENT_SEGCP, do_segcp);
+	register_task("NET", EVENT_DHCP, task_network);
+	// The firmware update is not a task: it blocks the SEGCP task until it ends (see do_segcp())
+	
+	/* Network Configuration - DHCP client / DNS client: processed by the network task without blocking the main loop */
+	// The S2E application starts after the network configuration, serial data is buffered by the UART interrupts
+	init_network_task();
 	
 	while(1) // main loop
 	{
-		do_segcp();
-		do_seg(SOCK_DATA);
-		
-		if(dev_config->options.dhcp_use) DHCP_run(); // DHCP client handler for IP renewal
+		run_tasks(); // Run a task with the pending event, sleep until the interrupt handlers set the events
 		
 		// ## debugging: Data echoback
 		//loopback_tcps(6, g_recv_buf, 5001);
@@ -252,9 +227,20 @@ static void W7500x_WZTOE_Init(void)
 	// W7500x WZTOE (Hardwired TCP/IP core) Initialize
 	////////////////////////////////////////////////////
 	
-	/* Set Network Configuration: HW Socket Tx/Rx buffer size */
-	uint8_t tx_size[8] = { 4, 2, 2, 2, 2, 2, 2, 0 }; // default: { 2, 2, 2, 2, 2, 2, 2, 2 }
-	uint8_t rx_size[8] = { 4, 2, 2, 2, 2, 2, 2, 0 }; // default: { 2, 2, 2, 2, 2, 2, 2, 2 }
+	/* Set Network Configuration: HW Socket Tx/Rx buffer size (KB) by the profile, the same sizes are used for Tx and Rx */
+	// Socket:                   DATA, CONFIG_UDP, CONFIG_TCP, DHCP, DNS/FWUPDATE, 5, 6, 7
+	static uint8_t sock_buf_size[SOCK_BUF_PROFILE_MAX + 1][8] = {
+#ifdef __USE_DUAL_DATA_UART__
+		// Dual data UART mode: socket 7 is the data socket of channel 2 (SOCK_DATA_CH2)
+		{ 4, 2, 2, 2, 2, 1, 1, 2 }, // SOCK_BUF_PROFILE_BALANCED (default)
+		{ 4, 1, 2, 1, 2, 1, 1, 4 }, // SOCK_BUF_PROFILE_THROUGHPUT
+#else
+		{ 4, 2, 2, 2, 2, 2, 2, 0 }, // SOCK_BUF_PROFILE_BALANCED (default)
+		{ 8, 1, 2, 1, 2, 1, 1, 0 }, // SOCK_BUF_PROFILE_THROUGHPUT
+#endif
+		{ 2, 2, 2, 2, 2, 2, 2, 2 }  // SOCK_BUF_PROFILE_MULTISESSION
+	};
+	uint8_t profile = get_DevConfig_pointer()->network_info_extend[0].sock_buf_profile;
 	
 	/* Structure for TCP timeout control: RTR, RCR */
 	wiz_NetTimeout * net_timeout;
@@ -283,7 +269,8 @@ static void W7500x_WZTOE_Init(void)
 #endif
 	
 	/* Set Network Configuration */
-	wizchip_init(tx_size, rx_size);
+	if(profile > SOCK_BUF_PROFILE_MAX) profile = SOCK_BUF_PROFILE_DEFAULT;
+	wizchip_init(sock_buf_size[profile], sock_buf_size[profile]);
 	
 #ifdef _MAIN_DEBUG_
 	printf(" - WZTOE H/W Socket Buffer Settings (kB)\r\n");
@@ -296,107 +283,187 @@ static void W7500x_WZTOE_Init(void)
 #endif
 }
 
-int8_t process_dhcp(void)
+/*****************************************************************************
+ * Main loop tasks
+ ****************************************************************************/
+static void task_seg(void)
 {
-	uint8_t ret = 0;
-	uint8_t dhcp_retry = 0;
+	if(!flag_s2e_application_running) return; // Network configuration in progress
+	
+	lock_seg_data_path(); // Immediate flush mode: the flush by PendSV is held off during the data path process
+#ifdef __USE_UART_RX_DMA__
+	uart_rx_dma_process(); // UART Rx DMA: check and publish the landed serial data
+#endif
+	do_seg(get_s2e_session(S2E_CH1));
+#ifdef __USE_DUAL_DATA_UART__
+	do_seg(get_s2e_session(S2E_CH2)); // Dual data UART mode: channel 2, the flush of the channel is also held off
+#endif
+	unlock_seg_data_path();
+	
+	// The data path runs again only while the data moves; the blocked data waits for the next event
+	if(take_seg_progress() && check_seg_pending()) set_event(EVENT_SEG);
+}
 
+static void init_network_task(void)
+{
+	DevConfig *dev_config = get_DevConfig_pointer();
+	
+	net_retry = 0;
+	
+	// Initialize Network Information: DHCP or Static IP allocation
+	if(dev_config->options.dhcp_use)
+	{
 #ifdef _MAIN_DEBUG_
-	printf(" - DHCP Client running\r\n");
+		printf(" - DHCP Client running\r\n");
 #endif
-	DHCP_init(SOCK_DHCP, g_send_buf);
-	reg_dhcp_cbfunc(w7500x_dhcp_assign, w7500x_dhcp_assign, w7500x_dhcp_conflict);
+		DHCP_init(SOCK_DHCP, net_service_buf);
+		reg_dhcp_cbfunc(w7500x_dhcp_assign, w7500x_dhcp_assign, w7500x_dhcp_conflict);
+		
+		set_device_status(ST_UPGRADE);
+		net_state = NET_STATE_DHCP;
+	}
+	else
+	{
+		Net_Conf(); // Set default static IP settings
+		net_state = NET_STATE_CONFIGURED;
+	}
 	
-	set_device_status(ST_UPGRADE);
+	set_event(EVENT_DHCP);
+}
+
+// Network task: each step returns immediately, the DHCP / DNS responses and the 1-second tick raise the next run
+static void task_network(void)
+{
+	DevConfig *dev_config = get_DevConfig_pointer();
+	int8_t ret;
 	
-	while(1)
+	switch(net_state)
 	{
-		ret = DHCP_run();
+		case NET_STATE_DHCP:
+			ret = DHCP_run();
+			
+			if(ret == DHCP_IP_LEASED)
+			{
+#ifdef _MAIN_DEBUG_
+				printf(" - DHCP Success\r\n");
+#endif
+				flag_process_dhcp_success = ON;
+				net_state = NET_STATE_CONFIGURED;
+			}
+			else if(ret == DHCP_FAILED)
+			{
+				net_retry++;
+#ifdef _MAIN_DEBUG_
+				if(net_retry <= NET_DHCP_RETRY_MAX) printf(" - DHCP Timeout occurred and retry [%d]\r\n", net_retry);
+#endif
+				if(net_retry > NET_DHCP_RETRY_MAX)
+				{
+#ifdef _MAIN_DEBUG_
+					printf(" - DHCP Failed\r\n\r\n");
+#endif
+					DHCP_stop();
+					Net_Conf(); // DHCP failed: Set default static IP settings
+					net_state = NET_STATE_CONFIGURED;
+				}
+			}
+			
+			if(net_state == NET_STATE_CONFIGURED) set_event(EVENT_DHCP);
+			break;
 		
-		if(ret == DHCP_IP_LEASED)
-		{
+		case NET_STATE_CONFIGURED:
+			set_device_status(ST_OPEN);
+			
+			// Debug UART: Network information print out (includes DHCP IP allocation result)
+			if(dev_config->serial_info[0].serial_debug_en)
+			{
+				display_Net_Info();
+				display_Dev_Info_dhcp();
+			}
+			
+			/* DNS client */
+			if((dev_config->network_info[0].working_mode != TCP_SERVER_MODE) && (dev_config->network_info[0].working_mode != MODBUS_TCP_MODE) && dev_config->options.dns_use)
+			{
 #ifdef _MAIN_DEBUG_
-			printf(" - DHCP Success\r\n");
+				printf(" - DNS Client running\r\n");
 #endif
+				DNS_init(SOCK_DNS, net_service_buf);
+				DNS_start(dev_config->options.dns_server_ip, (uint8_t *)dev_config->options.dns_domain_name);
+				
+				set_device_status(ST_UPGRADE);
+				net_retry = 0;
+				net_state = NET_STATE_DNS;
+			}
+			else
+			{
+				start_s2e_application();
+			}
 			break;
-		}
-		else if(ret == DHCP_FAILED)
-		{
-			dhcp_retry++;
+		
+		case NET_STATE_DNS:
+			ret = DNS_poll(dev_config->network_info[0].remote_ip);
+			
+			if(ret == 1) // DNS success
+			{
 #ifdef _MAIN_DEBUG_
-			if(dhcp_retry <= 3) printf(" - DHCP Timeout occurred and retry [%d]\r\n", dhcp_retry);
+				printf(" - DNS Success\r\n");
 #endif
-		}
-
-		if(dhcp_retry > 3)
-		{
+				flag_process_dns_success = ON;
+				start_s2e_application();
+			}
+			else if(ret != DNS_RUNNING)
+			{
+				net_retry++;
+#ifdef _MAIN_DEBUG_
+				if(net_retry <= NET_DNS_RETRY_MAX) printf(" - DNS Timeout occurred and retry [%d]\r\n", net_retry);
+#endif
+				if(net_retry > NET_DNS_RETRY_MAX)
+				{
 #ifdef _MAIN_DEBUG_
-			printf(" - DHCP Failed\r\n\r\n");
+					printf(" - DNS Failed\r\n\r\n");
 #endif
-			DHCP_stop();
+					start_s2e_application();
+				}
+				else
+				{
+					DNS_start(dev_config->options.dns_server_ip, (uint8_t *)dev_config->options.dns_domain_name);
+				}
+			}
+			
+			if(dev_config->options.dhcp_use) DHCP_run();
+			break;
+		
+		case NET_STATE_RUNNING:
+		default:
+			if(dev_config->options.dhcp_use) DHCP_run(); // DHCP client handler for IP renewal
 			break;
-		}
-
-		do_segcp(); // Process the requests of configuration tool during the DHCP client run.
 	}
-	
-	set_device_status(ST_OPEN);
-	
-	return ret;
 }
 
-
-int8_t process_dns(void)
+static void start_s2e_application(void)
 {
 	DevConfig *dev_config = get_DevConfig_pointer();
-	int8_t ret = 0;
-	uint8_t dns_retry = 0;
-	uint8_t dns_server_ip[4];
-	
-#ifdef _MAIN_DEBUG_
-	printf(" - DNS Client running\r\n");
-#endif
 	
-	DNS_init(SOCK_DNS, g_send_buf);
+	set_device_status(ST_OPEN);
 	
-	dns_server_ip[0] = dev_config->options.dns_server_ip[0];
-	dns_server_ip[1] = dev_config->options.dns_server_ip[1];
-	dns_server_ip[2] = dev_config->options.dns_server_ip[2];
-	dns_server_ip[3] = dev_config->options.dns_server_ip[3];
+	// Debug UART: DNS results print out
+	if(dev_config->serial_info[0].serial_debug_en)
+	{
+		display_Dev_Info_dns();
+	}
 	
-	set_device_status(ST_UPGRADE);
+	flag_s2e_application_running = ON;
+	net_state = NET_STATE_RUNNING;
 	
-	while(1) 
+	// HW_TRIG switch ON
+	if(flag_hw_trig_enable)
 	{
-		if((ret = DNS_run(dns_server_ip, (uint8_t *)dev_config->options.dns_domain_name, dev_config->network_info[0].remote_ip)) == 1)
-		{
-#ifdef _MAIN_DEBUG_
-			printf(" - DNS Success\r\n");
-#endif
-			break;
-		}
-		else
-		{
-			dns_retry++;
-#ifdef _MAIN_DEBUG_
-			if(dns_retry <= 2) printf(" - DNS Timeout occurred and retry [%d]\r\n", dns_retry);
-#endif
-		}
-
-		if(dns_retry > 2) {
-#ifdef _MAIN_DEBUG_
-			printf(" - DNS Failed\r\n\r\n");
-#endif
-			break;
-		}
-
-		do_segcp(); // Process the requests of configuration tool during the DNS client run.
-
-		if(dev_config->options.dhcp_use) DHCP_run();
+		lock_seg_data_path();
+		init_trigger_modeswitch(DEVICE_AT_MODE);
+		unlock_seg_data_path();
+		flag_hw_trig_enable = 0;
 	}
 	
-	set_device_status(ST_OPEN);
-	return ret;
+	set_event(EVENT_SEG); // Serial data buffered during the network configuration
 }
 
 void display_Dev_Info_header(void)
@@ -424,9 +491,13 @@ void display_Dev_Info_header(void)
 
 void display_Dev_Info_main(void)
 {
-	//uint8_t i;
+	uint8_t i;
 	DevConfig *dev_config = get_DevConfig_pointer();
+#ifdef __USE_DUAL_DATA_UART__
+	DevConfig_ch2 *dev_config_ch2 = get_DevConfig_ch2_pointer();
+#endif
 	uint32_t baud_table[] = {300, 600, 1200, 1800, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200, 230400};
+	char * str_udp_delivery[] = {"Last peer", "All peers", "Round-robin"};
 	
 	printf(" - Device name: %s\r\n", dev_config->module_name);
 	printf(" - Device mode: %s\r\n", str_working[dev_config->network_info[0].working_mode]);
@@ -437,6 +508,19 @@ void display_Dev_Info_main(void)
 		printf("\t   + S2E data port: [%d]\r\n", dev_config->network_info[0].local_port);
 		printf("\t   + TCP/UDP setting port: [%d]\r\n", DEVICE_SEGCP_PORT);
 		printf("\t   + Firmware update port: [%d]\r\n", DEVICE_FWUP_PORT);
+		printf("\t- Data protocol: [%s]\r\n", (dev_config->telnet_en[0] == 1)?"Telnet COM port control (RFC 2217)":"Raw");
+	
+	if(dev_config->network_info[0].working_mode == UDP_MODE)
+	{
+		printf(" - UDP mode settings: \r\n");
+			printf("\t- 1:N peer delivery: [%s], peer aging: ", str_udp_delivery[dev_config->network_info_extend[0].udp_peer_delivery]);
+				if(dev_config->network_info_extend[0].udp_peer_aging) printf("[%d] (sec)\r\n", dev_config->network_info_extend[0].udp_peer_aging);
+				else printf("%s\r\n", STR_DISABLED);
+			printf("\t- Multicast group: ");
+				if(dev_config->network_info_extend[0].udp_multicast_ip[0]) printf("[%d.%d.%d.%d]\r\n", dev_config->network_info_extend[0].udp_multicast_ip[0], dev_config->network_info_extend[0].udp_multicast_ip[1], 
+																			dev_config->network_info_extend[0].udp_multicast_ip[2], dev_config->network_info_extend[0].udp_multicast_ip[3]);
+				else printf("%s\r\n", STR_DISABLED);
+	}
 	
 	printf(" - Search ID code: \r\n");
 		printf("\t- %s: [%s]\r\n", (dev_config->options.pw_search[0] != 0)?"Enabled":"Disabled", (dev_config->options.pw_search[0] != 0)?dev_config->options.pw_search:"None");
@@ -470,18 +554,61 @@ void display_Dev_Info_main(void)
 		else
 			printf("Flow control: %s\r\n", flow_ctrl_table[0]); // RS-422/485; flow control - NONE only
 		
+#ifdef __USE_DUAL_DATA_UART__
+		printf("\t- Data %s port (channel 2):  [%s%d]\r\n", STR_UART, STR_UART, SEG_DATA2_UART);
+		if(dev_config_ch2->channel_en)
+		{
+			printf("\t   + %s, ", str_working[dev_config_ch2->network_info[0].working_mode]);
+			if((dev_config_ch2->network_info[0].working_mode == TCP_CLIENT_MODE) || (dev_config_ch2->network_info[0].working_mode == UDP_MODE))
+				printf("remote [%d.%d.%d.%d:%d], ", dev_config_ch2->network_info[0].remote_ip[0], dev_config_ch2->network_info[0].remote_ip[1],
+						dev_config_ch2->network_info[0].remote_ip[2], dev_config_ch2->network_info[0].remote_ip[3], dev_config_ch2->network_info[0].remote_port);
+			printf("local port [%d]\r\n", dev_config_ch2->network_info[0].local_port);
+			printf("\t   + %d-", baud_table[dev_config_ch2->serial_info[0].baud_rate]);
+			printf("%d-", word_len_table[dev_config_ch2->serial_info[0].data_bits]);
+			printf("%s-", parity_table[dev_config_ch2->serial_info[0].parity]);
+			printf("%d / ", stop_bit_table[dev_config_ch2->serial_info[0].stop_bits]);
+			printf("Flow control: %s\r\n", flow_ctrl_table[0]);
+		}
+		else
+		{
+			printf("\t   + %s\r\n", STR_DISABLED);
+		}
+#endif
+		
 		printf("\t- Debug %s port: [%s%d]\r\n", STR_UART, STR_UART, SEG_DEBUG_UART);
 		printf("\t   + %s / %s %s\r\n", "115200-8-N-1", "NONE", "(fixed)");
 		
 	printf(" - Serial data packing options:\r\n");
 		printf("\t- Time: ");
-			if(dev_config->network_info[0].packing_time) printf("[%d] (msec)\r\n", dev_config->network_info[0].packing_time);
+			if(dev_config->network_info[0].packing_time)
+			{
+				switch(dev_config->network_info_extend[0].packing_time_unit)
+				{
+					case PACKING_TIME_UNIT_USEC:
+						printf("[%d] (usec)\r\n", dev_config->network_info[0].packing_time);
+						break;
+					case PACKING_TIME_UNIT_HALF_CHAR:
+						printf("[%d.%d] (character times)\r\n", dev_config->network_info[0].packing_time / 2, (dev_config->network_info[0].packing_time % 2) * 5);
+						break;
+					default:
+						printf("[%d] (msec)\r\n", dev_config->network_info[0].packing_time);
+						break;
+				}
+			}
 			else printf("%s\r\n", STR_DISABLED);
 		printf("\t- Size: ");
 			if(dev_config->network_info[0].packing_size) printf("[%d] (bytes)\r\n", dev_config->network_info[0].packing_size);
 			else printf("%s\r\n", STR_DISABLED);
+		printf("\t- Coalesce to MSS: ");
+			if(dev_config->network_info_extend[0].packing_coalesce_time) printf("[%d] (msec, latency budget)\r\n", dev_config->network_info_extend[0].packing_coalesce_time);
+			else printf("%s\r\n", STR_DISABLED);
+		printf("\t- Immediate flush: %s\r\n", (dev_config->network_info_extend[0].immediate_flush == IMMEDIATE_FLUSH_ENABLE)?STR_ENABLED:STR_DISABLED);
 		printf("\t- Char: ");
-			if(dev_config->network_info[0].packing_delimiter_length == 1) printf("[%.2X] (hex only)\r\n", dev_config->network_info[0].packing_delimiter[0]);
+			if(dev_config->network_info[0].packing_delimiter_length != 0)
+			{
+				for(i = 0; i < dev_config->network_info[0].packing_delimiter_length; i++) printf("[%.2X]", dev_config->network_info[0].packing_delimiter[i]);
+				printf(" (hex only), appendix: [%d] (bytes)\r\n", dev_config->network_info[0].packing_data_appendix);
+			}
 			else printf("%s\r\n", STR_DISABLED);
 		
 		printf(" - Serial command mode swtich code:\r\n");
@@ -435,7 +435,7 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 						break;
 					case SEGCP_OP: 
 						tmp_byte = is_hex(*param);
-						if(param_len != 1 || tmp_byte > UDP_MODE)
+						if(param_len != 1 || tmp_byte > MODBUS_TCP_MODE)
 						{
 							ret |= SEGCP_RET_ERR_INVALIDPARAM;
 						}
@@ -609,6 +609,10 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 							dev_config->network_info[0].remote_ip[2] = tmp_ip[2];
 							dev_config->network_info[0].remote_ip[3] = tmp_ip[3];
 						}
+						else if(param_len > DEVCONF_DOMAIN_MAX)
+						{
+							ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						}
 						else
 						{
 							dev_config->options.dns_use = SEGCP_ENABLE;
@@ -666,9 +670,9 @@ uint16_t proc_SEGCP(uint8_t* segcp_req, uint8_t* segcp_rep)
 						else dev_config->network_info[0].packing_time = (uint16_t)tmp_long;
 						break;
 					case SEGCP_PS:
-						sscanf(param, "%d", &tmp_int);
-						if(param_len > 3 || tmp_int > 0xFF) ret |= SEGCP_RET_ERR_INVALIDPARAM;
-						else dev_config->network_info[0].packing_size = (uint8_t)tmp_int;
+						sscanf(param, "%ld", &tmp_long);
+						if(param_len > 5 || tmp_long > PACKING_SIZE_MAX) ret |= SEGCP_RET_ERR_INVALIDPARAM;
+						else dev_config->network_info[0].packing_size = (uint16_t)tmp_long;
 						break;
 					case SEGCP_PD:
 						if(param_len != 2 || !is_hexstr(param))
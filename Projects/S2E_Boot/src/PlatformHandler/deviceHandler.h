@@ -47,6 +47,7 @@
 
 #define DEVICE_MAC_ADDR						(DAT0_START_ADDR)
 #define DEVICE_CONFIG_ADDR					(DAT1_START_ADDR)
+#define DEVICE_CONFIG_CH2_ADDR				(DAT0_START_ADDR + 0x10) // Dual data UART mode: channel 2 configuration data, in the MAC address sector
 
 
 /* Defines for firmware update */
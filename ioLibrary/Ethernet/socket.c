@@ -141,6 +141,7 @@ int8_t socket(uint8_t sn, uint8_t protocol, uint16_t port, uint8_t flag)
     setSn_PORT(sn,port);	
     setSn_CR(sn,Sn_CR_OPEN);
     while(getSn_CR(sn));
+    sock_io_mode &= ~(1 << sn);
     sock_io_mode |= ((flag & SF_IO_NONBLOCK) << sn);   
     sock_is_sending &= ~(1<<sn);
     sock_remained_size[sn] = 0;
@@ -254,9 +255,15 @@ int8_t disconnect(uint8_t sn)
 }
 
 int32_t send(uint8_t sn, uint8_t * buf, uint16_t len)
+{
+    return send_sg(sn, buf, len, 0, 0);
+}
+
+int32_t send_sg(uint8_t sn, uint8_t * buf1, uint16_t len1, uint8_t * buf2, uint16_t len2)
 {
     uint8_t tmp=0;
     uint16_t freesize=0;
+    uint32_t len = (uint32_t)len1 + len2;
 
     CHECK_SOCKNUM();
     CHECK_SOCKMODE(Sn_MR_TCP);
@@ -297,10 +304,17 @@ int32_t send(uint8_t sn, uint8_t * buf, uint16_t len)
             close(sn);
             return SOCKERR_SOCKSTATUS;
         }
-        if( (sock_io_mode & (1<<sn)) && (len > freesize) ) return SOCK_BUSY;
+        if(sock_io_mode & (1<<sn))
+        {
+            // Non-block io mode: partial write, as much as the free socket buffer can hold
+            if(freesize == 0) return SOCK_BUSY;
+            if(len > freesize) len = freesize;
+        }
         if(len <= freesize) break;
     }
-    wiz_send_data(sn, buf, len);
+    if(len1 > len) len1 = len;
+    wiz_send_data(sn, buf1, len1);
+    if(len > len1) wiz_send_data(sn, buf2, len - len1); // second segment follows the first in the Tx memory
 #if _WIZCHIP_ == 5200
     sock_next_rd[sn] = getSn_TX_RD(sn) + len;
 #endif
@@ -354,9 +368,15 @@ int32_t recv(uint8_t sn, uint8_t * buf, uint16_t len)
 }
 
 int32_t sendto(uint8_t sn, uint8_t * buf, uint16_t len, uint8_t * addr, uint16_t port)
+{
+    return sendto_sg(sn, buf, len, 0, 0, addr, port);
+}
+
+int32_t sendto_sg(uint8_t sn, uint8_t * buf1, uint16_t len1, uint8_t * buf2, uint16_t len2, uint8_t * addr, uint16_t port)
 {
     uint8_t tmp = 0;
     uint16_t freesize = 0;
+    uint32_t len = (uint32_t)len1 + len2;
         uint32_t taddr;
     CHECK_SOCKNUM();
     switch(getSn_MR(sn) & 0x0F)
@@ -398,7 +418,9 @@ int32_t sendto(uint8_t sn, uint8_t * buf, uint16_t len, uint8_t * addr, uint16_t
         if( (sock_io_mode & (1<<sn)) && (len > freesize) ) return SOCK_BUSY;
         if(len <= freesize) break;
     };
-    wiz_send_data(sn, buf, len);
+    if(len1 > len) len1 = len;
+    wiz_send_data(sn, buf1, len1);
+    if(len > len1) wiz_send_data(sn, buf2, len - len1);
 
 #if _WIZCHIP_ == 5200   // for W5200 ARP errata 
     setSUBR(0);
@@ -220,7 +220,8 @@ int8_t  disconnect(uint8_t sn);
  * @details It is used to send outgoing data to the connected socket.
  * @note    It is valid only in TCP server or client mode. It can't send data greater than socket buffer size. \n
  *          In block io mode, It doesn't return until data send is completed - socket buffer size is greater than data. \n
- *          In non-block io mode, It return @ref SOCK_BUSY immediatly when socket buffer is not enough. \n
+ *          In non-block io mode, It sends as much data as the free socket buffer can hold and returns the sent size (partial write),
+ *          It return @ref SOCK_BUSY immediatly when socket buffer is full. \n
  * @param sn Socket number. It should be <b>0 ~ @ref \_WIZCHIP_SOCK_NUM_</b>.
  * @param buf Pointer buffer containing data to be sent.
  * @param len The byte length of data in buf.
@@ -234,6 +235,21 @@ int8_t  disconnect(uint8_t sn);
  */
 int32_t send(uint8_t sn, uint8_t * buf, uint16_t len);
 
+/**
+ * @ingroup WIZnet_socket_APIs
+ * @brief	Send data held in two separate buffers to the connected peer in TCP socket.
+ * @details It works as @ref send(), but gathers the data from <I>buf1</I> followed by <I>buf2</I>
+ *          directly into the socket Tx buffer, e.g. the two contiguous spans of a ring buffer, without an intermediate copy.
+ * @note    When the total length exceeds the socket buffer size, the data is truncated from the tail of <I>buf2</I> (then <I>buf1</I>).
+ * @param sn Socket number. It should be <b>0 ~ @ref \_WIZCHIP_SOCK_NUM_</b>.
+ * @param buf1 Pointer buffer containing the first part of data to be sent.
+ * @param len1 The byte length of data in buf1.
+ * @param buf2 Pointer buffer containing the second part of data to be sent. It can be NULL when <I>len2</I> is zero.
+ * @param len2 The byte length of data in buf2.
+ * @return	Same as @ref send(), the sent data size is the total of both buffers.
+ */
+int32_t send_sg(uint8_t sn, uint8_t * buf1, uint16_t len1, uint8_t * buf2, uint16_t len2);
+
 /**
  * @ingroup WIZnet_socket_APIs
  * @brief	Receive data from the connected peer.
@@ -284,6 +300,24 @@ int32_t recv(uint8_t sn, uint8_t * buf, uint16_t len);
  */
 int32_t sendto(uint8_t sn, uint8_t * buf, uint16_t len, uint8_t * addr, uint16_t port);
 
+/**
+ * @ingroup WIZnet_socket_APIs
+ * @brief	Sends datagram held in two separate buffers to the peer with destination IP address and port number passed as parameter.
+ * @details It works as @ref sendto(), but gathers the datagram from <I>buf1</I> followed by <I>buf2</I>
+ *          directly into the socket Tx buffer, without an intermediate copy.
+ *
+ * @param sn    Socket number. It should be <b>0 ~ @ref \_WIZCHIP_SOCK_NUM_</b>.
+ * @param buf1  Pointer buffer containing the first part of outgoing data.
+ * @param len1  The byte length of data in buf1.
+ * @param buf2  Pointer buffer containing the second part of outgoing data. It can be NULL when <I>len2</I> is zero.
+ * @param len2  The byte length of data in buf2.
+ * @param addr  Pointer variable of destination IP address. It should be allocated 4 bytes.
+ * @param port  Destination port number.
+ *
+ * @return Same as @ref sendto(), the sent data size is the total of both buffers.
+ */
+int32_t sendto_sg(uint8_t sn, uint8_t * buf1, uint16_t len1, uint8_t * buf2, uint16_t len2, uint8_t * addr, uint16_t port);
+
 /**
  * @ingroup WIZnet_socket_APIs
  * @brief Receive datagram of UDP or MACRAW
@@ -121,6 +121,9 @@ uint16_t DNS_MSGID;     // DNS message ID
 
 uint32_t dns_1s_tick;   // for timout of DNS processing
 
+static uint8_t dns_server[4];  // DNS server of the query in progress (non-blocking)
+static int16_t dns_query_len;  // DNS query message length, for retransmission
+
 /* converts uint16_t from network buffer to a host byte order integer. */
 uint16_t get16(uint8_t * s)
 {
@@ -499,56 +502,74 @@ void DNS_init(uint8_t s, uint8_t * buf)
 }
 
 /* DNS CLIENT RUN */
-int8_t DNS_run(uint8_t * dns_ip, uint8_t * name, uint8_t * ip_from_dns)
+void DNS_start(uint8_t * dns_ip, uint8_t * name)
+{
+	uint8_t i;
+
+	for(i = 0; i < 4; i++) dns_server[i] = dns_ip[i];
+
+	// Socket open
+	socket(DNS_SOCKET, Sn_MR_UDP, 0, 0);
+
+#ifdef _DNS_DEBUG_
+	printf("> DNS Query to DNS Server : %d.%d.%d.%d\r\n", dns_ip[0], dns_ip[1], dns_ip[2], dns_ip[3]);
+#endif
+
+	dns_query_len = dns_makequery(0, (char *)name, pDNSMSG, MAX_DNS_BUF_SIZE);
+	dns_1s_tick = 0;
+	sendto(DNS_SOCKET, pDNSMSG, dns_query_len, dns_server, IPPORT_DOMAIN);
+}
+
+int8_t DNS_poll(uint8_t * ip_from_dns)
 {
 	int8_t ret;
 	struct dhdr dhp;
 	uint8_t ip[4];
 	uint16_t len, port;
 	int8_t ret_check_timeout;
-   
-   // Socket open
-   socket(DNS_SOCKET, Sn_MR_UDP, 0, 0);
-
-#ifdef _DNS_DEBUG_
-	printf("> DNS Query to DNS Server : %d.%d.%d.%d\r\n", dns_ip[0], dns_ip[1], dns_ip[2], dns_ip[3]);
-#endif
-   
-	len = dns_makequery(0, (char *)name, pDNSMSG, MAX_DNS_BUF_SIZE);
-	sendto(DNS_SOCKET, pDNSMSG, len, dns_ip, IPPORT_DOMAIN);
 
-	while (1)
+	if ((len = getSn_RX_RSR(DNS_SOCKET)) > 0)
 	{
-		if ((len = getSn_RX_RSR(DNS_SOCKET)) > 0)
-		{
-			if (len > MAX_DNS_BUF_SIZE) len = MAX_DNS_BUF_SIZE;
-			len = recvfrom(DNS_SOCKET, pDNSMSG, len, ip, &port);
+		if (len > MAX_DNS_BUF_SIZE) len = MAX_DNS_BUF_SIZE;
+		len = recvfrom(DNS_SOCKET, pDNSMSG, len, ip, &port);
 #ifdef _DNS_DEBUG_
-			printf("> Receive DNS message from %d.%d.%d.%d(%d). len = %d\r\n", ip[0], ip[1], ip[2], ip[3],port,len);
+		printf("> Receive DNS message from %d.%d.%d.%d(%d). len = %d\r\n", ip[0], ip[1], ip[2], ip[3],port,len);
 #endif
-			ret = parseDNSMSG(&dhp, pDNSMSG, ip_from_dns);
-			break;
-		}
-		// Check Timeout
-		ret_check_timeout = check_DNS_timeout();
-		if (ret_check_timeout < 0) {
+		ret = parseDNSMSG(&dhp, pDNSMSG, ip_from_dns);
+		close(DNS_SOCKET);
+		// Return value
+		// 0 > :  failed / 1 - success
+		return ret;
+	}
+
+	// Check Timeout
+	ret_check_timeout = check_DNS_timeout();
+	if (ret_check_timeout < 0) {
 
 #ifdef _DNS_DEBUG_
-			printf("> DNS Server is not responding : %d.%d.%d.%d\r\n", dns_ip[0], dns_ip[1], dns_ip[2], dns_ip[3]);
+		printf("> DNS Server is not responding : %d.%d.%d.%d\r\n", dns_server[0], dns_server[1], dns_server[2], dns_server[3]);
 #endif
-			return 0; // timeout occurred
-		}
-		else if (ret_check_timeout == 0) {
+		close(DNS_SOCKET);
+		return 0; // timeout occurred
+	}
+	else if (ret_check_timeout == 0) {
 
 #ifdef _DNS_DEBUG_
-			printf("> DNS Timeout\r\n");
+		printf("> DNS Timeout\r\n");
 #endif
-			sendto(DNS_SOCKET, pDNSMSG, len, dns_ip, IPPORT_DOMAIN);
-		}
+		sendto(DNS_SOCKET, pDNSMSG, dns_query_len, dns_server, IPPORT_DOMAIN);
 	}
-	close(DNS_SOCKET);
-	// Return value
-	// 0 > :  failed / 1 - success
+
+	return DNS_RUNNING;
+}
+
+int8_t DNS_run(uint8_t * dns_ip, uint8_t * name, uint8_t * ip_from_dns)
+{
+	int8_t ret;
+
+	DNS_start(dns_ip, name);
+	while ((ret = DNS_poll(ip_from_dns)) == DNS_RUNNING);
+
 	return ret;
 }
 
@@ -73,6 +73,8 @@
 #define	IPPORT_DOMAIN     53       ///< DNS server port number
 
 #define DNS_MSG_ID         0x1122   ///< ID for DNS message. You can be modifyed it any number
+
+#define DNS_RUNNING        2        ///< DNS_poll(): the query is in progress
 /*
  * @brief DNS process initialize
  * @param s   : Socket number for DNS
@@ -93,6 +95,23 @@ void DNS_init(uint8_t s, uint8_t * buf);
  */
 int8_t DNS_run(uint8_t * dns_ip, uint8_t * name, uint8_t * ip_from_dns);
 
+/*
+ * @brief Non-blocking DNS process: send the DNS query
+ * @param dns_ip        : DNS server ip
+ * @param name          : Domain name to be queryed
+ * @note The result is checked by @ref DNS_poll()
+ */
+void DNS_start(uint8_t * dns_ip, uint8_t * name);
+
+/*
+ * @brief Non-blocking DNS process: check the DNS response of the query started by @ref DNS_start()
+ * @param ip_from_dns   : IP address from DNS server
+ * @return  @ref DNS_RUNNING : the query is in progress \n
+ *           0 : failed  (Timeout or Parse error)\n
+ *           1 : success
+ */
+int8_t DNS_poll(uint8_t * ip_from_dns);
+
 /*
  * @brief DNS 1s Tick Timer handler
  * @note SHOULD BE register to your system 1s Tick timer handler 
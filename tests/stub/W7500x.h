@@ -0,0 +1,33 @@
+/* Host-side test stub: W7500x device header */
+#ifndef __W7500X_H
+#define __W7500X_H
+
+#include <stdint.h>
+
+typedef enum {RESET = 0, SET = !RESET} FlagStatus, ITStatus;
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+
+typedef enum {PendSV_IRQn = -2, UART0_IRQn = 9, UART1_IRQn = 10, DMA_IRQn = 19, DUALTIMER0_IRQn = 20, DUALTIMER1_IRQn = 21} IRQn_Type;
+
+#define __NVIC_PRIO_BITS		2
+
+// System control block: the PendSV request bit only, the register is a variable of the test (scb_stub)
+typedef struct {
+	volatile uint32_t ICSR;
+} SCB_Type;
+
+extern SCB_Type scb_stub;
+
+#define SCB						(&scb_stub)
+#define SCB_ICSR_PENDSVSET_Msk	(1UL << 28)
+
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+
+#define __INLINE			inline
+#define __disable_irq()
+#define __enable_irq()
+
+#endif
@@ -0,0 +1,10 @@
+/* Host-side test stub: W7500x_adc.h, the ADC channel type of the user IO declarations (gpioHandler.h) */
+#ifndef __W7500X_ADC_H
+#define __W7500X_ADC_H
+
+#include "W7500x.h"
+
+typedef enum { ADC_CH0 = 0, ADC_CH1, ADC_CH2, ADC_CH3, ADC_CH4, ADC_CH5, ADC_CH6, ADC_CH7,
+	ADC_CH8, ADC_CH9, ADC_CH10, ADC_CH11, ADC_CH12, ADC_CH13, ADC_CH14, ADC_CH15 } ADC_CH;
+
+#endif
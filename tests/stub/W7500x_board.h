@@ -0,0 +1,10 @@
+/* Host-side test stub: W7500x_board.h, the board options of WIZ750SR used by the UART handler and the SEGCP */
+#ifndef __W7500X_BOARD_H__
+#define __W7500X_BOARD_H__
+
+#define __USE_GPIO_HARDWARE_FLOWCONTROL__
+
+#define STATUS_PHYLINK_PIN			GPIO_Pin_10
+#define STATUS_TCPCONNECT_PIN		GPIO_Pin_1
+
+#endif
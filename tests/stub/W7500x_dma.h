@@ -0,0 +1,13 @@
+/* Host-side test stub: W7500x DMA */
+#ifndef __W7500X_DMA_H
+#define __W7500X_DMA_H
+
+#include <stdint.h>
+
+typedef enum {DMA_UART0 = 2, DMA_UART1 = 3} dma_channel;
+enum {byte = 0};
+
+void dma_peripheral_to_memory(uint32_t chnl_num, unsigned int src, unsigned int dest, unsigned int size, unsigned int num);
+unsigned int dma_get_remaining(uint32_t chnl_num);
+
+#endif
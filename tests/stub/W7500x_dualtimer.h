@@ -0,0 +1,39 @@
+/* Host-side test stub: W7500x dual timer */
+#ifndef __W7500X_DUALTIMER_H
+#define __W7500X_DUALTIMER_H
+
+#include <stdint.h>
+#include "W7500x.h"
+
+/* The timers are modelled by the test */
+typedef struct { volatile uint32_t load, value, run, it, it_en; } DUALTIMER_TypeDef;
+extern DUALTIMER_TypeDef dualtimer_regs[4];
+#define DUALTIMER0_0		(&dualtimer_regs[0])
+#define DUALTIMER0_1		(&dualtimer_regs[1])
+#define DUALTIMER1_0		(&dualtimer_regs[2])
+#define DUALTIMER1_1		(&dualtimer_regs[3])
+
+typedef struct
+{
+	uint32_t TimerLoad;
+	uint32_t TimerControl_Mode;
+	uint32_t TimerControl_Pre;
+	uint32_t TimerControl_Size;
+	uint32_t TimerControl_OneShot;
+} DUALTIMER_InitTypDef;
+
+#define DUALTIMER_TimerControl_Periodic		1
+#define DUALTIMER_TimerControl_OneShot		1
+#define DUALTIMER_TimerControl_Pre_1		0
+#define DUALTIMER_TimerControl_Size_32		1
+
+void DUALTIMER_ClockEnable(DUALTIMER_TypeDef * DUALTIMERn);
+void DUALTIMER_Init(DUALTIMER_TypeDef * DUALTIMERn, DUALTIMER_InitTypDef * DUALTIMER_InitStruct);
+void DUALTIMER_IntConfig(DUALTIMER_TypeDef * DUALTIMERn, FunctionalState state);
+void DUALTIMER_IntClear(DUALTIMER_TypeDef * DUALTIMERn);
+ITStatus DUALTIMER_GetIntStatus(DUALTIMER_TypeDef * DUALTIMERn);
+void DUALTIMER_Start(DUALTIMER_TypeDef * DUALTIMERn);
+void DUALTIMER_Stop(DUALTIMER_TypeDef * DUALTIMERn);
+void DUALTIMER_SetTimerLoad(DUALTIMER_TypeDef * DUALTIMERn, uint32_t TimerLoad);
+
+#endif
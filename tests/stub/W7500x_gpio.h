@@ -0,0 +1,27 @@
+/* Host-side test stub: W7500x GPIO */
+#ifndef __W7500X_GPIO_H
+#define __W7500X_GPIO_H
+
+#include <stdint.h>
+#include "W7500x.h"
+
+typedef struct { volatile uint32_t DATA; } GPIO_TypeDef;
+extern GPIO_TypeDef gpio_regs[4];
+#define GPIOA				(&gpio_regs[0])
+#define GPIOC				(&gpio_regs[2])
+
+typedef enum {GPIO_Mode_IN = 0, GPIO_Mode_OUT = 1} GPIOMode_TypeDef;
+typedef enum {PAD_PF = 0, PAD_AF1 = 1} PAD_AF_TypeDef;
+
+#define GPIO_Pin_1			((uint16_t)0x0002)
+#define GPIO_Pin_7			((uint16_t)0x0080)
+#define GPIO_Pin_10			((uint16_t)0x0400)
+#define GPIO_Pin_11			((uint16_t)0x0800)
+#define GPIO_Pin_12			((uint16_t)0x1000)
+
+void GPIO_Configuration(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin, GPIOMode_TypeDef GPIO_Mode, PAD_AF_TypeDef PAD_AF);
+void GPIO_SetBits(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin);
+void GPIO_ResetBits(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin);
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin);
+
+#endif
@@ -0,0 +1,89 @@
+/* Host-side test stub: W7500x UART peripheral */
+#ifndef __W7500X_UART_H
+#define __W7500X_UART_H
+
+#include <stdint.h>
+#include "W7500x.h"
+
+typedef struct
+{
+	volatile uint32_t DR;
+	union { volatile uint32_t RSR; volatile uint32_t ECR; } STATUS;
+	uint32_t RESERVED0[4];
+	volatile uint32_t FR;
+	uint32_t RESERVED1;
+	volatile uint32_t ILPR, IBRD, FBRD, LCR_H, CR, IFLS, IMSC, RIS, MIS, ICR, DMACR;
+} UART_TypeDef;
+
+typedef struct
+{
+	uint32_t UART_BaudRate;
+	uint16_t UART_WordLength;
+	uint16_t UART_StopBits;
+	uint16_t UART_Parity;
+	uint16_t UART_Mode;
+	uint16_t UART_HardwareFlowControl;
+} UART_InitTypeDef;
+
+/* The UART registers are host memory, the peripheral behaviour is modelled by the test */
+extern UART_TypeDef uart_regs[3];
+#define UART0				(&uart_regs[0])
+#define UART1				(&uart_regs[1])
+#define UART2				(&uart_regs[2])
+
+#define UART_FR_TXFE		(0x01ul << 7)
+#define UART_FR_TXFF		(0x01ul << 5)
+#define UART_FR_RXFE		(0x01ul << 4)
+#define UART_FR_BUSY		(0x01ul << 3)
+#define UART_FR_CTS			(0x01ul << 0)
+
+#define UART_LCR_H_SPS		(0x1ul << 7)
+#define UART_LCR_H_WLEN(n)	((n & 0x3ul) << 5)
+#define UART_LCR_H_STP2		(0x1ul << 3)
+#define UART_LCR_H_EPS		(0x1ul << 2)
+#define UART_LCR_H_PEN		(0x1ul << 1)
+#define UART_LCR_H_BRK		(0x1ul << 0)
+#define UART_CR_CTSEn		(0x1ul << 15)
+#define UART_CR_RTSEn		(0x1ul << 14)
+#define UART_CR_RXE			(0x1ul << 9)
+#define UART_CR_TXE			(0x1ul << 8)
+
+#define UART_WordLength_8b	((uint16_t)UART_LCR_H_WLEN(3))
+#define UART_WordLength_7b	((uint16_t)UART_LCR_H_WLEN(2))
+#define UART_Parity_No		((uint16_t)0x0000)
+#define UART_Parity_Even	((uint16_t)(UART_LCR_H_PEN | UART_LCR_H_EPS))
+#define UART_Parity_Odd		((uint16_t)(UART_LCR_H_PEN))
+#define UART_StopBits_1		((uint16_t)0x0000)
+#define UART_StopBits_2		((uint16_t)(UART_LCR_H_STP2))
+#define UART_Mode_Rx		((uint16_t)(UART_CR_RXE))
+#define UART_Mode_Tx		((uint16_t)(UART_CR_TXE))
+#define UART_HardwareFlowControl_None		((uint16_t)0x0000)
+#define UART_HardwareFlowControl_RTS_CTS	((uint16_t)(UART_CR_RTSEn | UART_CR_CTSEn))
+
+#define UART_RECV_STATUS_OE	((uint16_t)0x01UL << 3)
+#define UART_RECV_STATUS_BE	((uint16_t)0x01UL << 2)
+#define UART_RECV_STATUS_PE	((uint16_t)0x01UL << 1)
+#define UART_RECV_STATUS_FE	((uint16_t)0x01UL << 0)
+
+#define UART_IT_FLAG_RTI	((uint16_t)0x01UL << 6)
+#define UART_IT_FLAG_TXI	((uint16_t)0x01UL << 5)
+#define UART_IT_FLAG_RXI	((uint16_t)0x01UL << 4)
+
+void UART_Init(UART_TypeDef * UARTx, UART_InitTypeDef * UART_InitStruct);
+void UART_ITConfig(UART_TypeDef * UARTx, uint16_t UART_IT, FunctionalState NewState);
+ITStatus UART_GetITStatus(UART_TypeDef * UARTx, uint16_t UART_IT);
+void UART_ClearITPendingBit(UART_TypeDef * UARTx, uint16_t UART_IT);
+uint8_t UART_ReceiveData(UART_TypeDef * UARTx);
+void UART_SendData(UART_TypeDef * UARTx, uint16_t Data);
+void UART_SendBreak(UART_TypeDef * UARTx);
+void UART_ClearRecvStatus(UART_TypeDef * UARTx, uint16_t UART_RECV_STATUS);
+void UART_FIFO_Enable(UART_TypeDef * UARTx, uint16_t rx_fifo_level, uint16_t tx_fifo_level);
+void UART_FIFO_Disable(UART_TypeDef * UARTx);
+void S_UART_Init(uint32_t baud);
+void S_UartPutc(uint8_t ch);
+uint32_t GetSystemClock(void);
+
+/* Cortex-M0 data memory barrier: a full fence on the host */
+#define __DMB()		__atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#endif
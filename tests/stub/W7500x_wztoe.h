@@ -0,0 +1,120 @@
+/*
+ * Host-side test stub: W7500x WZTOE (TCP/IP offload engine)
+ * The socket buffer memory is a host memory window below 4GB (the driver keeps the addresses in uint32_t),
+ * the socket registers are plain variables of the test (wztoe_sn[]), the socket commands are run by
+ * the test's wztoe_command()
+ */
+#ifndef __W7500X_WZTOE_H
+#define __W7500X_WZTOE_H
+
+#include <stdint.h>
+
+#define _WIZCHIP_SOCK_NUM_		8
+
+#define Sn_MR_MULTI			(0x80)
+#define Sn_MR_ND			(0x20)
+#define Sn_MR_MC			(0x20)
+#define Sn_MR_MACRAW		(0x04)
+#define Sn_MR_IPRAW			(0x03)
+#define Sn_MR_UDP			(0x02)
+#define Sn_MR_TCP			(0x01)
+#define Sn_MR_CLOSE			(0x00)
+#define Sn_MR_MFEN			(Sn_MR_MULTI)
+
+#define Sn_CR_OPEN			(0x01)
+#define Sn_CR_LISTEN		(0x02)
+#define Sn_CR_CONNECT		(0x04)
+#define Sn_CR_DISCON		(0x08)
+#define Sn_CR_CLOSE			(0x10)
+#define Sn_CR_SEND			(0x20)
+#define Sn_CR_SEND_KEEP		(0x22)
+#define Sn_CR_RECV			(0x40)
+
+#define Sn_IR_SENDOK		(0x10)
+#define Sn_IR_TIMEOUT		(0x08)
+#define Sn_IR_RECV			(0x04)
+#define Sn_IR_DISCON		(0x02)
+#define Sn_IR_CON			(0x01)
+
+#define SOCK_CLOSED			(0x00)
+#define SOCK_INIT			(0x13)
+#define SOCK_LISTEN			(0x14)
+#define SOCK_SYNSENT		(0x15)
+#define SOCK_SYNRECV		(0x16)
+#define SOCK_ESTABLISHED	(0x17)
+#define SOCK_FIN_WAIT		(0x18)
+#define SOCK_CLOSING		(0x1A)
+#define SOCK_TIME_WAIT		(0x1B)
+#define SOCK_CLOSE_WAIT		(0x1C)
+#define SOCK_LAST_ACK		(0x1D)
+#define SOCK_UDP			(0x22)
+#define SOCK_MACRAW			(0x42)
+
+typedef struct {
+	uint8_t mr, sr, ir, imr, ttl, tos;
+	uint16_t port, dport, mssr, kpalvtr;
+	uint8_t dipr[4];
+	uint8_t dhar[6];
+	uint16_t tx_fsr, rx_rsr;
+	uint16_t txmax, rxmax;
+	uint32_t tx_wr;
+	uint32_t tx_rd;
+	uint32_t rx_rd;
+} wztoe_sn_t;
+
+extern uint32_t wztoe_mem_base;		// Set by the test: 2MB aligned, 8 socket windows of 256KB
+extern wztoe_sn_t wztoe_sn[_WIZCHIP_SOCK_NUM_];
+extern uint8_t wztoe_sipr[4];		// Source IP address register, set by the test
+void wztoe_command(uint8_t sn, uint8_t cr);
+
+#define TXMEM_BASE			(wztoe_mem_base)
+#define RXMEM_BASE			(wztoe_mem_base + 0x00010000)
+
+#define WIZCHIP_CRITICAL_ENTER()
+#define WIZCHIP_CRITICAL_EXIT()
+
+#define setSn_MR(sn, _v)		(wztoe_sn[sn].mr = (_v))
+#define getSn_MR(sn)			(wztoe_sn[sn].mr)
+#define setSn_CR(sn, _v)		wztoe_command(sn, _v)
+#define getSn_CR(sn)			0
+#define setSn_IR(sn, _v)		(wztoe_sn[sn].ir &= (uint8_t)~(_v))	// write 1 to clear
+#define getSn_IR(sn)			(wztoe_sn[sn].ir)
+#define setSn_IMR(sn, _v)		(wztoe_sn[sn].imr = (_v))
+#define getSn_IMR(sn)			(wztoe_sn[sn].imr)
+#define getSn_SR(sn)			(wztoe_sn[sn].sr)
+#define setSn_PORT(sn, _v)		(wztoe_sn[sn].port = (_v))
+#define setSn_DPORT(sn, _v)		(wztoe_sn[sn].dport = (_v))
+#define getSn_DPORT(sn)			(wztoe_sn[sn].dport)
+#define setSn_DIPR(sn, a)		do { int _i; for(_i = 0; _i < 4; _i++) wztoe_sn[sn].dipr[_i] = ((uint8_t *)(a))[_i]; } while(0)
+#define getSn_DIPR(sn, a)		do { int _i; for(_i = 0; _i < 4; _i++) ((uint8_t *)(a))[_i] = wztoe_sn[sn].dipr[_i]; } while(0)
+#define setSn_DHAR(sn, a)		do { int _i; for(_i = 0; _i < 6; _i++) wztoe_sn[sn].dhar[_i] = ((uint8_t *)(a))[_i]; } while(0)
+#define setSn_MSSR(sn, _v)		(wztoe_sn[sn].mssr = (_v))
+#define getSn_MSSR(sn)			(wztoe_sn[sn].mssr)
+#define setSn_TTL(sn, _v)		(wztoe_sn[sn].ttl = (_v))
+#define getSn_TTL(sn)			(wztoe_sn[sn].ttl)
+#define setSn_TOS(sn, _v)		(wztoe_sn[sn].tos = (_v))
+#define getSn_TOS(sn)			(wztoe_sn[sn].tos)
+#define setSn_KPALVTR(sn, _v)	(wztoe_sn[sn].kpalvtr = (_v))
+#define getSn_KPALVTR(sn)		(wztoe_sn[sn].kpalvtr)
+#define getSn_TxMAX(sn)			(wztoe_sn[sn].txmax)
+#define getSn_RxMAX(sn)			(wztoe_sn[sn].rxmax)
+#define getSn_TXBUF_SIZE(sn)	((uint8_t)(wztoe_sn[sn].txmax >> 10))
+#define getSIPR(a)				do { int _i; for(_i = 0; _i < 4; _i++) ((uint8_t *)(a))[_i] = wztoe_sipr[_i]; } while(0)
+#define getSn_TX_FSR(sn)		(wztoe_sn[sn].tx_fsr)
+#define getSn_RX_RSR(sn)		(wztoe_sn[sn].rx_rsr)
+#define getSn_TX_RD(sn)			((uint16_t)wztoe_sn[sn].tx_rd)
+#define setSn_TX_WR(sn, _v)		(wztoe_sn[sn].tx_wr = (_v))
+#define getSn_TX_WR(sn)			((uint16_t)wztoe_sn[sn].tx_wr)
+#define setSn_RX_RD(sn, _v)		(wztoe_sn[sn].rx_rd = (_v))
+#define getSn_RX_RD(sn)			((uint16_t)wztoe_sn[sn].rx_rd)
+
+uint8_t WIZCHIP_READ(uint32_t Addr);
+void WIZCHIP_WRITE(uint32_t Addr, uint8_t Data);
+void WIZCHIP_READ_BUF (uint32_t BaseAddr, uint32_t ptr, uint8_t* pBuf, uint16_t len);
+void WIZCHIP_WRITE_BUF(uint32_t BaseAddr, uint32_t ptr, uint8_t* pBuf, uint16_t len);
+void wiz_send_data(uint8_t sn, uint8_t *wizdata, uint16_t len);
+void wiz_recv_data(uint8_t sn, uint8_t *wizdata, uint16_t len);
+void wiz_recv_peek(uint8_t sn, uint8_t *wizdata, uint16_t len);
+void wiz_recv_ignore(uint8_t sn, uint16_t len);
+
+#endif
@@ -0,0 +1,2 @@
+/* Host-side test stub: configdata.h (the include name of uartHandler.c, case-insensitive on the target tools) */
+#include "ConfigData.h"
@@ -0,0 +1,42 @@
+/*
+ * Host test helpers shared by the tests
+ *	- failed / CHECK(): the failed check printed with its line, the test goes on to the end of the case
+ *	- next_rand(): xorshift, seeded by TEST_SEED (defined by the test before the include): the same sequence in each run
+ *	- xorshift(): the same generator on the caller's state (the threads of the test)
+ *	- elapsed_ns(): the host time of the benchmarks
+ */
+#ifndef _TEST_COMMON_H
+#define _TEST_COMMON_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+// volatile: also set by the threads of the ring buffer test
+static volatile int failed = 0;
+
+#define CHECK(_cond) do { if(!(_cond)) { printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #_cond); failed = 1; } } while(0)
+
+static inline uint32_t xorshift(uint32_t * s)
+{
+	*s ^= *s << 13;
+	*s ^= *s >> 17;
+	*s ^= *s << 5;
+	return *s;
+}
+
+#ifdef TEST_SEED
+static uint32_t seed = TEST_SEED;
+
+static inline uint32_t next_rand(void)
+{
+	return xorshift(&seed);
+}
+#endif
+
+static inline double elapsed_ns(struct timespec * a, struct timespec * b)
+{
+	return (double)(b->tv_sec - a->tv_sec) * 1e9 + (double)(b->tv_nsec - a->tv_nsec);
+}
+
+#endif
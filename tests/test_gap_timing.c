@@ -0,0 +1,300 @@
+/*
+ * UART Rx gap timer (uartHandler.c, the packing time delimiter in usec / character times, Modbus RTU t3.5) host timing simulation
+ * The UART handler runs against a bit-time model of the data UART and the one-shot timer:
+ *	- Rx FIFO: 16 bytes, Rx interrupt at 1/2 full (UART_RX_FIFO_LEVEL), Rx timeout interrupt after 32 bit times idle
+ *	- The serial frames are sent with random idle times inside the frames (shorter than the gap time)
+ *	  and between the frames (longer than the gap time)
+ *	- Every frame end is reported once at the right ring buffer index, no frame is split inside,
+ *	  the report delay from the last stop bit matches the gap time (the gap times shorter than the Rx timeout raised to it)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "uartHandler.h"
+#include "W7500x_dualtimer.h"
+#include "W7500x_gpio.h"
+#include "seg.h"
+
+#define TEST_SEED		0x1B873593	// next_rand()
+#include "test_common.h"
+
+#define SYSTEM_CLOCK		48000000UL
+#define FIFO_DEPTH			16
+#define FIFO_TRIGGER		8		// UART_RX_FIFO_LEVEL [2] 1/2 full
+#define RX_TIMEOUT_BITS		32
+#define FRAMES				3000
+#define FRAME_LEN_MAX		64
+#define MAX_ENDS			(FRAMES + 16)
+
+BUFFER_DECLARATION(data_rx);
+
+UART_TypeDef uart_regs[3];
+DUALTIMER_TypeDef dualtimer_regs[4];
+GPIO_TypeDef gpio_regs[4];
+uint8_t opmode = 0;
+
+static DevConfig dev_config;
+
+// Data UART model: Rx FIFO, Rx interrupt by the trigger level, Rx timeout interrupt
+static uint8_t fifo[FIFO_DEPTH];
+static uint8_t fifo_head, fifo_count;
+static uint32_t fifo_idle_bits;		// bit times since the last byte received
+static uint8_t rx_timeout_flag;
+static uint32_t overruns;
+
+static void fifo_update_flags(void)
+{
+	if(fifo_count == 0) UART0->FR |= UART_FR_RXFE;
+	else UART0->FR &= ~UART_FR_RXFE;
+}
+
+static void fifo_push(uint8_t ch)
+{
+	if(fifo_count == FIFO_DEPTH)
+	{
+		overruns++;
+		return;
+	}
+	fifo[(fifo_head + fifo_count) % FIFO_DEPTH] = ch;
+	fifo_count++;
+	fifo_idle_bits = 0;
+	fifo_update_flags();
+}
+
+uint8_t UART_ReceiveData(UART_TypeDef * UARTx)
+{
+	uint8_t ch = fifo[fifo_head];
+
+	(void)UARTx;
+	if(fifo_count == 0) return 0;
+	fifo_head = (fifo_head + 1) % FIFO_DEPTH;
+	fifo_count--;
+	fifo_update_flags();
+
+	return ch;
+}
+
+ITStatus UART_GetITStatus(UART_TypeDef * UARTx, uint16_t UART_IT)
+{
+	uint16_t pending = 0;
+
+	(void)UARTx;
+	if(fifo_count >= FIFO_TRIGGER) pending |= UART_IT_FLAG_RXI;
+	if(rx_timeout_flag) pending |= UART_IT_FLAG_RTI;
+
+	return (pending & UART_IT) ? SET : RESET;
+}
+
+void UART_ClearITPendingBit(UART_TypeDef * UARTx, uint16_t UART_IT)
+{
+	(void)UARTx;
+	if(UART_IT & UART_IT_FLAG_RTI) rx_timeout_flag = 0;
+}
+
+void UART_Init(UART_TypeDef * UARTx, UART_InitTypeDef * UART_InitStruct) { (void)UARTx; (void)UART_InitStruct; }
+void UART_FIFO_Enable(UART_TypeDef * UARTx, uint16_t rx_fifo_level, uint16_t tx_fifo_level) { (void)UARTx; (void)rx_fifo_level; (void)tx_fifo_level; }
+void UART_SendData(UART_TypeDef * UARTx, uint16_t Data) { (void)UARTx; (void)Data; }
+// Not used by the test: the interrupt mask / the break / the error status / the debug UART
+void UART_ITConfig(UART_TypeDef * UARTx, uint16_t UART_IT, FunctionalState NewState) { (void)UARTx; (void)UART_IT; (void)NewState; }
+void UART_SendBreak(UART_TypeDef * UARTx) { (void)UARTx; }
+void UART_ClearRecvStatus(UART_TypeDef * UARTx, uint16_t UART_RECV_STATUS) { (void)UARTx; (void)UART_RECV_STATUS; }
+void S_UART_Init(uint32_t baud) { (void)baud; }
+void S_UartPutc(uint8_t ch) { (void)ch; }
+uint32_t GetSystemClock(void) { return SYSTEM_CLOCK; }
+
+// One-shot timer model: counts down in the timer ticks
+void DUALTIMER_ClockEnable(DUALTIMER_TypeDef * DUALTIMERn) { (void)DUALTIMERn; }
+void DUALTIMER_Init(DUALTIMER_TypeDef * DUALTIMERn, DUALTIMER_InitTypDef * DUALTIMER_InitStruct) { DUALTIMERn->load = DUALTIMER_InitStruct->TimerLoad; DUALTIMERn->run = 0; }
+void DUALTIMER_IntConfig(DUALTIMER_TypeDef * DUALTIMERn, FunctionalState state) { DUALTIMERn->it_en = (state == ENABLE); }
+void DUALTIMER_IntClear(DUALTIMER_TypeDef * DUALTIMERn) { DUALTIMERn->it = 0; }
+ITStatus DUALTIMER_GetIntStatus(DUALTIMER_TypeDef * DUALTIMERn) { return (DUALTIMERn->it && DUALTIMERn->it_en) ? SET : RESET; }
+void DUALTIMER_Start(DUALTIMER_TypeDef * DUALTIMERn) { DUALTIMERn->value = DUALTIMERn->load; DUALTIMERn->run = 1; }
+void DUALTIMER_Stop(DUALTIMER_TypeDef * DUALTIMERn) { DUALTIMERn->run = 0; }
+void DUALTIMER_SetTimerLoad(DUALTIMER_TypeDef * DUALTIMERn, uint32_t TimerLoad) { DUALTIMERn->load = TimerLoad; }
+
+// GPIO: the RS-485 / RTS pins, not used by the RS-232 settings of the test
+void GPIO_Configuration(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin, GPIOMode_TypeDef GPIO_Mode, PAD_AF_TypeDef PAD_AF) { (void)GPIOx; (void)GPIO_Pin; (void)GPIO_Mode; (void)PAD_AF; }
+void GPIO_SetBits(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin) { (void)GPIOx; (void)GPIO_Pin; }
+void GPIO_ResetBits(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin) { (void)GPIOx; (void)GPIO_Pin; }
+uint8_t GPIO_ReadInputDataBit(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin) { (void)GPIOx; (void)GPIO_Pin; return 0; }
+
+void NVIC_EnableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+void NVIC_DisableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn) { (void)IRQn; }
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority) { (void)IRQn; (void)priority; }
+
+// S2E hooks: no trigger code, no flow control, every byte stored
+DevConfig * get_DevConfig_pointer(void) { return &dev_config; }
+uint8_t check_serial_store_permitted(uint8_t ch) { (void)ch; return 1; }
+uint8_t check_modeswitch_trigger(uint8_t ch) { (void)ch; return 0; }
+uint8_t get_serial_store_permitted(void) { return 1; }
+uint8_t get_modeswitch_trigger_idx(void) { return 0; }
+void clear_modeswitch_gap_time(void) { }
+void init_time_delimiter_timer(void) { }
+void notify_serial_rx(void) { }
+void set_event(uint8_t event) { (void)event; }
+
+typedef struct
+{
+	const char * name;
+	uint8_t baud;				// enum baud
+	uint8_t parity;				// enum parity
+	uint16_t gap_half_chars;	// uart_rx_gap_timer_init() arguments
+	uint16_t gap_min_usec;
+} gap_case_t;
+
+static const gap_case_t gap_cases[] =
+{
+	{"Modbus t3.5, 9600-8-N-1",		baud_9600,		parity_none,	7,	1750},	// 35 bit times: the Rx interrupt every 80 bit times inside the frame
+	{"Modbus t3.5, 19200-8-E-1",	baud_19200,		parity_even,	7,	1750},	// 38.5 bit times
+	{"Modbus t3.5, 115200-8-N-1",	baud_115200,	parity_none,	7,	1750},	// 1750us: 201.6 bit times
+	{"PT 1.5c, 115200-8-N-1",		baud_115200,	parity_none,	3,	0},		// 15 bit times: raised to the Rx timeout
+	{"PT 100u, 115200-8-N-1",		baud_115200,	parity_none,	0,	100},	// 11.5 bit times: raised to the Rx timeout
+	{"PT 750u, 115200-8-N-1",		baud_115200,	parity_none,	0,	750},	// 86.4 bit times
+};
+
+static const uint32_t baud_rates[] = {300, 600, 1200, 1800, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200, 230400};
+
+static uint16_t expected_end[MAX_ENDS];		// data_rx_wr at the frame ends
+static uint32_t expected_time[MAX_ENDS];	// bit time of the last stop bit
+static uint16_t reported_end[MAX_ENDS];
+static uint32_t reported_time[MAX_ENDS];
+static uint32_t n_expected, n_reported;
+
+static uint32_t now;				// bit times
+static uint32_t bit_ticks;
+
+// One bit time: the gap timer counted, the character received at the stop bit, the UART interrupt, the main loop
+static void step(uint8_t rx, uint8_t ch)
+{
+	DUALTIMER_TypeDef * timer = DUALTIMER1_1;	// UART_RX_GAP_TIMER
+	uint16_t rx_end;
+
+	now++;
+
+	if(timer->run)
+	{
+		if(timer->value > bit_ticks)
+		{
+			timer->value -= bit_ticks;
+		}
+		else
+		{
+			timer->value = 0;
+			timer->run = 0;
+			timer->it = 1;
+			S2E_UART_Rx_Gap_Timer_IRQ_Handler();
+		}
+	}
+
+	if(rx) fifo_push(ch);
+	else if(fifo_count && (++fifo_idle_bits >= RX_TIMEOUT_BITS)) rx_timeout_flag = 1;
+
+	if(UART_GetITStatus(UART0, (UART_IT_FLAG_RXI | UART_IT_FLAG_RTI))) S2E_UART_IRQ_Handler(UART0);
+
+	// Main loop: the frame ends checked, the data taken
+	while((n_reported < MAX_ENDS) && uart_rx_gap_check(&rx_end))
+	{
+		reported_end[n_reported] = rx_end;
+		reported_time[n_reported++] = now;
+	}
+	data_rx_rd = data_rx_wr;
+}
+
+static void run_case(const gap_case_t * c)
+{
+	struct __serial_info * serial = &dev_config.serial_info[0];
+	uint32_t frame_bits, gap_ticks, gap_bits, intra_max;
+	uint32_t frame, len, i, bits, intra_gaps = 0;
+	uint32_t delay, delay_min = 0xFFFFFFFF, delay_max = 0;
+	uint16_t sent = 0;
+
+	memset(serial, 0, sizeof(*serial));
+	serial->baud_rate = c->baud;
+	serial->data_bits = word_len8;
+	serial->parity = c->parity;
+	serial->stop_bits = stop_bit1;
+	serial->flow_control = flow_none;
+	serial_info_init(UART0, serial);
+	uart_rx_gap_timer_init(c->gap_half_chars, c->gap_min_usec);
+
+	data_rx_wr = data_rx_rd = 0;
+	fifo_head = fifo_count = 0;
+	fifo_idle_bits = 0;
+	rx_timeout_flag = 0;
+	overruns = 0;
+	fifo_update_flags();
+	n_expected = n_reported = 0;
+	now = 0;
+
+	// The expected gap time: the setting, not shorter than the Rx timeout
+	bit_ticks = SYSTEM_CLOCK / baud_rates[c->baud];
+	frame_bits = 10 + ((c->parity != parity_none) ? 1 : 0);
+	gap_ticks = (c->gap_half_chars * frame_bits * bit_ticks) / 2;
+	if(gap_ticks < c->gap_min_usec * (SYSTEM_CLOCK / 1000000)) gap_ticks = c->gap_min_usec * (SYSTEM_CLOCK / 1000000);
+	if(gap_ticks < RX_TIMEOUT_BITS * bit_ticks) gap_ticks = RX_TIMEOUT_BITS * bit_ticks;
+	gap_bits = (gap_ticks + bit_ticks - 1) / bit_ticks;
+
+	// The idle time inside the frames: the next stop bit comes before the gap time elapsed
+	intra_max = gap_bits - frame_bits - 2;
+
+	for(frame = 0; (frame < FRAMES) && !failed; frame++)
+	{
+		// The idle time between the frames: longer than the gap time
+		bits = gap_bits + 1 + (next_rand() % 40);
+		while(bits--) step(0, 0);
+
+		len = 1 + (next_rand() % FRAME_LEN_MAX);
+		for(i = 0; i < len; i++)
+		{
+			// Mostly back-to-back characters
+			bits = 0;
+			if((i != 0) && ((next_rand() & 7) == 0))
+			{
+				bits = next_rand() % (intra_max + 1);
+				intra_gaps++;
+			}
+			bits += frame_bits;
+			while(--bits) step(0, 0);
+			step(1, (uint8_t)sent++);
+		}
+		expected_end[n_expected] = sent;
+		expected_time[n_expected++] = now;
+	}
+
+	// The line idle after the last frame
+	bits = gap_bits + 64;
+	while(bits--) step(0, 0);
+
+	CHECK(overruns == 0);
+	for(i = 0; (i < n_expected) && (i < n_reported); i++)
+	{
+		if(reported_end[i] != expected_end[i])
+		{
+			printf("FAIL: %s: frame end %u at %u, expected %u\n", c->name, (unsigned)i, reported_end[i], expected_end[i]);
+			failed = 1;
+			break;
+		}
+		delay = reported_time[i] - expected_time[i];
+		if(delay < delay_min) delay_min = delay;
+		if(delay > delay_max) delay_max = delay;
+	}
+	CHECK(n_reported == n_expected);
+
+	// The frame end is reported at the gap time after the last stop bit (the simulation steps in bit times)
+	CHECK(delay_min >= gap_bits);
+	CHECK(delay_max <= (gap_bits + 1));
+
+	if(!failed) printf("%-26s gap %3u bit times: %u frames, %u idle times inside the frames, reported %u..%u bit times after the frame\n",
+			c->name, (unsigned)gap_bits, (unsigned)n_reported, (unsigned)intra_gaps, (unsigned)delay_min, (unsigned)delay_max);
+}
+
+int main(void)
+{
+	uint32_t i;
+
+	for(i = 0; (i < (sizeof(gap_cases) / sizeof(gap_cases[0]))) && !failed; i++) run_case(&gap_cases[i]);
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed;
+}
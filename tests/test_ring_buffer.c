@@ -0,0 +1,227 @@
+/*
+ * Ring buffer (uartHandler.h BUFFER_xxx) host test
+ *	- Single thread: empty / full, the contiguous spans at the buffer end, the 16-bit index wrap-around
+ *	- Ring descriptor (RING_xxx, the S2E channels): the same results as BUFFER_xxx on the same buffer
+ *	- Two threads: producer (UART IRQ handler side) / consumer (main loop side) stress test,
+ *	  the byte and the zero-copy (span) accesses mixed, every byte checked in order
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "uartHandler.h"
+
+#include "test_common.h"
+
+#define RING_SIZE		64			// Small buffer: the stress test wraps around the buffer / the indices many times
+#define STRESS_BYTES	(16UL * 1024 * 1024)
+
+BUFFER_DEFINITION(ring, RING_SIZE)
+
+// Sequence pattern: not periodic by the buffer size
+static uint8_t pattern(uint32_t n)
+{
+	return (uint8_t)(n ^ (n >> 8) ^ (n >> 16));
+}
+
+static void test_single_thread(void)
+{
+	uint16_t i, span;
+	uint32_t n;
+
+	BUFFER_CLEAR(ring);
+	CHECK(IS_BUFFER_EMPTY(ring));
+	CHECK(BUFFER_FREE_SIZE(ring) == RING_SIZE);
+
+	// All of the bytes are usable
+	for(i = 0; i < RING_SIZE; i++)
+	{
+		BUFFER_IN(ring) = (uint8_t)i;
+		BUFFER_IN_MOVE(ring, 1);
+	}
+	CHECK(IS_BUFFER_FULL(ring));
+	CHECK(BUFFER_FREE_SIZE(ring) == 0);
+
+	for(i = 0; i < RING_SIZE; i++) CHECK(BUFFER_OUT_OFFSET(ring, i) == (uint8_t)i);
+	BUFFER_OUT_MOVE(ring, RING_SIZE - 3);
+	CHECK(BUFFER_USED_SIZE(ring) == 3);
+
+	// Spans: the write position wrapped to the buffer start, the read position 3 bytes before the end
+	CHECK(BUFFER_IN_SPAN(ring) == RING_SIZE);
+	CHECK(BUFFER_OUT_SPAN(ring) == 3);
+	CHECK(*BUFFER_OUT_PTR(ring) == (uint8_t)(RING_SIZE - 3));
+
+	BUFFER_CLEAR(ring);
+	CHECK(IS_BUFFER_EMPTY(ring));
+
+	// 16-bit free-running indices: the used size is correct across the index wrap-around
+	ring_wr = ring_rd = 0xFFF0;
+	for(n = 0; n < 0x40; n++)
+	{
+		BUFFER_IN(ring) = pattern(n);
+		BUFFER_IN_MOVE(ring, 1);
+		CHECK(BUFFER_USED_SIZE(ring) == 1);
+		CHECK(BUFFER_OUT(ring) == pattern(n));
+		BUFFER_OUT_MOVE(ring, 1);
+	}
+	CHECK(ring_wr == 0x0030);
+
+	span = BUFFER_IN_SPAN(ring);
+	CHECK(span == (RING_SIZE - (0x0030 & (RING_SIZE - 1))));
+
+	ring_wr = ring_rd = 0;
+}
+
+// The S2E session reaches the ring buffers of its UART by the descriptor: both macro sets see the same indices
+static void test_ring_descriptor(void)
+{
+	const tsRINGBUF * r = &ring_ring;
+	uint16_t i, n;
+
+	CHECK(r->sz == RING_SIZE);
+
+	ring_wr = ring_rd = 0xFFE0;
+	for(n = 0; n < 0x80; n++)
+	{
+		// Fill by one macro set, check and drain by the other
+		for(i = 0; i < (n % RING_SIZE); i++)
+		{
+			if(n & 1) { RING_IN(r) = pattern(n + i); RING_IN_MOVE(r, 1); }
+			else { BUFFER_IN(ring) = pattern(n + i); BUFFER_IN_MOVE(ring, 1); }
+		}
+
+		CHECK(RING_USED_SIZE(r) == BUFFER_USED_SIZE(ring));
+		CHECK(RING_FREE_SIZE(r) == BUFFER_FREE_SIZE(ring));
+		CHECK(RING_IN_SPAN(r) == BUFFER_IN_SPAN(ring));
+		CHECK(RING_OUT_SPAN(r) == BUFFER_OUT_SPAN(ring));
+		CHECK(RING_IN_PTR(r) == BUFFER_IN_PTR(ring));
+		CHECK(IS_RING_FULL(r) == IS_BUFFER_FULL(ring));
+
+		for(i = 0; i < (n % RING_SIZE); i++)
+		{
+			CHECK(RING_OUT_OFFSET(r, i) == BUFFER_OUT_OFFSET(ring, i));
+			CHECK(RING_OUT_OFFSET(r, i) == pattern(n + i));
+		}
+
+		if(n & 1) { RING_OUT_MOVE(r, n % RING_SIZE); }
+		else { BUFFER_OUT_MOVE(ring, n % RING_SIZE); }
+		CHECK(IS_RING_EMPTY(r) && IS_BUFFER_EMPTY(ring));
+	}
+
+	RING_IN(r) = 0x5A;
+	RING_IN_MOVE(r, 1);
+	RING_CLEAR(r);
+	CHECK(IS_BUFFER_EMPTY(ring));
+
+	ring_wr = ring_rd = 0;
+}
+
+static void * producer(void * arg)
+{
+	uint32_t seed = 0x12345678;	// xorshift() state of the thread
+	uint32_t n = 0;
+	uint16_t len, span, i;
+
+	(void)arg;
+
+	while((n < STRESS_BYTES) && !failed)
+	{
+		len = BUFFER_FREE_SIZE(ring);
+		if(len == 0) { sched_yield(); continue; } // Full: the consumer runs (single core hosts)
+
+		if(xorshift(&seed) & 1)
+		{
+			// Byte access (the UART Rx FIFO drain)
+			BUFFER_IN(ring) = pattern(n++);
+			BUFFER_IN_MOVE(ring, 1);
+		}
+		else
+		{
+			// Zero-copy access up to the span (the DMA / recv into the ring buffer)
+			span = BUFFER_IN_SPAN(ring);
+			if(len > span) len = span;
+			len = (uint16_t)(1 + (xorshift(&seed) % len));
+			if(len > (STRESS_BYTES - n)) len = (uint16_t)(STRESS_BYTES - n);
+
+			for(i = 0; i < len; i++) BUFFER_IN_PTR(ring)[i] = pattern(n + i);
+			n += len;
+			BUFFER_IN_MOVE(ring, len);
+		}
+	}
+
+	return NULL;
+}
+
+static void * consumer(void * arg)
+{
+	uint32_t seed = 0x9ABCDEF0;	// xorshift() state of the thread
+	uint32_t n = 0;
+	uint16_t len, span, i;
+	uint8_t * p;
+
+	(void)arg;
+
+	while((n < STRESS_BYTES) && !failed)
+	{
+		len = BUFFER_USED_SIZE(ring);
+		if(len == 0) { sched_yield(); continue; } // Empty: the producer runs
+
+		if(xorshift(&seed) & 1)
+		{
+			if(BUFFER_OUT(ring) != pattern(n))
+			{
+				printf("FAIL: byte %lu: 0x%02X, expected 0x%02X\n", (unsigned long)n, BUFFER_OUT(ring), pattern(n));
+				failed = 1;
+			}
+			n++;
+			BUFFER_OUT_MOVE(ring, 1);
+		}
+		else
+		{
+			span = BUFFER_OUT_SPAN(ring);
+			if(len > span) len = span;
+			len = (uint16_t)(1 + (xorshift(&seed) % len));
+
+			p = BUFFER_OUT_PTR(ring);
+			for(i = 0; i < len; i++)
+			{
+				if(p[i] != pattern(n + i))
+				{
+					printf("FAIL: span byte %lu: 0x%02X, expected 0x%02X\n", (unsigned long)(n + i), p[i], pattern(n + i));
+					failed = 1;
+					break;
+				}
+			}
+			n += len;
+			BUFFER_OUT_MOVE(ring, len);
+		}
+	}
+
+	return NULL;
+}
+
+static void test_two_threads(void)
+{
+	pthread_t prod, cons;
+
+	ring_wr = ring_rd = 0;
+
+	pthread_create(&cons, NULL, consumer, NULL);
+	pthread_create(&prod, NULL, producer, NULL);
+	pthread_join(prod, NULL);
+	pthread_join(cons, NULL);
+
+	CHECK(IS_BUFFER_EMPTY(ring));
+	printf("two threads: %lu bytes through a %d-byte ring buffer\n", (unsigned long)STRESS_BYTES, RING_SIZE);
+}
+
+int main(void)
+{
+	test_single_thread();
+	if(!failed) test_ring_descriptor();
+	if(!failed) test_two_threads();
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed;
+}
@@ -0,0 +1,529 @@
+/*
+ * S2E session state machine (seg.c do_seg / seg_session_timer_msec / seg_session_timer_sec) host test
+ * The session contexts of the test run side by side, each one on its own socket, UART ring buffers,
+ * user's buffers and channel settings (get_DevConfig_channel of the test):
+ *	- Parallel sessions: TCP server (no packing, packing time, packing size, coalesce to MSS) and UDP 1:1
+ *	  (no packing, packing time) sessions, the serial and the network data in random bursts both ways,
+ *	  every byte checked in order on the socket / the UART of its own session (no cross-talk),
+ *	  the UDP datagrams sent to the remote address of their own session
+ *	- Session timers: the TCP server sessions with different inactivity times are disconnected each at
+ *	  its own time, a session with the data flowing is kept connected
+ * The simulated sessions use the channel numbers after S2E_CH1 and the UARTs after SEG_DATA_UART:
+ * the channel 1 only paths (serial command mode, flow control, UART Rx gap timer) are not run
+ */
+#define _GNU_SOURCE		// MAP_32BIT
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "../Projects/S2E_App/src/Serial_to_Ethernet/seg.c"
+
+#define TEST_SEED		0x7F4A7C15	// next_rand()
+#include "test_common.h"
+
+#define SIMS			6
+#define SOCK_BUF_SIZE	2048
+#define RX_RING_SIZE	1024
+#define TX_RING_SIZE	512
+#define USER_BUF_SIZE	512
+#define STREAM_LEN		64000		// per session and direction, a multiple of the packing size
+#define PACKING_SIZE	100
+#define TICKS_MAX		2000000
+
+uint32_t wztoe_mem_base;
+wztoe_sn_t wztoe_sn[_WIZCHIP_SOCK_NUM_];
+uint8_t wztoe_sipr[4] = {192, 168, 11, 2};
+SCB_Type scb_stub;
+
+// The channel 1 buffers referenced by s2e_channel[] of seg.c, not used by the test
+BUFFER_DEFINITION(data_rx, 64)
+BUFFER_DEFINITION(data_tx, 64)
+uint8_t g_send_buf[DATA_BUF_SIZE];
+uint8_t g_recv_buf[DATA_BUF_SIZE];
+
+// Simulated session: the context, its UART (ring buffers), its socket (sock = index) and its settings
+typedef struct {
+	s2e_session_t ctx;
+	tsSEGSESSION session[1];
+	tsRINGBUF rx, tx;
+	uint8_t rx_buf[RX_RING_SIZE];
+	uint8_t tx_buf[TX_RING_SIZE];
+	volatile uint16_t rx_wr, rx_rd, tx_wr, tx_rd;
+	uint8_t send_buf[USER_BUF_SIZE];
+	uint8_t recv_buf[USER_BUF_SIZE];
+	DevConfig_channel cfg;
+	struct __network_info net;
+	struct __serial_info serial;
+	struct __network_info_extend netx;
+	uint8_t pw_connect_en;
+	uint8_t telnet_en;
+	// Test side
+	uint8_t connect;			// The peer connects when the socket listens
+	uint8_t idle;				// Serial line idle ticks left
+	uint16_t net_rx_wr;			// Socket Rx buffer write pointer (the network side)
+	uint32_t u2e_len;			// Serial data length to be received
+	uint32_t u2e_in, u2e_out;	// Serial data received by the UART / taken from the socket Tx buffer
+	uint32_t e2u_in, e2u_out;	// Network data received by the socket / taken from the UART Tx ring buffer
+	uint32_t datagrams;
+	uint32_t disconnects;
+	uint32_t disconnect_tick;
+} tsSIM;
+
+static tsSIM sim[SIMS];
+static uint32_t tick;
+
+static DevConfig dev_config_test;
+
+// Data pattern of the session and the direction: the data of another session does not match
+static uint8_t pattern(uint8_t idx, uint8_t dir, uint32_t n)
+{
+	uint32_t x = (n + 1) * 2654435761UL + ((uint32_t)idx * 2 + dir) * 0x9E3779B9UL;
+	return (uint8_t)((x >> 24) ^ (x >> 11));
+}
+
+/* Settings ------------------------------------------------------------------*/
+DevConfig * get_DevConfig_pointer(void)
+{
+	return &dev_config_test;
+}
+
+// The simulated sessions: ch = index + 1, channel 1 (S2E_CH1) is not run by the test
+const DevConfig_channel * get_DevConfig_channel(uint8_t ch)
+{
+	CHECK((ch >= 1) && (ch <= SIMS));
+	return &sim[(uint8_t)(ch - 1) % SIMS].cfg;
+}
+
+/* UART of the simulated sessions: uartNum = index + 1 ------------------------*/
+static tsSIM * uart_sim(uint8_t uartNum)
+{
+	CHECK((uartNum >= 1) && (uartNum <= SIMS));
+	return &sim[(uint8_t)(uartNum - 1) % SIMS];
+}
+
+int32_t uart_gets(uint8_t uartNum, uint8_t * buf, uint16_t reqSize)
+{
+	const tsRINGBUF * rx = &uart_sim(uartNum)->rx;
+	uint16_t i, len = RING_USED_SIZE(rx);
+
+	if(len > reqSize) len = reqSize;
+	for(i = 0; i < len; i++) buf[i] = RING_OUT_OFFSET(rx, i);
+	RING_OUT_MOVE(rx, len);
+
+	return len;
+}
+
+int32_t uart_gets_delim(uint8_t uartNum, uint8_t * buf, uint16_t reqSize, uint8_t * delim, uint8_t delim_len, uint8_t * matched)
+{
+	CHECK(0); // No packing delimiter in the test
+	return 0;
+}
+
+int32_t uart_write(uint8_t uartNum, uint8_t * buf, uint16_t reqSize)
+{
+	const tsRINGBUF * tx = &uart_sim(uartNum)->tx;
+	uint16_t i;
+
+	CHECK(reqSize <= RING_FREE_SIZE(tx)); // The received length is limited by the free size
+	for(i = 0; (i < reqSize) && !IS_RING_FULL(tx); i++)
+	{
+		RING_IN(tx) = buf[i];
+		RING_IN_MOVE(tx, 1);
+	}
+
+	return i;
+}
+
+int32_t uart_puts(uint8_t uartNum, uint8_t * buf, uint16_t reqSize)
+{
+	return uart_write(uartNum, buf, reqSize);
+}
+
+void uart_rx_flush(uint8_t uartNum)
+{
+	RING_CLEAR(&uart_sim(uartNum)->rx);
+}
+
+// The channel 1 UART: not used by the simulated sessions
+uint8_t uart_rx_gap_check(uint16_t * rx_end) { CHECK(0); return 0; }
+void uart_rx_gap_flush(void) { CHECK(0); }
+void uart_rx_gap_timer_init(uint16_t gap_half_chars, uint16_t gap_min_usec) { CHECK(0); }
+uint32_t get_uart_char_usec(struct __serial_info *serial) { CHECK(0); return 0; }
+void check_uart_flow_control(uint8_t flow_ctrl) { CHECK(0); }
+uint8_t get_uart_cts_pin(uint8_t uartNum) { return UART_CTS_LOW; }
+uint8_t get_flowcontrol_dsr_pin(void) { return 1; }
+
+/* The other modules -------------------------------------------------------*/
+void set_event(uint8_t event) {}
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority) { CHECK(0); } // Immediate flush is not enabled by the test
+void set_connection_status_io(uint16_t pin, uint8_t set) {}
+uint32_t getDeviceTimestamp(void) { return tick; }
+uint32_t convertTimestamp_usec(uint32_t ticks) { return ticks * 1000; }
+uint32_t get_phylink_downtime(void) { return 0; }
+
+// Telnet COM port control is not enabled by the test
+void rfc2217_open(uint8_t ch, uint8_t sock) { CHECK(0); }
+void rfc2217_close(uint8_t ch) { CHECK(0); }
+void rfc2217_process(uint8_t ch, uint8_t sock, uint8_t send_permitted) { CHECK(0); }
+uint16_t rfc2217_unescape(uint8_t ch, uint8_t * buf, uint16_t len) { CHECK(0); return len; }
+uint16_t rfc2217_escape(uint8_t * buf, uint16_t len) { CHECK(0); return len; }
+uint8_t rfc2217_has_iac(uint8_t * buf, uint16_t len) { return 0; }
+
+// Modbus TCP gateway is not used by the test
+uint8_t modbus_check_rtu_frame(uint8_t * buf, uint16_t len) { CHECK(0); return 0; }
+uint16_t modbus_add_rtu_crc(uint8_t * buf, uint16_t len) { CHECK(0); return len; }
+uint16_t modbus_get_mbap_length(uint8_t * mbap) { CHECK(0); return 0; }
+void modbus_set_mbap_header(uint8_t * adu, uint16_t tid, uint16_t len) { CHECK(0); }
+uint16_t modbus_set_exception(uint8_t * frame, uint8_t addr, uint8_t func, uint8_t code) { CHECK(0); return 0; }
+
+/* Socket of the simulated sessions: sock = index -----------------------------*/
+void wztoe_command(uint8_t sn, uint8_t cr)
+{
+	wztoe_sn_t * s = &wztoe_sn[sn];
+	tsSIM * p = &sim[sn];
+
+	switch(cr)
+	{
+		case Sn_CR_OPEN:
+			s->sr = ((s->mr & 0x0F) == Sn_MR_UDP) ? SOCK_UDP : SOCK_INIT;
+			s->tx_wr = s->tx_rd = 0;
+			s->tx_fsr = s->txmax;
+			s->rx_rd = 0;
+			s->rx_rsr = 0;
+			p->net_rx_wr = 0;
+			break;
+		case Sn_CR_LISTEN:
+			if(s->sr == SOCK_INIT) s->sr = SOCK_LISTEN;
+			break;
+		case Sn_CR_DISCON:
+			if(p->disconnects++ == 0) p->disconnect_tick = tick;
+			s->sr = SOCK_CLOSED;
+			break;
+		case Sn_CR_CLOSE:
+			s->sr = SOCK_CLOSED;
+			break;
+		case Sn_CR_SEND:
+			// UDP: the datagram goes to the remote of its own session
+			if(s->sr == SOCK_UDP)
+			{
+				CHECK(memcmp(s->dipr, p->net.remote_ip, 4) == 0);
+				CHECK(s->dport == p->net.remote_port);
+				p->datagrams++;
+			}
+			s->tx_fsr = (uint16_t)(s->txmax - (uint16_t)(s->tx_wr - s->tx_rd));
+			s->ir |= Sn_IR_SENDOK;
+			break;
+		case Sn_CR_RECV:
+			s->rx_rsr = (uint16_t)(p->net_rx_wr - s->rx_rd);
+			break;
+		default:
+			break;
+	}
+}
+
+static void init_sim(uint8_t idx, uint8_t mode)
+{
+	tsSIM * p = &sim[idx];
+	s2e_session_t * ctx = &p->ctx;
+
+	memset(p, 0, sizeof(*p));
+	memset(&wztoe_sn[idx], 0, sizeof(wztoe_sn[idx]));
+	wztoe_sn[idx].txmax = SOCK_BUF_SIZE;
+	wztoe_sn[idx].rxmax = SOCK_BUF_SIZE;
+
+	p->rx.buf = p->rx_buf;
+	p->rx.wr = &p->rx_wr;
+	p->rx.rd = &p->rx_rd;
+	p->rx.sz = RX_RING_SIZE;
+	p->tx.buf = p->tx_buf;
+	p->tx.wr = &p->tx_wr;
+	p->tx.rd = &p->tx_rd;
+	p->tx.sz = TX_RING_SIZE;
+
+	p->net.working_mode = mode;
+	p->net.state = ST_OPEN;
+	p->net.local_port = 5000 + idx;
+	p->net.remote_ip[0] = 192;
+	p->net.remote_ip[1] = 168;
+	p->net.remote_ip[2] = 11;
+	p->net.remote_ip[3] = 100 + idx;
+	p->net.remote_port = 6000 + idx;
+
+	p->cfg.network_info = &p->net;
+	p->cfg.serial_info = &p->serial;
+	p->cfg.network_info_extend = &p->netx;
+	p->cfg.pw_connect = "";
+	p->cfg.pw_connect_en = &p->pw_connect_en;
+	p->cfg.telnet_en = &p->telnet_en;
+
+	p->session[0].sock = idx;
+	p->u2e_len = STREAM_LEN;
+
+	ctx->ch = idx + 1;
+	ctx->sock = idx;
+	ctx->uart = idx + 1;
+	ctx->rx = &p->rx;
+	ctx->tx = &p->tx;
+	ctx->send_buf = p->send_buf;
+	ctx->recv_buf = p->recv_buf;
+	ctx->buf_size = USER_BUF_SIZE;
+	ctx->session = p->session;
+	ctx->sessions_max = 1;
+	ctx->mixed_state = MIXED_SERVER;
+	ctx->isXON = SEG_ENABLE;
+	ctx->arb_owner = SEG_ARB_OWNER_NONE;
+}
+
+// UART Rx: the serial data stored while the session permits it, the packing time counted from the last Rx burst
+static void serial_rx(tsSIM * p, uint8_t idx)
+{
+	s2e_session_t * ctx = &p->ctx;
+	uint16_t n;
+
+	if(p->idle) { p->idle--; return; }
+	if(!get_seg_store_permitted(ctx)) return;
+
+	n = (uint16_t)(1 + next_rand() % 64);
+	if(n > RING_FREE_SIZE(ctx->rx)) n = RING_FREE_SIZE(ctx->rx);
+	if(n > (p->u2e_len - p->u2e_in)) n = (uint16_t)(p->u2e_len - p->u2e_in);
+	if(n == 0) return;
+
+	for( ; n > 0; n--)
+	{
+		RING_IN(ctx->rx) = pattern(idx, 0, p->u2e_in++);
+		RING_IN_MOVE(ctx->rx, 1);
+	}
+
+	if(get_packing_time_msec(ctx) != 0)
+	{
+		S2E_TIMER_TIME(ctx, SERIAL_INPUT) = 0;
+		S2E_TIMER_RUN(ctx, SERIAL_INPUT) = SEG_ENABLE;
+	}
+
+	if((next_rand() % 16) == 0) p->idle = (uint8_t)(next_rand() % 20);
+}
+
+// Network Rx: TCP stream / UDP datagrams (the 8-byte header: peer IP, port, length) into the socket Rx buffer
+static void network_rx(tsSIM * p, uint8_t idx)
+{
+	wztoe_sn_t * s = &wztoe_sn[idx];
+	uint8_t data[256 + 8];
+	uint16_t n, i, hdr, room;
+
+	if((s->sr != SOCK_ESTABLISHED) && (s->sr != SOCK_UDP)) return;
+	if(p->e2u_in == STREAM_LEN) return;
+
+	hdr = (s->sr == SOCK_UDP) ? 8 : 0;
+	room = (uint16_t)(s->rxmax - (uint16_t)(p->net_rx_wr - s->rx_rd));
+	n = (uint16_t)(1 + next_rand() % 256);
+	if(n > (STREAM_LEN - p->e2u_in)) n = (uint16_t)(STREAM_LEN - p->e2u_in);
+	if((n + hdr) > room) return;
+
+	if(hdr)
+	{
+		data[0] = p->net.remote_ip[0];
+		data[1] = p->net.remote_ip[1];
+		data[2] = p->net.remote_ip[2];
+		data[3] = p->net.remote_ip[3];
+		data[4] = (uint8_t)(p->net.remote_port >> 8);
+		data[5] = (uint8_t)p->net.remote_port;
+		data[6] = (uint8_t)(n >> 8);
+		data[7] = (uint8_t)n;
+	}
+	for(i = 0; i < n; i++) data[hdr + i] = pattern(idx, 1, p->e2u_in + i);
+
+	WIZCHIP_WRITE_BUF(RXMEM_BASE | (idx << 18), p->net_rx_wr, data, n + hdr);
+	p->net_rx_wr += n + hdr;
+	p->e2u_in += n;
+	s->rx_rsr = (uint16_t)(p->net_rx_wr - s->rx_rd);
+}
+
+// The peer / the network takes the sent data from the socket Tx buffer
+static void network_tx(tsSIM * p, uint8_t idx)
+{
+	wztoe_sn_t * s = &wztoe_sn[idx];
+	uint8_t data[600];
+	uint16_t n, i;
+
+	n = (uint16_t)(s->tx_wr - s->tx_rd);
+	if(n > 600) n = 600;
+	n = (uint16_t)(next_rand() % (n + 1));
+	if(n == 0) return;
+
+	WIZCHIP_READ_BUF(TXMEM_BASE | (idx << 18), s->tx_rd, data, n);
+	for(i = 0; i < n; i++)
+	{
+		if(data[i] != pattern(idx, 0, p->u2e_out + i))
+		{
+			printf("FAIL: session %u serial data byte %lu\n", idx, (unsigned long)(p->u2e_out + i));
+			failed = 1;
+			break;
+		}
+	}
+	p->u2e_out += n;
+	s->tx_rd += n;
+	s->tx_fsr += n;
+}
+
+// The UART Tx interrupt takes the received data from the UART Tx ring buffer
+static void serial_tx(tsSIM * p, uint8_t idx)
+{
+	const tsRINGBUF * tx = &p->tx;
+	uint16_t n = (uint16_t)(next_rand() % 64);
+	uint16_t i;
+
+	if(n > RING_USED_SIZE(tx)) n = RING_USED_SIZE(tx);
+	for(i = 0; i < n; i++)
+	{
+		if(RING_OUT_OFFSET(tx, i) != pattern(idx, 1, p->e2u_out + i))
+		{
+			printf("FAIL: session %u network data byte %lu\n", idx, (unsigned long)(p->e2u_out + i));
+			failed = 1;
+			break;
+		}
+	}
+	p->e2u_out += n;
+	RING_OUT_MOVE(tx, n);
+}
+
+// The peer of a TCP server session connects once the socket listens
+static void network_connect(tsSIM * p, uint8_t idx)
+{
+	if(p->connect && (wztoe_sn[idx].sr == SOCK_LISTEN))
+	{
+		wztoe_sn[idx].sr = SOCK_ESTABLISHED;
+		wztoe_sn[idx].ir |= Sn_IR_CON;
+		p->connect = 0;
+	}
+}
+
+// 1ms tick: the session timers of every context, the 1s timers every 1000 ticks
+static void timer_tick(void)
+{
+	uint8_t i;
+
+	tick++;
+	for(i = 0; i < SIMS; i++) seg_session_timer_msec(&sim[i].ctx);
+	if((tick % 1000) == 0)
+	{
+		for(i = 0; i < SIMS; i++) seg_session_timer_sec(&sim[i].ctx);
+	}
+}
+
+static uint8_t sim_done(tsSIM * p)
+{
+	return (p->u2e_out == STREAM_LEN) && (p->e2u_out == STREAM_LEN);
+}
+
+static void test_parallel_sessions(void)
+{
+	uint8_t i, idx, done;
+
+	init_sim(0, TCP_SERVER_MODE);
+	init_sim(1, TCP_SERVER_MODE);
+	sim[1].net.packing_time = 5;
+	init_sim(2, TCP_SERVER_MODE);
+	sim[2].net.packing_size = PACKING_SIZE;
+	init_sim(3, TCP_SERVER_MODE);
+	sim[3].netx.packing_coalesce_time = 2;
+	init_sim(4, UDP_MODE);
+	init_sim(5, UDP_MODE);
+	sim[5].net.packing_time = 3;
+	for(i = 0; i < SIMS; i++) sim[i].connect = (sim[i].net.working_mode == TCP_SERVER_MODE);
+
+	tick = 0;
+	do {
+		done = 1;
+		for(i = 0; i < SIMS; i++)
+		{
+			idx = (uint8_t)((i + tick) % SIMS); // the sessions run in a rotating order
+			network_connect(&sim[idx], idx);
+			serial_rx(&sim[idx], idx);
+			network_rx(&sim[idx], idx);
+			do_seg(&sim[idx].ctx);
+			network_tx(&sim[idx], idx);
+			serial_tx(&sim[idx], idx);
+			if(!sim_done(&sim[idx])) done = 0;
+		}
+		timer_tick();
+	} while(!done && !failed && (tick < TICKS_MAX));
+
+	CHECK(done);
+	for(i = 0; i < SIMS; i++)
+	{
+		CHECK(sim[i].disconnects == 0);
+		CHECK(sim[i].net.state == ((sim[i].net.working_mode == UDP_MODE) ? ST_UDP : ST_CONNECT));
+		if(sim[i].net.working_mode == UDP_MODE) CHECK(sim[i].datagrams > 0);
+	}
+	CHECK(get_device_status() == 0); // The channel 1 status is not touched by the other sessions
+
+	if(!failed) printf("parallel sessions: %d sessions, %lu ticks, %d bytes each way per session in order\n", SIMS, (unsigned long)tick, STREAM_LEN);
+}
+
+static void test_session_timers(void)
+{
+	static const uint16_t inactivity[SIMS] = {1, 2, 3, 1, 2, 3};
+	uint8_t i;
+
+	// Sessions 0 ~ 2 idle after the connection, sessions 3 ~ 5 with the serial data flowing
+	for(i = 0; i < SIMS; i++)
+	{
+		init_sim(i, TCP_SERVER_MODE);
+		sim[i].net.inactivity = inactivity[i];
+		sim[i].connect = SEG_ENABLE;
+		if(i >= 3) sim[i].u2e_len = 0xFFFFFFFF;
+	}
+
+	tick = 0;
+	while((tick < 4500) && !failed)
+	{
+		for(i = 0; i < SIMS; i++)
+		{
+			network_connect(&sim[i], i);
+			if(i >= 3)
+			{
+				sim[i].idle = 0;
+				serial_rx(&sim[i], i);
+			}
+			do_seg(&sim[i].ctx);
+			if(i >= 3) while(getSn_TX_WR(i) != getSn_TX_RD(i)) network_tx(&sim[i], i);
+		}
+		timer_tick();
+	}
+
+	for(i = 0; i < 3; i++)
+	{
+		CHECK(sim[i].disconnects == 1);
+		CHECK(sim[i].disconnect_tick == (uint32_t)inactivity[i] * 1000);
+		CHECK(wztoe_sn[i].sr == SOCK_LISTEN); // reopened, the peer does not connect again
+		CHECK(sim[i].net.state == ST_OPEN);
+	}
+	for(i = 3; i < SIMS; i++)
+	{
+		CHECK(sim[i].disconnects == 0);
+		CHECK(wztoe_sn[i].sr == SOCK_ESTABLISHED);
+		CHECK(sim[i].net.state == ST_CONNECT);
+	}
+
+	if(!failed) printf("session timers: inactivity 1 / 2 / 3 s disconnected at %lu / %lu / %lu ms, the active sessions kept\n",
+		(unsigned long)sim[0].disconnect_tick, (unsigned long)sim[1].disconnect_tick, (unsigned long)sim[2].disconnect_tick);
+}
+
+int main(void)
+{
+	uint8_t * map = mmap(NULL, 0x400000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+	if(map == MAP_FAILED)
+	{
+		printf("FAIL: mmap\n");
+		return 1;
+	}
+	wztoe_mem_base = ((uint32_t)(uintptr_t)map + 0x1FFFFF) & ~0x1FFFFFUL;
+
+	test_parallel_sessions();
+	if(!failed) test_session_timers();
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed;
+}
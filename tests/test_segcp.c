@@ -0,0 +1,427 @@
+/*
+ * SEGCP command lookup (segcp.c init_SEGCP_index / parse_SEGCP) and response writer (segcp_rep_xxx) host test
+ *	- Every command of tbSEGCPCMD is found through the first character index at its table number
+ *	- All the 2-byte command strings: the index lookup result is the one of the linear table scan it replaced
+ *	- Benchmark: the linear scan vs the index lookup, the commands of a "get all" request (host time)
+ *	- Writer without the continuation: the replies past the buffer size are truncated, null-terminated,
+ *	  nothing written past the buffer end (the guard bytes around the buffer checked)
+ *	- Writer with the continuation (UDP / TCP / UART): the response is sent in parts before the reply that
+ *	  may not fit, each part starts with the header (MA, PW), the replies are sent whole and in order
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../Projects/S2E_App/src/Configuration/segcp.c"
+
+#define TEST_SEED		0x3C6EF372	// next_rand()
+#include "test_common.h"
+
+#define BENCH_ROUNDS	20000
+#define GUARD			16
+#define GUARD_BYTE		0xA5
+#define REPLIES			2000
+#define STREAM_MAX		(REPLIES * SEGCP_REPLY_MAX)
+
+static DevConfig dev_config_test;
+
+// The response parts sent by segcp_rep_flush(): the output functions of the stub
+static uint8_t sent[STREAM_MAX * 2];
+static uint32_t sent_len;
+static uint16_t sent_part[REPLIES + 1];		// The length of each part
+static uint16_t sent_parts;
+static uint8_t sent_sock;
+
+DevConfig * get_DevConfig_pointer(void)
+{
+	return &dev_config_test;
+}
+
+static int32_t capture(uint8_t sock, uint8_t * buf, uint16_t len)
+{
+	CHECK(buf[len] == 0);
+	memcpy(&sent[sent_len], buf, len);
+	sent_len += len;
+	sent_part[sent_parts++] = len;
+	sent_sock = sock;
+	return len;
+}
+
+int32_t sendto(uint8_t sn, uint8_t * buf, uint16_t len, uint8_t * addr, uint16_t port)
+{
+	CHECK(memcmp(addr, "\xFF\xFF\xFF\xFF", 4) == 0);
+	CHECK(port == 50001);
+	return capture(sn, buf, len);
+}
+
+int32_t send(uint8_t sn, uint8_t * buf, uint16_t len)
+{
+	return capture(sn, buf, len);
+}
+
+int32_t uart_puts(uint8_t uartNum, uint8_t * buf, uint16_t reqSize)
+{
+	return capture(0xFF, buf, reqSize);
+}
+
+// The other modules referenced by segcp.c: not called by the test (the requests of the test only get the settings)
+uint32_t wztoe_mem_base;
+wztoe_sn_t wztoe_sn[_WIZCHIP_SOCK_NUM_];
+BUFFER_DEFINITION(data_rx, 64)
+uint8_t opmode = DEVICE_GW_MODE;
+uint8_t USER_IO_SEL[4];
+uint8_t * uart_if_table[] = {(uint8_t *)UART_IF_STR_RS232_TTL, (uint8_t *)UART_IF_STR_RS422_485};
+
+const DevConfig_channel * get_DevConfig_channel(uint8_t ch) { CHECK(0); return NULL; }
+void save_DevConfig_to_storage(void) { CHECK(0); }
+void erase_storage(teDATASTORAGE stype) { CHECK(0); }
+void device_set_factory_default(void) { CHECK(0); }
+void device_reboot(void) { CHECK(0); }
+uint8_t device_firmware_update(teDATASTORAGE stype) { CHECK(0); return 0; }
+int8_t disconnect(uint8_t sn) { CHECK(0); return 0; }
+
+uint8_t get_device_status(void) { CHECK(0); return 0; }
+void set_device_status(teDEVSTATUS status) { CHECK(0); }
+void init_trigger_modeswitch(uint8_t mode) { CHECK(0); }
+void init_seg_rx_gap_timer(uint8_t ch) { CHECK(0); }
+void lock_seg_data_path(void) { CHECK(0); }
+void unlock_seg_data_path(void) { CHECK(0); }
+void process_data_channel_termination(uint8_t ch) { CHECK(0); }
+void process_data_sockets_termination(void) { CHECK(0); }
+uint32_t get_u2e_latency_usec(uint8_t percentile) { CHECK(0); return 0; }
+uint32_t get_u2e_latency_count(void) { CHECK(0); return 0; }
+void clear_u2e_latency(void) { CHECK(0); }
+uint8_t get_task_status(uint8_t idx, const char ** name, uint32_t * run_msec, uint32_t * max_usec, uint32_t * runs) { CHECK(0); return 0; }
+void clear_task_status(void) { CHECK(0); }
+
+int32_t uart_getc(uint8_t uartNum) { CHECK(0); return RET_NOK; }
+void uart_rx_flush(uint8_t uartNum) { CHECK(0); }
+void set_flowcontrol_dtr_pin(uint8_t set) { CHECK(0); }
+void init_connection_status_io(void) { CHECK(0); }
+uint8_t get_connection_status_io(uint16_t pin) { CHECK(0); return 0; }
+void init_user_io(uint8_t io_sel) { CHECK(0); }
+uint8_t get_user_io_type(uint8_t io_sel) { CHECK(0); return 0; }
+uint8_t get_user_io_direction(uint8_t io_sel) { CHECK(0); return 0; }
+uint8_t set_user_io_type(uint8_t io_sel, uint8_t type) { CHECK(0); return 0; }
+uint8_t set_user_io_direction(uint8_t io_sel, uint8_t dir) { CHECK(0); return 0; }
+uint8_t get_user_io_val(uint16_t io_sel, uint16_t * val) { CHECK(0); return 0; }
+uint8_t set_user_io_val(uint16_t io_sel, uint16_t * val) { CHECK(0); return 0; }
+
+uint8_t is_macaddr(uint8_t * macstr, uint8_t * digitstr, uint8_t * mac) { CHECK(0); return 0; }
+uint8_t is_ipaddr(uint8_t * ipaddr, uint8_t * ret_ip) { CHECK(0); return 0; }
+uint8_t is_hexstr(uint8_t * hexstr) { CHECK(0); return 0; }
+uint8_t is_hex(uint8_t hex) { CHECK(0); return 0; }
+uint8_t str_to_hex(uint8_t * str, uint8_t * hex) { CHECK(0); return 0; }
+
+// The command lookup replaced by the index: strncmp() through the whole table
+static uint8_t ref_lookup(uint8_t * pmsg)
+{
+	uint8_t ** pcmd;
+
+	for(pcmd = tbSEGCPCMD; *pcmd != 0; pcmd++)
+	{
+		if(!strncmp((char *)pmsg, (char *)*pcmd, strlen((char *)*pcmd))) break;
+	}
+	if(*pcmd == 0) return SEGCP_UNKNOWN;
+
+	return (uint8_t)(pcmd - tbSEGCPCMD);
+}
+
+// Request line of a command: MA + 6-byte MAC address, PW + password, the others without a parameter
+static void make_request(uint8_t * msg, uint8_t cmdnum)
+{
+	memcpy(msg, tbSEGCPCMD[cmdnum], SEGCP_CMD_MAX);
+	msg[2] = 0;
+	if(cmdnum == SEGCP_MA) strcat((char *)msg, "\x00\x08\xDC\x01\x02\x03");
+	else if(cmdnum == SEGCP_PW) strcat((char *)msg, "pass");
+	strcat((char *)&msg[(cmdnum == SEGCP_MA) ? 8 : 2], SEGCP_DELIMETER);
+}
+
+static void test_table(void)
+{
+	uint8_t n;
+
+	// The index is built for SEGCP_CMD_NUM commands from 'A' ~ 'Z'
+	for(n = 0; tbSEGCPCMD[n] != 0; n++)
+	{
+		CHECK(strlen((char *)tbSEGCPCMD[n]) == SEGCP_CMD_MAX);
+		CHECK((tbSEGCPCMD[n][0] >= 'A') && (tbSEGCPCMD[n][0] <= 'Z'));
+	}
+	CHECK(n == SEGCP_CMD_NUM);
+	CHECK(SEGCP_CMD_NUM < SEGCP_UNKNOWN);
+}
+
+static void test_every_command(void)
+{
+	uint8_t msg[32], param[32];
+	uint8_t i;
+
+	for(i = 0; i < SEGCP_CMD_NUM; i++)
+	{
+		make_request(msg, i);
+		if(parse_SEGCP(msg, param) != i)
+		{
+			printf("FAIL: %s not found at %u\n", tbSEGCPCMD[i], i);
+			failed = 1;
+		}
+	}
+	if(!failed) printf("every command: %u commands found at their table number\n", SEGCP_CMD_NUM);
+}
+
+// All the 2-byte strings (the command characters and the unknown ones) against the linear scan
+static void test_compare(void)
+{
+	uint8_t msg[8], param[8];
+	uint32_t c0, c1, found = 0;
+	uint8_t ref, ret;
+
+	for(c0 = 1; c0 < 256; c0++)
+	{
+		for(c1 = 0; c1 < 256; c1++)
+		{
+			msg[0] = (uint8_t)c0;
+			msg[1] = (uint8_t)c1;
+			msg[2] = 0;
+			ref = ref_lookup(msg);
+			if((ref == SEGCP_MA) || (ref == SEGCP_PW)) continue; // the parameter format checked after the lookup (test_every_command)
+			ret = parse_SEGCP(msg, param);
+			if(ret != ref)
+			{
+				printf("FAIL: 0x%02X 0x%02X: %u, linear scan %u\n", (unsigned)c0, (unsigned)c1, ret, ref);
+				failed = 1;
+			}
+			if(ret != SEGCP_UNKNOWN) found++;
+		}
+	}
+	if(!failed) printf("compare: 65280 command strings, %u found (MA, PW excluded), the same results as the linear scan\n", (unsigned)found);
+}
+
+// Host time only: the lookup of all the commands, the order of a "get all" request
+static void bench(void)
+{
+	static uint8_t msg[SEGCP_CMD_NUM][32];
+	uint8_t param[32];
+	struct timespec t0, t1;
+	double ref_ns, new_ns;
+	volatile uint32_t sum = 0;
+	uint32_t r;
+	uint8_t i;
+
+	for(i = 0; i < SEGCP_CMD_NUM; i++) make_request(msg[i], i);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(r = 0; r < BENCH_ROUNDS; r++)
+		for(i = 0; i < SEGCP_CMD_NUM; i++) sum += ref_lookup(msg[i]);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	ref_ns = elapsed_ns(&t0, &t1) / BENCH_ROUNDS;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(r = 0; r < BENCH_ROUNDS; r++)
+		for(i = 0; i < SEGCP_CMD_NUM; i++) sum += parse_SEGCP(msg[i], param);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	new_ns = elapsed_ns(&t0, &t1) / BENCH_ROUNDS;
+
+	printf("bench %u commands: linear scan %8.1f ns, index (parse_SEGCP) %8.1f ns (x%.1f)\n", SEGCP_CMD_NUM, ref_ns, new_ns, ref_ns / new_ns);
+}
+
+static void check_guard(uint8_t * area, uint16_t size)
+{
+	uint16_t i;
+
+	for(i = 0; i < GUARD; i++)
+	{
+		if((area[i] != GUARD_BYTE) || (area[GUARD + size + i] != GUARD_BYTE))
+		{
+			printf("FAIL: size %u: written past the buffer\n", size);
+			failed = 1;
+			return;
+		}
+	}
+}
+
+// Random reply: the writer functions of proc_SEGCP() mixed, the expected text appended to 'expect'
+static uint16_t write_reply(uint8_t * expect)
+{
+	static const char * str[] = {"WIZ750SR", "", "1.2.3dev", "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz01"};
+	uint8_t ip[4];
+	uint8_t data[6];
+	uint32_t val;
+	uint16_t len;
+	uint8_t i;
+
+	len = sprintf((char *)expect, "%s", tbSEGCPCMD[next_rand() % SEGCP_CMD_NUM]);
+	segcp_rep_put(expect, SEGCP_CMD_MAX);
+
+	switch(next_rand() % 5)
+	{
+		case 0:
+			val = next_rand() >> (next_rand() % 32);
+			segcp_rep_dec(val);
+			len += sprintf((char *)&expect[len], "%u", (unsigned)val);
+			break;
+		case 1:
+			for(i = 0; i < 4; i++) ip[i] = (uint8_t)next_rand();
+			segcp_rep_ip(ip);
+			len += sprintf((char *)&expect[len], "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+			break;
+		case 2:
+			for(i = 0; i < 6; i++) data[i] = (uint8_t)next_rand();
+			segcp_rep_hex(data, 6, SEGCP_DISABLE);
+			len += sprintf((char *)&expect[len], "%02X%02X%02X%02X%02X%02X", data[0], data[1], data[2], data[3], data[4], data[5]);
+			break;
+		case 3:
+			i = (uint8_t)(next_rand() % 4);
+			segcp_rep_str(str[i]);
+			len += sprintf((char *)&expect[len], "%s", str[i]);
+			break;
+		default:
+			// The longest reply: a value of SEGCP_PARAM_MAX * 2 characters
+			for(i = 0; i < (SEGCP_PARAM_MAX * 2); i++)
+			{
+				expect[len] = (uint8_t)('a' + (next_rand() % 26));
+				segcp_rep_char(expect[len++]);
+			}
+			break;
+	}
+	segcp_rep_str(SEGCP_DELIMETER);
+	len += sprintf((char *)&expect[len], SEGCP_DELIMETER);
+
+	return len;
+}
+
+// No continuation (SEGCP_REP_NONE): bounded by the buffer size
+static void test_writer_truncate(void)
+{
+	static uint8_t area[GUARD + CONFIG_BUF_SIZE + GUARD];
+	static uint8_t expect[STREAM_MAX];
+	uint32_t expect_len, t;
+	uint16_t size;
+
+	for(t = 0; (t < 20000) && !failed; t++)
+	{
+		size = (uint16_t)(1 + (next_rand() % CONFIG_BUF_SIZE));
+		memset(area, GUARD_BYTE, sizeof(area));
+		sent_parts = 0;
+
+		segcp_rep_init(&area[GUARD], size, SEGCP_REP_NONE, 0);
+		expect_len = 0;
+		while(expect_len < (uint32_t)(size + SEGCP_REPLY_MAX))
+		{
+			segcp_rep_reserve(SEGCP_REPLY_MAX);
+			expect_len += write_reply(&expect[expect_len]);
+		}
+
+		CHECK(sent_parts == 0);
+		CHECK(segcp_wr.len == (size - 1));
+		CHECK(area[GUARD + size - 1] == 0);
+		CHECK(memcmp(&area[GUARD], expect, size - 1) == 0);
+		check_guard(area, size);
+	}
+	if(!failed) printf("writer truncate: %u buffer sizes (1 ~ %u bytes) overfilled, null-terminated, nothing written past the end\n", (unsigned)t, CONFIG_BUF_SIZE);
+}
+
+// Continuation: the response sent in parts, each part starting with the header
+static void test_writer_continue(uint8_t out, uint16_t size)
+{
+	static uint8_t area[GUARD + CONFIG_BUF_SIZE + GUARD];
+	static uint8_t expect[STREAM_MAX];
+	uint8_t head[32];
+	uint16_t head_len, mark, part_len;
+	uint32_t expect_len = 0, off, body, dropped = 0;
+	uint16_t r, p;
+
+	memset(area, GUARD_BYTE, sizeof(area));
+	memset(&dev_config_test, 0, sizeof(dev_config_test));
+	memcpy(dev_config_test.network_info_common.mac, "\x00\x08\xDC\x5A\x00\x0D", 6);
+	sent_len = 0;
+	sent_parts = 0;
+
+	// MA + MAC address (binary) + PW line of the request
+	memcpy(head, "MA\x00\x08\xDC\x5A\x00\x0D\r\nPWsecret\r\n", 19);
+	head_len = 19;
+
+	segcp_rep_init(&area[GUARD], size, out, 50001);
+	segcp_rep_header(&head[10], 9);
+	CHECK(segcp_wr.len == head_len);
+
+	for(r = 0; r < REPLIES; r++)
+	{
+		segcp_rep_reserve(SEGCP_REPLY_MAX);
+		mark = segcp_wr.len;
+		CHECK((size - 1 - segcp_wr.len) >= SEGCP_REPLY_MAX);
+
+		if((next_rand() % 8) == 0)
+		{
+			// Error path of proc_SEGCP(): the reply dropped by the rewind to the mark
+			write_reply(&expect[expect_len]);
+			segcp_rep_rewind(mark);
+			dropped++;
+		}
+		else
+		{
+			expect_len += write_reply(&expect[expect_len]);
+		}
+	}
+	segcp_rep_flush();
+
+	// Each part: the header + the whole replies, the bodies in order are the replies written
+	off = 0;
+	body = 0;
+	for(p = 0; (p < sent_parts) && !failed; p++)
+	{
+		part_len = sent_part[p];
+		CHECK(part_len <= (size - 1));
+		CHECK(part_len > head_len);
+		CHECK(memcmp(&sent[off], head, head_len) == 0);
+		CHECK(memcmp(&sent[off + head_len], &expect[body], part_len - head_len) == 0);
+		CHECK((sent[off + part_len - 2] == '\r') && (sent[off + part_len - 1] == '\n'));
+		body += part_len - head_len;
+		off += part_len;
+	}
+	CHECK(body == expect_len);
+	CHECK(sent_sock == ((out == SEGCP_REP_UDP) ? SEGCP_UDP_SOCK : (out == SEGCP_REP_TCP) ? SEGCP_TCP_SOCK : 0xFF));
+	check_guard(area, size);
+
+	if(!failed) printf("writer continue (%s, %3u bytes): %u replies (%u dropped) in %u parts, each with the header\n",
+		(out == SEGCP_REP_UDP) ? "UDP " : (out == SEGCP_REP_TCP) ? "TCP " : "UART", size, REPLIES, (unsigned)dropped, sent_parts);
+}
+
+// The header alone does not fit the next reply: the reply is truncated, no part of the header only is sent
+static void test_writer_small(void)
+{
+	static uint8_t area[GUARD + 64 + GUARD];
+	uint8_t expect[SEGCP_REPLY_MAX * 2];
+
+	memset(area, GUARD_BYTE, sizeof(area));
+	sent_len = 0;
+	sent_parts = 0;
+
+	segcp_rep_init(&area[GUARD], 64, SEGCP_REP_UDP, 50001);
+	segcp_rep_header((uint8_t *)"PWsecret\r\n", 10);
+	segcp_rep_reserve(SEGCP_REPLY_MAX);
+	CHECK(sent_parts == 0);
+	while(segcp_wr.len < 63) write_reply(expect);
+	CHECK(area[GUARD + 63] == 0);
+	check_guard(area, 64);
+
+	segcp_rep_flush();
+	CHECK((sent_parts == 1) && (sent_part[0] == 63));
+}
+
+int main(void)
+{
+	test_table();
+	if(!failed) test_every_command();
+	if(!failed) test_compare();
+	if(!failed) bench();
+	if(!failed) test_writer_truncate();
+	if(!failed) test_writer_continue(SEGCP_REP_UDP, CONFIG_BUF_SIZE);
+	if(!failed) test_writer_continue(SEGCP_REP_TCP, CONFIG_BUF_SIZE);
+	if(!failed) test_writer_continue(SEGCP_REP_UART, CONFIG_BUF_SIZE);
+	if(!failed) test_writer_continue(SEGCP_REP_UDP, 19 + SEGCP_REPLY_MAX + 1);	// one reply per part
+	if(!failed) test_writer_small();
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed;
+}
@@ -0,0 +1,230 @@
+/*
+ * Non-block io mode partial writes (socket.c send / send_sg / sendto_sg) host test
+ * The stub socket has a Tx buffer whose free size is smaller than the send length (slow consumer):
+ *	- send(): the returned byte count is the free size, the next call continues from the returned offset
+ *	- send_sg(): the zero-copy UART ring buffer path of uart_to_ether(), the ring read index moved by
+ *	  the returned count; the two segments across the ring wrap
+ *	- sendto_sg(): a UDP datagram is not split, SOCK_BUSY until the whole datagram fits
+ * The data taken by the consumer is compared with the data sent, byte for byte
+ */
+#define _GNU_SOURCE		// MAP_32BIT
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "socket.h"
+#include "W7500x_wztoe.h"
+#include "uartHandler.h"
+
+#define TEST_SEED		0x6C078965	// next_rand()
+#include "test_common.h"
+
+#define SOCK_TCP		0
+#define SOCK_UDP_SN		1
+#define TX_MAX			2048
+#define STREAM_LEN		(256 * 1024)
+#define RING_SIZE		512
+
+uint32_t wztoe_mem_base;
+wztoe_sn_t wztoe_sn[_WIZCHIP_SOCK_NUM_];
+
+BUFFER_DEFINITION(ring, RING_SIZE)
+
+static uint8_t stream[STREAM_LEN];
+static uint8_t taken[STREAM_LEN];		// The data taken from the socket Tx buffer by the consumer
+static uint32_t taken_len;
+
+// Socket commands of the stub socket: the sent data stays in the Tx buffer until the consumer takes it
+void wztoe_command(uint8_t sn, uint8_t cr)
+{
+	wztoe_sn_t * s = &wztoe_sn[sn];
+
+	switch(cr)
+	{
+		case Sn_CR_OPEN:
+			s->sr = ((s->mr & 0x0F) == Sn_MR_UDP) ? SOCK_UDP : SOCK_INIT;
+			s->tx_wr = s->tx_rd = 0;
+			s->tx_fsr = s->txmax;
+			break;
+		case Sn_CR_CLOSE:
+			s->sr = SOCK_CLOSED;
+			break;
+		case Sn_CR_SEND:
+			s->tx_fsr = (uint16_t)(s->txmax - (uint16_t)(s->tx_wr - s->tx_rd));
+			s->ir |= Sn_IR_SENDOK;
+			break;
+		default:
+			break;
+	}
+}
+
+// Consumer (the TCP peer / the network): takes up to max bytes of the sent data
+static uint16_t consume(uint8_t sn, uint16_t max)
+{
+	wztoe_sn_t * s = &wztoe_sn[sn];
+	uint16_t len = (uint16_t)(s->tx_wr - s->tx_rd);
+
+	if(len > max) len = max;
+	WIZCHIP_READ_BUF(TXMEM_BASE | (sn << 18), s->tx_rd, &taken[taken_len], len);
+	taken_len += len;
+	s->tx_rd += len;
+	s->tx_fsr += len;
+
+	return len;
+}
+
+static void open_socket(uint8_t sn, uint8_t protocol)
+{
+	wztoe_sn[sn].txmax = TX_MAX;
+	wztoe_sn[sn].rxmax = TX_MAX;
+	CHECK(socket(sn, protocol, 5000, SF_IO_NONBLOCK) == sn);
+	if(protocol == Sn_MR_TCP) wztoe_sn[sn].sr = SOCK_ESTABLISHED;
+	taken_len = 0;
+}
+
+// send(): the free size smaller than the length, the caller continues from the returned offset
+static void test_send_partial(void)
+{
+	uint32_t off = 0, calls = 0, partial = 0;
+	uint16_t len, fsr;
+	int32_t ret;
+
+	open_socket(SOCK_TCP, Sn_MR_TCP);
+
+	// 1000 bytes into 300 bytes of the free space
+	ret = send(SOCK_TCP, stream, TX_MAX - 300);
+	CHECK(ret == (TX_MAX - 300));
+	ret = send(SOCK_TCP, &stream[TX_MAX - 300], 1000);
+	CHECK(ret == 300);
+	CHECK(wztoe_sn[SOCK_TCP].tx_fsr == 0);
+	off = TX_MAX;
+
+	// Buffer full: SOCK_BUSY, nothing written
+	ret = send(SOCK_TCP, &stream[off], 700);
+	CHECK(ret == SOCK_BUSY);
+	CHECK(getSn_TX_WR(SOCK_TCP) == TX_MAX);
+
+	// 120 bytes taken: the next call continues from the returned offset
+	consume(SOCK_TCP, 120);
+	ret = send(SOCK_TCP, &stream[off], 700);
+	CHECK(ret == 120);
+	off += ret;
+
+	// Slow consumer: random amounts taken between the calls, the stream continues from the returned offset
+	while((off < STREAM_LEN) && !failed)
+	{
+		consume(SOCK_TCP, (uint16_t)(next_rand() % 700));
+
+		len = (uint16_t)(1 + next_rand() % 1460);
+		if(len > (STREAM_LEN - off)) len = (uint16_t)(STREAM_LEN - off);
+		fsr = wztoe_sn[SOCK_TCP].tx_fsr;
+
+		ret = send(SOCK_TCP, &stream[off], len);
+		calls++;
+
+		if(fsr == 0)
+		{
+			CHECK(ret == SOCK_BUSY);
+			continue;
+		}
+		CHECK(ret == ((len < fsr) ? len : fsr));
+		if(ret < len) partial++;
+		if(ret > 0) off += ret;
+	}
+	while(consume(SOCK_TCP, 0xFFFF));
+
+	CHECK(taken_len == STREAM_LEN);
+	CHECK(memcmp(taken, stream, STREAM_LEN) == 0);
+	printf("send: %u calls, %u partial writes, %u bytes in order\n", (unsigned)calls, (unsigned)partial, (unsigned)taken_len);
+}
+
+// send_sg(): the zero-copy path of uart_to_ether(), the UART ring buffer read index moved by the returned count
+static void test_send_sg_ring(void)
+{
+	uint32_t in = 0, calls = 0, wrapped = 0;
+	uint16_t len, len1st, n;
+	uint8_t * buf;
+	int32_t ret;
+
+	open_socket(SOCK_TCP, Sn_MR_TCP);
+	ring_wr = ring_rd = 0;
+
+	while((taken_len < STREAM_LEN) && !failed)
+	{
+		// Serial data received
+		n = (uint16_t)(next_rand() % 200);
+		if(n > BUFFER_FREE_SIZE(ring)) n = BUFFER_FREE_SIZE(ring);
+		if(n > (STREAM_LEN - in)) n = (uint16_t)(STREAM_LEN - in);
+		for( ; n > 0; n--)
+		{
+			BUFFER_IN(ring) = stream[in++];
+			BUFFER_IN_MOVE(ring, 1);
+		}
+
+		consume(SOCK_TCP, (uint16_t)(next_rand() % 400));
+
+		len = BUFFER_USED_SIZE(ring);
+		if(len == 0) continue;
+		buf = BUFFER_OUT_PTR(ring);
+		len1st = BUFFER_OUT_SPAN(ring);
+		if(len1st > len) len1st = len;
+		if(len > len1st) wrapped++;
+
+		ret = send_sg(SOCK_TCP, buf, len1st, ring_buf, len - len1st);
+		calls++;
+		CHECK(ret >= 0);
+		if(ret > 0) BUFFER_OUT_MOVE(ring, ret);
+
+		while((in == STREAM_LEN) && IS_BUFFER_EMPTY(ring) && consume(SOCK_TCP, 0xFFFF));
+	}
+
+	CHECK(taken_len == STREAM_LEN);
+	CHECK(memcmp(taken, stream, STREAM_LEN) == 0);
+	printf("send_sg: %u calls, %u across the ring wrap, %u bytes in order\n", (unsigned)calls, (unsigned)wrapped, (unsigned)taken_len);
+}
+
+// sendto_sg(): a UDP datagram is sent whole or not at all
+static void test_sendto_datagram(void)
+{
+	uint8_t ip[4] = {192, 168, 11, 2};
+	int32_t ret;
+
+	open_socket(SOCK_UDP_SN, Sn_MR_UDP);
+	CHECK(wztoe_sn[SOCK_UDP_SN].sr == SOCK_UDP);
+
+	wztoe_sn[SOCK_UDP_SN].tx_fsr = 500;
+	ret = sendto_sg(SOCK_UDP_SN, stream, 400, &stream[400], 200, ip, 5000);
+	CHECK(ret == SOCK_BUSY);
+	CHECK(wztoe_sn[SOCK_UDP_SN].tx_wr == 0);
+
+	wztoe_sn[SOCK_UDP_SN].tx_fsr = 600;
+	ret = sendto_sg(SOCK_UDP_SN, stream, 400, &stream[400], 200, ip, 5000);
+	CHECK(ret == 600);
+	CHECK(wztoe_sn[SOCK_UDP_SN].dport == 5000);
+
+	consume(SOCK_UDP_SN, 0xFFFF);
+	CHECK(taken_len == 600);
+	CHECK(memcmp(taken, stream, 600) == 0);
+}
+
+int main(void)
+{
+	uint8_t * map = mmap(NULL, 0x400000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+	uint32_t i;
+
+	if(map == MAP_FAILED)
+	{
+		printf("FAIL: mmap\n");
+		return 1;
+	}
+	wztoe_mem_base = ((uint32_t)(uintptr_t)map + 0x1FFFFF) & ~0x1FFFFFUL;
+
+	for(i = 0; i < STREAM_LEN; i++) stream[i] = (uint8_t)next_rand();
+
+	test_send_partial();
+	if(!failed) test_send_sg_ring();
+	if(!failed) test_sendto_datagram();
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed;
+}
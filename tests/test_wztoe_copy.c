@@ -0,0 +1,194 @@
+/*
+ * WZTOE socket buffer copy (W7500x_wztoe.c WIZCHIP_READ_BUF / WIZCHIP_WRITE_BUF) host test
+ *	- The word-wide copy is compared byte for byte with the byte loop it replaced:
+ *	  random pointers (the 64KB wrap included), lengths and RAM buffer alignments,
+ *	  the bytes around the destination are checked untouched
+ *	- Benchmark: the byte loop vs the word-wide copy, 2KB transfers at the pointers of all the alignments (host time)
+ */
+#define _GNU_SOURCE		// MAP_32BIT
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "../Libraries/W7500x_stdPeriph_Driver/src/W7500x_wztoe.c"
+
+#define TEST_SEED		0x2545F491	// next_rand()
+#include "test_common.h"
+
+#define WINDOW_SIZE		0x10000
+#define TRIALS			200000
+#define BENCH_LEN		2048
+#define BENCH_ROUNDS	20000
+#define GUARD			16
+
+uint32_t wztoe_mem_base;
+wztoe_sn_t wztoe_sn[_WIZCHIP_SOCK_NUM_];
+
+// The copy routines replaced by the word-wide copy (byte access, 64KB wrap masked per byte)
+static void ref_read_buf(uint32_t BaseAddr, uint32_t ptr, uint8_t* pBuf, uint16_t len)
+{
+	uint16_t i = 0;
+	for(i = 0; i < len; i++)
+		pBuf[i] = *(volatile uint8_t *)(uintptr_t)(BaseAddr + ((ptr + i) & 0xFFFF));
+}
+
+static void ref_write_buf(uint32_t BaseAddr, uint32_t ptr, uint8_t* pBuf, uint16_t len)
+{
+	uint16_t i = 0;
+	for(i = 0; i < len; i++)
+		*(volatile uint8_t *)(uintptr_t)(BaseAddr + ((ptr + i) & 0xFFFF)) = pBuf[i];
+}
+
+static void fill_random(uint8_t * p, uint32_t len)
+{
+	while(len--) *p++ = (uint8_t)next_rand();
+}
+
+// Random pointer: a quarter of the trials end across the 64KB wrap
+static uint32_t random_ptr(uint16_t len)
+{
+	if((next_rand() & 3) == 0) return (0x10000 - 1 - (next_rand() % (len + 1))) & 0xFFFF;
+	return next_rand(); // the upper bits are masked by the driver
+}
+
+static uint16_t random_len(void)
+{
+	switch(next_rand() & 3)
+	{
+		case 0:		return (uint16_t)(next_rand() % 8);		// shorter than a word
+		case 1:		return (uint16_t)(next_rand() % 64);
+		default:	return (uint16_t)(next_rand() % 2049);	// up to a socket buffer transfer
+	}
+}
+
+static void test_compare(void)
+{
+	uint8_t * win_new = (uint8_t *)(uintptr_t)wztoe_mem_base;
+	uint8_t * win_ref = (uint8_t *)(uintptr_t)(wztoe_mem_base | (1 << 18)); // the socket 1 window
+	static uint8_t ram_new[2048 + 2 * GUARD + 4], ram_ref[2048 + 2 * GUARD + 4];
+	uint32_t t, ptr, align;
+	uint16_t len;
+
+	fill_random(win_new, WINDOW_SIZE);
+	memcpy(win_ref, win_new, WINDOW_SIZE);
+
+	for(t = 0; (t < TRIALS) && !failed; t++)
+	{
+		len = random_len();
+		ptr = random_ptr(len);
+		align = next_rand() & 3;
+
+		if(t & 1)
+		{
+			// RAM -> socket buffer: the whole 64KB window compared
+			fill_random(ram_new, sizeof(ram_new));
+			WIZCHIP_WRITE_BUF((uint32_t)(uintptr_t)win_new, ptr, &ram_new[GUARD + align], len);
+			ref_write_buf((uint32_t)(uintptr_t)win_ref, ptr, &ram_new[GUARD + align], len);
+
+			if(memcmp(win_new, win_ref, WINDOW_SIZE) != 0)
+			{
+				printf("FAIL: write ptr 0x%04X len %u align %u\n", (unsigned)(ptr & 0xFFFF), len, align);
+				failed = 1;
+			}
+		}
+		else
+		{
+			// Socket buffer -> RAM: the destination and the guard bytes around it compared
+			fill_random(ram_new, sizeof(ram_new));
+			memcpy(ram_ref, ram_new, sizeof(ram_ref));
+			WIZCHIP_READ_BUF((uint32_t)(uintptr_t)win_new, ptr, &ram_new[GUARD + align], len);
+			ref_read_buf((uint32_t)(uintptr_t)win_new, ptr, &ram_ref[GUARD + align], len);
+
+			if(memcmp(ram_new, ram_ref, sizeof(ram_new)) != 0)
+			{
+				printf("FAIL: read ptr 0x%04X len %u align %u\n", (unsigned)(ptr & 0xFFFF), len, align);
+				failed = 1;
+			}
+		}
+	}
+
+	if(!failed) printf("compare: %u random transfers, byte for byte equal to the byte loop\n", (unsigned)t);
+}
+
+// Socket API path: wiz_send_data / wiz_recv_data move the pointers by the length, across the wrap
+static void test_socket_path(void)
+{
+	static uint8_t tx[1500], rx[1500];
+	uint8_t sn = 3;
+
+	fill_random(tx, sizeof(tx));
+
+	wztoe_sn[sn].tx_wr = 0xFE00;
+	wiz_send_data(sn, tx, sizeof(tx));
+	CHECK(getSn_TX_WR(sn) == (uint16_t)(0xFE00 + sizeof(tx)));
+
+	// The Tx window content read back through the Rx path at the same offset
+	memcpy((uint8_t *)(uintptr_t)(RXMEM_BASE | (sn << 18)), (uint8_t *)(uintptr_t)(TXMEM_BASE | (sn << 18)), WINDOW_SIZE);
+	wztoe_sn[sn].rx_rd = 0xFE00;
+	wiz_recv_peek(sn, rx, sizeof(rx));
+	CHECK(getSn_RX_RD(sn) == 0xFE00);
+	CHECK(memcmp(tx, rx, sizeof(rx)) == 0);
+
+	memset(rx, 0, sizeof(rx));
+	wiz_recv_data(sn, rx, sizeof(rx));
+	CHECK(getSn_RX_RD(sn) == (uint16_t)(0xFE00 + sizeof(rx)));
+	CHECK(memcmp(tx, rx, sizeof(rx)) == 0);
+}
+
+// Host time only: the ratio indicates the loop cost, the W7500 cycles also depend on the WZTOE memory wait states
+static void bench(void)
+{
+	static uint8_t ram[BENCH_LEN];
+	uint32_t base = wztoe_mem_base;
+	struct timespec t0, t1;
+	double ref_ns, new_ns;
+	uint32_t i;
+
+	fill_random(ram, sizeof(ram));
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < BENCH_ROUNDS; i++) ref_read_buf(base, i * 61, ram, BENCH_LEN);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	ref_ns = elapsed_ns(&t0, &t1) / BENCH_ROUNDS;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < BENCH_ROUNDS; i++) WIZCHIP_READ_BUF(base, i * 61, ram, BENCH_LEN);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	new_ns = elapsed_ns(&t0, &t1) / BENCH_ROUNDS;
+
+	printf("bench read  %u bytes: byte loop %8.1f ns, word copy %8.1f ns (x%.1f)\n", BENCH_LEN, ref_ns, new_ns, ref_ns / new_ns);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < BENCH_ROUNDS; i++) ref_write_buf(base, i * 61, ram, BENCH_LEN);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	ref_ns = elapsed_ns(&t0, &t1) / BENCH_ROUNDS;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(i = 0; i < BENCH_ROUNDS; i++) WIZCHIP_WRITE_BUF(base, i * 61, ram, BENCH_LEN);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	new_ns = elapsed_ns(&t0, &t1) / BENCH_ROUNDS;
+
+	printf("bench write %u bytes: byte loop %8.1f ns, word copy %8.1f ns (x%.1f)\n", BENCH_LEN, ref_ns, new_ns, ref_ns / new_ns);
+}
+
+int main(void)
+{
+	// 8 socket windows (256KB each) below 4GB, aligned as the WZTOE memory map (base | (sn << 18))
+	uint8_t * map = mmap(NULL, 0x400000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+
+	if(map == MAP_FAILED)
+	{
+		printf("FAIL: mmap\n");
+		return 1;
+	}
+	wztoe_mem_base = ((uint32_t)(uintptr_t)map + 0x1FFFFF) & ~0x1FFFFFUL;
+
+	test_compare();
+	if(!failed) test_socket_path();
+	if(!failed) bench();
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+	return failed;
+}